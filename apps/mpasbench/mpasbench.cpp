@@ -0,0 +1,179 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/DCMPAS.h>
+#include <vapor/FileUtils.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Measure the time DCMPAS takes to open and read variables, and the
+// connectivity of the meshes they are defined on, for each time step
+// of an MPAS data set. Connectivity is read along with the variables,
+// as DataMgr does when it constructs a grid.
+//
+
+struct opt_t {
+    vector<string>          varnames;
+    int                     nts;
+    int                     nreps;
+    OptionParser::Boolean_T help;
+} opt;
+
+OptionParser::OptDescRec_T set_opts[] = {{"varnames", 1, "", "Colon delimited list of variables to read. Default is all 2D and 3D data variables"},
+                                         {"nts", 1, "-1", "Number of time steps to read. Default is all"},
+                                         {"nreps", 1, "1", "Number of passes over the time steps"},
+                                         {"help", 0, "", "Print this message and exit"},
+                                         {NULL}};
+
+OptionParser::Option_T get_options[] = {{"varnames", Wasp::CvtToStrVec, &opt.varnames, sizeof(opt.varnames)},
+                                        {"nts", Wasp::CvtToInt, &opt.nts, sizeof(opt.nts)},
+                                        {"nreps", Wasp::CvtToInt, &opt.nreps, sizeof(opt.nreps)},
+                                        {"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+                                        {NULL}};
+
+const char *ProgName;
+
+// Open and read all of a variable. Returns the number of bytes read,
+// or -1 on failure
+//
+template<class T> long read_var(DC &dc, size_t ts, string varname, vector<T> &buf, double &openTime, double &readTime)
+{
+    vector<size_t> dims;
+    if (!dc.GetVarDimLens(varname, true, dims)) {
+        MyBase::SetErrMsg("Invalid variable name : %s", varname.c_str());
+        return (-1);
+    }
+
+    vector<size_t> min(dims.size(), 0);
+    vector<size_t> max;
+    size_t         n = 1;
+    for (auto d : dims) {
+        max.push_back(d - 1);
+        n *= d;
+    }
+    buf.resize(n);
+
+    double t0 = GetTime();
+    int    fd = dc.OpenVariableRead(ts, varname);
+    if (fd < 0) return (-1);
+
+    double t1 = GetTime();
+    int    rc = dc.ReadRegion(fd, min, max, buf.data());
+    dc.CloseVariable(fd);
+    if (rc < 0) return (-1);
+
+    double t2 = GetTime();
+    openTime += t1 - t0;
+    readTime += t2 - t1;
+
+    return (n * sizeof(T));
+}
+
+// Return the connectivity variables of the mesh a data variable is
+// defined on
+//
+vector<string> mesh_vars(const DC &dc, string varname)
+{
+    vector<string> vars;
+
+    DC::DataVar dvar;
+    DC::Mesh    mesh;
+    if (!dc.GetDataVarInfo(varname, dvar) || !dc.GetMesh(dvar.GetMeshName(), mesh)) return (vars);
+    if (mesh.GetMeshType() == DC::Mesh::STRUCTURED) return (vars);
+
+    for (auto v : {mesh.GetFaceNodeVar(), mesh.GetNodeFaceVar(), mesh.GetFaceEdgeVar(), mesh.GetFaceFaceVar(), mesh.GetEdgeNodeVar(), mesh.GetEdgeFaceVar()}) {
+        if (!v.empty()) vars.push_back(v);
+    }
+    return (vars);
+}
+
+int main(int argc, char **argv)
+{
+    OptionParser op;
+
+    ProgName = FileUtils::LegacyBasename(argv[0]);
+    MyBase::SetErrMsgFilePtr(stderr);
+
+    if (op.AppendOptions(set_opts) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (op.ParseOptions(&argc, argv, get_options) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (opt.help || argc < 2) {
+        cerr << "Usage: " << ProgName << " [options] mpasfile [mpasfile...]" << endl;
+        op.PrintOptionHelp(stderr);
+        exit(opt.help ? 0 : 1);
+    }
+
+    vector<string> files;
+    for (int i = 1; i < argc; i++) files.push_back(argv[i]);
+
+    double t0 = GetTime();
+    DCMPAS dc;
+    int    rc = dc.Initialize(files);
+    if (rc < 0) exit(1);
+    printf("Initialize: %.3f s\n", GetTime() - t0);
+
+    vector<string> varnames = opt.varnames;
+    if (varnames.empty()) {
+        varnames = dc.GetDataVarNames(2);
+        vector<string> v3d = dc.GetDataVarNames(3);
+        varnames.insert(varnames.end(), v3d.begin(), v3d.end());
+    }
+    if (varnames.empty()) {
+        MyBase::SetErrMsg("No variables to read");
+        exit(1);
+    }
+
+    size_t nts = dc.GetNumTimeSteps(varnames[0]);
+    if (opt.nts >= 0) nts = std::min(nts, (size_t)opt.nts);
+
+    vector<float> fbuf;
+    vector<int>   ibuf;
+    double        total = 0.0;
+    double        slowest = 0.0;
+    size_t        nsamples = 0;
+
+    printf("%6s %6s %10s %10s %10s %10s\n", "pass", "ts", "open (ms)", "read (ms)", "mesh (ms)", "MB");
+    for (int rep = 0; rep < opt.nreps; rep++) {
+        for (size_t ts = 0; ts < nts; ts++) {
+            double openTime = 0.0, readTime = 0.0, meshOpen = 0.0, meshRead = 0.0;
+            double bytes = 0.0;
+
+            for (auto varname : varnames) {
+                long n = read_var(dc, ts, varname, fbuf, openTime, readTime);
+                if (n < 0) exit(1);
+                bytes += n;
+
+                for (auto meshVar : mesh_vars(dc, varname)) {
+                    n = read_var(dc, ts, meshVar, ibuf, meshOpen, meshRead);
+                    if (n < 0) exit(1);
+                    bytes += n;
+                }
+            }
+
+            double t = openTime + readTime + meshOpen + meshRead;
+            printf("%6d %6zu %10.2f %10.2f %10.2f %10.2f\n", rep, ts, openTime * 1000.0, readTime * 1000.0, (meshOpen + meshRead) * 1000.0, bytes / (1024.0 * 1024.0));
+
+            total += t;
+            slowest = std::max(slowest, t);
+            nsamples++;
+        }
+    }
+
+    if (nsamples) printf("Mean per time step: %.2f ms, slowest: %.2f ms\n", total / nsamples * 1000.0, slowest * 1000.0);
+
+    return (0);
+}
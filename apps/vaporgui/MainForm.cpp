@@ -2514,7 +2514,7 @@ void MainForm::startAnimCapture(string baseFile, string defaultSuffix)
     _animationCapture = true;
     GUIStateParams *p = GetStateParams();
     string          vizName = p->GetActiveVizName();
-    _controlExec->EnableAnimationCapture(vizName, true, fpath);
+    _vizWinMgr->EnableAnimationCapture(vizName, true, fpath);
     _capturingAnimationVizName = vizName;
 
     _captureEndImageAction->setEnabled(true);
@@ -2535,7 +2535,7 @@ void MainForm::endAnimCapture()
     GUIStateParams *p = GetStateParams();
     string          vizName = p->GetActiveVizName();
     if (vizName != _capturingAnimationVizName) { MSG_WARN("Terminating capture in non-active visualizer"); }
-    if (_controlExec->EnableAnimationCapture(_capturingAnimationVizName, false)) MSG_WARN("Image Capture Warning;\nCurrent active visualizer is not capturing images");
+    if (_vizWinMgr->EnableAnimationCapture(_capturingAnimationVizName, false)) MSG_WARN("Image Capture Warning;\nCurrent active visualizer is not capturing images");
 
     _animationCapture = false;
 
@@ -15,6 +15,9 @@ ModelEventRouter::ModelEventRouter(QWidget *parent, ControlExec *ce) : RenderEve
             (new PFileOpenSelector(ModelParams::FileTag, "Model/Scene File"))
                 ->SetFileTypeFilter("3D Models/Scenes (*.vms *.3d *.3ds *.3mf *.ac *.ac3d *.acc *.amj *.ase *.ask *.b3d *.blend *.bvh *.cms *.cob *.dae *.dxf *.enff *.fbx *.hmb *.ifc *.irr *.lwo *.lws *.lxo *.md2 *.md3 *.md5 *.mdc *.mdl *.mesh *.mot *.ms3d *.ndo *.nff *.obj *.off *.ogex *.ply *.pmx *.prj *.q3o *.q3s *.raw *.scn *.sib *.smd *.stp *.stl *.ter *.uc *.vta *.x *.x3d *.xml *.xgl *.zgl)")
         }),
+        new PSection("Performance", {
+            new PCheckbox(ModelParams::MergeMeshesTag, "Large model mode (merge meshes by material)")
+        }),
         new PRendererTransformWidget
     }));
 
@@ -574,18 +574,17 @@ void Plot::_timeTabPlotClicked()
 
     std::vector<std::vector<float>> sequences;
     for (int v = 0; v < enabledVars.size(); v++) {
-        std::vector<float> seq;
-        for (int t = minMaxTS[0]; t <= minMaxTS[1]; t++) {
-            VAPoR::Grid *grid = dataMgr->GetVariable(t, enabledVars[v], refinementLevel, compressLevel);
-            if (grid) {
-                float fieldVal = grid->GetValue(singlePt);
-                if (fieldVal != grid->GetMissingValue())
-                    seq.push_back(fieldVal);
-                else
-                    seq.push_back(std::nanf("1"));
-            }
+        std::vector<std::vector<float>> values;
+        float                           missingValue;
+        int rc = dataMgr->GetProbeTimeSeries(enabledVars[v], std::vector<std::vector<double>>(1, singlePt), minMaxTS[0], minMaxTS[1], refinementLevel, compressLevel, values, missingValue);
+        if (rc < 0) {
+            MSG_ERR("Failed to read time series of " + enabledVars[v]);
+            return;
+        }
 
-            delete grid;
+        std::vector<float> seq = values[0];
+        for (int t = 0; t < seq.size(); t++) {
+            if (seq[t] == missingValue) seq[t] = std::nanf("1");
         }
         sequences.push_back(seq);
     }
@@ -42,6 +42,59 @@ using namespace Wasp;
 using namespace VAPoR;
 using namespace std;
 
+namespace {
+
+// Return a grid for the statistics region. Regions too large for the
+// DataMgr cache are paged in, so a pass over them has a bounded memory
+// footprint; smaller ones are read into the cache for later passes.
+//
+Grid *getStatsGrid(DataMgr *dataMgr, const StatisticsParams *statsParams, int ts, const string &varname, const vector<double> &minExtent, const vector<double> &maxExtent)
+{
+    int level = statsParams->GetRefinementLevel();
+    int lod = statsParams->GetCompressionLevel();
+
+    if (dataMgr->ExceedsCache(ts, varname, level, lod, minExtent, maxExtent)) return (dataMgr->GetVariableStreamed(ts, varname, level, lod, minExtent, maxExtent));
+    return (dataMgr->GetVariable(ts, varname, level, lod, minExtent, maxExtent));
+}
+
+// Invoke fn(slot, value) on the values a ConstIterator over the box
+// [minExtent, maxExtent] would visit that are not missing. Values are
+// visited in parallel with Grid::ParallelForEach(), and slot, less than
+// Grid::GetNumThreads(0), may index per-thread state. Nodes are only
+// tested against the box if the grid extends beyond it.
+//
+template<typename Fn> void forEachValueInBox(const Grid *grid, const vector<double> &minExtent, const vector<double> &maxExtent, Fn fn)
+{
+    const float missingVal = grid->GetMissingValue();
+    const int   ndim = std::min((int)grid->GetGeometryDim(), (int)minExtent.size());
+
+    DblArr3 gridMin, gridMax;
+    grid->GetUserExtents(gridMin, gridMax);
+    bool inside = true;
+    for (int i = 0; i < ndim; i++) inside = inside && gridMin[i] >= minExtent[i] && gridMax[i] <= maxExtent[i];
+
+    grid->ParallelForEach([&](int slot, const Grid::Span &span) {
+        Size_tArr3 index = span.index;
+        DblArr3    coords;
+        for (size_t k = 0; k < span.n; k++) {
+            float val = span.data[k];
+            if (val == missingVal) continue;
+
+            if (!inside) {
+                index[0] = span.index[0] + k;
+                grid->GetUserCoordinates(index, coords);
+                bool in = true;
+                for (int i = 0; i < ndim; i++) in = in && coords[i] >= minExtent[i] && coords[i] <= maxExtent[i];
+                if (!in) continue;
+            }
+
+            fn(slot, val);
+        }
+    });
+}
+
+};    // namespace
+
 // Class Statistics
 //
 Statistics::Statistics(QWidget *parent) : QDialog(parent), Ui_StatsWindow()
@@ -643,37 +696,42 @@ bool Statistics::_calc3M(std::string varname)
     std::vector<double> minExtent, maxExtent;
     statsParams->GetBox()->GetExtents(minExtent, maxExtent);
 
-    float c = 0.0;
-    float sum = 0.0;
-    float min = std::numeric_limits<float>::max();
-    float max = -min;
-    long  count = 0;
+    // Per-thread partial results, combined once all time steps are done
+    //
+    struct partial_t {
+        double sum = 0.0;
+        float  min = std::numeric_limits<float>::max();
+        float  max = -std::numeric_limits<float>::max();
+        long   count = 0;
+    };
+    vector<partial_t> partials(Grid::GetNumThreads(0));
 
     for (int ts = minTS; ts <= maxTS; ts++) {
-        VAPoR::Grid *grid = currentDmgr->GetVariable(ts, varname, statsParams->GetRefinementLevel(), statsParams->GetCompressionLevel(), minExtent, maxExtent);
+        VAPoR::Grid *grid = getStatsGrid(currentDmgr, statsParams, ts, varname, minExtent, maxExtent);
         if (grid) {
-            Grid::ConstIterator endItr = grid->cend();
-            float               missingVal = grid->GetMissingValue();
-
-            for (Grid::ConstIterator it = grid->cbegin(minExtent, maxExtent); it != endItr; ++it) {
-                if (*it != missingVal) {
-                    float val = *it;
-                    min = min < val ? min : val;
-                    max = max > val ? max : val;
-                    float y = val - c;
-                    float t = sum + y;
-                    c = t - sum - y;
-                    sum = t;
-                    count++;
-                }
-            }
+            forEachValueInBox(grid, minExtent, maxExtent, [&partials](int slot, float val) {
+                partial_t &p = partials[slot];
+                p.min = p.min < val ? p.min : val;
+                p.max = p.max > val ? p.max : val;
+                p.sum += val;
+                p.count++;
+            });
 
             delete grid;    // delete the grid after using it!
         }
     }
 
+    partial_t total;
+    for (const auto &p : partials) {
+        total.min = std::min(total.min, p.min);
+        total.max = std::max(total.max, p.max);
+        total.sum += p.sum;
+        total.count += p.count;
+    }
+    long count = total.count;
+
     if (count > 0) {
-        float m3[3] = {min, max, sum / (float)count};
+        float m3[3] = {total.min, total.max, (float)(total.sum / count)};
         _validStats.Add3MStats(varname, m3);
     } else    // count == 0
     {
@@ -699,22 +757,33 @@ bool Statistics::_calcMedian(std::string varname)
     std::vector<double> minExtent, maxExtent;
     statsParams->GetBox()->GetExtents(minExtent, maxExtent);
 
-    std::vector<float> buffer;
+    // The median needs every value, so memory grows with the region no
+    // matter how the grids are read. Paging large regions at least avoids
+    // also holding them in the cache.
+    //
+    vector<vector<float>> partials(Grid::GetNumThreads(0));
     for (int ts = minTS; ts <= maxTS; ts++) {
-        VAPoR::Grid *grid = currentDmgr->GetVariable(ts, varname, statsParams->GetRefinementLevel(), statsParams->GetCompressionLevel(), minExtent, maxExtent);
+        VAPoR::Grid *grid = getStatsGrid(currentDmgr, statsParams, ts, varname, minExtent, maxExtent);
         if (grid) {
-            Grid::ConstIterator endItr = grid->cend();
-            float               missingVal = grid->GetMissingValue();
+            forEachValueInBox(grid, minExtent, maxExtent, [&partials](int slot, float val) { partials[slot].push_back(val); });
 
-            for (Grid::ConstIterator it = grid->cbegin(minExtent, maxExtent); it != endItr; ++it) {
-                if (*it != missingVal) buffer.push_back(*it);
-            }
+            delete grid;
         }
     }
 
+    size_t n = 0;
+    for (const auto &p : partials) n += p.size();
+
+    std::vector<float> buffer;
+    buffer.reserve(n);
+    for (auto &p : partials) {
+        buffer.insert(buffer.end(), p.begin(), p.end());
+        vector<float>().swap(p);
+    }
+
     if (buffer.size() > 0) {
-        std::sort(buffer.begin(), buffer.end());
-        float median = buffer.at(buffer.size() / 2);
+        std::nth_element(buffer.begin(), buffer.begin() + buffer.size() / 2, buffer.end());
+        float median = buffer[buffer.size() / 2];
         _validStats.AddMedian(varname, median);
     } else {
         // std::cerr << "Error: Zero value got selected!!" << std::endl;
@@ -739,9 +808,6 @@ bool Statistics::_calcStddev(std::string varname)
     std::vector<double> minExtent, maxExtent;
     statsParams->GetBox()->GetExtents(minExtent, maxExtent);
 
-    float c = 0.0;
-    float sum = 0.0;
-    long  count = 0;
     float m3[3];
     _validStats.Get3MStats(varname, m3);
     if (std::isnan(m3[2])) {
@@ -749,26 +815,33 @@ bool Statistics::_calcStddev(std::string varname)
         _validStats.Get3MStats(varname, m3);
     }
 
+    // Per-thread sums of squared deviations and counts
+    //
+    const double   mean = m3[2];
+    vector<double> sums(Grid::GetNumThreads(0), 0.0);
+    vector<long>   counts(sums.size(), 0);
+
     for (int ts = minTS; ts <= maxTS; ts++) {
-        VAPoR::Grid *grid = currentDmgr->GetVariable(ts, varname, statsParams->GetRefinementLevel(), statsParams->GetCompressionLevel(), minExtent, maxExtent);
+        VAPoR::Grid *grid = getStatsGrid(currentDmgr, statsParams, ts, varname, minExtent, maxExtent);
         if (grid) {
-            Grid::ConstIterator endItr = grid->cend();
-            float               missingVal = grid->GetMissingValue();
-            for (Grid::ConstIterator it = grid->cbegin(minExtent, maxExtent); it != endItr; ++it) {
-                if (*it != missingVal) {
-                    float val = *it;
-                    float y = (val - m3[2]) * (val - m3[2]) - c;
-                    float t = sum + y;
-                    c = t - sum - y;
-                    sum = t;
-                    count++;
-                }
-            }
+            forEachValueInBox(grid, minExtent, maxExtent, [&](int slot, float val) {
+                sums[slot] += (val - mean) * (val - mean);
+                counts[slot]++;
+            });
+
+            delete grid;
         }
     }
 
+    double sum = 0.0;
+    long   count = 0;
+    for (size_t i = 0; i < sums.size(); i++) {
+        sum += sums[i];
+        count += counts[i];
+    }
+
     if (count > 0) {
-        _validStats.AddStddev(varname, std::sqrt(sum / (float)count));
+        _validStats.AddStddev(varname, (float)std::sqrt(sum / count));
     } else {
         // std::cerr << "Error: Zero value got selected!!" << std::endl;
     }
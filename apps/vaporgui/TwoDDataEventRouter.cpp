@@ -1,6 +1,7 @@
 #include "TwoDDataEventRouter.h"
 #include "vapor/TwoDDataParams.h"
 #include "PWidgets.h"
+#include "PIntegerInputHLI.h"
 
 using namespace VAPoR;
 
@@ -15,7 +16,12 @@ TwoDDataEventRouter::TwoDDataEventRouter(QWidget *parent, ControlExec *ce) : Ren
             new PScalarVariableSelector,
             new PHeightVariableSelector
         }),
-        new PFidelitySection
+        new PFidelitySection,
+        new PSection("Mesh", {
+            (new PIntegerInputHLI<TwoDDataParams>("Max grid points per axis", &TwoDDataParams::GetMaxMeshDim, &TwoDDataParams::SetMaxMeshDim))
+                ->SetRange(0, 65536)
+                ->SetTooltip("Larger meshes are decimated. Zero disables decimation.")
+        })
     }));
     
     AddAppearanceSubtab((new PTFEditor));
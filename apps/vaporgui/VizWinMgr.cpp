@@ -346,6 +346,13 @@ int VizWinMgr::EnableImageCapture(string filename, string winName)
     _vizWindow[winName]->_postRender();
 }
 
+int VizWinMgr::EnableAnimationCapture(string winName, bool doEnable, string filename)
+{
+    auto itr = _vizWindow.find(winName);
+    if (itr != _vizWindow.end()) itr->second->makeCurrent();
+    return _controlExec->EnableAnimationCapture(winName, doEnable, filename);
+}
+
 void VizWinMgr::Shutdown()
 {
     vector<string> vizNames = _getVisualizerNames();
@@ -74,6 +74,13 @@ public:
     //! \copydoc VAPoR::ControlExec::EnableImageCapture()
     int EnableImageCapture(string filename, string winName);
 
+    //! \copydoc VAPoR::ControlExec::EnableAnimationCapture()
+    //!
+    //! The OpenGL context of the visualizer is made current so that any
+    //! frames still being read back can be completed when capture ends
+    //
+    int EnableAnimationCapture(string winName, bool doEnable, string filename = "");
+
     VizWin *Get(const std::string &name) { return _vizWindow[name]; }
 
 public slots:
@@ -1,25 +1,82 @@
 /*
  * Define input/output operations given an Advection.
  * Specifically, it can read a list of seeds for the advection class to start with,
- * and also output the trajectory of advectios to a text file.
+ * and also output the trajectory of advectios to a file.
  */
 
 #ifndef ADVECTION_IO_H
 #define ADVECTION_IO_H
 
 #include <iostream>
+#include <cstdint>
 #include "vapor/Advection.h"
 
 namespace flow {
+
+// File formats that trajectories can be written in.
+//
+// CSV:    one line of text per sample, with time decoded to a date string.
+//
+// BINARY: a sequence of self-describing blocks, one per call to an output
+//         function, in native byte order. Each block is laid out as
+//             char[8]   magic "VAPORFLB"
+//             uint32    format version
+//             uint32    byte order mark, 0x01020304
+//             uint64    number of streams, S
+//             uint64    number of samples, N
+//             uint32    number of properties, P
+//             P x {uint32 length, char[length]}   property names
+//             uint64[S] stream IDs
+//             uint64[S] number of samples in each stream
+//             float[N]  X, then float[N] Y, then float[N] Z
+//             double[N] time
+//             P x float[N]                        property values
+//         Samples of a stream are contiguous within each column.
+//
+// NETCDF: a NetCDF-4 file following the CF "contiguous ragged array"
+//         representation of trajectories. Appending adds trajectories
+//         to the unlimited "trajectory" and "obs" dimensions. The
+//         variable of property P is named "property_P"; the property
+//         names are listed in the "flowline_properties" attribute.
+//
+enum class FlowlineFormat { CSV, BINARY, NETCDF };
+
+// Pick a format from the file name extension: ".nc" selects NETCDF,
+// ".vfl" or ".bin" selects BINARY, and anything else selects CSV.
+FLOW_API auto FlowlineFormatFromFilename(const std::string &filename) -> FlowlineFormat;
+
+// Trajectory samples in columnar form, as read back from a BINARY or NETCDF file.
+// The samples of stream i occupy [streamOffsets[i], streamOffsets[i+1]) of every column.
+struct FlowlineSet {
+    std::vector<std::string>        propertyNames;
+    std::vector<uint64_t>           streamIDs;
+    std::vector<uint64_t>           streamOffsets;
+    std::vector<float>              x, y, z;
+    std::vector<double>             time;
+    std::vector<std::vector<float>> properties;    // one column per property name
+
+    size_t GetNumberOfStreams() const { return streamIDs.size(); }
+    size_t GetNumberOfSamples() const { return x.size(); }
+};
+
 // Output a certain number of steps from an advection.
 // When `append == false`, a header will also be output.
 // Otherwise, only trajectories are output.
-FLOW_API auto OutputFlowlinesNumSteps(const Advection *adv, const char *filename, size_t numStep, const std::string &proj4string, bool append) -> int;
+// All samples are projected with a single call when `proj4string` is not empty.
+FLOW_API auto OutputFlowlinesNumSteps(const Advection *adv, const char *filename, size_t numStep, const std::string &proj4string, bool append,
+                                      FlowlineFormat format = FlowlineFormat::CSV) -> int;
 
 // Output trajectory to a maximum time.
 // When `append == false`, a header will also be output.
 // Otherwise, only trajectories are output.
-FLOW_API auto OutputFlowlinesMaxTime(const Advection *adv, const char *filename, double maxTime, const std::string &proj4string, bool append) -> int;
+// All samples are projected with a single call when `proj4string` is not empty.
+FLOW_API auto OutputFlowlinesMaxTime(const Advection *adv, const char *filename, double maxTime, const std::string &proj4string, bool append,
+                                     FlowlineFormat format = FlowlineFormat::CSV) -> int;
+
+// Read trajectories written in the BINARY or NETCDF format.
+// The format is detected from the file contents.
+// Blocks appended to a BINARY file must share the same property names.
+FLOW_API auto InputFlowlines(const std::string &filename, FlowlineSet &set) -> int;
 
 // Input a list of seeds from lines of CSVs.
 // In case of any error occurs, it returns an empty list.
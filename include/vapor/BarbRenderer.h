@@ -22,6 +22,7 @@
 #include <vapor/Renderer.h>
 #include <vapor/Grid.h>
 #include <vapor/BarbParams.h>
+#include <vapor/Texture.h>
 
 namespace VAPoR {
 
@@ -56,7 +57,12 @@ private:
 
     double _maxValue;
 
-    void _getMagnitudeAtPoint(std::vector<VAPoR::Grid *> variables, float point[3]);
+    GLuint    _VAO;
+    GLuint    _meshVBO;
+    GLuint    _instanceVBO;
+    Texture1D _lutTexture;
+    size_t    _nMeshVertices;
+    size_t    _nBarbs;
 
     void _recalculateScales(std::vector<VAPoR::Grid *> &varData, int ts);
 
@@ -78,7 +84,7 @@ private:
 
     int _getVarGrid(int ts, int refLevel, int lod, string varName, std::vector<double> minExts, std::vector<double> maxExts, std::vector<VAPoR::Grid *> &varData);
 
-    void _setUpLightingAndColor();
+    void _releaseGrids(std::vector<VAPoR::Grid *> &varData);
 
     void _reFormatExtents(vector<float> &rakeExts) const;
 
@@ -98,48 +104,19 @@ private:
     //		vector <Grid *> variableData
     //	);
 
-    float _getHeightOffset(Grid *heightVar, float xCoord, float yCoord, bool &missing) const;
-
     bool _makeCLUT(float clut[1024]) const;
 
-    void _getDirection(float direction[3], std::vector<Grid *> varData, float xCoord, float yCoord, float zCoord, bool &missing) const;
-
     vector<double> _getScales();
 
-    float _calculateLength(float start[3], float end[3]) const;
-
-    void _makeStartAndEndPoint(float start[3], float end[3], float direction[3]);
-
     void _getStrides(vector<float> &strides, vector<int> &rakeGrid, vector<float> &rakeExts) const;
 
-    bool _defineBarb(const std::vector<Grid *>, float start[3], float end[3], float *value, bool doColorMapping, const float clut[1024]);
-
-    void _operateOnGrid(vector<Grid *> variableData, bool drawBarb = true);
-
-    bool _getColorMapping(float val, const float clut[256 * 4]);
-
-    float _calculateDirVec(const float start[3], const float end[3], float dirVec[3]);
-
-    void _drawBackOfBarb(const float dirVec[3], const float startVertex[3]) const;
-
-    void _drawCylinderSides(const float nextNormal[3], const float nextVertex[3], const float startNormal[3], const float startVertex[3]) const;
-
-    void _drawBarbHead(const float dirVec[3], const float vertexPoint[3], const float startNormal[3], const float startVertex[3]) const;
-
-    //! Protected method to draw one barb (a hexagonal tube with a cone barbhead)
-    //! \param[in] const float startPoint[3] beginning position of barb
-    //! \param[in] const float endPoint[3] ending position of barb
-    // void drawBarb(const float startPoint[3], const float endPoint[3]);
-    void _drawBarb(const std::vector<Grid *> variableData, const float startPoint[3], bool doColorMapping, const float clut[1024]);
-
-    void _setBarbColor(float value, const float clut[1024], double crange[2]) const;
-
-    struct Barb;
-    void _drawBarb(Barb b, bool doColorMapping, const float clut[1024], double crange[2]);
-
-#ifdef DEBUG
-    _printBackDiameter(const float startVertex[18]) const;
-#endif
+    //! Sample the rake in parallel. If \p drawBarb is true one instance
+    //! per valid rake point is appended to \p instances, consisting of
+    //! the barb position, unit direction, vector magnitude, and color
+    //! variable value. Otherwise only the largest vector component
+    //! magnitude is computed and stored in _maxValue.
+    //
+    void _operateOnGrid(const vector<Grid *> &variableData, vector<float> &instances, bool drawBarb = true);
 
     struct {
         vector<string> fieldVarNames;
@@ -166,15 +143,6 @@ private:
     void _saveCacheParams();
 
     void _clearCache() { _cacheParams.fieldVarNames.clear(); }
-
-    struct Barb {
-        float startPoint[3];
-        float endPoint[3];
-        float value;
-        float lengthScalar;
-    };
-
-    vector<Barb> _barbCache;
 };
 
 };    // namespace VAPoR
@@ -0,0 +1,112 @@
+#ifndef _BlockPager_h_
+#define _BlockPager_h_
+
+#include <vector>
+#include <list>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <functional>
+#include <vapor/common.h>
+
+namespace VAPoR {
+
+//! \class BlockPager
+//! \brief Keep a bounded set of a grid's data blocks in memory
+//!
+//! A BlockPager backs the data blocks of a Grid that is too large to hold
+//! in memory (see Grid::SetBlockPager()). A block is read by a loader
+//! function the first time it is acquired, and stays resident until it
+//! is evicted to make room for another block. Only blocks that are not
+//! acquired are evicted, least recently used first, so the memory used is
+//! bounded by the larger of the resident limit and the number of blocks
+//! acquired at the same time.
+//!
+//! All methods may be called concurrently. The loader may be invoked
+//! concurrently for different blocks, so a loader that uses a reader
+//! that is not thread safe must serialize itself.
+//
+class VDF_API BlockPager {
+public:
+    //! Fill \p data, an array of GetBlockSize() elements, with the
+    //! contents of block \p index. Return a negative int on failure.
+    //
+    typedef std::function<int(size_t index, float *data)> Loader;
+
+    //! A pointer to an acquired block that releases the block when the
+    //! last copy is destroyed
+    //
+    typedef std::shared_ptr<float> BlockRef;
+
+    //! \param[in] nblocks Number of blocks
+    //! \param[in] blockSize Number of elements in each block
+    //! \param[in] maxResident Maximum number of blocks kept in memory. At
+    //! least one block is kept.
+    //! \param[in] loader Function that reads a block
+    //! \param[in] fillValue Value stored in a block that could not be
+    //! loaded
+    //
+    BlockPager(size_t nblocks, size_t blockSize, size_t maxResident, Loader loader, float fillValue);
+    ~BlockPager();
+
+    size_t GetNumBlocks() const { return (_blocks.size()); }
+    size_t GetBlockSize() const { return (_blockSize); }
+    size_t GetMaxResident() const { return (_maxResident); }
+
+    //! Return block \p index, loading it if it is not resident
+    //!
+    //! The block is not evicted until a matching call to Release(). The
+    //! returned pointer is never NULL: if the loader fails the block is
+    //! filled with the fill value passed to the constructor.
+    //
+    float *Acquire(size_t index);
+
+    void Release(size_t index);
+
+    //! Acquire block \p index for the lifetime of the returned reference
+    //
+    BlockRef Get(size_t index);
+
+    //! Return the number of blocks read by the loader
+    //
+    size_t GetNumLoads() const;
+
+    //! Return the number of loads that failed
+    //
+    size_t GetNumLoadErrors() const;
+
+    //! Return the largest number of blocks that were resident at once
+    //
+    size_t GetPeakResident() const;
+
+private:
+    class block_t {
+    public:
+        float *                     _data;
+        int                         _pins;
+        bool                        _loading;
+        std::list<size_t>::iterator _lru;
+    };
+
+    size_t                  _blockSize;
+    size_t                  _maxResident;
+    Loader                  _loader;
+    float                   _fillValue;
+    std::vector<block_t>    _blocks;
+    std::list<size_t>       _lru;    // resident blocks not acquired, least recent first
+    size_t                  _nresident;
+    size_t                  _peakResident;
+    size_t                  _nloads;
+    size_t                  _nerrors;
+    mutable std::mutex      _mutex;
+    std::condition_variable _loadedCV;
+
+    BlockPager(const BlockPager &);
+    BlockPager &operator=(const BlockPager &);
+
+    float *_evict();
+};
+
+};    // namespace VAPoR
+
+#endif
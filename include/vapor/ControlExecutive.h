@@ -201,6 +201,21 @@ public:
     //!
     int Paint(string name, bool force = false);
 
+    //! Return the timing of the most recent paint of each renderer
+    //!
+    //! \param[in] name handle to existing visualizer returned by
+    //! NewVisualizer().
+    //! \param[out] renderTypes Renderer type of each active renderer
+    //! \param[out] renderNames Instance name of each active renderer
+    //! \param[out] paintTimes Wall clock time, in seconds, each renderer
+    //! spent drawing during its last paint
+    //! \param[out] fetchTimes The portion of the corresponding element of
+    //! \p paintTimes spent fetching data from the DataMgr
+    //!
+    //! \sa Renderer::GetLastPaintTime(), Renderer::SetSynchronousTiming()
+    //
+    int GetRenderTimes(string name, vector<string> &renderTypes, vector<string> &renderNames, vector<double> &paintTimes, vector<double> &fetchTimes) const;
+
     //! Activate or Deactivate a renderer
 
     //!
@@ -506,11 +521,17 @@ public:
     //! Subsequent renders in the same visualizer will result in capture to a file
     //! and the filename will be incremented by 1.
     //! The starting filename should terminate with digits to permit incrementing.
+    //! If the filename has the extension .y4m all frames are instead appended
+    //! to a single uncompressed YUV4MPEG2 video file.
     //! filename is ignored if capture is being disabled
+    //!
+    //! Frames are encoded asynchronously. When capture is disabled the
+    //! outstanding frames are completed, which requires that the OpenGL
+    //! context of the visualizer be current.
 
     //! \param[in] viz Valid visualizer handle
     //! \param[in] doEnable true to start capture, false to end.
-    //! \param[in] filestart is either .jpg, .tif, or .tiff file
+    //! \param[in] filestart is either .jpg, .png, .tif, .tiff, or .y4m file
     //! name for first capture.  Ignored if doEnable = false.
     //!
     int EnableAnimationCapture(string winName, bool doEnable, string filename = "");
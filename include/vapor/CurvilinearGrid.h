@@ -238,6 +238,10 @@ protected:
 
     virtual float GetValueLinear(const DblArr3 &coords) const override;
 
+    virtual bool GetInterpolationStencilHelper(const DblArr3 &coords, InterpolationStencil &stencil) const override;
+
+    virtual float InterpolateStencilHelper(const InterpolationStencil &stencil) const override;
+
     // \copydoc GetGrid::GetUserExtents()
     //
     virtual void GetUserExtentsHelper(DblArr3 &minu, DblArr3 &maxu) const override;
@@ -3,6 +3,7 @@
 #include <map>
 #include <iostream>
 #include <vapor/MyBase.h>
+#include <vapor/Trace.h>
 
 #ifndef _DC_H_
     #define _DC_H_
@@ -1669,8 +1670,16 @@ public:
     //! \retval status Returns a non-negative value on success
     //! \sa OpenVariableRead(), GetDimLensAtLevel(), GetDimensionNames()
     //
-    virtual int ReadRegion(int fd, const vector<size_t> &min, const vector<size_t> &max, float *region) { return (readRegion(fd, min, max, region)); }
-    virtual int ReadRegion(int fd, const vector<size_t> &min, const vector<size_t> &max, int *region) { return (readRegion(fd, min, max, region)); }
+    virtual int ReadRegion(int fd, const vector<size_t> &min, const vector<size_t> &max, float *region)
+    {
+        Wasp::TraceSpan span("DC::ReadRegion", "io");
+        return (readRegion(fd, min, max, region));
+    }
+    virtual int ReadRegion(int fd, const vector<size_t> &min, const vector<size_t> &max, int *region)
+    {
+        Wasp::TraceSpan span("DC::ReadRegion", "io");
+        return (readRegion(fd, min, max, region));
+    }
 
     //! Read in and return a blocked subregion from the currently opened
     //! variable.
@@ -1690,8 +1699,16 @@ public:
     //! storage blocking (the data will not be contiguous, unless the
     //! data are not blocked)
     //!
-    virtual int ReadRegionBlock(int fd, const vector<size_t> &min, const vector<size_t> &max, float *region) { return (readRegionBlock(fd, min, max, region)); }
-    virtual int ReadRegionBlock(int fd, const vector<size_t> &min, const vector<size_t> &max, int *region) { return (readRegionBlock(fd, min, max, region)); }
+    virtual int ReadRegionBlock(int fd, const vector<size_t> &min, const vector<size_t> &max, float *region)
+    {
+        Wasp::TraceSpan span("DC::ReadRegionBlock", "io");
+        return (readRegionBlock(fd, min, max, region));
+    }
+    virtual int ReadRegionBlock(int fd, const vector<size_t> &min, const vector<size_t> &max, int *region)
+    {
+        Wasp::TraceSpan span("DC::ReadRegionBlock", "io");
+        return (readRegionBlock(fd, min, max, region));
+    }
 
     //! Read an entire variable in one call
     //!
@@ -1,6 +1,8 @@
 #include <vector>
 #include <algorithm>
 #include <map>
+#include <list>
+#include <memory>
 #include <iostream>
 #include <vapor/MyBase.h>
 #include <vapor/NetCDFCollection.h>
@@ -172,6 +174,34 @@ private:
     Wasp::SmartBuf                  _lonCellSmartBuf;
     Wasp::SmartBuf                  _lonVertexSmartBuf;
 
+    // Time steps _nEdgesOnCellBuf and the longitude buffers were
+    // read for, or -1
+    //
+    long _nEdgesOnCellTS;
+    long _coordinatesTS;
+
+    // MPAS mesh geometry and connectivity do not change with time, so
+    // mesh variables are read, and connectivity post-processed, once and
+    // shared by all time steps and variables. The time step a variable
+    // was read for only matters if the file has it varying with time.
+    // The cache is bounded in bytes; least recently used variables are
+    // released first, but the most recently read one is always kept.
+    // Data are shared so a caller's copy outlives eviction.
+    //
+    class meshVar_t {
+    public:
+        size_t                                  ts;
+        std::shared_ptr<const std::vector<int>> data;
+    };
+    std::map<string, meshVar_t> _meshVarCache;
+    std::list<string>           _meshVarLRU;    // most recently used first
+    size_t                      _meshVarCacheBytes;
+
+    // Scratch space reused across reads
+    //
+    Wasp::SmartBuf _transposeBuf;
+    Wasp::SmartBuf _edgeVarBuf;
+
     int _InitDerivedVars(NetCDFCollection *ncdfc);
     int _InitCoordvars(NetCDFCollection *ncdfc);
 
@@ -204,6 +234,10 @@ private:
 
     void _splitOnBoundary(string varname, int *connData) const;
 
+    bool                                    _isMeshVarCurrent(string varname, long cachedTS, size_t ts) const;
+    std::shared_ptr<const std::vector<int>> _getMeshVar(size_t ts, string varname);
+    int                                     _readRegionMeshVar(MPASFileObject *w, const vector<size_t> &min, const vector<size_t> &max, int *region);
+
     int _readRegionTransposed(MPASFileObject *w, const vector<size_t> &min, const vector<size_t> &max, float *region);
 
     int _readRegionEdgeVariable(MPASFileObject *w, const vector<size_t> &min, const vector<size_t> &max, float *region);
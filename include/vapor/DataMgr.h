@@ -1,6 +1,9 @@
 #include <vector>
 #include <iostream>
 #include <list>
+#include <set>
+#include <mutex>
+#include <atomic>
 #include "vapor/VAssert.h"
 #include <vapor/BlkMemMgr.h>
 #include <vapor/DC.h>
@@ -407,6 +410,50 @@ public:
 
     VAPoR::Grid *GetVariable(size_t ts, string varname, int level, int lod, std::vector<size_t> min, std::vector<size_t> max, bool lock = false);
 
+    //! Return a variable whose data are read on demand
+    //!
+    //! This method is identical to GetVariable(), except that the data
+    //! values of the returned grid are not read into the cache. Instead
+    //! the grid is backed by a BlockPager (see Grid::SetBlockPager()) that
+    //! reads blocks as they are accessed and keeps at most
+    //! \p max_resident_mb megabytes of them in memory. Variables much
+    //! larger than memory can thus be traversed with ParallelForEach() or
+    //! an iterator with a predictable memory footprint. Only data values
+    //! are paged; coordinate variables are read into the cache as usual.
+    //!
+    //! The returned grid is read only, and must be deleted before the
+    //! DataMgr. Derived variables and variables on unstructured grids are
+    //! not paged, and are returned as by GetVariable().
+    //!
+    //! \param[in] max_resident_mb Limit on the memory, in megabytes, used
+    //! by resident blocks. If zero, a quarter of the cache size passed to
+    //! the constructor, but no more than 1024 megabytes, is used.
+    //!
+    //! \sa GetVariable(), BlockPager
+    //
+    VAPoR::Grid *GetVariableStreamed(size_t ts, string varname, int level, int lod, size_t max_resident_mb = 0, bool lock = false);
+
+    //! Return a subregion of a variable whose data are read on demand
+    //!
+    //! The region is specified in user coordinates as with GetVariable().
+    //!
+    //! \sa GetVariableStreamed(size_t, string, int, int, size_t, bool)
+    //
+    VAPoR::Grid *GetVariableStreamed(size_t ts, string varname, int level, int lod, std::vector<double> min, std::vector<double> max, size_t max_resident_mb = 0, bool lock = false);
+
+    //! Return true if a region of a variable is too large for the cache
+    //!
+    //! A region is too large if its data values would occupy more than
+    //! half of the cache size passed to the constructor. Such regions are
+    //! best read with GetVariableStreamed(); smaller ones are better read
+    //! with GetVariable(), so that the data stay cached for later use.
+    //! The region is specified as with GetVariable(). False is returned
+    //! if the region can not be determined.
+    //!
+    //! \sa GetVariable(), GetVariableStreamed()
+    //
+    bool ExceedsCache(size_t ts, string varname, int level, int lod, std::vector<double> min, std::vector<double> max);
+
     //! Compute the coordinate extents of a variable
     //!
     //! This method finds the spatial domain extents of a variable
@@ -440,6 +487,32 @@ public:
     //
     int GetDataRange(size_t ts, string varname, int level, int lod, vector<double> min, vector<double> max, std::vector<double> &range);
 
+    //! Sample a variable at fixed points over a range of time steps
+    //!
+    //! This method returns the same values as calling Grid::GetValue()
+    //! for each point on grids returned by GetVariable() for each time step
+    //! in [\p ts0, \p ts1], but only the blocks containing the probe
+    //! points are read. Points that share blocks are sampled with a
+    //! single read. Time-varying data read by this method are released
+    //! from the cache once sampled, so a long series does not evict
+    //! other data. Coordinate data that do not vary with time remain
+    //! cached.
+    //!
+    //! \param[in] points Probe locations in user coordinates. The number
+    //! of elements of each point must match the spatial dimensionality
+    //! of \p varname
+    //! \param[out] values Upon success \p values[i] contains
+    //! \p ts1 - \p ts0 + 1 samples of \p varname at \p points[i]
+    //! \param[out] missing_value Value returned for points outside the
+    //! domain of \p varname, or where data are missing
+    //!
+    //! \retval status A negative int is returned on failure
+    //!
+    //! \sa GetVariable(), Grid::GetValue()
+    //
+    int GetProbeTimeSeries(string varname, const std::vector<std::vector<double>> &points, size_t ts0, size_t ts1, int level, int lod, std::vector<std::vector<float>> &values,
+                           float &missing_value);
+
     //! \copydoc DC::GetDimLensAtLevel()
     //!
     virtual int GetDimLensAtLevel(string varname, int level, std::vector<size_t> &dims_at_level) const
@@ -489,6 +562,17 @@ public:
     //
     void Clear();
 
+    //! Return the cumulative wall clock time, in seconds, spent in
+    //! GetVariable()
+    //!
+    //! The time includes reading from the data collection, derived
+    //! variable calculation, and grid construction. Requests satisfied
+    //! from the cache contribute little. Sampling this value before and
+    //! after an operation gives the portion of the operation's cost that
+    //! was due to data access.
+    //
+    double GetFetchTime() const { return (_fetchTime.load()); }
+
     //! Returns true if indicated data volume is available
     //!
     //! Returns true if the variable identified by the timestep, variable
@@ -570,6 +654,27 @@ public:
 
     void RemoveDerivedVar(string varname);
 
+    //! Add a derived variable computed from an arithmetic expression
+    //!
+    //! The expression is compiled by a DerivedExpressionVar, which
+    //! documents the expression language, and the resulting variable is
+    //! added with AddDerivedVar(). The variable is owned by the DataMgr and
+    //! deleted by RemoveDerivedVar().
+    //!
+    //! \param[in] varname The name of the derived variable
+    //! \param[in] expression The expression to compute, e.g.
+    //! "sqrt(U*U + V*V)"
+    //! \param[in] mesh The mesh on which the variable is sampled. If empty
+    //! the mesh of the expression's (non reduced) input variables is used.
+    //! \param[in] units The units of the derived variable
+    //!
+    //! \retval status A negative int is returned if a variable named
+    //! \p varname already exists or the expression is invalid
+    //!
+    //! \sa DerivedExpressionVar
+    //
+    int AddExpressionVar(string varname, string expression, string mesh = "", string units = "");
+
     //! Purge the cache of a variable
     //!
     //! \param[in] varname is the variable name
@@ -650,6 +755,7 @@ private:
     VAPoR::GridHelper _gridHelper;
 
     DerivedVarMgr _dvm;
+    std::set<string> _expressionVarNames;
     bool          _doTransformHorizontal;
     bool          _doTransformVertical;
     string        _openVarName;
@@ -658,6 +764,7 @@ private:
     string              _proj4String;
     string              _proj4StringDefault;
     std::vector<size_t> _bs;
+    std::atomic<double> _fetchTime;
 
     typedef struct {
         size_t              ts;
@@ -686,6 +793,11 @@ private:
     std::map<const Grid *, vector<float *>> _lockedFloatBlks;
     std::map<const Grid *, vector<int *>>   _lockedIntBlks;
 
+    // Serializes reads by the pagers of streamed grids, which may be
+    // invoked from several threads
+    //
+    std::mutex _streamMutex;
+
     // Get the immediate variable dependencies of a variable
     //
     std::vector<string> _get_var_dependencies_1(string varname) const;
@@ -752,6 +864,8 @@ private:
 
     VAPoR::Grid *_getVariable(size_t ts, string varname, int level, int lod, std::vector<size_t> min, std::vector<size_t> max, bool lock, bool dataless);
 
+    VAPoR::Grid *_getVariableStreamed(size_t ts, string varname, int level, int lod, const std::vector<size_t> &min, const std::vector<size_t> &max, size_t max_resident_mb, bool lock);
+
     int _parseOptions(vector<string> &options);
 
     template<typename T> T *_get_region_from_cache(size_t ts, string varname, int level, int lod, const std::vector<size_t> &bmin, const std::vector<size_t> &bmax, bool lock);
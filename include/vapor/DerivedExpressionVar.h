@@ -0,0 +1,197 @@
+#include <vector>
+#include <vapor/DC.h>
+#include <vapor/DerivedVar.h>
+
+#ifndef _DERIVEDEXPRESSIONVAR_H_
+    #define _DERIVEDEXPRESSIONVAR_H_
+
+namespace VAPoR {
+
+class DataMgr;
+
+//!
+//! \class DerivedExpressionVar
+//!
+//! \brief Derived data variable computed from an arithmetic expression
+//!
+//! This class implements a derived data variable whose values are
+//! computed by a compiled expression operating on other variables managed
+//! by a DataMgr. It provides a light weight alternative to PyEngine for
+//! simple operators (e.g. wind speed, vorticity, unit conversions) that
+//! does not require a Python interpreter. Instances are usually created
+//! with DataMgr::AddExpressionVar().
+//!
+//! Expressions are compiled once by Initialize() into a sequence of
+//! element-wise kernels. Only the region requested by ReadRegion() is
+//! computed, and rows of the region are evaluated in parallel. Each
+//! input is read over the region, plus any halo needed by stencils,
+//! and copied into a dense array before evaluation.
+//!
+//! The expression language supports:
+//!
+//! \li Numeric constants and the names of DataMgr data variables.
+//! Names that are not valid identifiers may be quoted with single quotes.
+//! \li The binary operators + - * / ^ (power), comparisons
+//! < <= > >= == != and the logical operators && || !. Comparisons and
+//! logical operators evaluate to 1.0 or 0.0, or to a missing value if
+//! an operand is missing.
+//! \li The functions abs, sqrt, exp, log, log10, sin, cos, tan, asin,
+//! acos, atan, floor, ceil, atan2(a, b), pow(a, b), min(a, b), max(a, b),
+//! and where(c, a, b), which returns \p a where \p c is non-zero and \p b
+//! elsewhere. min and max return a missing value if either argument is
+//! missing, as does where if \p c is missing.
+//! \li The stencil operators ddx(v), ddy(v), ddz(v), which return the
+//! centered finite difference of the variable \p v along the
+//! first, second, or third grid axis, divided by the difference of the
+//! corresponding user coordinate. One-sided differences are used at the
+//! domain boundary. ddy and ddz require a mesh with at least two or three
+//! dimensions, respectively.
+//! \li The reductions vsum(v), vmean(v), vmin(v), vmax(v), which reduce
+//! the 3D variable \p v along its third (vertical) axis, producing a 2D
+//! result.
+//!
+//! The argument to a stencil operator or reduction must be a variable
+//! name. All variables appearing outside of a reduction must be sampled
+//! on the same mesh as the derived variable, and reduced variables must
+//! share its horizontal dimensions. Missing values in any input, and
+//! results that are not finite, produce missing values in the output.
+//!
+//! For example, the expression "sqrt(U*U + V*V)" computes wind speed, and
+//! "ddx(V) - ddy(U)" the vertical component of vorticity.
+//!
+class VDF_API DerivedExpressionVar : public DerivedDataVar {
+public:
+    //! Create a derived variable from an expression
+    //!
+    //! \param[in] varName The name of the derived variable
+    //! \param[in] dataMgr The DataMgr supplying the input variables
+    //! \param[in] expression The expression to compute
+    //! \param[in] mesh The name of the mesh on which the derived variable
+    //! is sampled. If empty, the mesh of the first input variable that is
+    //! not reduced is used. A mesh must be given if all inputs are reduced.
+    //! \param[in] units The units of the derived variable
+    //! \param[in] nthreads The maximum number of execution threads. If less
+    //! than one the number of task scheduler threads is used.
+    //
+    DerivedExpressionVar(string varName, DataMgr *dataMgr, string expression, string mesh = "", string units = "", int nthreads = 0);
+    virtual ~DerivedExpressionVar() {}
+
+    //! Compile the expression and validate its inputs
+    //!
+    //! \retval status A negative int is returned if the expression
+    //! contains a syntax error, refers to unknown variables or functions,
+    //! combines variables with incompatible meshes, or differentiates
+    //! along an axis that the mesh does not have.
+    //
+    virtual int Initialize();
+
+    virtual bool GetBaseVarInfo(DC::BaseVar &var) const;
+
+    virtual bool GetDataVarInfo(DC::DataVar &cvar) const;
+
+    virtual std::vector<string> GetInputs() const { return (_inNames); }
+
+    virtual int GetDimLensAtLevel(int level, std::vector<size_t> &dims_at_level, std::vector<size_t> &bs_at_level) const;
+
+    virtual size_t GetNumRefLevels() const;
+
+    virtual int OpenVariableRead(size_t ts, int level = 0, int lod = 0);
+
+    virtual int CloseVariable(int fd);
+
+    virtual int ReadRegionBlock(int fd, const std::vector<size_t> &min, const std::vector<size_t> &max, float *region) { return (ReadRegion(fd, min, max, region)); }
+
+    virtual int ReadRegion(int fd, const std::vector<size_t> &min, const std::vector<size_t> &max, float *region);
+
+    virtual bool VariableExists(size_t ts, int reflevel, int lod) const;
+
+    //! Return the expression computed by this variable
+    //
+    string GetExpression() const { return (_expression); }
+
+    //! Compiled kernel operation codes
+    //
+    enum OpCode {
+        OP_CONST,
+        OP_LOAD,
+        OP_DDX,
+        OP_DDY,
+        OP_DDZ,
+        OP_VSUM,
+        OP_VMEAN,
+        OP_VMIN,
+        OP_VMAX,
+        OP_NEG,
+        OP_NOT,
+        OP_ABS,
+        OP_SQRT,
+        OP_EXP,
+        OP_LOG,
+        OP_LOG10,
+        OP_SIN,
+        OP_COS,
+        OP_TAN,
+        OP_ASIN,
+        OP_ACOS,
+        OP_ATAN,
+        OP_FLOOR,
+        OP_CEIL,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_POW,
+        OP_ATAN2,
+        OP_MIN,
+        OP_MAX,
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_EQ,
+        OP_NE,
+        OP_AND,
+        OP_OR,
+        OP_WHERE
+    };
+
+    //! A single compiled kernel. Each kernel computes one row of its
+    //! destination register from up to three source registers, a
+    //! constant, or an input variable.
+    //
+    class Instruction {
+    public:
+        Instruction(OpCode op, int dst, int a = -1, int b = -1, int c = -1) : _op(op), _dst(dst), _a(a), _b(b), _c(c), _input(-1), _value(0.0) {}
+
+        OpCode _op;
+        int    _dst;
+        int    _a;
+        int    _b;
+        int    _c;
+        int    _input;
+        float  _value;
+    };
+
+private:
+    DataMgr *                _dataMgr;
+    string                   _expression;
+    string                   _mesh;
+    string                   _units;
+    int                      _nthreads;
+    DC::DataVar              _varInfo;
+    DC::FileTable            _fileTable;
+    std::vector<string>      _inNames;
+    std::vector<bool>        _inReduced;
+    std::vector<bool>        _inStencil;
+    std::vector<Instruction> _program;
+    int                      _numRegisters;
+    int                      _result;
+    string                   _refVar;
+    size_t                   _rank;
+
+    int _compile();
+    int _setupVar();
+};
+};    // namespace VAPoR
+
+#endif
@@ -1,5 +1,8 @@
 #include <iostream>
 #include <functional>
+#include <memory>
+#include <list>
+#include <mutex>
 #include <vapor/DC.h>
 #include <vapor/MyBase.h>
 #include <vapor/Proj4API.h>
@@ -247,10 +250,65 @@ public:
 //! \author John Clyne
 //! \date   Februrary, 2018
 //!
+//! Projected coordinates are cached by region, and by time step only if
+//! the lat-lon coordinates are time varying. The X and Y coordinate
+//! variables derived from the same lat-lon pair may share a cache, in
+//! which case a single projection serves both. The cache is bounded by
+//! the size in bytes of the coordinates it holds.
 //!
 class VDF_API DerivedCoordVar_PCSFromLatLon : public DerivedCoordVar {
 public:
-    DerivedCoordVar_PCSFromLatLon(string derivedVarName, DC *dc, std::vector<string> inNames, string proj4String, bool uGridFlag, bool lonFlag);
+    //! Projected X and Y coordinates for a region
+    //
+    class PCSCoords {
+    public:
+        std::vector<float> x;
+        std::vector<float> y;
+    };
+
+    //! A least recently used cache of projected coordinates
+    //!
+    //! Entries are evicted once the total size of the cached coordinates
+    //! exceeds a limit. All methods may be called concurrently.
+    //
+    class VDF_API PCSCache {
+    public:
+        //! \param[in] maxBytes Largest total size of the cached
+        //! coordinates. Regions larger than this are not cached.
+        //
+        PCSCache(size_t maxBytes) : _maxBytes(maxBytes), _bytes(0) {}
+
+        //! Copy the \p n X (if \p xFlag is true) or Y coordinates cached
+        //! under \p key to \p region
+        //!
+        //! \retval found False if there is no entry for \p key, or its
+        //! coordinates for the requested axis do not have \p n elements
+        //
+        bool Get(const string &key, bool xFlag, float *region, size_t n);
+
+        //! Add \p coords under \p key, replacing any existing entry, and
+        //! evict the least recently used entries that no longer fit
+        //
+        void Insert(const string &key, std::unique_ptr<PCSCoords> coords);
+
+        size_t GetMaxBytes() const { return (_maxBytes); }
+
+    private:
+        typedef std::pair<string, std::unique_ptr<PCSCoords>> entry_t;
+
+        size_t             _maxBytes;
+        size_t             _bytes;
+        std::list<entry_t> _entries;    // Most recently used first
+        std::mutex         _mutex;
+
+        static size_t _size(const PCSCoords &coords) { return ((coords.x.size() + coords.y.size()) * sizeof(float)); }
+    };
+
+    //! \param[in] cache An optional cache of projected coordinates,
+    //! shared with the derived coordinate variable for the other axis.
+    //! If NULL a private cache is created.
+    //
+    DerivedCoordVar_PCSFromLatLon(string derivedVarName, DC *dc, std::vector<string> inNames, string proj4String, bool uGridFlag, bool lonFlag, std::shared_ptr<PCSCache> cache = nullptr);
     virtual ~DerivedCoordVar_PCSFromLatLon() {}
 
     virtual int Initialize();
@@ -286,12 +344,17 @@ private:
     std::vector<size_t> _dimLens;
     Proj4API            _proj4API;
     DC::CoordVar        _coordVarInfo;
+    bool                _timeVarying;
+
+    std::shared_ptr<PCSCache> _cache;
 
     int _setupVar();
 
+    string _cacheKey(size_t ts, int lod, const std::vector<size_t> &min, const std::vector<size_t> &max) const;
+
     int _readRegionHelperCylindrical(DC::FileTable::FileObject *f, const std::vector<size_t> &min, const std::vector<size_t> &max, float *region);
-    int _readRegionHelper1D(DC::FileTable::FileObject *f, const std::vector<size_t> &min, const std::vector<size_t> &max, float *region);
-    int _readRegionHelper2D(DC::FileTable::FileObject *f, const std::vector<size_t> &min, const std::vector<size_t> &max, float *region);
+    int _readRegionHelper1D(DC::FileTable::FileObject *f, const std::vector<size_t> &min, const std::vector<size_t> &max, float *lonBuf, float *latBuf);
+    int _readRegionHelper2D(DC::FileTable::FileObject *f, const std::vector<size_t> &min, const std::vector<size_t> &max, float *lonBuf, float *latBuf);
 };
 
 //!
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <glm/glm.hpp>
 #include "vapor/MyBase.h"
 
@@ -23,12 +24,19 @@ struct GLManager;
 
 class RENDER_API Font : public Wasp::MyBase {
     struct Glyph {
-        unsigned int textureID;
-        int          sizeX;
-        int          sizeY;
-        int          bearingX;
-        int          bearingY;
-        long         advance;
+        int  atlasX;
+        int  atlasY;
+        int  sizeX;
+        int  sizeY;
+        int  bearingX;
+        int  bearingY;
+        long advance;
+    };
+
+    struct Vertex {
+        glm::vec4 position;    // clip space
+        glm::vec2 texCoord;    // atlas pixels
+        glm::vec4 color;
     };
 
     GLManager *_glManager;
@@ -39,8 +47,42 @@ class RENDER_API Font : public Wasp::MyBase {
     int                  _size;
     unsigned int         _VAO, _VBO;
 
+    // Glyph bitmaps are packed into a single texture in rows ("shelves").
+    // A copy is kept on the host so the texture can be regrown.
+    //
+    unsigned int               _atlasTexture;
+    std::vector<unsigned char> _atlas;
+    int                        _atlasWidth;
+    int                        _atlasHeight;
+    int                        _shelfX;
+    int                        _shelfY;
+    int                        _shelfHeight;
+    glm::vec2                  _solidTexCoord;    // center of a fully opaque texel block
+
+    // Queued vertices are split into runs that share the depth test
+    // state in effect when they were queued; Flush() restores it per run.
+    //
+    struct DepthState {
+        bool test;
+        bool mask;
+        int  func;
+
+        bool operator==(const DepthState &s) const { return test == s.test && mask == s.mask && func == s.func; }
+    };
+    struct Run {
+        size_t     first;
+        DepthState depth;
+    };
+
+    std::vector<Vertex> _batch;
+    std::vector<Run>    _runs;
+
     bool  LoadGlyph(int c);
     Glyph GetGlyph(int c);
+    void  AllocateAtlasRegion(int w, int h, int &x, int &y);
+    void  ResizeAtlas(int width, int height);
+    void  BeginRun();
+    void  PushQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::mat4 &MVP, const glm::vec4 &color);
 
 public:
     Font(GLManager *glManager, const std::string &path, int size, FT_Library library = nullptr);
@@ -49,11 +91,33 @@ public:
     //! Draws text in pixel coordinates i.e. if font is 10px,
     //! text will be 10 OpenGL units tall.
     //!
+    //! If a text batch is open (see FontManager::BeginTextBatch) the text
+    //! is queued and drawn when the batch ends, otherwise it is drawn
+    //! immediately.
+    //!
     //! \param[in] text
     //! \param[in] color default is white
     //!
     void DrawText(const std::string &text, const glm::vec4 &color = glm::vec4(1));
 
+    //! Queues text to be drawn by the next call to Flush(). Glyph quads are
+    //! transformed by the current ModelViewProjection matrix when queued, so
+    //! text queued under different transforms is still drawn with a single
+    //! draw call. The depth test state is also captured, and Flush() draws
+    //! each run of text with the state it was queued under.
+    //!
+    void QueueText(const std::string &text, const glm::vec4 &color = glm::vec4(1));
+
+    //! Queues a solid rectangle, in the same pixel coordinates as text, to
+    //! be drawn by the next call to Flush(). Text backgrounds queued this
+    //! way are drawn in order with the text around them.
+    //!
+    void QueueRectangle(const glm::vec2 &min, const glm::vec2 &max, const glm::vec4 &color);
+
+    //! Draws all queued text
+    //!
+    void Flush();
+
     //! Returns pixel dimensions of text
     //!
     glm::vec2 TextDimensions(const std::string &text);
@@ -10,6 +10,7 @@ struct GLManager;
 class RENDER_API FontManager : public IResourceManager<std::pair<std::string, unsigned int>, Font> {
     GLManager *_glManager;
     FT_Library _library;
+    int        _batchDepth;
 
 public:
     FontManager(GLManager *glManager);
@@ -17,6 +18,14 @@ public:
 
     Font *GetFont(const std::string &name, unsigned int size);
     int   LoadResourceByKey(const std::pair<std::string, unsigned int> &key);
+
+    //! Defer Font::DrawText until EndTextBatch() so that all of the text
+    //! drawn with a given font and size is rendered with one draw call.
+    //! Batches may be nested; text is drawn when the outermost one ends.
+    //
+    void BeginTextBatch();
+    void EndTextBatch();
+    bool IsTextBatchOpen() const { return _batchDepth > 0; }
 };
 
 }    // namespace VAPoR
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vapor/MyBase.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+namespace VAPoR {
+
+class ImageWriter;
+
+//! \class FrameEncoder
+//! \brief Encode captured frames on background threads
+//!
+//! FrameEncoder moves image compression off of the rendering thread.
+//! Frames are placed on a bounded queue and written by a pool of
+//! encoder threads. When the queue is full Submit() blocks, so a capture
+//! that renders faster than frames can be written is throttled rather
+//! than accumulating unbounded memory.
+//!
+//! Frames may either be written to individual image files with an
+//! ImageWriter, or appended to a single uncompressed YUV4MPEG2 (.y4m)
+//! video stream opened with OpenStream(). Stream frames are converted in
+//! parallel but always written in submission order.
+//!
+//! Errors that occur on an encoder thread are reported by the next call
+//! to Submit(), Wait(), or CloseStream().
+//
+class RENDER_API FrameEncoder : public Wasp::MyBase {
+public:
+    //! \param[in] nthreads Number of encoder threads. If less than one
+    //! the number of Wasp::TaskScheduler threads, up to four, is used.
+    //! \param[in] maxQueued Maximum number of frames waiting to be
+    //! encoded. If zero, twice the number of threads is used.
+    //
+    FrameEncoder(int nthreads = 0, size_t maxQueued = 0);
+
+    //! Waits for all queued frames to be written and closes any open stream
+    //
+    virtual ~FrameEncoder();
+
+    //! Queue an RGB image to be written
+    //!
+    //! \param[in] writer The writer for the image. FrameEncoder takes
+    //! ownership of \p writer and deletes it once the image is written.
+    //! Writers for which ImageWriter::IsThreadSafe() is false are run
+    //! immediately on the calling thread.
+    //! \param[in,out] pixels Packed RGB pixels, top row first. The
+    //! contents are moved into the queue and \p pixels is left empty.
+    //! \param[in] width Image width
+    //! \param[in] height Image height
+    //!
+    //! \retval status A negative int is returned if this or a previously
+    //! queued frame could not be written
+    //
+    int Submit(ImageWriter *writer, std::vector<unsigned char> &pixels, int width, int height);
+
+    //! Open a YUV4MPEG2 video stream
+    //!
+    //! \param[in] path Output file
+    //! \param[in] width Frame width. All frames must have the same size.
+    //! \param[in] height Frame height
+    //! \param[in] fps Frame rate recorded in the stream header
+    //
+    int OpenStream(const std::string &path, int width, int height, int fps = 30);
+
+    //! Queue a frame to be appended to the open stream
+    //!
+    //! \p pixels are packed RGB, top row first, and are moved into the queue
+    //!
+    //! \sa OpenStream()
+    //
+    int SubmitStreamFrame(std::vector<unsigned char> &pixels, int width, int height);
+
+    //! Wait for queued stream frames and close the stream
+    //
+    int CloseStream();
+
+    bool IsStreamOpen() const { return (_stream != NULL); }
+
+    //! Block until all queued frames have been written
+    //!
+    //! \retval status A negative int is returned if any frame queued
+    //! since the last call to Wait() could not be written
+    //
+    int Wait();
+
+private:
+    class job_t {
+    public:
+        ImageWriter *              _writer;
+        std::vector<unsigned char> _pixels;
+        int                        _width;
+        int                        _height;
+        long                       _seq;    // Stream frame number, or -1
+    };
+
+    std::vector<std::thread> _threads;
+    std::deque<job_t *>      _queue;
+    size_t                   _maxQueued;
+    size_t                   _active;
+    bool                     _shutdown;
+    std::mutex               _mutex;
+    std::condition_variable  _workCV;
+    std::condition_variable  _doneCV;
+    std::vector<std::string> _failed;
+
+    FILE *      _stream;
+    std::string _streamPath;
+    int         _streamWidth;
+    int         _streamHeight;
+    long        _streamSubmitted;
+    long        _streamWritten;
+
+    void _worker();
+    void _encode(job_t *job);
+    void _enqueue(job_t *job);
+    int  _reportFailures();
+};
+
+};    // namespace VAPoR
@@ -90,6 +90,13 @@ public:
     virtual unsigned char *GetImage(size_t ts, const double pcsExtentsReq[4], string proj4StringReq, size_t maxWidthReq, size_t maxHeightReq, double pcsExtentsImg[4], double geoCornersImg[8],
                                     string &proj4StringImg, size_t &width, size_t &height) = 0;
 
+    //! Returns false if the image most recently returned by GetImage()
+    //! contains lower resolution placeholder content that is still being
+    //! loaded. Calling GetImage() again with the same arguments will return
+    //! a more refined image once loading has progressed.
+    //
+    virtual bool IsImageComplete() const { return (true); }
+
 protected:
     int _pixelsize;
     int _nbands;
@@ -103,6 +110,13 @@ protected:
 
     int TiffReadImage(int dirnum, unsigned char *texture) const;
 
+    // While msg is non-NULL, errors raised on the calling thread by the
+    // Tiff routines above are stored in *msg rather than reported with
+    // MyBase::SetErrMsg(), whose state is shared by all threads. Used by
+    // threads that decode images in the background.
+    //
+    static void SetThreadErrMsg(string *msg);
+
     TIFF *TiffGetHandle() const { return (_tif); }
 
     int CornerExtents(const double srccoords[4], double dstcoords[4], string proj4src) const;
@@ -12,6 +12,13 @@
 #include <sstream>
 #include <fstream>
 #include <sys/stat.h>
+#include <list>
+#include <map>
+#include <deque>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <vapor/MyBase.h>
 #include <vapor/UDUnitsClass.h>
 #include "GeoTileMercator.h"
@@ -23,10 +30,35 @@ namespace VAPoR {
 //! \brief A class for managing OSGeo Tile Map Service Specification images
 //! \author John Clyne
 //!
+//! Tiles are decoded by a pool of background threads and kept in a
+//! bounded, least-recently-used cache. When a requested tile has not
+//! been decoded yet the corresponding region of the nearest coarser
+//! resolution tile that is resident is upsampled in its place, and
+//! IsImageComplete() returns false until every tile of the most recent
+//! request has arrived. Tiles neighbouring the requested region, and
+//! the tiles one LOD above and below it, are prefetched.
 //
 class RENDER_API GeoImageTMS : public GeoImage {
 public:
-    GeoImageTMS();
+    //! Tile cache counters
+    //
+    class CacheStats {
+    public:
+        size_t hits;            // Requested tiles that were resident
+        size_t misses;          // Requested tiles that were not resident
+        size_t placeholders;    // Misses served from a coarser LOD tile
+        size_t prefetches;      // Tiles queued for prefetch
+        size_t prefetchHits;    // Hits on tiles that were loaded by prefetch
+        size_t evictions;       // Tiles dropped to respect the capacity
+        size_t resident;        // Tiles currently held in the cache
+        size_t pending;         // Tiles queued or being decoded
+    };
+
+    //! \param[in] nthreads Number of tile decoding threads. If less than
+    //! one the number of Wasp::TaskScheduler threads, up to four, is used.
+    //! \param[in] capacity Maximum number of decoded tiles to retain
+    //
+    GeoImageTMS(int nthreads = 0, size_t capacity = 256);
     virtual ~GeoImageTMS();
 
     int Initialize(string path, vector<double> times);
@@ -38,7 +70,52 @@ public:
     unsigned char *GetImage(size_t ts, const double pcsExtentsReq[4], string proj4StringReq, size_t maxWidthReq, size_t maxHeightReq, double pcsExtentsImg[4], double geoCornersImg[8],
                             string &proj4StringImg, size_t &width, size_t &height);
 
+    bool IsImageComplete() const { return (_imageComplete); }
+
+    //! Enable or disable placeholder substitution
+    //!
+    //! If \p enable is false GetImage() blocks until all of the tiles it
+    //! needs are decoded. Tiles are still decoded in parallel and
+    //! prefetching still takes place. The default is true.
+    //
+    void SetAsync(bool enable) { _async = enable; }
+
+    //! Set the maximum number of decoded tiles retained
+    //!
+    //! The capacity is exceeded temporarily if a single request needs
+    //! more tiles than it allows.
+    //
+    void SetCacheCapacity(size_t ntiles);
+
+    CacheStats GetCacheStats() const;
+    void       ResetCacheStats();
+
 private:
+    // Request for a tile to be decoded. Requests from a previous
+    // Initialize() are recognized by their generation and discarded.
+    //
+    class tileReq_t {
+    public:
+        string _quadkey;
+        string _dir;
+        size_t _size;    // bytes per tile
+        size_t _tileX;
+        size_t _tileY;
+        int    _lod;
+        long   _generation;
+    };
+
+    // A decoded tile waiting to be inserted into the GeoTile
+    //
+    class tileDone_t {
+    public:
+        string                _quadkey;
+        vector<unsigned char> _pixels;
+        bool                  _ok;
+        bool                  _prefetched;
+        string                _errMsg;    // reason the tile could not be read
+    };
+
     string _dir;           // path to TMS directory
     int    _maxLOD;        // Maximum LOD available in TMS
     int    _currentLOD;    // Current LOD in TMS
@@ -51,6 +128,32 @@ private:
 
     GeoTileMercator *_geotile;
 
+    // LRU order of the real tiles held by _geotile, most recent first.
+    // The LOD 0 tile is never evicted.
+    //
+    std::list<string>                             _lru;
+    std::map<string, std::list<string>::iterator> _lruPos;
+    std::set<string>                              _prefetchedResident;
+    std::map<string, string>                      _failedTiles;    // quadkey to error message
+    size_t                                        _capacity;
+    bool                                          _async;
+    bool                                          _imageComplete;
+    CacheStats                                    _stats;
+
+    // State shared with the decoding threads, guarded by _mutex
+    //
+    std::vector<std::thread> _threads;
+    std::deque<tileReq_t>    _demandQueue;
+    std::deque<tileReq_t>    _prefetchQueue;
+    std::set<string>         _pending;            // queued or in flight
+    std::set<string>         _pendingPrefetch;    // in _prefetchQueue
+    std::deque<tileDone_t>   _done;
+    long                     _generation;
+    bool                     _shutdown;
+    mutable std::mutex       _mutex;
+    std::condition_variable  _workCV;
+    std::condition_variable  _doneCV;
+
     string _defaultProj4String;    // proj4 string for global mercator
 
     int _tileSize(string dir, size_t tileX, size_t tileY, int lod, size_t &w, size_t &h);
@@ -60,6 +163,16 @@ private:
     int _getBestLOD(const double myGeoExtentsData[4], int maxWidthReq, int maxHeightReq) const;
 
     int _getMap(const size_t pixelSW[2], const size_t pixelNE[2], int lod, unsigned char *texture);
+
+    void _worker();
+    void _stopThreads();
+    bool _request(size_t tileX, size_t tileY, int lod, bool prefetch);
+    void _prefetch(size_t tileX0, size_t tileY0, size_t nxtiles, size_t nytiles, int lod);
+    void _collect();
+    void _insertTile(const string &quadkey, const unsigned char *pixels, bool prefetched);
+    void _touch(const string &quadkey);
+    void _evict(size_t keep);
+    bool _makePlaceholder(size_t tileX, size_t tileY, int lod, unsigned char *tile) const;
 };
 
 };    // namespace VAPoR
@@ -73,6 +73,21 @@ public:
     //
     int Insert(std::string quadkey, const unsigned char *image);
 
+    //! Remove an image tile from the class object
+    //!
+    //! Frees the storage for the tile associated with \p quadkey. Nothing
+    //! is done if no such tile has been inserted.
+    //!
+    //! \param[in] quadkey A Quad Key
+    //!
+    //! \sa Insert()
+    //
+    void Remove(std::string quadkey);
+
+    //! Return the number of image tiles currently held by the object
+    //
+    size_t GetNumTiles() const { return (_tiles.size()); }
+
     //! Converts a point from latitude/longitude WGS-84 coordinates (in degrees)
     //! into pixel XY coordinates at a specified level of detail.
     //!
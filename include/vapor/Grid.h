@@ -9,6 +9,7 @@
 #include <limits>
 #include "vapor/VAssert.h"
 #include <memory>
+#include <functional>
 #include <vapor/common.h>
 
 #ifdef WIN32
@@ -20,6 +21,8 @@ namespace VAPoR {
 using DblArr3 = std::array<double, 3>;
 using Size_tArr3 = std::array<size_t, 3>;
 
+class BlockPager;
+
 //! \class Grid
 //! \brief Abstract base class for a 2D or 3D structured or unstructured
 //!  grid.
@@ -137,8 +140,38 @@ public:
     //! Return the internal data structure containing a copy of the blocks
     //! passed in by the constructor
     //!
+    //! The block pointers of a grid backed by a BlockPager are NULL.
+    //!
+    //! \sa SetBlockPager()
+    //
     const std::vector<float *> &GetBlks() const { return (_blks); };
 
+    //! Back the grid's data blocks with a BlockPager
+    //!
+    //! Data blocks are no longer held by the grid but acquired from
+    //! \p pager when they are accessed, which allows grids that are
+    //! larger than memory to be traversed with a bounded amount of memory.
+    //! Block \a i of \p pager corresponds to block \a i of the
+    //! blocks passed to the constructor, and the grid must have been
+    //! constructed without blocks (dataless) with the same dimensions
+    //! and block size.
+    //!
+    //! A paged grid is read only: SetValue() has no effect, and values
+    //! written through an Iterator may be lost when their block is
+    //! evicted. Values are best accessed with ParallelForEach(), which
+    //! acquires each block once. An iterator visits values in index order
+    //! and so returns to a block for each of its rows; unless a slab of
+    //! blocks along the slowest axis fits in the resident set, blocks are
+    //! read more than once. Each call to GetValueAtIndex() acquires and
+    //! releases a block.
+    //
+    void SetBlockPager(const std::shared_ptr<BlockPager> &pager);
+
+    //! Return the pager backing the grid's blocks, or an empty pointer if
+    //! the blocks are held in memory
+    //
+    const std::shared_ptr<BlockPager> &GetBlockPager() const { return (_pager); }
+
     //! Get the data value at the indicated grid point
     //!
     //! This method provides read access to the scalar data value
@@ -246,6 +279,55 @@ public:
         return (GetValue(coords));
     }
 
+    //! Cell location and interpolation weights for a point
+    //!
+    //! The contents of a stencil are specific to the type of grid that
+    //! computed it.
+    //!
+    //! \sa GetInterpolationStencil(), InterpolateStencil()
+    //
+    class InterpolationStencil {
+    public:
+        bool       inside;     // false if the point is outside of the grid
+        int        order;      // interpolation order
+        Size_tArr3 indices;    // cell, or for order 0 node, indices
+        double     wgts[6];    // interpolation weights
+    };
+
+    //! Locate a point for later interpolation
+    //!
+    //! Finding the cell containing a point usually dominates the cost of
+    //! GetValue(). This method performs only the search, using the grid's
+    //! current interpolation order, and records the result in \p stencil.
+    //! The stencil may then be evaluated with InterpolateStencil() on this
+    //! grid, or on any other grid of the same type, node dimensions,
+    //! coordinates, and interpolation order. Several variables sampled on
+    //! the same mesh can thus share one search.
+    //!
+    //! \param[in] coords Coordinates of the point
+    //! \param[out] stencil Location of the point. A point outside of the
+    //! grid is not an error; evaluating its stencil yields the missing
+    //! value.
+    //!
+    //! \retval bool False if the grid type, or its current interpolation
+    //! order, does not support stencils. GetValue() must be used instead.
+    //!
+    //! \sa InterpolateStencil()
+    //
+    bool GetInterpolationStencil(const DblArr3 &coords, InterpolationStencil &stencil) const;
+
+    //! Interpolate the grid at a previously located point
+    //!
+    //! Returns the same value GetValue() returns at the point \p stencil
+    //! was computed for.
+    //!
+    //! \param[in] stencil A stencil returned by GetInterpolationStencil()
+    //! for this grid or for a grid with identical geometry
+    //!
+    //! \sa GetInterpolationStencil()
+    //
+    float InterpolateStencil(const InterpolationStencil &stencil) const;
+
     //! Return the extents of the user coordinate system
     //!
     //! This pure virtual method returns min and max extents of
@@ -524,6 +606,99 @@ public:
         GetRange(min3, max3, range);
     }
 
+    //! A contiguous run of data values
+    //!
+    //! A span describes \a n consecutive data values along the fastest
+    //! varying grid axis that are stored contiguously in memory, i.e.
+    //! that lie within a single block. \a data points to the first value, and
+    //! \a index contains the grid indices of the first value.
+    //!
+    //! \sa ParallelForEach(), ParallelReduce()
+    //
+    class Span {
+    public:
+        const float *data;
+        size_t       n;
+        Size_tArr3   index;
+    };
+
+    //! Invoke a function on every span of data values inside a box
+    //!
+    //! The index space box with corners \p min and \p max, inclusive, is
+    //! decomposed into spans (see Span), and \p fn is invoked once for
+    //! each span. The rows of the box along the fastest varying axis are
+    //! divided into slots that run as Wasp::TaskScheduler tasks, so \p fn
+    //! may be called concurrently. The first argument passed to \p fn is
+    //! the slot number, an integer between 0 and GetNumThreads(\p nthreads)
+    //! - 1. A slot is never run by two threads at once, so it may index
+    //! per-thread state. Each row is processed by a single slot. Small
+    //! boxes are processed serially on the calling thread.
+    //!
+    //! Unlike ConstIterator, spans allow inner loops over data values that
+    //! the compiler can vectorize. No spans are generated for dataless grids.
+    //!
+    //! For a grid backed by a BlockPager the box is instead divided by
+    //! blocks, each of which is acquired once and processed by a single
+    //! thread, and rows that cross blocks are split between threads.
+    //!
+    //! \param[in] min Minimum grid indices of the box. Indices are clamped
+    //! to GetDimensions().
+    //! \param[in] max Maximum grid indices of the box
+    //! \param[in] fn Function invoked on each span
+    //! \param[in] nthreads The maximum number of slots. If less than one
+    //! the number of TaskScheduler threads is used.
+    //!
+    //! \sa ParallelReduce()
+    //
+    void ParallelForEach(const Size_tArr3 &min, const Size_tArr3 &max, const std::function<void(int, const Span &)> &fn, int nthreads = 0) const;
+
+    //! Invoke a function on every span of data values in the grid
+    //!
+    //! \sa ParallelForEach(const Size_tArr3 &, const Size_tArr3 &, const std::function<void(int, const Span &)> &, int)
+    //
+    void ParallelForEach(const std::function<void(int, const Span &)> &fn, int nthreads = 0) const;
+
+    //! Reduce the data values inside a box in parallel
+    //!
+    //! Every slot of ParallelForEach() accumulates a partial
+    //! result, initialized to \p identity, by invoking
+    //! \p spanOp(partial, span) on each of its spans. The partial results
+    //! are then folded together, in slot order, with
+    //! \p combine(result, partial).
+    //!
+    //! For example, the following sums the values of a grid without
+    //! missing values:
+    //!
+    //! \code
+    //! double sum = grid->ParallelReduce(
+    //!     min, max, 0.0,
+    //!     [](double &s, const Grid::Span &span) {
+    //!         for (size_t i = 0; i < span.n; i++) s += span.data[i];
+    //!     },
+    //!     [](double a, double b) { return (a + b); });
+    //! \endcode
+    //!
+    //! \sa ParallelForEach()
+    //
+    template<typename T, typename SpanOp, typename Combine>
+    T ParallelReduce(const Size_tArr3 &min, const Size_tArr3 &max, const T &identity, SpanOp spanOp, Combine combine, int nthreads = 0) const
+    {
+        std::vector<T> partial(GetNumThreads(nthreads), identity);
+        ParallelForEach(
+            min, max, [&partial, &spanOp](int thread, const Span &span) { spanOp(partial[thread], span); }, nthreads);
+
+        T result = identity;
+        for (const auto &p : partial) result = combine(result, p);
+        return (result);
+    }
+
+    //! Return the maximum number of threads used by ParallelForEach()
+    //!
+    //! \param[in] nthreads The number of threads requested. If less than one
+    //! the number of Wasp::TaskScheduler threads is returned.
+    //
+    static int GetNumThreads(int nthreads);
+
     //! Return true if the specified point lies inside the grid
     //!
     //! This method can be used to determine if a point expressed in
@@ -1124,6 +1299,9 @@ public:
             std::swap(a._xb, b._xb);
             std::swap(a._itr, b._itr);
             std::swap(a._pred, b._pred);
+            std::swap(a._pager, b._pager);
+            std::swap(a._blkRef, b._blkRef);
+            std::swap(a._blkIndex, b._blkIndex);
         }
 
     private:
@@ -1140,6 +1318,12 @@ public:
         size_t               _xb;            // x index within a block
         float *              _itr;
         InsideBox            _pred;
+
+        std::shared_ptr<BlockPager> _pager;
+        std::shared_ptr<float>      _blkRef;      // acquired block of a paged grid
+        size_t                      _blkIndex;    // index of _blkRef
+
+        float *_blockData(size_t blk);
     };
 
     typedef Grid::ForwardIterator<Grid>       Iterator;
@@ -1163,6 +1347,26 @@ protected:
 
     virtual float GetValueLinear(const DblArr3 &coords) const = 0;
 
+    //! Locate \p coords, which have already been clamped with
+    //! ClampCoord(), for interpolation of order \p stencil.order. Derived
+    //! classes supporting stencils must set every field of \p stencil
+    //! that InterpolateStencilHelper() reads, and may change its order
+    //! to the one actually used. Return false if unsupported.
+    //
+    virtual bool GetInterpolationStencilHelper(const DblArr3 &coords, InterpolationStencil &stencil) const { return (false); }
+
+    //! Evaluate a stencil computed by GetInterpolationStencilHelper() for
+    //! a point inside of the grid
+    //
+    virtual float InterpolateStencilHelper(const InterpolationStencil &stencil) const { return (GetMissingValue()); }
+
+    //! Interpolate at \p coords with the given order by computing and
+    //! evaluating a stencil. Derived classes whose interpolation is
+    //! implemented by stencils use this for GetValueNearestNeighbor() and
+    //! GetValueLinear().
+    //
+    float GetValueWithStencil(const DblArr3 &coords, int order) const;
+
     virtual void GetUserExtentsHelper(DblArr3 &minu, DblArr3 &maxu) const = 0;
 
     virtual float *GetValuePtrAtIndex(const std::vector<float *> &blks, const Size_tArr3 &indices) const;
@@ -1213,7 +1417,11 @@ private:
     mutable DblArr3      _minuCache = {{std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()}};
     mutable DblArr3      _maxuCache = {{std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()}};
 
+    std::shared_ptr<BlockPager> _pager;    // source of the blocks if not in memory
+
     virtual void _getUserCoordinatesHelper(const std::vector<double> &coords, double &x, double &y, double &z) const;
+
+    void _getBlockOffset(const Size_tArr3 &indices, size_t &blk, size_t &offset) const;
 };
 };    // namespace VAPoR
 #endif
@@ -46,6 +46,7 @@ private:
     GLsizei        _texHeight;
     const int      _maxResamplingResolution;
     size_t         _cacheTimestep;
+    double         _cacheDefaultZ;
     int            _cacheRefLevel;
     int            _cacheLod;
     int            _cacheTMSLOD;
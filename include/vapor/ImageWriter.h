@@ -15,6 +15,13 @@ public:
     virtual int Write(const unsigned char *buffer, const unsigned int width, const unsigned int height) = 0;
     virtual ~ImageWriter(){};
 
+    //! Return true if instances may write concurrently from different
+    //! threads
+    //
+    virtual bool IsThreadSafe() const { return (true); }
+
+    const std::string &GetPath() const { return (path); }
+
     static ImageWriter *CreateImageWriterForFile(const std::string &path);
     static void         RegisterFactory(ImageWriterFactory *factory);
 
@@ -174,6 +174,10 @@ private:
 
     virtual float GetValueLinear(const DblArr3 &coords) const override;
 
+    virtual bool GetInterpolationStencilHelper(const DblArr3 &coords, InterpolationStencil &stencil) const override;
+
+    virtual float InterpolateStencilHelper(const InterpolationStencil &stencil) const override;
+
     //!
     //! Return the bilinear interpolation weights of a point given in user
     //! coordinates.  These weights apply to the x (iwgt) and y (jwgt) axes.
@@ -9,6 +9,11 @@ class PARAMS_API ModelParams : public RenderParams {
 public:
     static const std::string FileTag;
 
+    //! Merge all meshes that share a material into a single draw call.
+    //! Intended for very large models; repeated meshes are no longer
+    //! instanced and use more GPU memory.
+    static const std::string MergeMeshesTag;
+
     ModelParams(DataMgr *dataMgr, ParamsBase::StateSave *ssave);
     ModelParams(DataMgr *dataMgr, ParamsBase::StateSave *ssave, std::string classType);
     ModelParams(DataMgr *dataMgr, ParamsBase::StateSave *ssave, XmlNode *node);
@@ -38,6 +38,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace VAPoR {
 
@@ -61,17 +62,53 @@ public:
     virtual void _clearCache() {}
 
 private:
+    //! A model file. Each aiMesh is uploaded once to indexed vertex buffers
+    //! and drawn instanced, once per node that references it, with the
+    //! node transforms flattened at upload time. In merged (large model)
+    //! mode all meshes sharing a material are instead baked into a single
+    //! buffer and drawn with one call.
+    //
     class Model {
-        Assimp::Importer _importer;
-        const aiScene *  _scene;
-        glm::vec3        _min, _max;
+        struct Vertex {
+            glm::vec3 position;
+            glm::vec3 normal;
+            glm::vec4 color;
+        };
+
+        // Per instance attributes. Normals are transformed by the inverse
+        // transpose of the upper 3x3 of the node transform so that they
+        // stay perpendicular to surfaces under non-uniform scaling.
+        //
+        struct Instance {
+            glm::mat4 transform;
+            glm::mat3 normalMatrix;
+        };
+
+        struct GPUMesh {
+            unsigned int VAO = 0, VBO = 0, EBO = 0, instanceVBO = 0;
+            size_t       nIndices = 0;
+            size_t       nInstances = 0;
+            bool         hasNormals = false;
+        };
+
+        Assimp::Importer     _importer;
+        const aiScene *      _scene = nullptr;
+        glm::vec3            _min, _max;
+        std::vector<GPUMesh> _meshes;
+        bool                 _uploaded = false;
+        bool                 _uploadedMerged = false;
 
-        void      renderNode(GLManager *gl, const aiNode *nd) const;
         void      calculateBounds(const aiNode *nd, glm::mat4 transform = glm::mat4(1.0f));
+        void      collectInstances(const aiNode *nd, glm::mat4 transform, std::vector<std::vector<glm::mat4>> &instances) const;
+        void      appendMesh(const aiMesh *mesh, const glm::mat4 *bake, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices) const;
+        void      uploadMesh(GPUMesh &g, const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, const std::vector<glm::mat4> &instances) const;
+        void      upload(bool merge);
+        void      releaseGPU();
         glm::mat4 getMatrix(const aiNode *nd) const;
 
     public:
-        void      Render(GLManager *gl) const;
+        ~Model();
+        void      Render(GLManager *gl, const glm::vec3 &lightDir, bool merge);
         void      DrawBoundingBox(GLManager *gl) const;
         int       Load(const std::string &path);
         glm::vec3 BoundsMin() const { return _min; }
@@ -96,7 +133,7 @@ private:
     public:
         ~Scene();
         int       Load(const std::string &path);
-        void      Render(GLManager *gl, const int ts = 0);
+        void      Render(GLManager *gl, const glm::vec3 &lightDir, bool merge, const int ts = 0);
         glm::vec3 Center() const;
 
     private:
@@ -115,8 +152,6 @@ private:
 
     Scene       _scene;
     std::string _cachedFile;
-
-    void _renderNode(const aiNode *node);
 };
 
 };    // namespace VAPoR
@@ -123,8 +123,32 @@ public:
     //! this variable will be used to determine the time associated with each
     //! time step of a variable.
     //!
+    //! \note File headers are scanned once, with the file system reads
+    //! for all files issued in parallel. Unless disabled with
+    //! SetUseMetadataIndex(), the metadata gathered from each file, and
+    //! the values of any time coordinate variables, are saved in a hidden
+    //! index file in the file's directory. Files whose size and
+    //! modification time match their index entry are not rescanned by
+    //! subsequent calls.
+    //
     virtual int Initialize(const std::vector<string> &files, const std::vector<string> &time_dimnames, const std::vector<string> &time_coordvar);
 
+    //! Enable or disable the persistent metadata index
+    //!
+    //! \param[in] enable If true (the default) Initialize() reads and
+    //! updates metadata index files. Failure to write an index (e.g.
+    //! because a directory is read-only) is not an error.
+    //!
+    //! \sa Initialize()
+    //
+    static void SetUseMetadataIndex(bool enable) { _useMetadataIndex = enable; }
+
+    //! Return true if the persistent metadata index is enabled
+    //!
+    //! \sa SetUseMetadataIndex()
+    //
+    static bool GetUseMetadataIndex() { return (_useMetadataIndex); }
+
     //! Return a boolean indicating whether a variable exists in the
     //! data collection.
     //!
@@ -786,6 +810,21 @@ private:
     std::vector<string>              _failedVars;    // Varibles that could not be added
     std::map<string, DerivedVar *>   _derivedVarsMap;
     DerivedVar *                     _derivedVar;    // if current opened variable is derived this is it
+    static bool                      _useMetadataIndex;
+
+    //
+    // Metadata index entry for a file
+    //
+    class indexEntry {
+    public:
+        indexEntry() : _size(0), _mtime(0), _dirty(false) {}
+        long long                             _size;
+        long long                             _mtime;
+        string                                _metadata;    // NetCDFSimple::WriteMetadata()
+        std::map<string, std::vector<double>> _tcvs;        // time coordinate values
+        bool                                  _dirty;
+    };
+    std::map<string, indexEntry> _index;    // keyed by file path
 
     //
     // file handle for an open variable
@@ -814,15 +853,19 @@ private:
 
     void ReInitialize();
 
+    int _ScanFiles(const std::vector<string> &files);
+
+    void _WriteIndex() const;
+
     int _InitializeTimesMap(const std::vector<string> &files, const std::vector<string> &time_dimnames, const std::vector<string> &time_coordvars, std::map<string, std::vector<double>> &timesMap,
-                            std::vector<double> &times, int &file_org) const;
+                            std::vector<double> &times, int &file_org);
 
     int _InitializeTimesMapCase1(const std::vector<string> &files, std::map<string, std::vector<double>> &timesMap) const;
 
     int _InitializeTimesMapCase2(const std::vector<string> &files, const std::vector<string> &time_dimnames, std::map<string, std::vector<double>> &timesMap) const;
 
     int _InitializeTimesMapCase3(const std::vector<string> &files, const std::vector<string> &time_dimnames, const std::vector<string> &time_coordvars,
-                                 std::map<string, std::vector<double>> &timesMap) const;
+                                 std::map<string, std::vector<double>> &timesMap);
 
     void _InterpolateLine(const float *src, size_t n, size_t stride, bool has_missing, float mv, float *dst) const;
 
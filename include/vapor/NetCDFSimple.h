@@ -112,6 +112,7 @@ public:
         void SetAtt(string name, const string &values) { _str_atts.push_back(make_pair(name, values)); }
 
         VDF_API friend std::ostream &operator<<(std::ostream &o, const Variable &var);
+        friend class NetCDFSimple;
         VDF_API friend bool          operator==(const Variable &v1, const Variable &v2)
         {
             return ((v1._name == v2._name) && (v1._dimnames == v2._dimnames) && (v1._flt_atts == v2._flt_atts) && (v1._int_atts == v2._int_atts) && (v1._str_atts == v2._str_atts)
@@ -138,6 +139,57 @@ public:
     //!
     int Initialize(string path);
 
+    //! Write the file's metadata to a stream
+    //!
+    //! This method writes all of the metadata collected by Initialize()
+    //! (dimensions, attributes, and variables) in a compact binary form
+    //! that may be restored with ReadMetadata(). The encoding is native
+    //! to the host and is intended only for caching.
+    //!
+    //! \param[out] o Output stream
+    //!
+    //! \sa ReadMetadata()
+    //
+    void WriteMetadata(std::ostream &o) const;
+
+    //! Initialize the class instance from cached metadata
+    //!
+    //! This method is an alternative to Initialize() that restores
+    //! metadata previously written with WriteMetadata() rather than
+    //! reading it from the netCDF file. The file is not opened until a
+    //! variable is opened with OpenRead().
+    //!
+    //! \param[in] in Input stream positioned at metadata written by
+    //! WriteMetadata()
+    //! \param[in] path Path to the netCDF file the metadata describe
+    //!
+    //! \retval status A negative int is returned if the metadata could not
+    //! be decoded
+    //!
+    //! \sa WriteMetadata()
+    //
+    int ReadMetadata(std::istream &in, string path);
+
+    //! Set the maximum number of idle netCDF files kept open
+    //!
+    //! netCDF file handles are shared by all instances of this class and
+    //! are not closed when the last variable open on a file is closed.
+    //! Instead, up to \p n files that are not in use are kept open, and the
+    //! least recently used are closed when the limit is exceeded. Files
+    //! with open variables are never closed, so the limit may be exceeded
+    //! temporarily. A value of zero closes files as soon as they are no
+    //! longer in use. The default is 64.
+    //!
+    //! \param[in] n Maximum number of open, unused files
+    //
+    static void SetMaxOpenFiles(size_t n);
+
+    //! Return the maximum number of idle netCDF files kept open
+    //!
+    //! \sa SetMaxOpenFiles()
+    //
+    static size_t GetMaxOpenFiles();
+
     //! Open the named variable for reading
     //!
     //! This method prepares a netCDF variable
@@ -338,6 +390,8 @@ private:
     std::vector<std::pair<string, string>>              _str_atts;
     std::vector<NetCDFSimple::Variable>                 _variables;
 
+    int _GetMetadata(int ncid);
+
     int _GetAtts(int ncid, int varid, std::vector<std::pair<string, std::vector<double>>> &flt_atts, std::vector<std::pair<string, std::vector<long>>> &int_atts,
                  std::vector<std::pair<string, string>> &str_atts);
 };
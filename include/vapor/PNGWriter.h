@@ -11,5 +11,10 @@ public:
 
     static std::vector<std::string> GetFileExtensions();
     int                             Write(const unsigned char *buffer, const unsigned int width, const unsigned int height);
+
+    //! Return false if images are encoded by the Python interpreter,
+    //! which is the case only when the build did not find libpng
+    //
+    bool IsThreadSafe() const;
 };
 }    // namespace VAPoR
@@ -510,6 +510,9 @@ public:
 
     //! Reinit state saving
     //!
+    //! Make the current state the base state for undo/redo. Since
+    //! undo/redo entries are recorded as differences relative to the
+    //! base state any existing undo/redo history is discarded.
     //!
     void RebaseStateSave() { _ssave.Rebase(); }
 
@@ -542,11 +545,7 @@ private:
             emitStateChange();
         }
 
-        void Rebase()
-        {
-            if (_state0) delete _state0;
-            _state0 = _rootNode ? new XmlNode(*_rootNode) : NULL;
-        }
+        void Rebase();
         void Save(const XmlNode *node, string description);
         void BeginGroup(string descripion);
         void EndGroup();
@@ -567,9 +566,13 @@ private:
         }
         bool GetUndoEnabled() const { return _addToUndoEnabled; }
 
-        const XmlNode *GetTopUndo(string &description) const;
-        const XmlNode *GetTopRedo(string &description) const;
-        const XmlNode *GetBase() const { return (_state0); }
+        const XmlNodeDiff *GetTopUndo(string &description) const;
+        const XmlNodeDiff *GetTopRedo(string &description) const;
+
+        // Return the state at the top of the undo stack, or the base
+        // state if the undo stack is empty
+        //
+        const XmlNode *GetCurrent() const { return (_current); }
 
         bool Undo();
         bool Redo();
@@ -588,17 +591,22 @@ private:
         bool           _addToUndoEnabled = true;
         int            _stackSize;
         const XmlNode *_rootNode;
-        const XmlNode *_state0;
 
-        std::stack<string>                       _groups;
-        std::deque<std::pair<string, XmlNode *>> _undoStack;
-        std::deque<std::pair<string, XmlNode *>> _redoStack;
+        // Shadow copy of the most recently saved state. Undo and redo
+        // stack entries are differences relative to this tree.
+        //
+        XmlNode *_current;
+
+        std::stack<string>                           _groups;
+        std::deque<std::pair<string, XmlNodeDiff *>> _undoStack;
+        std::deque<std::pair<string, XmlNodeDiff *>> _redoStack;
 
         std::vector<bool *>                _stateChangeFlags;
         std::vector<std::function<void()>> _stateChangeCBs;
         std::vector<std::function<void()>> _intermediateStateChangeCBs;
 
-        void cleanStack(int maxN, std::deque<std::pair<string, XmlNode *>> &s);
+        void cleanStack(int maxN, std::deque<std::pair<string, XmlNodeDiff *>> &s);
+        void pushUndo(string description, XmlNodeDiff *diff);
         void emitStateChange();
         void emitIntermediateStateChange();
     };
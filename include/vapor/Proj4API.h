@@ -16,7 +16,16 @@ namespace VAPoR {
 //!
 class VDF_API Proj4API : public Wasp::MyBase {
 public:
-    Proj4API();
+    //! Constructor
+    //!
+    //! \param[in] nthreads Maximum number of threads used to transform
+    //! large coordinate arrays. Arrays are split into contiguous chunks,
+    //! each transformed by a Wasp::TaskScheduler task with its own proj4
+    //! context. If \p nthreads is less than one the number of scheduler
+    //! threads is used.
+    //! Small arrays are always transformed serially.
+    //
+    Proj4API(int nthreads = 0);
     ~Proj4API();
 
     //! Initialize the class
@@ -123,11 +132,14 @@ public:
 private:
     void *_pjSrc;
     void *_pjDst;
+    int   _nthreads;
 
     int _Initialize(string srcdef, string dstdef, void **pjSrc, void **pjDst) const;
 
     int _Transform(void *pjSrc, void *pjDst, double *x, double *y, double *z, size_t n, int offset) const;
 
+    int _TransformParallel(void *pjSrc, void *pjDst, double *x, double *y, double *z, size_t n, int offset, int nthreads) const;
+
     int _Transform(void *pjSrc, void *pjDst, float *x, float *y, float *z, size_t n, int offset) const;
 };
 };    // namespace VAPoR
@@ -2,6 +2,7 @@
 #include <vapor/MyPython.h>
 #include <vapor/DataMgr.h>
 #include <vapor/DC.h>
+#include <vapor/unique_ptr_cache.hpp>
 
 #pragma once
 
@@ -28,6 +29,7 @@ public:
     {
         VAssert(dataMgr != NULL);
         _dataMgr = dataMgr;
+        _zeroCopy = false;
     }
 
     ~PyEngine();
@@ -127,6 +129,28 @@ public:
     //
     string GetFunctionStdout(string name) const;
 
+    //! Enable or disable zero-copy script inputs
+    //!
+    //! When enabled, input variables whose data are stored contiguously
+    //! by the DataMgr are passed to scripts as read-only NumPy arrays that
+    //! reference the DataMgr's memory directly, rather than as writeable
+    //! copies. Scripts that modify their input arrays in place, such as
+    //! \c U \c *= \c 2, fail in this mode, so it is disabled by default
+    //! and should only be enabled for scripts known not to do so.
+    //!
+    //! \param[in] enable Boolean indicating whether inputs may be passed
+    //! without copying
+    //!
+    //! \sa GetZeroCopyInputs()
+    //
+    void SetZeroCopyInputs(bool enable);
+
+    //! Return true if zero-copy script inputs are enabled
+    //!
+    //! \sa SetZeroCopyInputs()
+    //
+    bool GetZeroCopyInputs() const { return (_zeroCopy); }
+
     //! Execute a NumPy script
     //!
     //! This static method executes the NumPy script \p script and copies the
@@ -199,6 +223,21 @@ private:
         //!
         string GetScriptStdout() const { return (_stdoutString); }
 
+        //! Enable or disable zero-copy script inputs
+        //!
+        //! \sa PyEngine::SetZeroCopyInputs()
+        //
+        void SetZeroCopy(bool enable) { _zeroCopy = enable; }
+
+        //! Discard any cached script results
+        //!
+        //! Results computed over the entire domain are cached so that
+        //! subsequent requests for different regions at the same time
+        //! step, level, and lod do not re-execute the script. The cache
+        //! must be cleared whenever the script or its inputs change.
+        //
+        void ClearCache() { _resultCache.clear(); }
+
     private:
         DC::DataVar         _varInfo;
         std::vector<string> _inNames;
@@ -209,6 +248,9 @@ private:
         vector<size_t>      _dims;
         bool                _meshMatchFlag;
         string              _stdoutString;
+        bool                _zeroCopy;
+
+        unique_ptr_cache<string, std::vector<float>> _resultCache;
 
         int _readRegionAll(int fd, const std::vector<size_t> &min, const std::vector<size_t> &max, float *region);
 
@@ -236,15 +278,21 @@ private:
     std::map<string, func_c> _functions;
     std::map<string, string> _functionsStdio;
     DataMgr *                _dataMgr;
+    bool                     _zeroCopy;
     static bool              _isInitialized;
 
-    PyEngine() : _dataMgr(NULL) {}
+    PyEngine() : _dataMgr(NULL), _zeroCopy(false) {}
+
+    void _clearCaches();
+
+    static int _calculate(const string &script, const vector<string> &inputVarNames, const vector<vector<size_t>> &inputVarDims, const vector<float *> &inputVarArrays,
+                          const vector<bool> &inputReadOnly, const vector<string> &outputVarNames, const vector<vector<size_t>> &outputVarDims, const vector<float *> &outputVarArrays);
 
     static void _cleanupDict(PyObject *mainDict, vector<string> keynames);
 
-    static int _c2python(PyObject *dict, vector<string> inputVarNames, vector<vector<size_t>> inputVarDims, vector<float *> inputVarArrays);
+    static int _c2python(PyObject *dict, const vector<string> &inputVarNames, const vector<vector<size_t>> &inputVarDims, const vector<float *> &inputVarArrays, const vector<bool> &inputReadOnly);
 
-    static int _python2c(PyObject *dict, vector<string> outputVarNames, vector<vector<size_t>> outputVarDims, vector<float *> outputVarArrays);
+    static int _python2c(PyObject *dict, const vector<string> &outputVarNames, const vector<vector<size_t>> &outputVarDims, const vector<float *> &outputVarArrays);
 
     bool _validOutputVar(string name) const;
     int  _checkOutVars(const vector<string> &outputVarNames) const;
@@ -146,6 +146,32 @@ public:
     //
     void ClearCache() { _clearCache(); };
 
+    //! Return timing of the most recent paintGL()
+    //!
+    //! \param[out] paintTime Wall clock time, in seconds, spent in
+    //! _paintGL() by the last call to paintGL() for which the renderer
+    //! was enabled
+    //! \param[out] fetchTime The portion of \p paintTime spent in
+    //! DataMgr::GetVariable()
+    //!
+    //! \sa SetSynchronousTiming()
+    //
+    void GetLastPaintTime(double &paintTime, double &fetchTime) const
+    {
+        paintTime = _lastPaintTime;
+        fetchTime = _lastFetchTime;
+    }
+
+    //! Wait for the GPU before recording paint times
+    //!
+    //! OpenGL commands are executed asynchronously, so by default the
+    //! time reported by GetLastPaintTime() may exclude GPU work. If \p
+    //! enable is true paintGL() calls glFinish() before stopping its
+    //! timer. This stalls the pipeline and should only be enabled for
+    //! benchmarking.
+    //
+    static void SetSynchronousTiming(bool enable) { _synchronousTiming = enable; }
+
 #ifdef VAPOR3_0_0_ALPHA
 #endif
 
@@ -302,6 +328,10 @@ protected:
 
 private:
     size_t _timestep;
+    double _lastPaintTime;
+    double _lastFetchTime;
+
+    static bool _synchronousTiming;
 
 #ifdef VAPOR3_0_0_ALPHA
     static ControlExec *_controlExec;
@@ -12,6 +12,7 @@
 #include <vapor/DataMgr.h>
 #include <vapor/utils.h>
 #include <vapor/Renderer.h>
+#include <vapor/SurfaceResampler.h>
 
 namespace VAPoR {
 
@@ -58,9 +59,7 @@ private:
     void _initTextures();
     void _createDataTexture(float *dataValues);
     int  _saveTextureData();
-    void _populateDataXY(float *dataValues, Grid *grid) const;
-    void _populateDataXZ(float *dataValues, Grid *grid) const;
-    void _populateDataYZ(float *dataValues, Grid *grid) const;
+    void _getSamplePlane(std::vector<double> &origin, std::vector<double> &du, std::vector<double> &dv) const;
 
     double _newWaySeconds;
     double _newWayInlineSeconds;
@@ -83,6 +82,8 @@ private:
     bool _initialized;
     int  _textureSideSize;
 
+    SurfaceResampler _resampler;
+
     GLuint _colorMapTextureID;
     GLuint _dataValueTextureID;
 
@@ -0,0 +1,124 @@
+#ifndef _SurfaceResampler_
+#define _SurfaceResampler_
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <vapor/MyBase.h>
+#include <vapor/common.h>
+#include <vapor/Grid.h>
+
+namespace VAPoR {
+
+class StructuredGrid;
+
+//! \class SurfaceResampler
+//! \brief Resample a Grid onto a 2D parametric surface
+//!
+//! This class samples the scalar field of a Grid at the nodes of a
+//! \a nu by \a nv lattice of points lying on an arbitrarily oriented
+//! plane, or on any 2D parametric surface. It is intended for renderers
+//! such as SliceRenderer that texture a surface with data values.
+//!
+//! Rows of the lattice are divided among threads. For structured grids
+//! the cell containing each sample is found by walking from the cell
+//! containing the previous sample in the row, and the cell indices and
+//! interpolation weights of every sample are cached. Subsequent calls to
+//! Resample() with a grid having the same geometry (e.g. a different
+//! variable or time step on the same mesh) reuse the cached weights and
+//! only gather the field values. Other grid types are sampled with
+//! Grid::GetValue().
+//!
+//! The cache is invalidated automatically when the surface changes, or
+//! when the node dimensions, user extents, or a sparse subset of the node
+//! coordinates of the grid differ from those of the grid used to build
+//! it. Invalidate() may be called to force recomputation, for example
+//! when coordinates vary with time in a way not detected by these checks.
+//!
+class VDF_API SurfaceResampler : public Wasp::MyBase {
+public:
+    //! \param[in] nthreads The maximum number of parts the sample lattice
+    //! is divided into for parallel execution on the Wasp::TaskScheduler.
+    //! If less than one the number of scheduler threads is used.
+    //
+    SurfaceResampler(int nthreads = 0);
+    virtual ~SurfaceResampler() {}
+
+    //! Define a planar lattice of sample points
+    //!
+    //! The sample point with lattice indices (i,j) is located at
+    //! \p origin + i * \p du + j * \p dv, for 0 <= i < \p nu and
+    //! 0 <= j < \p nv. The vectors need not be axis aligned or orthogonal.
+    //!
+    //! \param[in] origin User coordinates of sample (0,0). Must contain
+    //! three elements.
+    //! \param[in] du Offset between adjacent samples along the first
+    //! lattice axis. Must contain three elements.
+    //! \param[in] dv Offset between adjacent samples along the second
+    //! lattice axis. Must contain three elements.
+    //! \param[in] nu Number of samples along the first lattice axis
+    //! \param[in] nv Number of samples along the second lattice axis
+    //
+    void SetPlane(const std::vector<double> &origin, const std::vector<double> &du, const std::vector<double> &dv, size_t nu, size_t nv);
+
+    //! Define an arbitrary lattice of sample points
+    //!
+    //! \param[in] points User coordinates of the \p nu * \p nv sample
+    //! points, stored as x,y,z triples with the first lattice axis
+    //! varying fastest. Neighboring lattice points should be close in
+    //! space for the cell search to be efficient.
+    //! \param[in] nu Number of samples along the first lattice axis
+    //! \param[in] nv Number of samples along the second lattice axis
+    //
+    void SetSurface(const std::vector<double> &points, size_t nu, size_t nv);
+
+    //! Return the number of samples along the first lattice axis
+    //
+    size_t GetNumU() const { return (_nu); }
+
+    //! Return the number of samples along the second lattice axis
+    //
+    size_t GetNumV() const { return (_nv); }
+
+    //! Discard any cached cell indices and weights
+    //
+    void Invalidate();
+
+    //! Sample a grid at the lattice points
+    //!
+    //! \param[in] grid The grid to sample. The interpolation order of
+    //! the grid determines whether linear (order 1) or nearest neighbor
+    //! (order 0) interpolation is used.
+    //! \param[out] values Array of \p nu * \p nv elements in which the
+    //! sampled values are returned, with the first lattice axis varying
+    //! fastest. Samples outside of the grid, or interpolated from a missing
+    //! value, are set to grid->GetMissingValue().
+    //!
+    //! \retval status A negative int is returned if no lattice has been
+    //! defined, or the resampling fails.
+    //
+    int Resample(const Grid *grid, float *values);
+
+private:
+    int                 _nthreads;
+    size_t              _nu;
+    size_t              _nv;
+    std::vector<double> _points;
+
+    // Cached cell indices (i,j,k) and parametric coordinates within the
+    // cell of each sample. Samples outside of the grid have a first cell
+    // index of UINT32_MAX.
+    //
+    std::vector<uint32_t> _cells;
+    std::vector<float>    _weights;
+    std::vector<double>   _signature;
+    std::string           _gridType;
+
+    void _gridSignature(const Grid *grid, std::vector<double> &sig) const;
+    int  _locate(const StructuredGrid *sg);
+    int  _gather(const StructuredGrid *sg, float *values) const;
+    int  _sample(const Grid *grid, float *values) const;
+};
+};    // namespace VAPoR
+
+#endif
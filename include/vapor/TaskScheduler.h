@@ -0,0 +1,311 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <algorithm>
+#include <vapor/common.h>
+
+namespace Wasp {
+
+template<class T> class TaskFuture;
+
+//! \class TaskScheduler
+//! \brief A process-wide pool of threads that execute tasks
+//!
+//! Each worker thread owns a double ended queue of tasks. Tasks submitted
+//! by a worker are pushed onto and taken from the back of its own queue,
+//! so nested tasks run depth first on the thread that created them.
+//! Idle workers steal from the front of the other queues, which balances
+//! uneven workloads. Tasks submitted by any other thread go on a shared
+//! queue.
+//!
+//! A thread waiting on a TaskGroup or TaskFuture executes pending tasks
+//! while it waits rather than blocking, so tasks may create and wait on
+//! other tasks without exhausting the pool.
+//!
+//! A thread that must not run unrelated tasks, for example because it
+//! holds a lock that those tasks may also take, can create a SerialScope.
+//! Until the scope is destroyed, tasks submitted by that thread run
+//! immediately on it and it does not help execute other pending tasks.
+//!
+//! The worker threads are started on first use. Their number defaults to
+//! the number of processors, or to the VAPOR_NTHREADS environment
+//! variable if it is set, and can be changed with SetNumThreads().
+//!
+//! \sa TaskGroup, ParallelFor(), ParallelReduce()
+//
+class COMMON_API TaskScheduler {
+public:
+    typedef std::function<void()> Task;
+
+    //! Return the process-wide scheduler
+    //
+    static TaskScheduler &Instance();
+
+    ~TaskScheduler();
+
+    //! Set the number of worker threads
+    //!
+    //! Workers are stopped and restarted; queued tasks are kept. Must not
+    //! be called from a task, or while other threads are using the
+    //! scheduler.
+    //!
+    //! \param[in] nthreads Number of workers. If less than one the
+    //! default described above is used.
+    //
+    void SetNumThreads(int nthreads);
+
+    int GetNumThreads() const;
+
+    //! Queue \p task for execution on a worker thread
+    //!
+    //! If the calling thread is in a SerialScope \p task is executed
+    //! before Submit() returns.
+    //
+    void Submit(Task task);
+
+    //! Execute a single pending task on the calling thread
+    //!
+    //! \retval ran False if there was no task to execute, or if the
+    //! calling thread is in a SerialScope
+    //
+    bool RunOne();
+
+    //! Return the index, in [0, GetNumThreads()), of the calling worker
+    //! thread, or -1 if the caller is not one of this scheduler's workers
+    //
+    int GetThreadIndex() const;
+
+    //! Run \p f asynchronously and return a future for its result
+    //
+    template<class F> TaskFuture<typename std::result_of<F()>::type> Async(F f)
+    {
+        typedef typename std::result_of<F()>::type R;
+
+        std::shared_ptr<std::packaged_task<R()>> task = std::make_shared<std::packaged_task<R()>>(f);
+        std::future<R>                           future = task->get_future();
+        Submit([task]() { (*task)(); });
+        return (TaskFuture<R>(*this, std::move(future)));
+    }
+
+    //! \class SerialScope
+    //! \brief Run tasks submitted by the calling thread inline
+    //!
+    //! While an object of this class exists the thread that created it
+    //! executes the tasks it submits itself, and never picks up tasks
+    //! queued by other threads. Scopes may be nested.
+    //
+    class COMMON_API SerialScope {
+    public:
+        SerialScope();
+        ~SerialScope();
+
+    private:
+        SerialScope(const SerialScope &);
+        SerialScope &operator=(const SerialScope &);
+    };
+
+    //! Return true if the calling thread is in a SerialScope
+    //
+    static bool IsSerial();
+
+private:
+    class worker_t {
+    public:
+        std::mutex       _mutex;
+        std::deque<Task> _tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_t>> _workers;
+    std::vector<std::thread>               _threads;
+    std::deque<Task>                       _shared;    // tasks from non-worker threads
+    std::atomic<long>                      _queued;    // tasks in all queues
+    bool                                   _stop;
+    mutable std::mutex                     _mutex;
+    std::condition_variable                _workCV;
+    std::mutex                             _configMutex;
+
+    TaskScheduler();
+    TaskScheduler(const TaskScheduler &);
+    TaskScheduler &operator=(const TaskScheduler &);
+
+    void _start(int nthreads);
+    void _stopWorkers();
+    void _worker(int index);
+    bool _take(int index, Task &task);
+};
+
+//! \class TaskFuture
+//! \brief The result of TaskScheduler::Async()
+//!
+//! Get() executes other pending tasks while the result is not ready.
+//
+template<class T> class TaskFuture {
+public:
+    TaskFuture(TaskScheduler &scheduler, std::future<T> future) : _scheduler(&scheduler), _future(std::move(future)) {}
+
+    TaskFuture(TaskFuture &&rhs) : _scheduler(rhs._scheduler), _future(std::move(rhs._future)) {}
+
+    bool IsReady() const { return (_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready); }
+
+    void Wait()
+    {
+        while (!IsReady()) {
+            if (!_scheduler->RunOne()) _future.wait_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    //! Wait for and return the result. May only be called once.
+    //
+    T Get()
+    {
+        Wait();
+        return (_future.get());
+    }
+
+private:
+    TaskScheduler *_scheduler;
+    std::future<T> _future;
+};
+
+//! \class TaskGroup
+//! \brief A set of tasks that can be waited on together
+//!
+//! Tasks may add further tasks to the group they belong to. The
+//! destructor waits for all tasks in the group.
+//
+class COMMON_API TaskGroup {
+public:
+    TaskGroup(TaskScheduler &scheduler = TaskScheduler::Instance());
+    ~TaskGroup();
+
+    void Run(TaskScheduler::Task task);
+
+    //! Block until every task run in the group has completed, executing
+    //! pending tasks in the meantime
+    //
+    void Wait();
+
+private:
+    class state_t {
+    public:
+        std::atomic<long>       _pending;
+        std::mutex              _mutex;
+        std::condition_variable _doneCV;
+    };
+
+    TaskScheduler &          _scheduler;
+    std::shared_ptr<state_t> _state;
+
+    TaskGroup(const TaskGroup &);
+    TaskGroup &operator=(const TaskGroup &);
+};
+
+template<class F> void _parallelForSplit(TaskGroup &group, size_t begin, size_t end, size_t grain, const F &body)
+{
+    // Hand the upper halves to other threads and keep splitting the lower
+    // half, so that idle workers steal the largest remaining pieces
+    //
+    while (end - begin > grain) {
+        size_t mid = begin + (end - begin) / 2;
+        group.Run([&group, mid, end, grain, &body]() { _parallelForSplit(group, mid, end, grain, body); });
+        end = mid;
+    }
+    body(begin, end);
+}
+
+//! Call \p body(b, e) over subranges [b, e) that partition [begin, end)
+//!
+//! The range is split recursively down to at most \p grain elements, so
+//! uneven work is balanced by stealing. \p body may itself run parallel
+//! loops.
+//
+template<class F> void ParallelFor(size_t begin, size_t end, size_t grain, const F &body, TaskScheduler &scheduler = TaskScheduler::Instance())
+{
+    if (end <= begin) return;
+    if (grain < 1) grain = 1;
+
+    if (end - begin <= grain) {
+        body(begin, end);
+        return;
+    }
+
+    TaskGroup group(scheduler);
+    _parallelForSplit(group, begin, end, grain, body);
+    group.Wait();
+}
+
+//! Return the number of parts to split \p n elements into so that every
+//! part has at least \p grain elements and there is at most one part per
+//! worker thread. The result is at least one.
+//
+inline size_t NumParts(size_t n, size_t grain, TaskScheduler &scheduler = TaskScheduler::Instance())
+{
+    if (grain < 1) grain = 1;
+    return (std::max((size_t)1, std::min((size_t)scheduler.GetNumThreads(), n / grain)));
+}
+
+//! Call \p body(part, b, e) for each of \p nparts contiguous subranges
+//! [b, e) of nearly equal size that partition [begin, end)
+//!
+//! The parts run in parallel. Unlike ParallelFor() the partition is
+//! fixed, so each part may accumulate results in per-part state indexed
+//! by \p part, to be combined in index order afterwards.
+//!
+//! \sa NumParts()
+//
+template<class F> void ParallelForParts(size_t begin, size_t end, size_t nparts, const F &body, TaskScheduler &scheduler = TaskScheduler::Instance())
+{
+    if (end < begin) end = begin;
+    if (nparts < 1) nparts = 1;
+
+    size_t n = end - begin;
+    ParallelFor(
+        0, nparts, 1,
+        [begin, n, nparts, &body](size_t p0, size_t p1) {
+            for (size_t p = p0; p < p1; p++) body(p, begin + n * p / nparts, begin + n * (p + 1) / nparts);
+        },
+        scheduler);
+}
+
+//! Reduce [begin, end) in parallel
+//!
+//! \p map(b, e) returns the value of subrange [b, e) of at most \p grain
+//! elements, and \p reduce(x, y) combines two values. Partial values are
+//! combined in index order starting from \p identity, so the result does
+//! not depend on scheduling.
+//
+template<class T, class M, class R> T ParallelReduce(size_t begin, size_t end, size_t grain, T identity, const M &map, const R &reduce, TaskScheduler &scheduler = TaskScheduler::Instance())
+{
+    if (end <= begin) return (identity);
+    if (grain < 1) grain = 1;
+
+    size_t         nchunks = (end - begin + grain - 1) / grain;
+    std::vector<T> partial(nchunks, identity);
+
+    ParallelFor(
+        0, nchunks, 1,
+        [&](size_t c0, size_t c1) {
+            for (size_t c = c0; c < c1; c++) {
+                size_t b = begin + c * grain;
+                size_t e = std::min(end, b + grain);
+                partial[c] = map(b, e);
+            }
+        },
+        scheduler);
+
+    T result = identity;
+    for (size_t c = 0; c < nchunks; c++) result = reduce(result, partial[c]);
+    return (result);
+}
+
+};    // namespace Wasp
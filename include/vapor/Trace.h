@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <vapor/common.h>
+
+namespace Wasp {
+
+//! \class Trace
+//! \brief Runtime toggleable tracing of timed spans and counters
+//!
+//! Spans record the wall clock interval of a scope (see TraceSpan) and
+//! counters accumulate values such as cache hits. Events are buffered
+//! per thread and can be written in the Chrome trace event JSON format,
+//! which is read by chrome://tracing and Perfetto.
+//!
+//! BeginFrame() and EndFrame() delimit a frame. EndFrame() records a
+//! summary of the frame: the number of calls and total time of each
+//! span, and the total of each counter.
+//!
+//! Tracing is always compiled in. When it is disabled a span or counter
+//! costs a single relaxed atomic load. Tracing is enabled with Enable(),
+//! or by setting the VAPOR_TRACE environment variable to a file name, in
+//! which case the trace is written to that file, and the frame summaries
+//! to the same name with ".txt" appended, when the process exits.
+//!
+//! Span, category, and counter names are stored by pointer and must be
+//! string literals. Variable information belongs in a span's detail
+//! string, which is only copied while tracing is enabled.
+//
+class COMMON_API Trace {
+public:
+    static bool IsEnabled() { return (_enabled.load(std::memory_order_relaxed)); }
+
+    static void Enable(bool enable);
+
+    //! Discard all recorded events and frame summaries
+    //
+    static void Clear();
+
+    //! Microseconds since the first use of the trace clock
+    //
+    static double Now();
+
+    //! Record a span that started at \p t0, as returned by Now(), and
+    //! ends now
+    //
+    static void Complete(const char *name, const char *category, double t0, const std::string &detail);
+
+    //! Add \p value to the counter \p name
+    //
+    static void Count(const char *name, double value = 1.0)
+    {
+        if (IsEnabled()) _count(name, value);
+    }
+
+    static void BeginFrame(const std::string &label)
+    {
+        if (IsEnabled()) _beginFrame(label);
+    }
+
+    static void EndFrame()
+    {
+        if (IsEnabled()) _endFrame();
+    }
+
+    //! Return the summary of the most recent frame, or an empty string
+    //
+    static std::string GetFrameSummary();
+
+    //! Limit the number of buffered events. Events beyond the limit are
+    //! dropped and the number dropped is reported. The default is 2^20.
+    //
+    static void SetMaxEvents(size_t n);
+
+    //! Write all buffered events as Chrome trace event JSON
+    //!
+    //! \retval status A negative int is returned if the file could not
+    //! be written
+    //
+    static int WriteJSON(const std::string &path);
+
+    //! Write the summaries of all recorded frames as text
+    //
+    static int WriteFrameSummaries(const std::string &path);
+
+private:
+    static std::atomic<bool> _enabled;
+
+    static void _count(const char *name, double value);
+    static void _beginFrame(const std::string &label);
+    static void _endFrame();
+};
+
+//! \class TraceSpan
+//! \brief Record the lifetime of a scope as a Trace span
+//!
+//! \code
+//! {
+//!     TraceSpan span("DataMgr::GetVariable", "data", varname);
+//!     ...
+//! }
+//! \endcode
+//
+class TraceSpan {
+public:
+    TraceSpan(const char *name, const char *category) : _name(NULL), _category(category), _t0(0.0)
+    {
+        if (Trace::IsEnabled()) {
+            _name = name;
+            _t0 = Trace::Now();
+        }
+    }
+
+    TraceSpan(const char *name, const char *category, const std::string &detail) : _name(NULL), _category(category), _t0(0.0)
+    {
+        if (Trace::IsEnabled()) {
+            _name = name;
+            _detail = detail;
+            _t0 = Trace::Now();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (_name) Trace::Complete(_name, _category, _t0, _detail);
+    }
+
+private:
+    const char *_name;    // NULL if tracing was disabled on entry
+    const char *_category;
+    double      _t0;
+    std::string _detail;
+
+    TraceSpan(const TraceSpan &);
+    TraceSpan &operator=(const TraceSpan &);
+};
+
+};    // namespace Wasp
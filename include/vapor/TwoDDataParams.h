@@ -32,7 +32,18 @@ public:
     //
     virtual size_t GetRenderDim() const override { return (2); }
 
+    //! Get the largest number of grid points drawn along each axis
+    //!
+    //! Structured meshes, and their textures, with more grid points than
+    //! this along an axis are decimated. Zero disables decimation.
+    //
+    long GetMaxMeshDim() const { return (GetValueLong(_maxMeshDimTag, 4096)); }
+
+    void SetMaxMeshDim(long n) { SetValueLong(_maxMeshDimTag, "Maximum mesh dimension", n < 0 ? 0 : n); }
+
 private:
+    static const string _maxMeshDimTag;
+
     void _init();
 #ifdef VAPOR3_0_0_ALPHA
     void _validateTF(int type, DataMgr *dataMgr);
@@ -58,11 +58,15 @@ protected:
     const GLvoid *GetTexture(DataMgr *dataMgr, GLsizei &width, GLsizei &height, GLint &internalFormat, GLenum &format, GLenum &type, size_t &texelSize, bool &gridAligned);
 
 private:
+    // Geometry of the mesh. The time step is only significant if the
+    // geometry varies with time (see TwoDRenderer::GetMeshTimeStep()).
+    //
     class _grid_state_c {
     public:
         _grid_state_c() = default;
-        _grid_state_c(size_t numRefLevels, int refLevel, int lod, string hgtVar, string meshName, size_t ts, vector<double> minExts, vector<double> maxExts)
-        : _numRefLevels(numRefLevels), _refLevel(refLevel), _lod(lod), _hgtVar(hgtVar), _meshName(meshName), _ts(ts), _minExts(minExts), _maxExts(maxExts)
+        _grid_state_c(size_t numRefLevels, int refLevel, int lod, string hgtVar, string meshName, size_t ts, double defaultZ, vector<double> minExts, vector<double> maxExts, long maxMeshDim)
+        : _numRefLevels(numRefLevels), _refLevel(refLevel), _lod(lod), _hgtVar(hgtVar), _meshName(meshName), _ts(ts), _defaultZ(defaultZ), _minExts(minExts), _maxExts(maxExts),
+          _maxMeshDim(maxMeshDim)
         {
         }
 
@@ -72,14 +76,16 @@ private:
             _refLevel = _lod = -1;
             _hgtVar = _meshName = "";
             _ts = 0;
+            _defaultZ = 0.0;
             _minExts.clear();
             _maxExts.clear();
+            _maxMeshDim = -1;
         }
 
         bool operator==(const _grid_state_c &rhs) const
         {
             return (_numRefLevels == rhs._numRefLevels && _refLevel == rhs._refLevel && _lod == rhs._lod && _hgtVar == rhs._hgtVar && _meshName == rhs._meshName && _ts == rhs._ts
-                    && _minExts == rhs._minExts && _maxExts == rhs._maxExts);
+                    && _defaultZ == rhs._defaultZ && _minExts == rhs._minExts && _maxExts == rhs._maxExts && _maxMeshDim == rhs._maxMeshDim);
         }
         bool operator!=(const _grid_state_c &rhs) const { return (!(*this == rhs)); }
 
@@ -90,15 +96,17 @@ private:
         string         _hgtVar;
         string         _meshName;
         size_t         _ts;
+        double         _defaultZ;
         vector<double> _minExts;
         vector<double> _maxExts;
+        long           _maxMeshDim;
     };
 
     class _tex_state_c {
     public:
         _tex_state_c() = default;
-        _tex_state_c(int refLevel, int lod, string varname, size_t ts, vector<double> minExts, vector<double> maxExts)
-        : _refLevel(refLevel), _lod(lod), _varname(varname), _ts(ts), _minExts(minExts), _maxExts(maxExts)
+        _tex_state_c(int refLevel, int lod, string varname, size_t ts, vector<double> minExts, vector<double> maxExts, long maxMeshDim)
+        : _refLevel(refLevel), _lod(lod), _varname(varname), _ts(ts), _minExts(minExts), _maxExts(maxExts), _maxMeshDim(maxMeshDim)
         {
         }
 
@@ -109,11 +117,13 @@ private:
             _ts = 0;
             _minExts.clear();
             _maxExts.clear();
+            _maxMeshDim = -1;
         }
 
         bool operator==(const _tex_state_c &rhs) const
         {
-            return (_refLevel == rhs._refLevel && _lod == rhs._lod && _varname == rhs._varname && _ts == rhs._ts && _minExts == rhs._minExts && _maxExts == rhs._maxExts);
+            return (_refLevel == rhs._refLevel && _lod == rhs._lod && _varname == rhs._varname && _ts == rhs._ts && _minExts == rhs._minExts && _maxExts == rhs._maxExts
+                    && _maxMeshDim == rhs._maxMeshDim);
         }
         bool operator!=(const _tex_state_c &rhs) const { return (!(*this == rhs)); }
 
@@ -124,6 +134,7 @@ private:
         size_t         _ts;
         vector<double> _minExts;
         vector<double> _maxExts;
+        long           _maxMeshDim;
     };
 
     _grid_state_c _grid_state;
@@ -141,10 +152,18 @@ private:
     GLsizei  _nindices;
     GLsizei  _nverts;
 
+    // Dimensions of the grids the mesh and texture were built from,
+    // before any decimation
+    //
+    vector<size_t> _meshGridDims;
+    vector<size_t> _texGridDims;
+
     GLuint   _cMapTexID;
     GLfloat *_colormap;
     size_t   _colormapsize;
 
+    _grid_state_c _getGridState() const;
+
     bool _gridStateDirty() const;
 
     void _gridStateClear();
@@ -163,9 +182,7 @@ private:
 
     int _getMeshUnStructuredHelper(DataMgr *dataMgr, const Grid *g, double defaultZ);
 
-    int _getMeshStructuredDisplaced(DataMgr *dataMgr, const StructuredGrid *g, double defaultZ);
-
-    int _getMeshStructuredPlane(DataMgr *dataMgr, const StructuredGrid *g, double defaultZ);
+    Grid *_getHeightGrid(DataMgr *dataMgr, const vector<double> &minExts, const vector<double> &maxExts);
 
     const GLvoid *_getTexture(DataMgr *dataMgr);
 
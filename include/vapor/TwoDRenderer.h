@@ -137,6 +137,52 @@ protected:
     //
     void ComputeNormals(const GLfloat *verts, GLsizei w, GLsizei h, GLfloat *normals);
 
+    //! Displace mesh vertices by a height field
+    //!
+    //! The z coordinate of each of the \p nverts vertices in \p verts,
+    //! stored as interleaved x,y,z triplets, is set to \p defaultZ plus the
+    //! value of \p hgtGrid at the vertex's x,y coordinates. Missing values
+    //! result in no displacement. If \p hgtGrid is NULL all vertices
+    //! are placed at \p defaultZ. Vertices are divided among threads.
+    //!
+    //! \param[out] normals If not NULL, an array of \p nverts interleaved
+    //! triplets in which the surface normal at each vertex, computed from
+    //! central differences of \p hgtGrid with offsets \p dx and
+    //! \p dy, is returned. Normals are not unit length.
+    //
+    void DisplaceVertices(const Grid *hgtGrid, double defaultZ, GLfloat *verts, size_t nverts, GLfloat *normals = NULL, float dx = 0.0, float dy = 0.0) const;
+
+    //! Compute the vertices of a structured mesh
+    //!
+    //! Vertex (i,j) of the mesh is located at the user coordinates of
+    //! node (\p iIndices[i], \p jIndices[j]) of \p g, and is displaced by
+    //! \p hgtGrid as described by DisplaceVertices(). Rows of the mesh are
+    //! divided among threads.
+    //!
+    //! \param[out] verts Array of iIndices.size() * jIndices.size() interleaved
+    //! x,y,z triplets
+    //
+    void ComputeStructuredVertices(const StructuredGrid *g, const Grid *hgtGrid, double defaultZ, const std::vector<size_t> &iIndices, const std::vector<size_t> &jIndices, GLfloat *verts) const;
+
+    //! Select grid indices along an axis for a decimated mesh
+    //!
+    //! Returns in \p indices at most \p maxn evenly strided indices from
+    //! the range 0..\p n - 1, always including the first and last. If
+    //! \p maxn is zero, or not less than \p n, all \p n indices are
+    //! returned.
+    //
+    static void GetDecimatedIndices(size_t n, size_t maxn, std::vector<size_t> &indices);
+
+    //! Return the time step that mesh geometry depends on
+    //!
+    //! Cached mesh geometry need not be recomputed when only the time step
+    //! changes if neither the coordinates of \p meshVar, nor the values or
+    //! coordinates of the height variable \p hgtVar, vary with time.
+    //! Returns \p ts if any of these are time varying, otherwise returns 0.
+    //! Either variable name may be empty.
+    //
+    static size_t GetMeshTimeStep(const DataMgr *dataMgr, size_t ts, const string &meshVar, const string &hgtVar);
+
 private:
     GLuint        _textureID;
     const GLvoid *_texture;
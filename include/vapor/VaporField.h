@@ -136,6 +136,8 @@ private:
     std::vector<double>                _c_ext_min, _c_ext_max;             // cached extents
     const VAPoR::Grid *                _c_scalar_grid = nullptr;           // cached scalar grid
     std::array<const VAPoR::Grid *, 3> _c_velocity_grids = {{nullptr, nullptr, nullptr}};
+    bool                               _c_vel_shared_mesh = false;    // components on one mesh?
+    bool                               _c_vel_static_mesh = false;    // mesh constant in time?
     // Note on the cached scalar and velocity grids:
     // they act as a cache of _recentGrids, so kind of like a cache of cache.
     // This is due to the not-so-cheap cost of constructing keys and querying _recentGrids.
@@ -155,6 +157,21 @@ private:
     // Note 2: If a variable is essentially 2D, we then grow it to be 3D
     //         and return a GrownGrid.
     const VAPoR::Grid *_getAGrid(size_t timestep, const std::string &varName) const;
+
+    // Determine from the DataMgr whether the three velocity variables are
+    // defined on the same mesh, and whether that mesh's coordinates are
+    // constant in time.
+    void _velocityMeshInfo(bool &shared, bool &isStatic) const;
+
+    // Sample three velocity grids of one time step at coords.
+    // If `shared` is true and the grids have identical geometry, the cell
+    // containing coords is located once, recorded in `stencil`, and its
+    // weights are applied to every component. A stencil already present
+    // (`haveStencil` true) is reused without another search.
+    // Otherwise each grid is sampled with Grid::GetValue().
+    // Returns 0 or MISSING_VAL.
+    int _sampleVelocity(const std::array<const VAPoR::Grid *, 3> &grids, const VAPoR::DblArr3 &coords, bool shared, VAPoR::Grid::InterpolationStencil &stencil, bool &haveStencil,
+                        glm::vec3 &velocity) const;
 };
 };    // namespace flow
 
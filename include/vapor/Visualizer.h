@@ -28,6 +28,7 @@
 #include <vapor/Renderer.h>
 #include <vapor/AnnotationRenderer.h>
 #include <vapor/Framebuffer.h>
+#include <vapor/FrameEncoder.h>
 
 namespace VAPoR {
 
@@ -108,6 +109,15 @@ public:
 
     bool HasRenderer(string renderType, string renderName) const;
 
+    //! Return the timing of the most recent paint of each renderer
+    //!
+    //! The vectors are returned in rendering order, one element per
+    //! renderer.
+    //!
+    //! \sa Renderer::GetLastPaintTime()
+    //
+    void GetRenderTimes(vector<string> &renderTypes, vector<string> &renderNames, vector<double> &paintTimes, vector<double> &fetchTimes) const;
+
     //! Move the renderer to the front of the render queue
     //! \param[out] Renderer instance that is moved to front
     void MoveRendererToFront(string renderType, string renderName);
@@ -135,23 +145,20 @@ public:
 
     //! Turn on or off the animation capture enablement.  If on, all paintEvents will result in capture
     //! until it is turned off
-    int SetAnimationCaptureEnabled(bool onOff, string filename)
-    {
-        if (_imageCaptureEnabled) {
-            SetErrMsg("Image capture concurrent with Animation Capture\n");
-            return -1;
-        }
-        if (_animationCaptureEnabled == onOff) {
-            SetErrMsg("Animation capture in incorrect state\n");
-            return -1;
-        }
-        _animationCaptureEnabled = onOff;
-        if (onOff)
-            _captureImageFile = filename;
-        else
-            _captureImageFile = "";
-        return 0;
-    }
+    //!
+    //! Frames are read back from the GPU asynchronously and written by
+    //! background encoder threads, so a frame may not be on disk until a
+    //! later paintEvent. If \p filename has the extension ".y4m" all
+    //! frames are appended to a single uncompressed YUV4MPEG2 video
+    //! stream instead of being written to one image file per frame.
+    //!
+    //! When \p onOff is false any outstanding frames are completed before
+    //! returning. The OpenGL context for this visualizer must be current.
+    //!
+    //! \retval status A negative int is returned if capture is in the
+    //! wrong state, or if any captured frame could not be written
+    //
+    int SetAnimationCaptureEnabled(bool onOff, string filename);
 
     //! Draw a text banner at x, y coordinates
     //
@@ -178,6 +185,26 @@ private:
     //! \return zero if successful
     int _captureImage(std::string path);
 
+    //! Start an asynchronous capture of the current frame for an
+    //! animation, and hand the previously captured frame to the encoder
+    //
+    int _captureAnimationFrame(std::string path);
+
+    //! Create and configure the writer for a captured image, and compute
+    //! the region of the frame to write. \p cropMin and \p cropMax are
+    //! pixel coordinates with the origin at the top left.
+    //
+    int _prepareCapture(std::string path, int width, int height, ImageWriter **writer, int cropMin[2], int cropMax[2]);
+
+    //! Read back a pending animation frame from its pixel buffer object
+    //! and queue it for encoding
+    //
+    int _finishPendingCapture(int index);
+
+    //! Complete all pending animation frames and wait for them to be written
+    //
+    int _finishCapture();
+
     void _loadMatricesFromViewpointParams();
 
     //! Definition of OpenGL Vendors
@@ -218,6 +245,19 @@ private:
     bool   _animationCaptureEnabled;
     string _captureImageFile;
 
+    // Animation capture. Two pixel buffer objects are alternated so that
+    // the read back of one frame overlaps with rendering the next.
+    //
+    struct {
+        bool         valid;
+        ImageWriter *writer;    // NULL for video stream frames
+        int          width, height;
+        int          cropMin[2], cropMax[2];
+    } _pendingCapture[2];
+    unsigned int  _capturePBO[2];
+    int           _capturePBOIndex;
+    FrameEncoder *_frameEncoder;
+
     vector<Renderer *> _renderers;
     vector<Renderer *> _renderersToDestroy;
 
@@ -16,6 +16,7 @@ class VolumeParams;
 class ViewpointParams;
 class AnnotationParams;
 class Transform;
+class DataMgr;
 
 //! \class VolumeAlgorithm
 //! \ingroup Public_Render
@@ -47,6 +48,12 @@ public:
     virtual bool  RequiresChunkedRendering() = 0;
     virtual float GuestimateFastModeSpeedupFactor() const { return 1; }
 
+    //! Returns true if the data loaded by the last successful call to
+    //! LoadData() still references the memory of the grid it was given.
+    //! The renderer then keeps that grid locked in the DataMgr until the
+    //! next successful LoadData() or until the algorithm is destroyed.
+    virtual bool SharesGridData() const { return false; }
+
     static VolumeAlgorithm *NewAlgorithm(const std::string &name, GLManager *gl, VolumeRenderer *renderer);
 
     static void Register(VolumeAlgorithmFactory *f);
@@ -58,6 +65,7 @@ protected:
     ViewpointParams * GetViewpointParams() const;
     AnnotationParams *GetAnnotationParams() const;
     Transform *       GetDatasetTransform() const;
+    DataMgr *         GetDataMgr() const;
     void              GetExtents(glm::vec3 *dataMin, glm::vec3 *dataMax, glm::vec3 *userMin, glm::vec3 *userMax) const;
 
 private:
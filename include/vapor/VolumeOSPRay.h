@@ -34,6 +34,7 @@ public:
     virtual void           SetUniforms(const ShaderProgram *shader) const;
     virtual float          GuestimateFastModeSpeedupFactor() const;
     virtual void           GetFinalBlendingMode(int *src, int *dst);
+    virtual bool           SharesGridData() const { return _sharesGridData; }
 
 protected:
     virtual bool _isIso() const { return false; }
@@ -64,6 +65,26 @@ private:
     OSPGeometry         _ospIso = nullptr;
     OSPGeometricModel   _ospIsoModel = nullptr;
 
+    // Data values of the current volume when they had to be copied out of
+    // the grid. OSPRay references this memory rather than copying it.
+    std::vector<float> _scalarData;
+    bool               _sharesGridData = false;
+
+    // Vertex positions and cells of the last structured or unstructured
+    // grid loaded, shared with OSPRay and reused while only the data
+    // values change
+    struct {
+        std::string                key;    // see _topologyKey()
+        std::vector<glm::vec3>     coords;
+        std::vector<unsigned int>  indices;
+        std::vector<unsigned int>  cellStarts;
+        std::vector<unsigned char> cellTypes;
+        OSPData                    position = nullptr;
+        OSPData                    index = nullptr;
+        OSPData                    cellIndex = nullptr;
+        OSPData                    cellType = nullptr;
+    } _topology;
+
     void _setupRenderer(bool fast);
     void _setupCamera();
     void _setupIso();
@@ -72,11 +93,21 @@ private:
     void _copyDepth();
     void _copyBackplate();
 
-    float     _guessSamplingRateScalar(const Grid *grid) const;
-    OSPVolume _loadVolumeRegular(const Grid *grid);
-    OSPVolume _loadVolumeStructured(const Grid *grid);
-    OSPVolume _loadVolumeUnstructured(const Grid *grid);
-    OSPVolume _loadVolumeTest(const Grid *grid);
+    float       _guessSamplingRateScalar(const Grid *grid) const;
+    OSPVolume   _loadVolumeRegular(const Grid *grid);
+    OSPVolume   _loadVolumeStructured(const Grid *grid);
+    OSPVolume   _loadVolumeUnstructured(const Grid *grid);
+    OSPVolume   _loadVolumeTest(const Grid *grid);
+    OSPData     _newScalarData(const Grid *grid, uint64_t n1, uint64_t n2 = 1, uint64_t n3 = 1);
+    std::string _topologyKey(const Grid *grid) const;
+    bool        _isTopologyCached(const Grid *grid, std::string &key) const;
+    void        _cacheTopology(const std::string &key, std::vector<glm::vec3> &coords, std::vector<unsigned int> &indices, std::vector<unsigned int> &cellStarts,
+                               std::vector<unsigned char> &cellTypes);
+    void        _setTopology(OSPVolume volume) const;
+    void        _releaseTopology();
+
+    static void *_buildStructuredCells(void *arg);
+    static void *_buildUnstructuredCells(void *arg);
 
     enum WindingOrder { CCW, CW, INVALID };
     static WindingOrder getWindingOrderRespectToZ(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c);
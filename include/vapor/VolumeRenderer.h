@@ -39,12 +39,15 @@ protected:
     int                 _loadSecondaryData();
     virtual std::string _getDefaultAlgorithmForGrid(const Grid *grid) const;
     bool                _needToSetDefaultAlgorithm() const;
+    void                _releaseGrid(Grid *grid);
+    void                _releaseSharedGrid();
 
     unsigned int     _VAO = (int)NULL;
     unsigned int     _VBO = (int)NULL;
     unsigned int     _VAOChunked = (int)NULL;
     unsigned int     _VBOChunked = (int)NULL;
     VolumeAlgorithm *_algorithm = nullptr;
+    Grid *           _sharedGrid = nullptr;    // Locked grid whose memory _algorithm references
     Framebuffer      _framebuffer;
 
     int                 _nChunks;
@@ -8,7 +8,7 @@
 #include <netcdf.h>
 #include <vapor/NetCDFCpp.h>
 #include <vapor/Compressor.h>
-#include <vapor/EasyThreads.h>
+#include <vapor/TaskScheduler.h>
 #include <vapor/utils.h>
 
 namespace VAPoR {
@@ -102,11 +102,11 @@ public:
     //!
     //! Construct a WASP object
     //!
-    //! \param[in] nthreads Number of parallel execution threads
+    //! \param[in] nthreads Number of parallel tasks
     //! to be run during encoding and decoding of compressed data. A value
-    //! of 0, the default, indicates that the thread count should be
-    //! determined by the environment in a platform-specific manner, for
-    //! example using sysconf(_SC_NPROCESSORS_ONLN) under *nix OSes.
+    //! of 0, the default, uses the number of threads of the process-wide
+    //! Wasp::TaskScheduler. Blocks are handed out to the tasks
+    //! dynamically, so uneven block costs are balanced.
     //!
     //
     WASP(int nthreads = 0);
@@ -629,7 +629,6 @@ public:
     static string AttNameVersion() { return ("WASP.Version"); }
 
 private:
-    Wasp::EasyThreads * _et;
     int                 _nthreads;
     vector<NetCDFCpp>   _ncdfcs;
     vector<NetCDFCpp *> _ncdfcptrs;         // pointers into _ncdfcs;
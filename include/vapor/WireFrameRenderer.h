@@ -58,7 +58,6 @@ private:
     Texture1D    _lutTexture;
     bool         _GPUOutOfMemory;
 
-    struct VertexData;
     struct {
         string              varName;
         string              heightVarName;
@@ -69,56 +68,34 @@ private:
 
     } _cacheParams;
 
-    // Helper class to keep track of which cell edges have been drawn so
-    // we can avoid duplicate draws.
+    // Describes the grid whose edges are in _EBO. The index buffer depends
+    // only on the grid topology, so it is reused when only the node
+    // coordinates or values change (e.g. a new time step).
     //
-    class DrawList {
-    public:
-        // maxEntries is the maximum number of unique cell nodes.
-        // maxLinesPerVertex is the *expected* max valence (degree) of any
-        // node (vertex). If a node has more than maxLinesPerVertex edges
-        // only the first maxLinesPerVertex edges will be recorded in
-        // DrawList. Hence, queries to edges with DrawList::InList will
-        // return false once maxLinesPerVertex has been exceeded
-        //
-        DrawList(GLuint maxEntries, size_t maxLinesPerVertex)
-        : _drawList(maxEntries * maxLinesPerVertex, (std::numeric_limits<GLuint>::max)()), _maxEntries(maxEntries), _maxLinesPerVertex(maxLinesPerVertex)
-        {
-        }
-
-        bool InList(GLuint idx0, GLuint idx1)
-        {
-            VAssert(idx0 < _maxEntries);
-            VAssert(idx1 < _maxEntries);
-
-            if (idx1 < idx0) { std::swap(idx1, idx0); }
-
-            for (int i = 0; i < _maxLinesPerVertex; i++) {
-                if (_drawList[idx0 * _maxLinesPerVertex + i] == idx1) { return (true); }
-                if (_drawList[idx0 * _maxLinesPerVertex + i] == (std::numeric_limits<GLuint>::max)()) {
-                    _drawList[idx0 * _maxLinesPerVertex + i] = idx1;
-                    return (false);
-                }
-            }
-            return (false);
-        }
-
-    private:
-        vector<GLuint> _drawList;
-        const size_t   _maxEntries;
-        const size_t   _maxLinesPerVertex;
+    struct topology {
+        string              gridType;
+        string              meshName;
+        std::vector<size_t> dims;
+        std::vector<size_t> minAbs;
+
+        bool operator==(const topology &rhs) const { return gridType == rhs.gridType && meshName == rhs.meshName && dims == rhs.dims && minAbs == rhs.minAbs; }
     };
+    topology _topology;
+    bool     _topologyValid;
 
-    void _buildCacheVertices(const Grid *grid, const Grid *heightGrid, vector<GLuint> &nodeMap, bool *GPUOutOfMemory) const;
+    void _buildCacheVertices(const Grid *grid, const Grid *heightGrid, bool *GPUOutOfMemory) const;
 
-    size_t _buildCacheConnectivity(const Grid *grid, const vector<GLuint> &nodeMap, bool *GPUOutOfMemory) const;
+    size_t _buildCacheConnectivity(const Grid *grid, bool *GPUOutOfMemory) const;
 
     int  _buildCache();
     bool _isCacheDirty() const;
     void _saveCacheParams();
-    void _drawCell(const GLuint *cellNodeIndices, int n, bool layered, const std::vector<GLuint> &nodeMap, GLuint invalidIndex, std::vector<unsigned int> &indices, DrawList &drawList) const;
 
-    void _clearCache() { _cacheParams.varName.clear(); }
+    void _clearCache()
+    {
+        _cacheParams.varName.clear();
+        _topologyValid = false;
+    }
 };
 
 };    // namespace VAPoR
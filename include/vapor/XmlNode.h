@@ -495,12 +495,21 @@ public:
     //!
     virtual XmlNode *GetRoot() const;
 
+    //! Return all XmlNode instances currently allocated
+    //!
+    //! Allocation tracking is a debugging aid and is only enabled
+    //! in debug builds (NDEBUG not defined). In release builds the
+    //! returned vector is always empty. The order of the nodes is
+    //! unspecified.
+    //
     static const std::vector<XmlNode *> &GetAllocatedNodes() { return (_allocatedNodes); }
 
     // Following is a substitute for exporting the "<<" operator in windows.
     // I don't know how to export an operator<< !
     static ostream &streamOut(ostream &os, const XmlNode &node);
 
+    friend class XmlNodeDiff;
+
 private:
     static vector<long>   _emptyLongVec;    // empty elements
     static vector<double> _emptyDoubleVec;
@@ -519,9 +528,96 @@ private:
 
     size_t   _asciiLimit;    // length limit beyond which element data are encoded
     XmlNode *_parent;        // Node's parent
+    size_t   _allocIndex;    // Node's position in _allocatedNodes
+
+    void _copyChildren(const XmlNode &rhs);
 };
 // ostream& VAPoR::operator<< (ostream& os, const XmlNode& node);
 
+//
+//! \class XmlNodeDiff
+//! \brief A structural difference between two Xml trees
+//!
+//! This class records the changes needed to transform one XmlNode
+//! tree into another: data elements and attributes that were added,
+//! removed, or modified, and child nodes that were added or removed.
+//! Only the changed elements are stored, so the memory footprint and
+//! the cost of Apply() and Revert() are proportional to the size of
+//! the change, not the size of the trees.
+//!
+//! Nodes are matched by tag, relying on the XmlNode invariant that
+//! the tags of sibling nodes are unique.
+//!
+class PARAMS_API XmlNodeDiff {
+public:
+    XmlNodeDiff() {}
+
+    //! Compute the difference between two trees
+    //!
+    //! \param[in] from The original tree
+    //! \param[in] to The modified tree
+    //!
+    XmlNodeDiff(const XmlNode &from, const XmlNode &to);
+    ~XmlNodeDiff();
+
+    //! Return true if the two trees compared were equivalent
+    //!
+    //! \sa XmlNode::operator==()
+    //
+    bool Empty() const { return (_changes.empty()); }
+
+    //! Return the number of nodes affected by the difference
+    //
+    size_t GetNumNodes() const { return (_changes.size()); }
+
+    //! Transform the tree rooted at \p root from the \p from tree
+    //! into the \p to tree passed to the constructor
+    //!
+    //! \p root must be equivalent to \p from
+    //
+    void Apply(XmlNode *root) const { _patch(root, true); }
+
+    //! Transform the tree rooted at \p root from the \p to tree
+    //! back into the \p from tree passed to the constructor
+    //!
+    //! \p root must be equivalent to \p to
+    //
+    void Revert(XmlNode *root) const { _patch(root, false); }
+
+    XmlNodeDiff(const XmlNodeDiff &) = delete;
+    XmlNodeDiff &operator=(const XmlNodeDiff &) = delete;
+
+private:
+    // Changes to a single node. For each element map the "old" maps
+    // hold the entries in the "from" node that are modified or removed,
+    // and the "new" maps hold the entries in the "to" node that are
+    // modified or added.
+    //
+    class NodeChange {
+    public:
+        std::vector<string>         path;    // Path relative to the root
+        string                      oldTag;
+        string                      newTag;
+        map<string, vector<long>>   oldLongs, newLongs;
+        map<string, vector<double>> oldDoubles, newDoubles;
+        map<string, string>         oldStrings, newStrings;
+        map<string, string>         oldAttrs, newAttrs;
+
+        // Removed and added children, and the children's tag order
+        // before and after. Orders are empty if unchanged.
+        //
+        std::vector<XmlNode *> oldChildren, newChildren;
+        std::vector<string>    oldOrder, newOrder;
+
+        bool Empty() const;
+    };
+
+    std::vector<NodeChange *> _changes;
+
+    void _diff(const XmlNode &from, const XmlNode &to, std::vector<string> &path);
+    void _patch(XmlNode *root, bool forward) const;
+};
+
 class PARAMS_API XmlParser : public Wasp::MyBase {
 public:
     XmlParser();
@@ -0,0 +1,227 @@
+#include <sstream>
+#include <cstdlib>
+#include <vapor/VAssert.h>
+#include <vapor/EasyThreads.h>
+#include <vapor/TaskScheduler.h>
+
+using namespace Wasp;
+
+namespace {
+
+// Worker identity of the calling thread
+//
+thread_local TaskScheduler *tlsScheduler = NULL;
+thread_local int            tlsIndex = -1;
+
+// Nesting depth of SerialScope objects on the calling thread
+//
+thread_local int tlsSerialDepth = 0;
+
+int defaultNumThreads()
+{
+    int nthreads = EasyThreads::NProc();
+    if (char *s = getenv("VAPOR_NTHREADS")) {
+        std::istringstream ist(s);
+        ist >> nthreads;
+    }
+    return (nthreads < 1 ? 1 : nthreads);
+}
+
+};    // namespace
+
+TaskScheduler &TaskScheduler::Instance()
+{
+    static TaskScheduler scheduler;
+    return (scheduler);
+}
+
+TaskScheduler::TaskScheduler() : _queued(0), _stop(false) { _start(defaultNumThreads()); }
+
+TaskScheduler::~TaskScheduler() { _stopWorkers(); }
+
+void TaskScheduler::SetNumThreads(int nthreads)
+{
+    VAssert(tlsScheduler != this);
+    if (nthreads < 1) nthreads = defaultNumThreads();
+
+    std::unique_lock<std::mutex> config(_configMutex);
+    if (nthreads == (int)_threads.size()) return;
+
+    _stopWorkers();
+    _start(nthreads);
+}
+
+int TaskScheduler::GetNumThreads() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return ((int)_threads.size());
+}
+
+void TaskScheduler::_start(int nthreads)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _stop = false;
+    for (int i = 0; i < nthreads; i++) _workers.push_back(std::unique_ptr<worker_t>(new worker_t));
+    for (int i = 0; i < nthreads; i++) _threads.push_back(std::thread(&TaskScheduler::_worker, this, i));
+}
+
+// Stop and join the workers. Tasks left in their queues are moved to
+// the shared queue so that they run once workers are restarted.
+//
+void TaskScheduler::_stopWorkers()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _workCV.notify_all();
+    for (auto &t : _threads) t.join();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (auto &w : _workers) {
+        for (auto &task : w->_tasks) _shared.push_back(std::move(task));
+    }
+    _workers.clear();
+    _threads.clear();
+}
+
+int TaskScheduler::GetThreadIndex() const { return (tlsScheduler == this ? tlsIndex : -1); }
+
+TaskScheduler::SerialScope::SerialScope() { tlsSerialDepth++; }
+
+TaskScheduler::SerialScope::~SerialScope() { tlsSerialDepth--; }
+
+bool TaskScheduler::IsSerial() { return (tlsSerialDepth > 0); }
+
+void TaskScheduler::Submit(Task task)
+{
+    if (IsSerial()) {
+        task();
+        return;
+    }
+
+    int index = GetThreadIndex();
+    if (index >= 0) {
+        worker_t &                   w = *_workers[index];
+        std::unique_lock<std::mutex> lock(w._mutex);
+        w._tasks.push_back(std::move(task));
+    } else {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _shared.push_back(std::move(task));
+    }
+    _queued++;
+
+    // Sleeping workers test _queued while holding _mutex, so taking it
+    // here guarantees the notification is not lost
+    //
+    { std::unique_lock<std::mutex> lock(_mutex); }
+    _workCV.notify_one();
+}
+
+// Take a task: the back of the caller's own queue first, then the
+// shared queue, then the front of another worker's queue
+//
+bool TaskScheduler::_take(int index, Task &task)
+{
+    if (_queued.load() == 0) return (false);
+
+    if (index >= 0) {
+        worker_t &                   w = *_workers[index];
+        std::unique_lock<std::mutex> lock(w._mutex);
+        if (!w._tasks.empty()) {
+            task = std::move(w._tasks.back());
+            w._tasks.pop_back();
+            _queued--;
+            return (true);
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_shared.empty()) {
+            task = std::move(_shared.front());
+            _shared.pop_front();
+            _queued--;
+            return (true);
+        }
+    }
+
+    size_t n = _workers.size();
+    size_t first = index >= 0 ? index + 1 : 0;
+    for (size_t k = 0; k < n; k++) {
+        size_t victim = (first + k) % n;
+        if ((int)victim == index) continue;
+
+        worker_t &                   w = *_workers[victim];
+        std::unique_lock<std::mutex> lock(w._mutex);
+        if (!w._tasks.empty()) {
+            task = std::move(w._tasks.front());
+            w._tasks.pop_front();
+            _queued--;
+            return (true);
+        }
+    }
+    return (false);
+}
+
+bool TaskScheduler::RunOne()
+{
+    if (IsSerial()) return (false);
+
+    Task task;
+    if (!_take(GetThreadIndex(), task)) return (false);
+
+    task();
+    return (true);
+}
+
+void TaskScheduler::_worker(int index)
+{
+    tlsScheduler = this;
+    tlsIndex = index;
+
+    while (true) {
+        Task task;
+        if (_take(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _workCV.wait(lock, [this] { return _stop || _queued.load() > 0; });
+        if (_stop) return;
+    }
+}
+
+TaskGroup::TaskGroup(TaskScheduler &scheduler) : _scheduler(scheduler), _state(std::make_shared<state_t>()) { _state->_pending = 0; }
+
+TaskGroup::~TaskGroup() { Wait(); }
+
+void TaskGroup::Run(TaskScheduler::Task task)
+{
+    // Tasks hold a reference to the state rather than to the group so
+    // that the final notification cannot outlive a destroyed group
+    //
+    std::shared_ptr<state_t> state = _state;
+    state->_pending++;
+    _scheduler.Submit([state, task]() {
+        task();
+        if (--state->_pending == 0) {
+            std::unique_lock<std::mutex> lock(state->_mutex);
+            state->_doneCV.notify_all();
+        }
+    });
+}
+
+void TaskGroup::Wait()
+{
+    while (_state->_pending.load() > 0) {
+        if (_scheduler.RunOne()) continue;
+
+        // Nothing to help with. Sleep briefly; tasks of this group that
+        // are running elsewhere may still queue more work.
+        //
+        std::unique_lock<std::mutex> lock(_state->_mutex);
+        _state->_doneCV.wait_for(lock, std::chrono::milliseconds(1), [this] { return _state->_pending.load() == 0; });
+    }
+}
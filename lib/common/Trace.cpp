@@ -0,0 +1,355 @@
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <vapor/MyBase.h>
+#include <vapor/Trace.h>
+
+using namespace Wasp;
+
+std::atomic<bool> Trace::_enabled(false);
+
+namespace {
+
+class event_t {
+public:
+    const char *_name;
+    const char *_category;
+    char        _phase;    // 'X' for a span, 'C' for a counter
+    double      _ts;       // microseconds
+    double      _dur;
+    double      _value;
+    std::string _detail;
+};
+
+// Events recorded by one thread. The owning thread appends and readers
+// take the lock, so the lock is uncontended while recording.
+//
+class threadBuffer_t {
+public:
+    std::mutex                     _mutex;
+    std::vector<event_t>           _events;
+    std::map<const char *, double> _counters;      // accumulated since the last frame
+    size_t                         _frameStart;    // first event of the current frame
+    int                            _tid;
+};
+
+class frame_t {
+public:
+    std::string                                    _label;
+    double                                         _t0;
+    double                                         _t1;
+    std::map<std::string, std::pair<long, double>> _spans;    // calls, microseconds
+    std::map<std::string, double>                  _counters;
+};
+
+class registry_t {
+public:
+    std::mutex                                   _mutex;
+    std::vector<std::shared_ptr<threadBuffer_t>> _buffers;
+    std::vector<frame_t>                         _frames;
+    std::string                                  _frameLabel;
+    double                                       _frameT0;
+    bool                                         _inFrame;
+    std::atomic<size_t>                          _nevents;
+    std::atomic<size_t>                          _dropped;
+    std::atomic<size_t>                          _maxEvents;
+
+    registry_t() : _frameT0(0.0), _inFrame(false), _nevents(0), _dropped(0), _maxEvents(1 << 20) {}
+};
+
+registry_t &registry()
+{
+    static registry_t r;
+    return (r);
+}
+
+std::chrono::steady_clock::time_point epoch()
+{
+    static std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    return (t0);
+}
+
+threadBuffer_t &localBuffer()
+{
+    thread_local std::shared_ptr<threadBuffer_t> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<threadBuffer_t>();
+        buffer->_frameStart = 0;
+
+        registry_t &                 r = registry();
+        std::unique_lock<std::mutex> lock(r._mutex);
+        buffer->_tid = (int)r._buffers.size() + 1;
+        r._buffers.push_back(buffer);
+    }
+    return (*buffer);
+}
+
+void append(event_t &event)
+{
+    registry_t &r = registry();
+    if (r._nevents.fetch_add(1) >= r._maxEvents) {
+        r._nevents--;
+        r._dropped++;
+        return;
+    }
+
+    threadBuffer_t &             b = localBuffer();
+    std::unique_lock<std::mutex> lock(b._mutex);
+    b._events.push_back(std::move(event));
+}
+
+std::string spanKey(const event_t &e) { return (e._detail.empty() ? std::string(e._name) : std::string(e._name) + " [" + e._detail + "]"); }
+
+std::string jsonEscape(const std::string &s)
+{
+    std::string out;
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return (out);
+}
+
+std::string formatFrame(const frame_t &f, size_t index)
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3);
+    oss << "Frame " << index << " \"" << f._label << "\" " << (f._t1 - f._t0) / 1000.0 << " ms" << std::endl;
+
+    // Most expensive spans first
+    //
+    std::vector<std::pair<std::string, std::pair<long, double>>> spans(f._spans.begin(), f._spans.end());
+    std::sort(spans.begin(), spans.end(), [](const std::pair<std::string, std::pair<long, double>> &a, const std::pair<std::string, std::pair<long, double>> &b) {
+        return (a.second.second > b.second.second);
+    });
+    for (const auto &s : spans) { oss << "  " << std::left << std::setw(48) << s.first << std::right << std::setw(8) << s.second.first << " calls " << std::setw(12) << s.second.second / 1000.0 << " ms" << std::endl; }
+    oss.unsetf(std::ios::floatfield);
+    for (const auto &c : f._counters) { oss << "  " << std::left << std::setw(48) << c.first << std::right << std::setw(8) << c.second << std::endl; }
+    return (oss.str());
+}
+
+// Honor VAPOR_TRACE. The registry is created first so that it is still
+// alive when the trace is written at exit.
+//
+class envTrace_t {
+public:
+    envTrace_t()
+    {
+        (void)registry();
+        (void)epoch();
+        if (const char *s = getenv("VAPOR_TRACE")) {
+            _path = s;
+            if (!_path.empty()) Trace::Enable(true);
+        }
+    }
+    ~envTrace_t()
+    {
+        if (_path.empty()) return;
+        (void)Trace::WriteJSON(_path);
+        (void)Trace::WriteFrameSummaries(_path + ".txt");
+    }
+
+private:
+    std::string _path;
+};
+
+envTrace_t envTrace;
+
+};    // namespace
+
+void Trace::Enable(bool enable)
+{
+    (void)epoch();
+    _enabled.store(enable);
+}
+
+double Trace::Now() { return (std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch()).count()); }
+
+void Trace::Clear()
+{
+    registry_t &                 r = registry();
+    std::unique_lock<std::mutex> lock(r._mutex);
+    for (auto &b : r._buffers) {
+        std::unique_lock<std::mutex> block(b->_mutex);
+        b->_events.clear();
+        b->_counters.clear();
+        b->_frameStart = 0;
+    }
+    r._frames.clear();
+    r._inFrame = false;
+    r._nevents = 0;
+    r._dropped = 0;
+}
+
+void Trace::SetMaxEvents(size_t n)
+{
+    registry_t &                 r = registry();
+    std::unique_lock<std::mutex> lock(r._mutex);
+    r._maxEvents = n;
+}
+
+void Trace::Complete(const char *name, const char *category, double t0, const std::string &detail)
+{
+    event_t e;
+    e._name = name;
+    e._category = category;
+    e._phase = 'X';
+    e._ts = t0;
+    e._dur = Now() - t0;
+    e._value = 0.0;
+    e._detail = detail;
+    append(e);
+}
+
+void Trace::_count(const char *name, double value)
+{
+    threadBuffer_t &             b = localBuffer();
+    std::unique_lock<std::mutex> lock(b._mutex);
+    b._counters[name] += value;
+}
+
+void Trace::_beginFrame(const std::string &label)
+{
+    registry_t &                 r = registry();
+    std::unique_lock<std::mutex> lock(r._mutex);
+    for (auto &b : r._buffers) {
+        std::unique_lock<std::mutex> block(b->_mutex);
+        b->_frameStart = b->_events.size();
+    }
+    r._frameLabel = label;
+    r._frameT0 = Now();
+    r._inFrame = true;
+}
+
+void Trace::_endFrame()
+{
+    registry_t &r = registry();
+    double      t1 = Now();
+
+    frame_t frame;
+    {
+        std::unique_lock<std::mutex> lock(r._mutex);
+        if (!r._inFrame) return;
+        r._inFrame = false;
+
+        frame._label = r._frameLabel;
+        frame._t0 = r._frameT0;
+        frame._t1 = t1;
+
+        for (auto &b : r._buffers) {
+            std::unique_lock<std::mutex> block(b->_mutex);
+            for (size_t i = b->_frameStart; i < b->_events.size(); i++) {
+                const event_t &e = b->_events[i];
+                if (e._phase != 'X' || e._ts < frame._t0) continue;
+
+                std::pair<long, double> &s = frame._spans[spanKey(e)];
+                s.first++;
+                s.second += e._dur;
+            }
+            for (const auto &c : b->_counters) frame._counters[c.first] += c.second;
+            b->_counters.clear();
+        }
+        if (r._dropped.load()) frame._counters["Trace events dropped"] = (double)r._dropped.load();
+    }
+
+    // Record the frame's counter totals so that they appear as tracks
+    // in the trace
+    //
+    for (const auto &c : frame._counters) {
+        event_t e;
+        e._name = "counter";
+        e._category = "counter";
+        e._phase = 'C';
+        e._ts = t1;
+        e._dur = 0.0;
+        e._value = c.second;
+        e._detail = c.first;
+        append(e);
+    }
+
+    std::unique_lock<std::mutex> lock(r._mutex);
+    r._frames.push_back(frame);
+}
+
+std::string Trace::GetFrameSummary()
+{
+    registry_t &                 r = registry();
+    std::unique_lock<std::mutex> lock(r._mutex);
+    if (r._frames.empty()) return ("");
+    return (formatFrame(r._frames.back(), r._frames.size() - 1));
+}
+
+int Trace::WriteJSON(const std::string &path)
+{
+    FILE *fp = fopen(path.c_str(), "w");
+    if (!fp) {
+        MyBase::SetErrMsg("fopen(%s) : %M", path.c_str());
+        return (-1);
+    }
+
+    registry_t &                 r = registry();
+    std::unique_lock<std::mutex> lock(r._mutex);
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%zu},\"traceEvents\":[\n", r._dropped.load());
+    bool first = true;
+    for (auto &b : r._buffers) {
+        std::unique_lock<std::mutex> block(b->_mutex);
+        for (const event_t &e : b->_events) {
+            fprintf(fp, "%s", first ? "" : ",\n");
+            first = false;
+            if (e._phase == 'C') {
+                fprintf(fp, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"value\":%.17g}}", jsonEscape(e._detail).c_str(), e._ts, b->_tid, e._value);
+            } else {
+                fprintf(fp, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d", jsonEscape(e._name).c_str(), jsonEscape(e._category).c_str(), e._ts, e._dur,
+                        b->_tid);
+                if (!e._detail.empty()) fprintf(fp, ",\"args\":{\"detail\":\"%s\"}", jsonEscape(e._detail).c_str());
+                fprintf(fp, "}");
+            }
+        }
+    }
+    fprintf(fp, "\n]}\n");
+
+    if (fclose(fp) != 0) {
+        MyBase::SetErrMsg("Failed to write trace file \"%s\"", path.c_str());
+        return (-1);
+    }
+    return (0);
+}
+
+int Trace::WriteFrameSummaries(const std::string &path)
+{
+    FILE *fp = fopen(path.c_str(), "w");
+    if (!fp) {
+        MyBase::SetErrMsg("fopen(%s) : %M", path.c_str());
+        return (-1);
+    }
+
+    registry_t &                 r = registry();
+    std::unique_lock<std::mutex> lock(r._mutex);
+    for (size_t i = 0; i < r._frames.size(); i++) fputs(formatFrame(r._frames[i], i).c_str(), fp);
+
+    if (fclose(fp) != 0) {
+        MyBase::SetErrMsg("Failed to write trace summary file \"%s\"", path.c_str());
+        return (-1);
+    }
+    return (0);
+}
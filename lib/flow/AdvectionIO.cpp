@@ -4,152 +4,467 @@
 #include <algorithm>
 #include <iterator>    // std::distance
 #include <cctype>
+#include <cstring>
+#include <cassert>
 #include "vapor/AdvectionIO.h"
 #include "vapor/UDUnitsClass.h"
 #include "vapor/Proj4API.h"
+#include "vapor/NetCDFCpp.h"
 
-auto flow::OutputFlowlinesNumSteps(const Advection *adv, const char *filename, size_t numSteps, const std::string &proj4string, bool append) -> int
+namespace {
+
+const char     binaryMagic[8] = {'V', 'A', 'P', 'O', 'R', 'F', 'L', 'B'};
+const uint32_t binaryVersion = 1;
+const uint32_t byteOrderMark = 0x01020304;
+
+// NETCDF property variables carry a prefix so that no property name can
+// collide with the fixed trajectory, rowSize, x, y, z, and time variables
+const std::string propertyVarPrefix = "property_";
+
+std::string propertyVarName(const std::string &name) { return propertyVarPrefix + name; }
+
+// Append one particle to the columns of `set`
+void pushSample(flow::FlowlineSet &set, const flow::Particle &p)
 {
-    // First we need the infrastructure for time conversion
-    VAPoR::UDUnits udunits;
-    if (udunits.Initialize() < 0) return PARAMS_ERROR;
+    set.x.push_back(p.location.x);
+    set.y.push_back(p.location.y);
+    set.z.push_back(p.location.z);
+    set.time.push_back(p.time);
+
+    size_t i = 0;
+    for (const auto &val : p.GetPropertyList()) {
+        if (i < set.properties.size()) set.properties[i].push_back(val);
+        i++;
+    }
+    // A quick sanity check
+    assert(i == set.propertyNames.size());
+}
 
-    // Second we need the infrastructure for coordinate conversion
-    bool            needGeoConversion = false;
-    VAPoR::Proj4API proj4API;
-    if (!proj4string.empty()) {
-        if (proj4API.Initialize(proj4string, "") < 0) return PARAMS_ERROR;
-        needGeoConversion = true;
+// Close the stream whose samples were pushed since the previous call.
+// Streams without any sample are dropped.
+void endStream(flow::FlowlineSet &set, size_t s_idx)
+{
+    if (set.x.size() == set.streamOffsets.back()) return;
+    set.streamIDs.push_back(s_idx);
+    set.streamOffsets.push_back(set.x.size());
+}
+
+void initSet(const flow::Advection *adv, flow::FlowlineSet &set)
+{
+    set.propertyNames = adv->GetPropertyVarNames();
+    set.properties.assign(set.propertyNames.size(), std::vector<float>());
+    set.streamOffsets.assign(1, 0);
+
+    size_t total = 0;
+    for (size_t s_idx = 0; s_idx < adv->GetNumberOfStreams(); s_idx++) total += adv->GetStreamAt(s_idx).size();
+    set.x.reserve(total);
+    set.y.reserve(total);
+    set.z.reserve(total);
+    set.time.reserve(total);
+    for (auto &col : set.properties) col.reserve(total);
+}
+
+// Collect the first numSteps + 1 non-special particles of each stream
+void gatherNumSteps(const flow::Advection *adv, size_t numSteps, flow::FlowlineSet &set)
+{
+    initSet(adv, set);
+    for (size_t s_idx = 0; s_idx < adv->GetNumberOfStreams(); s_idx++) {
+        size_t step = 0;
+        for (const auto &p : adv->GetStreamAt(s_idx)) {
+            if (!p.IsSpecial()) {
+                pushSample(set, p);
+                step++;
+            }
+            if (step > numSteps)    // when numSteps + 1 particles are collected.
+                break;
+        }
+        endStream(set, s_idx);
     }
+}
 
-    // Requesting the file handle
-    std::FILE *f = nullptr;
-    if (append) {
-        f = std::fopen(filename, "a");
-    } else {
-        f = std::fopen(filename, "w");
+// Collect the non-special particles of each stream up to maxTime
+void gatherMaxTime(const flow::Advection *adv, double maxTime, flow::FlowlineSet &set)
+{
+    initSet(adv, set);
+    for (size_t s_idx = 0; s_idx < adv->GetNumberOfStreams(); s_idx++) {
+        for (const auto &p : adv->GetStreamAt(s_idx)) {
+            if (p.time > maxTime) break;
+            if (!p.IsSpecial()) pushSample(set, p);
+        }
+        endStream(set, s_idx);
     }
-    if (f == nullptr) return FILE_ERROR;
+}
 
-    auto propertyNames = adv->GetPropertyVarNames();
+// Convert X, Y of every sample in one batched call. If any point fails
+// the batch is redone one point at a time from the original values, and,
+// as before the conversion was batched, points that still fail are
+// written anyway rather than aborting the export.
+int project(flow::FlowlineSet &set, const std::string &proj4string)
+{
+    if (proj4string.empty() || set.x.empty()) return 0;
+
+    VAPoR::Proj4API proj4API;
+    if (proj4API.Initialize(proj4string, "") < 0) return flow::PARAMS_ERROR;
+
+    std::vector<float> x = set.x;
+    std::vector<float> y = set.y;
+
+    bool enabled = Wasp::MyBase::EnableErrMsg(false);
+    if (proj4API.Transform(set.x.data(), set.y.data(), set.x.size()) < 0) {
+        set.x = x;
+        set.y = y;
+        for (size_t i = 0; i < set.x.size(); i++) (void)proj4API.Transform(&set.x[i], &set.y[i], 1);
+        Wasp::MyBase::SetErrCode(0);
+    }
+    (void)Wasp::MyBase::EnableErrMsg(enabled);
+
+    return 0;
+}
+
+int writeCSV(const flow::FlowlineSet &set, const char *filename, bool append)
+{
+    // We need the infrastructure for time conversion
+    VAPoR::UDUnits udunits;
+    if (udunits.Initialize() < 0) return flow::PARAMS_ERROR;
+
+    std::FILE *f = std::fopen(filename, append ? "a" : "w");
+    if (f == nullptr) return flow::FILE_ERROR;
 
     // Write the header
     if (!append) {
         std::fprintf(f, "%s", "# ID,  X-position,  Y-position,  Z-position,  Time");
 
-        for (auto &n : propertyNames) std::fprintf(f, ",  %s", n.c_str());
+        for (auto &n : set.propertyNames) std::fprintf(f, ",  %s", n.c_str());
         std::fprintf(f, "\n");
     }
 
-    // Let's declare variables that will be used repeatedly for
-    //   time and geo coordinate conversion
-    int   year, month, day, hour, minute, second;
-    float cX, cY;    // converted X, Y coordinates
+    int year, month, day, hour, minute, second;
 
-    // Write the trajectories
-    for (size_t s_idx = 0; s_idx < adv->GetNumberOfStreams(); s_idx++) {
-        const auto &stream = adv->GetStreamAt(s_idx);
+    for (size_t s = 0; s < set.GetNumberOfStreams(); s++) {
+        for (size_t i = set.streamOffsets[s]; i < set.streamOffsets[s + 1]; i++) {
+            udunits.DecodeTime(set.time[i], &year, &month, &day, &hour, &minute, &second);
 
-        size_t step = 0;
-        for (const auto &p : stream) {
-            if (!p.IsSpecial()) {
-                // Let's convert the time!
-                udunits.DecodeTime(p.time, &year, &month, &day, &hour, &minute, &second);
+            std::fprintf(f, "%lu, %f, %f, %f, %4.4d-%2.2d-%2.2d_%2.2d:%2.2d:%2.2d", (unsigned long)set.streamIDs[s], set.x[i], set.y[i], set.z[i], year, month, day, hour, minute,
+                         second);
+            for (const auto &col : set.properties) std::fprintf(f, ", %f", col[i]);
 
-                // Let's also convert geo coordinates if needed.
-                cX = p.location.x;
-                cY = p.location.y;
-                if (needGeoConversion) { proj4API.Transform(&cX, &cY, 1); }
-
-                std::fprintf(f, "%lu, %f, %f, %f, %4.4d-%2.2d-%2.2d_%2.2d:%2.2d:%2.2d", s_idx, cX, cY, p.location.z, year, month, day, hour, minute, second);
-
-                auto props = p.GetPropertyList();
-                // A quick sanity check
-                assert(std::distance(props.cbegin(), props.cend()) == propertyNames.size());
-                for (const auto &val : props) std::fprintf(f, ", %f", val);
-
-                std::fprintf(f, "\n");    // end of one line
-                step++;
-            }
-            if (step > numSteps)    // when numSteps + 1 particles are printed.
-                break;
+            std::fprintf(f, "\n");    // end of one line
         }
     }
 
     std::fclose(f);
-
     return 0;
 }
 
-auto flow::OutputFlowlinesMaxTime(const Advection *adv, const char *filename, double maxTime, const std::string &proj4string, bool append) -> int
+int writeBinary(const flow::FlowlineSet &set, const char *filename, bool append)
 {
-    // First we need the infrastructure for time conversion
-    VAPoR::UDUnits udunits;
-    if (udunits.Initialize() < 0) return PARAMS_ERROR;
+    std::FILE *f = std::fopen(filename, append ? "ab" : "wb");
+    if (f == nullptr) return flow::FILE_ERROR;
 
-    // Second we need the infrastructure for coordinate conversion
-    bool            needGeoConversion = false;
-    VAPoR::Proj4API proj4API;
-    if (!proj4string.empty()) {
-        if (proj4API.Initialize(proj4string, "") < 0) return PARAMS_ERROR;
-        needGeoConversion = true;
+    bool ok = true;
+    auto put = [&](const void *ptr, size_t size, size_t n) {
+        if (ok && n) ok = std::fwrite(ptr, size, n, f) == n;
+    };
+
+    const uint64_t nStreams = set.GetNumberOfStreams();
+    const uint64_t nSamples = set.GetNumberOfSamples();
+    const uint32_t nProps = set.propertyNames.size();
+
+    put(binaryMagic, 1, sizeof(binaryMagic));
+    put(&binaryVersion, sizeof(binaryVersion), 1);
+    put(&byteOrderMark, sizeof(byteOrderMark), 1);
+    put(&nStreams, sizeof(nStreams), 1);
+    put(&nSamples, sizeof(nSamples), 1);
+    put(&nProps, sizeof(nProps), 1);
+    for (const auto &n : set.propertyNames) {
+        uint32_t len = n.size();
+        put(&len, sizeof(len), 1);
+        put(n.data(), 1, len);
     }
 
-    // Requesting the file handle
-    std::FILE *f = nullptr;
+    std::vector<uint64_t> counts(nStreams);
+    for (size_t s = 0; s < nStreams; s++) counts[s] = set.streamOffsets[s + 1] - set.streamOffsets[s];
+    put(set.streamIDs.data(), sizeof(uint64_t), nStreams);
+    put(counts.data(), sizeof(uint64_t), nStreams);
+
+    put(set.x.data(), sizeof(float), nSamples);
+    put(set.y.data(), sizeof(float), nSamples);
+    put(set.z.data(), sizeof(float), nSamples);
+    put(set.time.data(), sizeof(double), nSamples);
+    for (const auto &col : set.properties) put(col.data(), sizeof(float), nSamples);
+
+    if (std::fclose(f) != 0) ok = false;
+    return ok ? 0 : flow::FILE_ERROR;
+}
+
+// Write `set` to `ncdf`, which the caller closes on success or failure
+int writeNetCDFFile(VAPoR::NetCDFCpp &ncdf, const flow::FlowlineSet &set, const char *filename, bool append)
+{
+    size_t trajStart = 0, obsStart = 0;
+
     if (append) {
-        f = std::fopen(filename, "a");
+        if (ncdf.Open(filename, NC_WRITE) < 0) return flow::FILE_ERROR;
+        if (ncdf.InqDimlen("trajectory", trajStart) < 0) return flow::FILE_ERROR;
+        if (ncdf.InqDimlen("obs", obsStart) < 0) return flow::FILE_ERROR;
+
+        std::vector<std::string> names;
+        ncdf.GetAtt("", "flowline_properties", names);
+        if (names != set.propertyNames) return flow::PARAMS_ERROR;
     } else {
-        f = std::fopen(filename, "w");
+        size_t hint = 0;
+        if (ncdf.Create(filename, NC_CLOBBER | NC_NETCDF4, 0, hint) < 0) return flow::FILE_ERROR;
+
+        int rc = 0;
+        rc |= ncdf.DefDim("trajectory", NC_UNLIMITED);
+        rc |= ncdf.DefDim("obs", NC_UNLIMITED);
+        rc |= ncdf.DefVar("trajectory", NC_INT, {"trajectory"});
+        rc |= ncdf.PutAtt("trajectory", "cf_role", std::string("trajectory_id"));
+        rc |= ncdf.DefVar("rowSize", NC_INT, {"trajectory"});
+        rc |= ncdf.PutAtt("rowSize", "sample_dimension", std::string("obs"));
+        rc |= ncdf.DefVar("x", NC_FLOAT, {"obs"});
+        rc |= ncdf.DefVar("y", NC_FLOAT, {"obs"});
+        rc |= ncdf.DefVar("z", NC_FLOAT, {"obs"});
+        rc |= ncdf.DefVar("time", NC_DOUBLE, {"obs"});
+        for (const auto &n : set.propertyNames) rc |= ncdf.DefVar(propertyVarName(n), NC_FLOAT, {"obs"});
+        rc |= ncdf.PutAtt("", "featureType", std::string("trajectory"));
+        rc |= ncdf.PutAtt("", "flowline_properties", set.propertyNames);
+        rc |= ncdf.EndDef();
+        if (rc < 0) return flow::FILE_ERROR;
     }
-    if (f == nullptr) return FILE_ERROR;
 
-    auto propertyNames = adv->GetPropertyVarNames();
+    const size_t     nStreams = set.GetNumberOfStreams();
+    const size_t     nSamples = set.GetNumberOfSamples();
+    std::vector<int> ids(nStreams), rowSize(nStreams);
+    for (size_t s = 0; s < nStreams; s++) {
+        ids[s] = set.streamIDs[s];
+        rowSize[s] = set.streamOffsets[s + 1] - set.streamOffsets[s];
+    }
 
-    // Write the header
-    if (!append) {
-        std::fprintf(f, "%s", "# ID,  X-position,  Y-position,  Z-position,  Time,  ");
+    int rc = 0;
+    if (nStreams) {
+        rc |= ncdf.PutVara("trajectory", {trajStart}, {nStreams}, ids.data());
+        rc |= ncdf.PutVara("rowSize", {trajStart}, {nStreams}, rowSize.data());
+    }
+    if (nSamples) {
+        rc |= ncdf.PutVara("x", {obsStart}, {nSamples}, set.x.data());
+        rc |= ncdf.PutVara("y", {obsStart}, {nSamples}, set.y.data());
+        rc |= ncdf.PutVara("z", {obsStart}, {nSamples}, set.z.data());
+        rc |= ncdf.PutVara("time", {obsStart}, {nSamples}, set.time.data());
+        for (size_t k = 0; k < set.propertyNames.size(); k++) rc |= ncdf.PutVara(propertyVarName(set.propertyNames[k]), {obsStart}, {nSamples}, set.properties[k].data());
+    }
 
-        for (auto &n : propertyNames) std::fprintf(f, ",  %s", n.c_str());
-        std::fprintf(f, "\n");
+    return rc < 0 ? flow::FILE_ERROR : 0;
+}
+
+int writeNetCDF(const flow::FlowlineSet &set, const char *filename, bool append)
+{
+    VAPoR::NetCDFCpp ncdf;
+
+    int rv = writeNetCDFFile(ncdf, set, filename, append);
+    if (ncdf.Close() < 0 && rv == 0) rv = flow::FILE_ERROR;
+    return rv;
+}
+
+int writeSet(flow::FlowlineSet &set, const char *filename, const std::string &proj4string, bool append, flow::FlowlineFormat format)
+{
+    int rv = project(set, proj4string);
+    if (rv != 0) return rv;
+
+    switch (format) {
+    case flow::FlowlineFormat::BINARY: return writeBinary(set, filename, append);
+    case flow::FlowlineFormat::NETCDF: return writeNetCDF(set, filename, append);
+    default: return writeCSV(set, filename, append);
     }
+}
 
-    // Let's declare variables that will be used repeatedly for
-    //   time and geo coordinate conversion
-    int   year, month, day, hour, minute, second;
-    float cX, cY;    // converted X, Y coordinates
+// Bytes between the current position of `f` and the end of a file of `fileSize` bytes
+uint64_t bytesLeft(std::FILE *f, uint64_t fileSize)
+{
+    long pos = std::ftell(f);
+    return pos < 0 || (uint64_t)pos > fileSize ? 0 : fileSize - pos;
+}
 
-    // Write the trajectories
-    for (size_t s_idx = 0; s_idx < adv->GetNumberOfStreams(); s_idx++) {
-        const auto &stream = adv->GetStreamAt(s_idx);
+// Read one block of a BINARY file and append it to `set`.
+// Counts read from the file are checked against the bytes left in it,
+// so a corrupt block can not trigger a huge allocation.
+// Returns 1 on a clean end of file.
+int readBinaryBlock(std::FILE *f, uint64_t fileSize, flow::FlowlineSet &set, bool first)
+{
+    char magic[sizeof(binaryMagic)];
+    if (std::fread(magic, 1, sizeof(magic), f) != sizeof(magic)) return std::feof(f) && !first ? 1 : flow::FILE_ERROR;
+    if (std::memcmp(magic, binaryMagic, sizeof(magic)) != 0) return flow::FILE_ERROR;
 
-        for (const auto &p : stream) {
-            if (p.time > maxTime) break;
+    bool ok = true;
+    auto get = [&](void *ptr, size_t size, size_t n) {
+        if (ok && n) ok = std::fread(ptr, size, n, f) == n;
+    };
 
-            if (!p.IsSpecial()) {
-                // Let's convert the time!
-                udunits.DecodeTime(p.time, &year, &month, &day, &hour, &minute, &second);
+    uint32_t version = 0, bom = 0, nProps = 0;
+    uint64_t nStreams = 0, nSamples = 0;
+    get(&version, sizeof(version), 1);
+    get(&bom, sizeof(bom), 1);
+    if (!ok || version != binaryVersion || bom != byteOrderMark) return flow::FILE_ERROR;
+    get(&nStreams, sizeof(nStreams), 1);
+    get(&nSamples, sizeof(nSamples), 1);
+    get(&nProps, sizeof(nProps), 1);
+    if (!ok || nProps > bytesLeft(f, fileSize) / sizeof(uint32_t)) return flow::FILE_ERROR;
+
+    std::vector<std::string> names(nProps);
+    for (auto &n : names) {
+        uint32_t len = 0;
+        get(&len, sizeof(len), 1);
+        if (!ok || len > bytesLeft(f, fileSize)) return flow::FILE_ERROR;
+        n.resize(len);
+        get(&n[0], 1, len);
+    }
+    if (!ok) return flow::FILE_ERROR;
+
+    if (first) {
+        set.propertyNames = names;
+        set.properties.assign(nProps, std::vector<float>());
+        set.streamOffsets.assign(1, 0);
+    } else if (names != set.propertyNames)
+        return flow::SIZE_MISMATCH;
+
+    if (nStreams > bytesLeft(f, fileSize) / (2 * sizeof(uint64_t))) return flow::FILE_ERROR;
+
+    std::vector<uint64_t> ids(nStreams), counts(nStreams);
+    get(ids.data(), sizeof(uint64_t), nStreams);
+    get(counts.data(), sizeof(uint64_t), nStreams);
+    if (!ok) return flow::FILE_ERROR;
+
+    const size_t base = set.x.size();
+    uint64_t     sum = 0;
+    for (size_t s = 0; s < nStreams; s++) {
+        sum += counts[s];
+        set.streamIDs.push_back(ids[s]);
+        set.streamOffsets.push_back(base + sum);
+    }
+    if (sum != nSamples) return flow::FILE_ERROR;
+    const uint64_t sampleSize = 3 * sizeof(float) + sizeof(double) + nProps * sizeof(float);
+    if (nSamples > bytesLeft(f, fileSize) / sampleSize) return flow::FILE_ERROR;
+
+    set.x.resize(base + nSamples);
+    set.y.resize(base + nSamples);
+    set.z.resize(base + nSamples);
+    set.time.resize(base + nSamples);
+    get(set.x.data() + base, sizeof(float), nSamples);
+    get(set.y.data() + base, sizeof(float), nSamples);
+    get(set.z.data() + base, sizeof(float), nSamples);
+    get(set.time.data() + base, sizeof(double), nSamples);
+    for (auto &col : set.properties) {
+        col.resize(base + nSamples);
+        get(col.data() + base, sizeof(float), nSamples);
+    }
+
+    return ok ? 0 : flow::FILE_ERROR;
+}
 
-                // Let's also convert geo coordinates if needed.
-                cX = p.location.x;
-                cY = p.location.y;
-                if (needGeoConversion) { proj4API.Transform(&cX, &cY, 1); }
+// Read `set` from `ncdf`, which the caller closes on success or failure
+int readNetCDFFile(VAPoR::NetCDFCpp &ncdf, const std::string &filename, flow::FlowlineSet &set)
+{
+    if (ncdf.Open(filename, NC_NOWRITE) < 0) return flow::FILE_ERROR;
+
+    size_t nStreams = 0, nSamples = 0;
+    if (ncdf.InqDimlen("trajectory", nStreams) < 0) return flow::FILE_ERROR;
+    if (ncdf.InqDimlen("obs", nSamples) < 0) return flow::FILE_ERROR;
+    ncdf.GetAtt("", "flowline_properties", set.propertyNames);
+
+    std::vector<int> ids(nStreams), rowSize(nStreams);
+    set.x.resize(nSamples);
+    set.y.resize(nSamples);
+    set.z.resize(nSamples);
+    set.time.resize(nSamples);
+    set.properties.assign(set.propertyNames.size(), std::vector<float>(nSamples));
+
+    int rc = 0;
+    if (nStreams) {
+        rc |= ncdf.GetVar("trajectory", ids.data());
+        rc |= ncdf.GetVar("rowSize", rowSize.data());
+    }
+    if (nSamples) {
+        rc |= ncdf.GetVar("x", set.x.data());
+        rc |= ncdf.GetVar("y", set.y.data());
+        rc |= ncdf.GetVar("z", set.z.data());
+        rc |= ncdf.GetVar("time", set.time.data());
+        for (size_t k = 0; k < set.propertyNames.size(); k++) rc |= ncdf.GetVar(propertyVarName(set.propertyNames[k]), set.properties[k].data());
+    }
+    if (rc < 0) return flow::FILE_ERROR;
 
-                std::fprintf(f, "%lu, %f, %f, %f, %4.4d-%2.2d-%2.2d_%2.2d:%2.2d:%2.2d", s_idx, cX, cY, p.location.z, year, month, day, hour, minute, second);
+    set.streamIDs.assign(ids.begin(), ids.end());
+    set.streamOffsets.assign(1, 0);
+    for (size_t s = 0; s < nStreams; s++) set.streamOffsets.push_back(set.streamOffsets.back() + rowSize[s]);
+    if (set.streamOffsets.back() != nSamples) return flow::FILE_ERROR;
 
-                auto props = p.GetPropertyList();
-                // A quick sanity check
-                assert(std::distance(props.cbegin(), props.cend()) == propertyNames.size());
-                for (const auto &val : props) std::fprintf(f, ", %f", val);
+    return 0;
+}
 
-                std::fprintf(f, "\n");    // end of one line
-            }
-        }
+int readNetCDF(const std::string &filename, flow::FlowlineSet &set)
+{
+    VAPoR::NetCDFCpp ncdf;
+
+    int rv = readNetCDFFile(ncdf, filename, set);
+    ncdf.Close();
+    return rv;
+}
+
+};    // namespace
+
+auto flow::FlowlineFormatFromFilename(const std::string &filename) -> FlowlineFormat
+{
+    auto dot = filename.rfind('.');
+    if (dot == std::string::npos) return FlowlineFormat::CSV;
+
+    std::string ext = filename.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    if (ext == "nc") return FlowlineFormat::NETCDF;
+    if (ext == "vfl" || ext == "bin") return FlowlineFormat::BINARY;
+    return FlowlineFormat::CSV;
+}
+
+auto flow::OutputFlowlinesNumSteps(const Advection *adv, const char *filename, size_t numSteps, const std::string &proj4string, bool append, FlowlineFormat format) -> int
+{
+    FlowlineSet set;
+    gatherNumSteps(adv, numSteps, set);
+    return writeSet(set, filename, proj4string, append, format);
+}
+
+auto flow::OutputFlowlinesMaxTime(const Advection *adv, const char *filename, double maxTime, const std::string &proj4string, bool append, FlowlineFormat format) -> int
+{
+    FlowlineSet set;
+    gatherMaxTime(adv, maxTime, set);
+    return writeSet(set, filename, proj4string, append, format);
+}
+
+auto flow::InputFlowlines(const std::string &filename, FlowlineSet &set) -> int
+{
+    set = FlowlineSet();
+
+    std::FILE *f = std::fopen(filename.c_str(), "rb");
+    if (f == nullptr) return FILE_ERROR;
+
+    char magic[sizeof(binaryMagic)] = {0};
+    bool isBinary = std::fread(magic, 1, sizeof(magic), f) == sizeof(magic) && std::memcmp(magic, binaryMagic, sizeof(magic)) == 0;
+
+    if (!isBinary) {
+        std::fclose(f);
+        return readNetCDF(filename, set);
     }
 
+    std::fseek(f, 0, SEEK_END);
+    long fileSize = std::ftell(f);
+    if (fileSize < 0) {
+        std::fclose(f);
+        return FILE_ERROR;
+    }
+
+    std::rewind(f);
+    int rv = 0;
+    for (bool first = true; rv == 0; first = false) rv = readBinaryBlock(f, fileSize, set, first);
     std::fclose(f);
 
-    return 0;
+    return rv == 1 ? 0 : rv;
 }
 
 auto flow::InputSeedsCSV(const std::string &filename) -> std::vector<flow::Particle>
@@ -86,6 +86,7 @@ auto VaporField::LockParams() -> int
 
     for (int i = 0; i < 3; i++) { _c_velocity_grids[i] = _getAGrid(_c_currentTS, this->VelocityNames[i]); }
     _c_scalar_grid = _getAGrid(_c_currentTS, this->ScalarName);
+    _velocityMeshInfo(_c_vel_shared_mesh, _c_vel_static_mesh);
 
     // Note that if the DefaultZ value is changed by the renderer after LockParams(),
     // cached grids here won't reflect the change.
@@ -107,6 +108,8 @@ auto VaporField::UnlockParams() -> int
 
     for (int i = 0; i < 3; i++) { _c_velocity_grids[i] = nullptr; }
     _c_scalar_grid = nullptr;
+    _c_vel_shared_mesh = false;
+    _c_vel_static_mesh = false;
 
     _params_locked = false;
     return 0;
@@ -238,33 +241,39 @@ int VaporField::GetVelocityIntersection(size_t ts, glm::vec3 &minxyz, glm::vec3
 
 int VaporField::GetVelocity(double time, const glm::vec3 &pos, glm::vec3 &velocity) const
 {
-    const std::array<double, 3> coords{pos.x, pos.y, pos.z};
-    const VAPoR::Grid *         grid = nullptr;
+    const VAPoR::DblArr3               coords{pos.x, pos.y, pos.z};
+    std::array<const VAPoR::Grid *, 3> grids;
+
+    // When the components share a mesh the point is located only once,
+    // and if the mesh is constant in time, only once for both time steps.
+    bool shared, isStatic;
+    if (_params_locked) {
+        shared = _c_vel_shared_mesh;
+        isStatic = _c_vel_static_mesh;
+    } else
+        _velocityMeshInfo(shared, isStatic);
+
+    VAPoR::Grid::InterpolationStencil stencil;
+    bool                              haveStencil = false;
 
-    // Retrieve the missing value and velocity multiplier
-    glm::vec3 missingV(0.0f);    // stores missing values for 3 velocity variables
     velocity = glm::vec3(0.0f);
 
     if (IsSteady) {
         for (int i = 0; i < 3; i++) {
             if (_params_locked) {
-                grid = _c_velocity_grids[i];
+                grids[i] = _c_velocity_grids[i];
             } else {
                 auto currentTS = _params->GetCurrentTimestep();
-                grid = _getAGrid(currentTS, VelocityNames[i]);
+                grids[i] = _getAGrid(currentTS, VelocityNames[i]);
             }
-            if (grid == nullptr) return GRID_ERROR;
-            velocity[i] = grid->GetValue(coords);
-            missingV[i] = grid->GetMissingValue();
+            if (grids[i] == nullptr) return GRID_ERROR;
         }
-        auto  hasMissing = glm::equal(velocity, missingV);
+        int rv = _sampleVelocity(grids, coords, shared, stencil, haveStencil, velocity);
+        if (rv != 0) return rv;
+
         float mult = _params_locked ? _c_vel_mult : _params->GetVelocityMultiplier();
-        if (glm::any(hasMissing))
-            return MISSING_VAL;
-        else {
-            velocity *= mult;
-            return 0;
-        }
+        velocity *= mult;
+        return 0;
     } else {
         float mult = _params->GetVelocityMultiplier();
 
@@ -280,13 +289,11 @@ int VaporField::GetVelocity(double time, const glm::vec3 &pos, glm::vec3 &veloci
         glm::vec3 floorVelocity(0.f, 0.f, 0.f);
         glm::vec3 ceilingVelocity(0.f, 0.f, 0.f);
         for (int i = 0; i < 3; i++) {
-            grid = _getAGrid(floorTS, VelocityNames[i]);
-            if (grid == nullptr) return GRID_ERROR;
-            floorVelocity[i] = grid->GetValue(coords);
-            missingV[i] = grid->GetMissingValue();
+            grids[i] = _getAGrid(floorTS, VelocityNames[i]);
+            if (grids[i] == nullptr) return GRID_ERROR;
         }
-        auto hasMissing = glm::equal(floorVelocity, missingV);
-        if (glm::any(hasMissing)) { return MISSING_VAL; }
+        rv = _sampleVelocity(grids, coords, shared, stencil, haveStencil, floorVelocity);
+        if (rv != 0) return rv;
 
         if (time == _timestamps[floorTS]) {
             velocity = floorVelocity * mult;
@@ -296,13 +303,12 @@ int VaporField::GetVelocity(double time, const glm::vec3 &pos, glm::vec3 &veloci
             // We need to make sure there aren't duplicate time stamps
             VAssert(_timestamps[floorTS + 1] > _timestamps[floorTS]);
             for (int i = 0; i < 3; i++) {
-                grid = _getAGrid(floorTS + 1, VelocityNames[i]);
-                if (grid == nullptr) return GRID_ERROR;
-                ceilingVelocity[i] = grid->GetValue(coords);
-                missingV[i] = grid->GetMissingValue();
+                grids[i] = _getAGrid(floorTS + 1, VelocityNames[i]);
+                if (grids[i] == nullptr) return GRID_ERROR;
             }
-            hasMissing = glm::equal(ceilingVelocity, missingV);
-            if (glm::any(hasMissing)) { return MISSING_VAL; }
+            if (!isStatic) haveStencil = false;
+            rv = _sampleVelocity(grids, coords, shared, stencil, haveStencil, ceilingVelocity);
+            if (rv != 0) return rv;
 
             float weight = (time - _timestamps[floorTS]) / (_timestamps[floorTS + 1] - _timestamps[floorTS]);
             velocity = glm::mix(floorVelocity, ceilingVelocity, weight) * mult;
@@ -311,6 +317,48 @@ int VaporField::GetVelocity(double time, const glm::vec3 &pos, glm::vec3 &veloci
     }    // end of unsteady condition
 }
 
+int VaporField::_sampleVelocity(const std::array<const VAPoR::Grid *, 3> &grids, const VAPoR::DblArr3 &coords, bool shared, VAPoR::Grid::InterpolationStencil &stencil, bool &haveStencil,
+                                glm::vec3 &velocity) const
+{
+    // Variables on the same mesh may still be read as differently sized
+    // grids (e.g. at different refinement levels), so the geometry of
+    // the grids themselves is compared too.
+    bool useStencil = shared;
+    for (int i = 1; i < 3 && useStencil; i++) {
+        if (grids[i]->GetNodeDimensions() != grids[0]->GetNodeDimensions() || grids[i]->GetInterpolationOrder() != grids[0]->GetInterpolationOrder()) useStencil = false;
+    }
+
+    if (useStencil && !haveStencil) haveStencil = grids[0]->GetInterpolationStencil(coords, stencil);
+    useStencil = useStencil && haveStencil;
+
+    for (int i = 0; i < 3; i++) {
+        velocity[i] = useStencil ? grids[i]->InterpolateStencil(stencil) : grids[i]->GetValue(coords);
+        if (velocity[i] == grids[i]->GetMissingValue()) return MISSING_VAL;
+    }
+    return 0;
+}
+
+void VaporField::_velocityMeshInfo(bool &shared, bool &isStatic) const
+{
+    shared = false;
+    isStatic = false;
+    if (_datamgr == nullptr) return;
+
+    // Empty names are sampled from a ConstantGrid
+    std::array<std::vector<std::string>, 3> coordVars;
+    for (int i = 0; i < 3; i++) {
+        if (VelocityNames[i].empty()) return;
+        if (!_datamgr->GetVarCoordVars(VelocityNames[i], true, coordVars[i])) return;
+    }
+    if (coordVars[1] != coordVars[0] || coordVars[2] != coordVars[0]) return;
+
+    shared = true;
+    isStatic = true;
+    for (const auto &v : coordVars[0]) {
+        if (_datamgr->IsTimeVarying(v)) isStatic = false;
+    }
+}
+
 int VaporField::GetScalar(double time, const glm::vec3 &pos, float &scalar) const
 {
     // When this variable doesn't exist, it doesn't make sense to get a scalar value
@@ -7,6 +7,7 @@ using namespace Wasp;
 using namespace VAPoR;
 
 const std::string ModelParams::FileTag = "FileTag";
+const std::string ModelParams::MergeMeshesTag = "MergeMeshesTag";
 
 //
 // Register class with object factory!!!
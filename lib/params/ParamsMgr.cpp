@@ -1072,12 +1072,10 @@ int ParamsMgr::SaveToFile(string path) const
 
 bool ParamsMgr::undoRedoHelper()
 {
-    string description;
-
-    // Get top of **undo** stack
+    // The state save class has already moved its current state to the
+    // top of the **undo** stack (or the base state if the stack is empty)
     //
-    const XmlNode *newNode = _ssave.GetTopUndo(description);
-    if (!newNode) { newNode = _ssave.GetBase(); }
+    const XmlNode *newNode = _ssave.GetCurrent();
     if (!newNode) return (false);    // nothing to undo - shouldnt get here
 
     // Need to disable state saving so the undo itself doesn't trigger
@@ -1140,7 +1138,7 @@ ParamsMgr::PMgrStateSave::PMgrStateSave(int stackSize) : StateSave()
     _enabled = true;
     _stackSize = stackSize;
     _rootNode = NULL;
-    _state0 = NULL;
+    _current = NULL;
     _undoStack.clear();
     _redoStack.clear();
 }
@@ -1149,7 +1147,19 @@ ParamsMgr::PMgrStateSave::~PMgrStateSave()
 {
     cleanStack(0, _undoStack);
     cleanStack(0, _redoStack);
-    if (_state0) delete _state0;
+    if (_current) delete _current;
+}
+
+void ParamsMgr::PMgrStateSave::Rebase()
+{
+    // Stack entries are differences relative to the current state and
+    // are meaningless once it is replaced
+    //
+    cleanStack(0, _undoStack);
+    cleanStack(0, _redoStack);
+
+    if (_current) delete _current;
+    _current = _rootNode ? new XmlNode(*_rootNode) : NULL;
 }
 
 void ParamsMgr::PMgrStateSave::Save(const XmlNode *node, string description)
@@ -1165,27 +1175,21 @@ void ParamsMgr::PMgrStateSave::Save(const XmlNode *node, string description)
     vector<string> pathvec = node->GetPathVec();
     if ((!pathvec.size()) || (pathvec[0] != _rootTag)) { return; }
 
-    if (GetUndoEnabled()) {
-        const XmlNode *topNode = NULL;
-        string         s;
-        topNode = GetTopUndo(s);
-        if (topNode && (*topNode == *_rootNode)) {
-            // Don't save tree if no changes
-            return;
-        }
-    }
-
     if (!_groups.empty()) { return; }
 
-    if (!_state0) { _state0 = new XmlNode(*_rootNode); }
-
-    // Delete oldest elements if needed
-    //
-    cleanStack(_stackSize, _undoStack);
+    if (!_current) { _current = new XmlNode(*_rootNode); }
 
     // It not inside a group push this element onto the stack
     //
-    if (GetUndoEnabled()) _undoStack.push_back(make_pair(description, new XmlNode(*_rootNode)));
+    if (GetUndoEnabled()) {
+        XmlNodeDiff *diff = new XmlNodeDiff(*_current, *_rootNode);
+        if (diff->Empty() && _undoStack.size()) {
+            // Don't save tree if no changes
+            delete diff;
+            return;
+        }
+        pushUndo(description, diff);
+    }
 
 //#define DEBUG
 #ifdef DEBUG
@@ -1223,59 +1227,53 @@ void ParamsMgr::PMgrStateSave::EndGroup()
     //
     if (_groups.size()) return;
 
-    const XmlNode *topNode = NULL;
-    string         s;
-    topNode = GetTopUndo(s);
+    if (!_current) { _current = new XmlNode(*_rootNode); }
 
-    if (topNode && (*topNode == *_rootNode)) {
+    XmlNodeDiff *diff = new XmlNodeDiff(*_current, *_rootNode);
+    if (diff->Empty() && _undoStack.size()) {
         // Don't save tree if no changes
         //
+        delete diff;
         return;
     }
 
-    if (!_state0) { _state0 = new XmlNode(*_rootNode); }
-
 #ifdef DEBUG
     cout << "ParamsMgr::PMgrStateSave::EndGroup() : saving "
          << " : " << desc << endl;
 #endif
 
-    // Delete oldest elements if needed
-    //
-    cleanStack(_stackSize, _undoStack);
-
     // Clear redo stack
     //
     cleanStack(0, _redoStack);
 
-    _undoStack.push_back(make_pair(desc, new XmlNode(*_rootNode)));
+    pushUndo(desc, diff);
 
     emitStateChange();
 }
 
 void ParamsMgr::PMgrStateSave::IntermediateChange() { emitIntermediateStateChange(); }
 
-const XmlNode *ParamsMgr::PMgrStateSave::GetTopUndo(string &description) const
+const XmlNodeDiff *ParamsMgr::PMgrStateSave::GetTopUndo(string &description) const
 {
     VAssert(_rootNode);
     description.clear();
 
     if (!_undoStack.size()) return (NULL);
 
-    const pair<string, XmlNode *> &p1 = _undoStack.back();
+    const pair<string, XmlNodeDiff *> &p1 = _undoStack.back();
 
     description = p1.first;
     return (p1.second);
 }
 
-const XmlNode *ParamsMgr::PMgrStateSave::GetTopRedo(string &description) const
+const XmlNodeDiff *ParamsMgr::PMgrStateSave::GetTopRedo(string &description) const
 {
     VAssert(_rootNode);
     description.clear();
 
     if (!_redoStack.size()) return (NULL);
 
-    const pair<string, XmlNode *> &p1 = _redoStack.back();
+    const pair<string, XmlNodeDiff *> &p1 = _redoStack.back();
 
     description = p1.first;
     return (p1.second);
@@ -1286,8 +1284,11 @@ bool ParamsMgr::PMgrStateSave::Undo()
     VAssert(_rootNode);
 
     if (!_undoStack.size()) return (false);
+    VAssert(_current);
 
-    pair<string, XmlNode *> &p1 = _undoStack.back();
+    pair<string, XmlNodeDiff *> p1 = _undoStack.back();
+
+    p1.second->Revert(_current);
 
     // Delete oldest elements if needed
     //
@@ -1307,8 +1308,11 @@ bool ParamsMgr::PMgrStateSave::Redo()
     VAssert(_rootNode);
 
     if (!_redoStack.size()) return (false);
+    VAssert(_current);
+
+    pair<string, XmlNodeDiff *> p1 = _redoStack.back();
 
-    pair<string, XmlNode *> &p1 = _redoStack.back();
+    p1.second->Apply(_current);
 
     // Delete oldest elements if needed
     //
@@ -1332,12 +1336,26 @@ void ParamsMgr::PMgrStateSave::Clear()
     while (_groups.size()) _groups.pop();
 }
 
-void ParamsMgr::PMgrStateSave::cleanStack(int maxN, std::deque<std::pair<string, XmlNode *>> &s)
+void ParamsMgr::PMgrStateSave::pushUndo(string description, XmlNodeDiff *diff)
+{
+    // Bring the shadow copy up to date with the saved state. Only the
+    // changed elements are touched.
+    //
+    diff->Apply(_current);
+
+    // Delete oldest elements if needed
+    //
+    cleanStack(_stackSize, _undoStack);
+
+    _undoStack.push_back(make_pair(description, diff));
+}
+
+void ParamsMgr::PMgrStateSave::cleanStack(int maxN, std::deque<std::pair<string, XmlNodeDiff *>> &s)
 {
     // Delete oldest elements if needed
     //
     while (s.size() > maxN) {
-        pair<string, XmlNode *> &p1 = s.front();
+        pair<string, XmlNodeDiff *> &p1 = s.front();
 
         if (p1.second) { delete p1.second; }
 
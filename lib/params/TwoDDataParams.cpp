@@ -12,6 +12,8 @@ using namespace VAPoR;
 //
 static RenParamsRegistrar<TwoDDataParams> registrar(TwoDDataParams::GetClassType());
 
+const string TwoDDataParams::_maxMeshDimTag = "MaxMeshDim";
+
 TwoDDataParams::TwoDDataParams(DataMgr *dataMgr, ParamsBase::StateSave *ssave) : RenderParams(dataMgr, ssave, TwoDDataParams::GetClassType(), 2)
 {
     SetDiagMsg("TwoDDataParams::TwoDDataParams() this=%p", this);
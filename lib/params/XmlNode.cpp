@@ -32,9 +32,12 @@
 using namespace VAPoR;
 using namespace Wasp;
 
-// Enable memory checking
+// Enable memory checking in debug builds. Allocated nodes are tracked
+// in XmlNode::_allocatedNodes
 //
-#define MEMCHECK
+#ifndef NDEBUG
+    #define MEMCHECK
+#endif
 
 namespace VAPoR {
 vector<double>         XmlNode::_emptyDoubleVec;
@@ -107,6 +110,7 @@ XmlNode::XmlNode(const string &tag, const map<string, string> &attrs, size_t num
     if (numChildrenHint) _children.reserve(numChildrenHint);
 
 #ifdef MEMCHECK
+    _allocIndex = _allocatedNodes.size();
     _allocatedNodes.push_back(this);
 #endif
 }
@@ -129,6 +133,7 @@ XmlNode::XmlNode(const string &tag, size_t numChildrenHint)
     if (numChildrenHint) _children.reserve(numChildrenHint);
 
 #ifdef MEMCHECK
+    _allocIndex = _allocatedNodes.size();
     _allocatedNodes.push_back(this);
 #endif
 }
@@ -145,24 +150,27 @@ XmlNode::XmlNode()
     _parent = NULL;
 
 #ifdef MEMCHECK
+    _allocIndex = _allocatedNodes.size();
     _allocatedNodes.push_back(this);
 #endif
 }
 
 XmlNode::XmlNode(const XmlNode &rhs)
-: _longmap(rhs._longmap), _doublemap(rhs._doublemap), _stringmap(rhs._stringmap), _attrmap(rhs._attrmap), _children(rhs._children), _tag(rhs._tag), _asciiLimit(rhs._asciiLimit),
+: _longmap(rhs._longmap), _doublemap(rhs._doublemap), _stringmap(rhs._stringmap), _attrmap(rhs._attrmap), _tag(rhs._tag), _asciiLimit(rhs._asciiLimit),
   _parent(NULL)    // Set parent to NULL
 {
-    _children.clear();
-    for (int i = 0; i < rhs._children.size(); i++) { AddChild(rhs._children[i]); }
+    _copyChildren(rhs);
 
 #ifdef MEMCHECK
+    _allocIndex = _allocatedNodes.size();
     _allocatedNodes.push_back(this);
 #endif
 }
 
 XmlNode &XmlNode::operator=(const XmlNode &rhs)
 {
+    if (this == &rhs) return (*this);
+
     DeleteAll();
     MyBase::operator=(rhs);
 
@@ -171,17 +179,30 @@ XmlNode &XmlNode::operator=(const XmlNode &rhs)
     _doublemap = rhs._doublemap;
     _stringmap = rhs._stringmap;
     _attrmap = rhs._attrmap;
-    _children = rhs._children;
     _tag = rhs._tag;
     _asciiLimit = rhs._asciiLimit;
     _parent = NULL;    // Set parent to NULL
 
-    _children.clear();
-    for (int i = 0; i < rhs._children.size(); i++) { AddChild(rhs._children[i]); }
+    _copyChildren(rhs);
 
     return (*this);
 }
 
+// Deep copy the children of rhs. Sibling tags in rhs are already unique,
+// so unlike AddChild() there is no need to search for duplicates
+//
+void XmlNode::_copyChildren(const XmlNode &rhs)
+{
+    VAssert(_children.empty());
+
+    _children.reserve(rhs._children.size());
+    for (int i = 0; i < rhs._children.size(); i++) {
+        XmlNode *mychild = new XmlNode(*rhs._children[i]);
+        mychild->_parent = this;
+        _children.push_back(mychild);
+    }
+}
+
 bool XmlNode::operator==(const XmlNode &rhs) const
 {
     if (_longmap != rhs._longmap) return (false);
@@ -209,13 +230,13 @@ XmlNode::~XmlNode()
     DeleteAll();
 
 #ifdef MEMCHECK
-    std::vector<XmlNode *>::iterator itr;
-    for (itr = _allocatedNodes.begin(); itr != _allocatedNodes.end(); ++itr) {
-        if (*itr == this) {
-            _allocatedNodes.erase(itr);
-            break;
-        }
-    }
+    // Constant time removal: move the last node into our slot
+    //
+    VAssert(_allocIndex < _allocatedNodes.size() && _allocatedNodes[_allocIndex] == this);
+    XmlNode *last = _allocatedNodes.back();
+    _allocatedNodes[_allocIndex] = last;
+    last->_allocIndex = _allocIndex;
+    _allocatedNodes.pop_back();
 #endif
 }
 
@@ -616,6 +637,156 @@ ostream &XmlNode::streamOut(ostream &os, const XmlNode &node)
     return os;
 }
 
+namespace {
+
+// Record the entries of 'from' that are modified or removed in 'to' in
+// 'oldm', and the entries of 'to' that are modified or added in 'newm'
+//
+template<class T> void diffMaps(const map<string, T> &from, const map<string, T> &to, map<string, T> &oldm, map<string, T> &newm)
+{
+    if (from == to) return;
+
+    for (auto itr = from.begin(); itr != from.end(); ++itr) {
+        auto p = to.find(itr->first);
+        if (p == to.end() || !(p->second == itr->second)) oldm.insert(*itr);
+    }
+    for (auto itr = to.begin(); itr != to.end(); ++itr) {
+        auto p = from.find(itr->first);
+        if (p == from.end() || !(p->second == itr->second)) newm.insert(*itr);
+    }
+}
+
+template<class T> void patchMap(map<string, T> &m, const map<string, T> &remove, const map<string, T> &add)
+{
+    for (auto itr = remove.begin(); itr != remove.end(); ++itr) m.erase(itr->first);
+    for (auto itr = add.begin(); itr != add.end(); ++itr) m[itr->first] = itr->second;
+}
+
+vector<string> childTags(const XmlNode &node)
+{
+    vector<string> tags;
+    for (int i = 0; i < node.GetNumChildren(); i++) tags.push_back(node.GetChild(i)->GetTag());
+    return (tags);
+}
+};    // namespace
+
+bool XmlNodeDiff::NodeChange::Empty() const
+{
+    return (oldTag == newTag && oldLongs.empty() && newLongs.empty() && oldDoubles.empty() && newDoubles.empty() && oldStrings.empty() && newStrings.empty() && oldAttrs.empty() && newAttrs.empty()
+            && oldOrder.empty() && newOrder.empty());
+}
+
+XmlNodeDiff::XmlNodeDiff(const XmlNode &from, const XmlNode &to)
+{
+    vector<string> path;
+    _diff(from, to, path);
+}
+
+XmlNodeDiff::~XmlNodeDiff()
+{
+    for (int i = 0; i < _changes.size(); i++) {
+        NodeChange *c = _changes[i];
+        for (int j = 0; j < c->oldChildren.size(); j++) delete c->oldChildren[j];
+        for (int j = 0; j < c->newChildren.size(); j++) delete c->newChildren[j];
+        delete c;
+    }
+    _changes.clear();
+}
+
+void XmlNodeDiff::_diff(const XmlNode &from, const XmlNode &to, vector<string> &path)
+{
+    NodeChange *c = new NodeChange();
+    c->path = path;
+    c->oldTag = from._tag;
+    c->newTag = to._tag;
+
+    diffMaps(from._longmap, to._longmap, c->oldLongs, c->newLongs);
+    diffMaps(from._doublemap, to._doublemap, c->oldDoubles, c->newDoubles);
+    diffMaps(from._stringmap, to._stringmap, c->oldStrings, c->newStrings);
+    diffMaps(from._attrmap, to._attrmap, c->oldAttrs, c->newAttrs);
+
+    // Pair up children by tag. In the common case the children are
+    // unchanged and can be paired by position.
+    //
+    vector<pair<const XmlNode *, const XmlNode *>> common;
+
+    vector<string> fromTags = childTags(from);
+    vector<string> toTags = childTags(to);
+    if (fromTags == toTags) {
+        for (int i = 0; i < from._children.size(); i++) { common.push_back(make_pair(from._children[i], to._children[i])); }
+    } else {
+        c->oldOrder = fromTags;
+        c->newOrder = toTags;
+
+        for (int i = 0; i < from._children.size(); i++) {
+            const XmlNode *child = to.GetChild(from._children[i]->_tag);
+            if (!child) c->oldChildren.push_back(new XmlNode(*from._children[i]));
+        }
+        for (int i = 0; i < to._children.size(); i++) {
+            const XmlNode *child = from.GetChild(to._children[i]->_tag);
+            if (child) {
+                common.push_back(make_pair(child, to._children[i]));
+            } else {
+                c->newChildren.push_back(new XmlNode(*to._children[i]));
+            }
+        }
+    }
+
+    // Parents must precede their descendants so that patching can
+    // look up the descendants by path
+    //
+    if (c->Empty()) {
+        delete c;
+    } else {
+        _changes.push_back(c);
+    }
+
+    for (int i = 0; i < common.size(); i++) {
+        path.push_back(common[i].first->_tag);
+        _diff(*common[i].first, *common[i].second, path);
+        path.pop_back();
+    }
+}
+
+void XmlNodeDiff::_patch(XmlNode *root, bool forward) const
+{
+    VAssert(root);
+
+    for (int i = 0; i < _changes.size(); i++) {
+        const NodeChange *c = _changes[i];
+
+        XmlNode *node = c->path.empty() ? root : root->GetNode(c->path, false);
+        VAssert(node);
+
+        node->_tag = forward ? c->newTag : c->oldTag;
+
+        patchMap(node->_longmap, forward ? c->oldLongs : c->newLongs, forward ? c->newLongs : c->oldLongs);
+        patchMap(node->_doublemap, forward ? c->oldDoubles : c->newDoubles, forward ? c->newDoubles : c->oldDoubles);
+        patchMap(node->_stringmap, forward ? c->oldStrings : c->newStrings, forward ? c->newStrings : c->oldStrings);
+        patchMap(node->_attrmap, forward ? c->oldAttrs : c->newAttrs, forward ? c->newAttrs : c->oldAttrs);
+
+        if (c->oldOrder.empty() && c->newOrder.empty()) continue;
+
+        const vector<XmlNode *> &remove = forward ? c->oldChildren : c->newChildren;
+        const vector<XmlNode *> &add = forward ? c->newChildren : c->oldChildren;
+        for (int j = 0; j < remove.size(); j++) { node->DeleteChild(remove[j]->_tag); }
+        for (int j = 0; j < add.size(); j++) { node->AddChild(add[j]); }
+
+        // Restore the order of the children
+        //
+        const vector<string> &order = forward ? c->newOrder : c->oldOrder;
+        VAssert(order.size() == node->_children.size());
+        for (int j = 0; j < order.size(); j++) {
+            for (int k = j; k < node->_children.size(); k++) {
+                if (node->_children[k]->_tag == order[j]) {
+                    std::swap(node->_children[j], node->_children[k]);
+                    break;
+                }
+            }
+        }
+    }
+}
+
 namespace VAPoR {
 std::ostream &operator<<(ostream &os, const VAPoR::XmlNode &node)
 {
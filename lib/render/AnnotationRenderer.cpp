@@ -34,6 +34,7 @@
 #include <vapor/ResourcePath.h>
 #include "vapor/LegacyGL.h"
 #include "vapor/TextLabel.h"
+#include "vapor/FontManager.h"
 #include "vapor/AnnotationParams.h"
 #define INCLUDE_DEPRECATED_LEGACY_VECTOR_MATH
 #include <vapor/LegacyVectorMath.h>
@@ -182,11 +183,13 @@ void AnnotationRenderer::drawDomainFrame(std::vector<double> corners) const
 void AnnotationRenderer::DrawText()
 {
     _glManager->PixelCoordinateSystemPush();
+    _glManager->fontManager->BeginTextBatch();
 
     DrawText(_miscAnnot);
     DrawText(_timeAnnot);
     DrawText(_axisAnnot);
 
+    _glManager->fontManager->EndTextBatch();
     _glManager->PixelCoordinateSystemPop();
 }
 
@@ -466,7 +469,11 @@ void AnnotationRenderer::InScenePaint(size_t ts)
     vpParams->SetModelViewMatrix(mvMatrix);
 
     AxisAnnotation *aa = vfParams->GetAxisAnnotation();
-    if (aa->GetAxisAnnotationEnabled()) { drawAxisTics(aa); }
+    if (aa->GetAxisAnnotationEnabled()) {
+        _glManager->fontManager->BeginTextBatch();
+        drawAxisTics(aa);
+        _glManager->fontManager->EndTextBatch();
+    }
 
     mm->MatrixModeModelView();
     mm->PopMatrix();
@@ -30,6 +30,8 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 #include <limits>
 
 #ifndef WIN32
@@ -50,6 +52,8 @@
 #include <vapor/LegacyVectorMath.h>
 #include "vapor/LegacyGL.h"
 #include "vapor/GLManager.h"
+#include <vapor/ShaderProgram.h>
+#include <vapor/TaskScheduler.h>
 #include <glm/gtc/type_ptr.hpp>
 
 #define X    0
@@ -69,6 +73,55 @@ using namespace Wasp;
 
 static RendererRegistrar<BarbRenderer> registrar(BarbRenderer::GetClassType(), BarbParams::GetClassType());
 
+namespace {
+
+// Number of floats per barb instance: position (3), unit direction (3),
+// vector magnitude (1), and color variable value (1)
+//
+const int barbInstanceSize = 8;
+
+// Append the vertices of the shared barb mesh, a hexagonal tube with a
+// cone barb head, as triangles. See Barb.vert for the vertex layout.
+//
+void makeBarbMesh(vector<float> &mesh)
+{
+    // Constants are needed for cosines and sines, at
+    // 60 degree intervals. The barb is really a hexagonal tube,
+    // but the shading makes it look round.
+    const float sines[6] = {0.f, (float)(sqrt(3.) / 2.), (float)(sqrt(3.) / 2.), 0.f, (float)(-sqrt(3.) / 2.), (float)(-sqrt(3.) / 2.)};
+    const float coses[6] = {1.f, 0.5, -0.5, -1., -.5, 0.5};
+
+    auto vertex = [&mesh](float x, float y, float lengthOffset, float radiusOffset, float nx, float ny, float nz) { mesh.insert(mesh.end(), {x, y, lengthOffset, radiusOffset, nx, ny, nz}); };
+
+    // Tube sides, from the start of the barb to where the head attaches
+    //
+    for (int i = 0; i < 6; i++) {
+        int n = (i + 1) % 6;
+        vertex(coses[i], sines[i], 0.f, 0.f, coses[i], sines[i], 0.f);
+        vertex(coses[n], sines[n], 0.f, 0.f, coses[n], sines[n], 0.f);
+        vertex(coses[i], sines[i], BARB_LENGTH_FACTOR, 0.f, coses[i], sines[i], 0.f);
+
+        vertex(coses[n], sines[n], 0.f, 0.f, coses[n], sines[n], 0.f);
+        vertex(coses[n], sines[n], BARB_LENGTH_FACTOR, 0.f, coses[n], sines[n], 0.f);
+        vertex(coses[i], sines[i], BARB_LENGTH_FACTOR, 0.f, coses[i], sines[i], 0.f);
+    }
+
+    // Barb head. The vertex is one radius beyond the end of the tube
+    // (a 45 degree vertex angle), and the back of the head is
+    // BARB_HEAD_FACTOR - 1 radii behind it. Normals are tilted in the
+    // direction of the barb.
+    //
+    float back = -(BARB_HEAD_FACTOR - 1.0);
+    for (int i = 0; i < 6; i++) {
+        int n = (i + 1) % 6;
+        vertex(0.f, 0.f, BARB_LENGTH_FACTOR, 1.f, 0.f, 0.f, 1.f);
+        vertex(BARB_HEAD_FACTOR * coses[i], BARB_HEAD_FACTOR * sines[i], BARB_LENGTH_FACTOR, back, 0.5 * coses[i], 0.5 * sines[i], 0.5);
+        vertex(BARB_HEAD_FACTOR * coses[n], BARB_HEAD_FACTOR * sines[n], BARB_LENGTH_FACTOR, back, 0.5 * coses[n], 0.5 * sines[n], 0.5);
+    }
+}
+
+};    // namespace
+
 BarbRenderer::BarbRenderer(const ParamsMgr *pm, string winName, string dataSetName, string instName, DataMgr *dataMgr)
 : Renderer(pm, winName, dataSetName, BarbParams::GetClassType(), BarbRenderer::GetClassType(), instName, dataMgr)
 {
@@ -76,12 +129,23 @@ BarbRenderer::BarbRenderer(const ParamsMgr *pm, string winName, string dataSetNa
     _vectorScaleFactor = .2;
     _maxThickness = .2;
     _maxValue = 0.f;
+    _VAO = 0;
+    _meshVBO = 0;
+    _instanceVBO = 0;
+    _nMeshVertices = 0;
+    _nBarbs = 0;
 }
 
 //----------------------------------------------------------------------------
 //
 //----------------------------------------------------------------------------
-BarbRenderer::~BarbRenderer() {}
+BarbRenderer::~BarbRenderer()
+{
+    if (_VAO) glDeleteVertexArrays(1, &_VAO);
+    if (_meshVBO) glDeleteBuffers(1, &_meshVBO);
+    if (_instanceVBO) glDeleteBuffers(1, &_instanceVBO);
+    _VAO = _meshVBO = _instanceVBO = 0;
+}
 
 std::string BarbRenderer::_getColorbarVariableName() const
 {
@@ -89,11 +153,42 @@ std::string BarbRenderer::_getColorbarVariableName() const
     return rParams->GetColorMapVariableName();
 }
 
-// Totally unnecessary?
-//
 int BarbRenderer::_initializeGL()
 {
-    //_initialized = true;
+    vector<float> mesh;
+    makeBarbMesh(mesh);
+    _nMeshVertices = mesh.size() / 7;
+
+    glGenVertexArrays(1, &_VAO);
+    glBindVertexArray(_VAO);
+
+    glGenBuffers(1, &_meshVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, _meshVBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(float), mesh.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 7 * sizeof(float), NULL);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void *)(4 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // Per instance attributes: position, direction, magnitude, and value
+    //
+    glGenBuffers(1, &_instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
+    const GLsizei stride = barbInstanceSize * sizeof(float);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, NULL);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void *)(3 * sizeof(float)));
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void *)(6 * sizeof(float)));
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void *)(7 * sizeof(float)));
+    for (int i = 2; i < 6; i++) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    _lutTexture.Generate();
+
     return (0);
 }
 
@@ -207,16 +302,53 @@ int BarbRenderer::_paintGL(bool)
         _saveCacheParams();
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    _setUpLightingAndColor();
+    if (!_nBarbs) return 0;
+
+    BarbParams *bParams = dynamic_cast<BarbParams *>(GetActiveParams());
+    VAssert(bParams);
 
     float clut[1024];
     bool  doColorMapping = _makeCLUT(clut);
-    auto  crange = GetActiveParams()->GetMapperFunc(GetActiveParams()->GetColorMapVariableName())->getMinMaxMapValue();
-    for (auto b : _barbCache) _drawBarb(b, doColorMapping, clut, crange.data());
+    auto  crange = bParams->GetMapperFunc(bParams->GetColorMapVariableName())->getMinMaxMapValue();
+    if (doColorMapping) _lutTexture.TexImage(GL_RGBA8, 256, 0, 0, GL_RGBA, GL_FLOAT, clut);
+
+    float constantColor[4] = {0.f, 0.f, 0.f, 1.f};
+    bParams->GetConstantColor(constantColor);
+
+    string           winName = GetVisualizer();    // GetVisualizer is not const :(
+    ViewpointParams *vpParams = _paramsMgr->GetViewpointParams(winName);
+    float            lightDir[3];
+    for (int i = 0; i < 3; i++) { lightDir[i] = vpParams->getLightDirection(0, i); }
+
+    vector<double> scales = _getScales();
+
+    ShaderProgram *shader = _glManager->shaderManager->GetShader("Barb");
+    if (shader == nullptr) return -1;
+    shader->Bind();
+    shader->SetUniform("P", _glManager->matrixManager->GetProjectionMatrix());
+    shader->SetUniform("MV", _glManager->matrixManager->GetModelViewMatrix());
+    shader->SetUniform("scales", glm::vec3(scales[X], scales[Y], scales[Z]));
+
+    // Length and thickness are applied here, so changing them does not
+    // require the barbs to be regenerated
+    //
+    shader->SetUniform("lengthScale", (float)(bParams->GetLengthScale() * _vectorScaleFactor));
+    shader->SetUniform("radius", (float)(bParams->GetLineThickness() * _maxThickness));
+    shader->SetUniform("lightingEnabled", vpParams->getNumLights() > 0);
+    shader->SetUniform("lightDir", glm::make_vec3(lightDir));
+    shader->SetUniform("useColormap", doColorMapping);
+    shader->SetUniform("constantColor", glm::make_vec4(constantColor));
+    shader->SetUniform("minLUTValue", (float)crange[0]);
+    shader->SetUniform("maxLUTValue", (float)crange[1]);
+    shader->SetSampler("colormap", _lutTexture);
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glBindVertexArray(_VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, _nMeshVertices, _nBarbs);
 
-    _glManager->legacy->DisableLighting();
+    glBindVertexArray(0);
+    shader->UnBind();
 
     return 0;
 }
@@ -248,6 +380,7 @@ int BarbRenderer::_generateBarbs()
     string heightVar = bParams->GetHeightVariableName();
     rc = _getVarGrid(ts, refLevel, lod, heightVar, minExts, maxExts, varData);
     if (rc < 0) {
+        _releaseGrids(varData);
         SetErrMsg("Height variable does not exist");
         return -1;
     }
@@ -256,302 +389,36 @@ int BarbRenderer::_generateBarbs()
     string colorVar = bParams->GetColorMapVariableName();
     rc = _getVarGrid(ts, refLevel, lod, colorVar, minExts, maxExts, varData);
     if (rc < 0) {
+        _releaseGrids(varData);
         SetErrMsg("Color variable does not exist");
         return -1;
     }
 
     _recalculateScales(varData, ts);
 
-    _barbCache.clear();
-    // Render the barbs
-    _operateOnGrid(varData);
-
-    return (rc);
-}
-
-float BarbRenderer::_calculateDirVec(const float start[3], const float end[3], float dirVec[3])
-{
-    vsub(end, start, dirVec);
-    float len = vlength(dirVec);
-    if (len != 0.f) vscale(dirVec, 1. / len);
-    return len;
-}
-
-void BarbRenderer::_drawBackOfBarb(const float dirVec[3], const float startVertex[3]) const
-{
-    // TODO GL
-    /*
-    glBegin(GL_POLYGON);
-    glNormal3fv(dirVec);
-    for (int k = 0; k<6; k++){
-        glVertex3fv(startVertex+3*k);
-    }
-    glEnd();
-     */
-}
-
-void BarbRenderer::_drawCylinderSides(const float nextNormal[3], const float nextVertex[3], const float startNormal[3], const float startVertex[3]) const
-{
-    LegacyGL *lgl = _glManager->legacy;
-
-    lgl->Begin(GL_TRIANGLE_STRIP);
-
-    for (int i = 0; i < 6; i++) {
-        lgl->Normal3fv(nextNormal + 3 * i);
-        lgl->Vertex3fv(nextVertex + 3 * i);
-
-        lgl->Normal3fv(startNormal + 3 * i);
-        lgl->Vertex3fv(startVertex + 3 * i);
-    }
-    // repeat first two vertices to close cylinder:
-
-    lgl->Normal3fv(nextNormal);
-    lgl->Vertex3fv(nextVertex);
-
-    lgl->Normal3fv(startNormal);
-    lgl->Vertex3fv(startVertex);
-
-    lgl->End();
-}
-
-void BarbRenderer::_drawBarbHead(const float dirVec[3], const float vertexPoint[3], const float startNormal[3], const float startVertex[3]) const
-{
-    LegacyGL *lgl = _glManager->legacy;
-
-    // Create a triangle fan from these 6 vertices.
-    lgl->Begin(GL_TRIANGLE_FAN);
-    lgl->Normal3fv(dirVec);
-    lgl->Vertex3fv(vertexPoint);
-    for (int i = 0; i < 6; i++) {
-        lgl->Normal3fv(startNormal + 3 * i);
-        lgl->Vertex3fv(startVertex + 3 * i);
-    }
-    // Repeat first point to close fan:
-    lgl->Normal3fv(startNormal);
-    lgl->Vertex3fv(startVertex);
-    lgl->End();
-}
-
-#ifdef DEBUG
-void BarbRenderer::_printBackDiameter(const float startVertex[18]) const
-{
-    float pointA[3] = {startVertex[0], startVertex[1], startVertex[2]};
-    float pointB[3] = {startVertex[3], startVertex[4], startVertex[5]};
-    float pointC[3] = {startVertex[6], startVertex[7], startVertex[8]};
-    float pointD[3] = {startVertex[9], startVertex[10], startVertex[11]};
-    float pointE[3] = {startVertex[12], startVertex[13], startVertex[14]};
-    float pointF[3] = {startVertex[15], startVertex[16], startVertex[17]};
-    cout << "   " << pointA[0] << "\t\t" << pointB[0] << "\t\t\t" << pointC[0];
-    cout << "\t\t" << pointD[0] << "\t\t" << pointE[0] << "\t\t" << pointF[0] << endl;
-
-    cout << "   " << pointA[1] << "\t\t" << pointB[1] << "\t\t" << pointC[1];
-    cout << "\t" << pointD[1] << "\t" << pointE[1] << "\t\t" << pointF[1] << endl;
-
-    cout << "   " << pointA[2] << "\t\t" << pointB[2] << "\t\t" << pointC[2];
-    cout << "\t\t" << pointD[2] << "\t\t" << pointE[2] << "\t\t" << pointF[2] << endl;
-    cout << "Back Diameter " << _calculateLength(pointA, pointD) << endl;
-}
-#endif
-
-// Issue OpenGL calls to draw a cylinder with orthogonal ends from
-// one point to another.  Then put an barb head on the end
-//
-void BarbRenderer::_drawBarb(const std::vector<Grid *> variableData, const float startPoint_[3], bool doColorMapping, const float clut[1024])
-{
-    Barb b;
-    memcpy(b.startPoint, startPoint_, sizeof(float) * 3);
-    b.lengthScalar = ((BarbParams *)GetActiveParams())->GetLengthScale() * _vectorScaleFactor;
-
-    VAssert(variableData.size() == 5);
-
-    bool missing = _defineBarb(variableData, b.startPoint, b.endPoint, &b.value, doColorMapping, clut);
-
-    if (missing) return;
-
-    _barbCache.push_back(b);
-}
-
-void BarbRenderer::_setBarbColor(float value, const float clut[1024], double crange[2]) const
-{
-    float range = crange[1] - crange[0];
-    float n = (value - crange[0]) / range;
-    n = glm::clamp(n, 0.f, 1.f);
-    int i = 255 * n;
-
-    _glManager->legacy->Color4fv(&clut[i * 4]);
-}
-
-void BarbRenderer::_drawBarb(Barb b, bool doColorMapping, const float clut[1024], double crange[2])
-{
-    float *        startPoint = b.startPoint;
-    float *        endPoint = b.endPoint;
-    MatrixManager *mm = _glManager->matrixManager;
-    if (doColorMapping) _setBarbColor(b.value, clut, crange);
-    float     newLengthScalar = ((BarbParams *)GetActiveParams())->GetLengthScale() * _vectorScaleFactor;
-    glm::vec3 v = glm::make_vec3(b.endPoint) - glm::make_vec3(b.startPoint);
-    float     l = glm::length(v) / b.lengthScalar * newLengthScalar;
-    glm::vec3 end = glm::make_vec3(b.startPoint) + glm::normalize(v) * l;
-    memcpy(b.endPoint, glm::value_ptr(end), sizeof(float) * 3);
-
-    mm->MatrixModeModelView();
-    mm->PushMatrix();
+    vector<float> instances;
+    _operateOnGrid(varData, instances);
 
-    mm->Translate(startPoint[0], startPoint[1], startPoint[2]);
+    _nBarbs = instances.size() / barbInstanceSize;
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(float), instances.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    endPoint[0] -= startPoint[0];
-    endPoint[1] -= startPoint[1];
-    endPoint[2] -= startPoint[2];
-
-    startPoint[0] = startPoint[1] = startPoint[2] = 0;
-
-    vector<double> scales = _getScales();
-    mm->Scale(1.f / scales[0], 1.f / scales[1], 1.f / scales[2]);
-
-    // Constants are needed for cosines and sines, at
-    // 60 degree intervals. The barb is really a hexagonal tube,
-    // but the shading makes it look round.
-    const float sines[6] = {0.f, (float)(sqrt(3.) / 2.), (float)(sqrt(3.) / 2.), 0.f, (float)(-sqrt(3.) / 2.), (float)(-sqrt(3.) / 2.)};
-    const float coses[6] = {1.f, 0.5, -0.5, -1., -.5, 0.5};
-
-    float nextPoint[3];
-    float vertexPoint[3];
-    float headCenter[3];
-    float startNormal[18];
-    float nextNormal[18];
-    float startVertex[18];
-    float nextVertex[18];
-    float testVec[3];
-    float testVec2[3];
-
-    // Calculate an orthonormal frame
-
-    // dirVec is the barb direction
-    float dirVec[3];
-    float len = _calculateDirVec(startPoint, endPoint, dirVec);
-
-    // Calculate uVec, orthogonal to dirVec
-    // Not sure what bVec is.  Up direction?
-    float uVec[3], bVec[3];
-    vset(testVec, 1., 0., 0.);
-    vcross(dirVec, testVec, uVec);
-    len = vdot(uVec, uVec);
-    if (len == 0.f) {
-        vset(testVec, 0., 1., 0.);
-        vcross(dirVec, testVec, uVec);
-        len = vdot(uVec, uVec);
-    }
-    vscale(uVec, 1.f / sqrt(len));
-    vcross(uVec, dirVec, bVec);
-
-    BarbParams *bParams = dynamic_cast<BarbParams *>(GetActiveParams());
-    VAssert(bParams);
-
-    float radius = bParams->GetLineThickness() * _maxThickness;
-
-    // calculate 6 points in plane orthog to dirVec, in plane of point
-    for (int i = 0; i < 6; i++) {
-        // testVec and testVec2 are components of point in plane
-        vmult(uVec, coses[i], testVec);
-        vmult(bVec, sines[i], testVec2);
-
-        // Calc outward normal as a sideEffect..
-        // It is the vector sum of x,y components (norm 1)
-        vadd(testVec, testVec2, startNormal + 3 * i);
-
-        // stretch by radius to get current displacement
-        vmult(startNormal + 3 * i, radius, startVertex + 3 * i);
-
-        // add to current point
-        vadd(startVertex + 3 * i, startPoint, startVertex + 3 * i);
-    }
-
-#ifdef DEBUG
-    _printBackDiameter(startVertex);
-#endif
-
-    _drawBackOfBarb(dirVec, startVertex);
-
-    // The variables are located as follows:
-    //		- - - - >
-    //	   ^       ^ ^
-    // start    next end
-
-    // Calculate nextPoint and vertexPoint, for barbhead
-    for (int i = 0; i < 3; i++) {
-        nextPoint[i] = (1. - BARB_LENGTH_FACTOR) * startPoint[i] + BARB_LENGTH_FACTOR * endPoint[i];
-        // Assume a vertex angle of 45 degrees:
-        vertexPoint[i] = nextPoint[i] + dirVec[i] * radius;
-        headCenter[i] = nextPoint[i] - dirVec[i] * (BARB_HEAD_FACTOR * radius - radius);
-    }
-
-    // calc for endpoints:
-    for (int i = 0; i < 6; i++) {
-        // testVec and testVec2 are components of point in plane
-        vmult(uVec, coses[i], testVec);
-        vmult(bVec, sines[i], testVec2);
-
-        // Calc outward normal as a sideEffect..
-        // It is the vector sum of x,y components (norm 1)
-        vadd(testVec, testVec2, nextNormal + 3 * i);
-
-        // stretch by radius to get current displacement
-        vmult(nextNormal + 3 * i, radius, nextVertex + 3 * i);
-
-        // add to current point
-        vadd(nextVertex + 3 * i, nextPoint, nextVertex + 3 * i);
-    }
-
-    _drawCylinderSides(nextNormal, nextVertex, startNormal, startVertex);
-
-    // Now draw the barb head.  First calc 6 vertices at back of barbhead
-    // Reuse startNormal and startVertex vectors
-    // calc for endpoints:
-    for (int i = 0; i < 6; i++) {
-        // testVec and testVec2 are components of point in plane
-        // Can reuse them from previous (cylinder end) calculation
-        vmult(uVec, coses[i], testVec);
-        vmult(bVec, sines[i], testVec2);
-
-        // Calc outward normal as a sideEffect..
-        // It is the vector sum of x,y components (norm 1)
-        vadd(testVec, testVec2, startNormal + 3 * i);
-
-        // stretch by radius to get current displacement
-        vmult(startNormal + 3 * i, BARB_HEAD_FACTOR * radius, startVertex + 3 * i);
-
-        // add to current point
-        vadd(startVertex + 3 * i, headCenter, startVertex + 3 * i);
-
-        // Now tilt normals in direction of barb:
-        for (int k = 0; k < 3; k++) { startNormal[3 * i + k] = 0.5 * startNormal[3 * i + k] + 0.5 * dirVec[k]; }
-    }
-
-    _drawBarbHead(dirVec, vertexPoint, startNormal, startVertex);
+    // The instance buffer holds everything needed to draw the barbs
+    //
+    _releaseGrids(varData);
 
-    mm->PopMatrix();
+    return (rc);
 }
 
-void BarbRenderer::_setUpLightingAndColor()
+void BarbRenderer::_releaseGrids(vector<Grid *> &varData)
 {
-    LegacyGL *       lgl = _glManager->legacy;
-    string           winName = GetVisualizer();    // GetVisualizer is not const :(
-    ViewpointParams *vpParams = _paramsMgr->GetViewpointParams(winName);
-    int              nLights = vpParams->getNumLights();
-
-    float       fcolor[3];
-    BarbParams *bParams = dynamic_cast<BarbParams *>(GetActiveParams());
-    VAssert(bParams);
-    bParams->GetConstantColor(fcolor);
-    if (nLights == 0) {
-        lgl->DisableLighting();
-    } else {
-        // All the geometry will get a white specular color:
-        float specColor[4];
-        specColor[0] = specColor[1] = specColor[2] = 0.8f;
-        specColor[3] = 1.f;
-        lgl->EnableLighting();
+    for (int i = 0; i < varData.size(); i++) {
+        if (!varData[i]) continue;
+        _dataMgr->UnlockGrid(varData[i]);
+        delete varData[i];
     }
-    lgl->Color3fv(fcolor);
+    varData.clear();
 }
 
 void BarbRenderer::_reFormatExtents(vector<float> &rakeExts) const
@@ -585,31 +452,6 @@ void BarbRenderer::_makeRakeGrid(vector<int> &rakeGrid) const
     rakeGrid.push_back((int)longGrid[Z]);
 }
 
-float BarbRenderer::_getHeightOffset(Grid *heightVar, float xCoord, float yCoord, bool &missing) const
-{
-    VAssert(heightVar);
-    float missingVal = heightVar->GetMissingValue();
-    float offset = heightVar->GetValue(xCoord, yCoord, 0.f);
-    if (offset == missingVal) {
-        missing = true;
-        offset = 0.f;
-    }
-    return offset;
-}
-
-void BarbRenderer::_getDirection(float direction[3], vector<Grid *> variableData, float xCoord, float yCoord, float zCoord, bool &missing) const
-{
-    for (int dim = 0; dim < 3; dim++) {
-        direction[dim] = 0.f;
-        if (variableData[dim]) {
-            direction[dim] = variableData[dim]->GetValue(xCoord, yCoord, zCoord);
-
-            float missingVal = variableData[dim]->GetMissingValue();
-            if (direction[dim] == missingVal) { missing = true; }
-        }
-    }
-}
-
 bool BarbRenderer::_makeCLUT(float clut[1024]) const
 {
     BarbParams *bParams = dynamic_cast<BarbParams *>(GetActiveParams());
@@ -644,28 +486,6 @@ vector<double> BarbRenderer::_getScales()
     return scales;
 }
 
-float BarbRenderer::_calculateLength(float start[3], float end[3]) const
-{
-    float xDist = start[X] - end[X];
-    float yDist = start[Y] - end[Y];
-    float zDist = start[Z] - end[Z];
-    float length = sqrt(xDist * xDist + yDist * yDist + zDist * zDist);
-    return length;
-}
-
-void BarbRenderer::_makeStartAndEndPoint(float start[3], float end[3], float direction[3])
-{
-    BarbParams *bParams = dynamic_cast<BarbParams *>(GetActiveParams());
-    VAssert(bParams);
-    float length = bParams->GetLengthScale() * _vectorScaleFactor;
-
-    vector<double> scales = _getScales();
-
-    end[X] = start[X] + scales[X] * direction[X] * length;
-    end[Y] = start[Y] + scales[Y] * direction[Y] * length;
-    end[Z] = start[Z] + scales[Z] * direction[Z] * length;
-}
-
 void BarbRenderer::_getStrides(vector<float> &strides, vector<int> &rakeGrid, vector<float> &rakeExts) const
 {
     strides.clear();
@@ -680,32 +500,7 @@ void BarbRenderer::_getStrides(vector<float> &strides, vector<int> &rakeGrid, ve
     strides.push_back(zStride);
 }
 
-bool BarbRenderer::_defineBarb(const std::vector<Grid *> variableData, float start[3], float end[3], float *value, bool doColorMapping, const float clut[1024])
-{
-    bool missing = false;
-
-    Grid *heightVar = variableData[3];
-    if (heightVar) { start[Z] += _getHeightOffset(heightVar, start[X], start[Y], missing); }
-
-    float direction[3] = {0.f, 0.f, 0.f};
-    _getDirection(direction, variableData, start[X], start[Y], start[Z], missing);
-
-    _makeStartAndEndPoint(start, end, direction);
-
-    if (doColorMapping) {
-        float val = variableData[4]->GetValue(start[X], start[Y], start[Z]);
-        *value = val;
-
-        if (val == variableData[4]->GetMissingValue())
-            missing = true;
-        else {
-            missing = _getColorMapping(val, clut);
-        }
-    }
-    return missing;
-}
-
-void BarbRenderer::_operateOnGrid(vector<Grid *> variableData, bool drawBarb)
+void BarbRenderer::_operateOnGrid(const vector<Grid *> &variableData, vector<float> &instances, bool drawBarb)
 {
     vector<int> rakeGrid;
     _makeRakeGrid(rakeGrid);
@@ -719,63 +514,95 @@ void BarbRenderer::_operateOnGrid(vector<Grid *> variableData, bool drawBarb)
     float clut[1024];
     bool  doColorMapping = _makeCLUT(clut);
 
-    float start[3];
-    for (int i = 1; i <= rakeGrid[X]; i++) {
-        start[X] = strides[X] * i + rakeExts[X];    // + xStride/2.0;
-        for (int j = 1; j <= rakeGrid[Y]; j++) {
-            start[Y] = strides[Y] * j + rakeExts[Y];    // + yStride/2.0;
-            for (int k = 1; k <= rakeGrid[Z]; k++) {
-                start[Z] = strides[Z] * k + rakeExts[Z];    //+ zStride/2.0;
-
-                if (drawBarb) {
-                    _drawBarb(variableData, start, doColorMapping, clut);
-                } else {
-                    _getMagnitudeAtPoint(variableData, start);
+    Grid *heightVar = variableData.size() > 3 ? variableData[3] : NULL;
+    Grid *colorVar = variableData.size() > 4 ? variableData[4] : NULL;
+    doColorMapping = doColorMapping && colorVar;
+    bool magnitudeOnly = !drawBarb;
+
+    // Grid::GetUserExtents() caches its result; fill the cache before the
+    // grids are shared between threads
+    //
+    for (auto g : variableData) {
+        if (!g) continue;
+        DblArr3 minu, maxu;
+        g->GetUserExtents(minu, maxu);
+    }
+
+    // Each part samples a contiguous range of X rake indices, which start
+    // at one. The results are concatenated in order so the barb order is
+    // independent of the number of threads.
+    //
+    size_t                nslabs = rakeGrid[X] > 0 ? rakeGrid[X] : 0;
+    size_t                nparts = NumParts(nslabs, 1);
+    vector<vector<float>> partInstances(nparts);
+    vector<double>        partMaxValue(nparts, 0.0);
+
+    ParallelForParts(1, nslabs + 1, nparts, [&](size_t part, size_t i0, size_t i1) {
+        vector<float> &out = partInstances[part];
+        double &       maxValue = partMaxValue[part];
+
+        float start[3];
+        for (size_t i = i0; i < i1; i++) {
+            start[X] = strides[X] * i + rakeExts[XMIN];
+            for (int j = 1; j <= rakeGrid[Y]; j++) {
+                start[Y] = strides[Y] * j + rakeExts[YMIN];
+                for (int k = 1; k <= rakeGrid[Z]; k++) {
+                    start[Z] = strides[Z] * k + rakeExts[ZMIN];
+
+                    // Largest vector component magnitude, used for default
+                    // scaling of barb lengths
+                    //
+                    if (magnitudeOnly) {
+                        for (int dim = 0; dim < 3; dim++) {
+                            if (!variableData[dim]) continue;
+                            double value = variableData[dim]->GetValue(start[X], start[Y], start[Z]);
+                            if (value == variableData[dim]->GetMissingValue()) continue;
+                            value = std::abs(value);
+                            if (value > maxValue && std::isfinite(value)) maxValue = value;
+                        }
+                        continue;
+                    }
+
+                    float point[3] = {start[X], start[Y], start[Z]};
+                    bool  missing = false;
+
+                    if (heightVar) {
+                        float offset = heightVar->GetValue(point[X], point[Y], 0.f);
+                        if (offset == heightVar->GetMissingValue())
+                            missing = true;
+                        else
+                            point[Z] += offset;
+                    }
+
+                    float direction[3] = {0.f, 0.f, 0.f};
+                    for (int dim = 0; dim < 3 && !missing; dim++) {
+                        if (!variableData[dim]) continue;
+                        direction[dim] = variableData[dim]->GetValue(point[X], point[Y], point[Z]);
+                        if (direction[dim] == variableData[dim]->GetMissingValue()) missing = true;
+                    }
+
+                    float value = 0.f;
+                    if (doColorMapping && !missing) {
+                        value = colorVar->GetValue(point[X], point[Y], point[Z]);
+                        if (value == colorVar->GetMissingValue()) missing = true;
+                    }
+
+                    float magnitude = sqrt(direction[X] * direction[X] + direction[Y] * direction[Y] + direction[Z] * direction[Z]);
+
+                    // Barbs without a direction have no geometry
+                    //
+                    if (missing || !(magnitude > 0.f)) continue;
+
+                    out.insert(out.end(), {point[X], point[Y], point[Z], direction[X] / magnitude, direction[Y] / magnitude, direction[Z] / magnitude, magnitude, value});
                 }
             }
         }
-    }
-    return;
-}
+    });
 
-void BarbRenderer::_getMagnitudeAtPoint(std::vector<VAPoR::Grid *> variables, float point[3])
-{
-    VAPoR::Grid *grid;
-    double       maxValue = 0.f;
-    for (int i = 0; i < 3; i++) {
-        grid = variables[i];
-        if (grid == NULL)
-            continue;
-        else {
-            double value = grid->GetValue(point[X], point[Y], point[Z]);
-            double missingValue = grid->GetMissingValue();
-
-            if (value == missingValue) { continue; }
-            value = abs(value);
-
-            if (value > maxValue && value < std::numeric_limits<double>::max() && value > std::numeric_limits<double>::lowest() && !std::isnan(value)) maxValue = value;
-        }
+    for (size_t p = 0; p < nparts; p++) {
+        instances.insert(instances.end(), partInstances[p].begin(), partInstances[p].end());
+        if (partMaxValue[p] > _maxValue) _maxValue = partMaxValue[p];
     }
-    if (maxValue > _maxValue) { _maxValue = maxValue; }
-}
-
-bool BarbRenderer::_getColorMapping(float val, const float clut[256 * 4])
-{
-    bool missing = false;
-
-    MapperFunction *tf = 0;
-    BarbParams *    bParams = dynamic_cast<BarbParams *>(GetActiveParams());
-    VAssert(bParams);
-    string colorVar = bParams->GetColorMapVariableName();
-    tf = (MapperFunction *)bParams->GetMapperFunc(colorVar);
-    VAssert(tf);
-
-    float mappedColor[4] = {0., 0., 0., 0.};
-    // Use the transfer function to map the data:
-    int lutIndex = tf->mapFloatToIndex(val);
-    for (int i = 0; i < 4; i++) mappedColor[i] = clut[4 * lutIndex + i];
-    _glManager->legacy->Color4fv(mappedColor);
-    return missing;
 }
 
 double BarbRenderer::_getDomainHypotenuse(size_t ts) const
@@ -810,7 +637,8 @@ void BarbRenderer::_setDefaultLengthAndThicknessScales(size_t ts, const std::vec
 
     _maxValue = 0;
 
-    _operateOnGrid(varData, false);
+    vector<float> unused;
+    _operateOnGrid(varData, unused, false);
 
     double hypotenuse = _getDomainHypotenuse(ts);
 
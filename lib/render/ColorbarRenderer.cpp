@@ -8,6 +8,7 @@
 #include <vapor/Texture.h>
 #include <vapor/TextLabel.h>
 #include <vapor/Font.h>
+#include <vapor/FontManager.h>
 #include <assert.h>
 
 using namespace VAPoR;
@@ -216,7 +217,9 @@ void ColorbarRenderer::Render(GLManager *glm, RenderParams *rp)
     lgl->Color(backgroundColor);
     DrawRect(lgl, pos + vec2(border), size - vec2(border * 2));
 
+    glm->fontManager->BeginTextBatch();
     titledColorbar.Render(glm, colorbarPos);
+    glm->fontManager->EndTextBatch();
 
     glm->PixelCoordinateSystemPop();
 }
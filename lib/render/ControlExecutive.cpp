@@ -11,6 +11,7 @@
 
 #include <vapor/ParamsMgr.h>
 #include <vapor/ControlExecutive.h>
+#include <vapor/Trace.h>
 #include <vapor/CalcEngineMgr.h>
 #include <vapor/Visualizer.h>
 #include <vapor/DataStatus.h>
@@ -143,7 +144,15 @@ int ControlExec::Paint(string winName, bool fast)
     bool enabled = _paramsMgr->GetSaveStateEnabled();
     _paramsMgr->SetSaveStateEnabled(false);
 
-    int rc = v->paintEvent(fast);
+    // Each paint is a trace frame
+    //
+    Wasp::Trace::BeginFrame(winName);
+    int rc;
+    {
+        Wasp::TraceSpan span("ControlExec::Paint", "render", winName);
+        rc = v->paintEvent(fast);
+    }
+    Wasp::Trace::EndFrame();
 
     _paramsMgr->SetSaveStateEnabled(enabled);
 
@@ -151,6 +160,18 @@ int ControlExec::Paint(string winName, bool fast)
     return rc;
 }
 
+int ControlExec::GetRenderTimes(string winName, vector<string> &renderTypes, vector<string> &renderNames, vector<double> &paintTimes, vector<double> &fetchTimes) const
+{
+    Visualizer *v = getVisualizer(winName);
+    if (!v) {
+        SetErrMsg("Invalid Visualizer \"%s\"", winName.c_str());
+        return -1;
+    }
+
+    v->GetRenderTimes(renderTypes, renderNames, paintTimes, fetchTimes);
+    return 0;
+}
+
 int ControlExec::ActivateRender(string winName, string dataSetName, string renderType, string renderName, bool on)
 {
     if (!_dataStatus->GetDataMgrNames().size()) {
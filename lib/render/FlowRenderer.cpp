@@ -133,11 +133,13 @@ int FlowRenderer::_outputFlowLines()
     // equals to the advection steps.
     // In the case of unsteady flow, output particles that are up to
     // the advection timestamp.
-    int rv;
+    // The file format follows the extension of the output file name.
+    const auto format = flow::FlowlineFormatFromFilename(params->GetFlowlineOutputFilename());
+    int        rv;
     if (params->GetIsSteady()) {
-        rv = flow::OutputFlowlinesNumSteps(&_advection, params->GetFlowlineOutputFilename().c_str(), params->GetSteadyNumOfSteps(), _dataMgr->GetMapProjection(), false);
+        rv = flow::OutputFlowlinesNumSteps(&_advection, params->GetFlowlineOutputFilename().c_str(), params->GetSteadyNumOfSteps(), _dataMgr->GetMapProjection(), false, format);
     } else {
-        rv = flow::OutputFlowlinesMaxTime(&_advection, params->GetFlowlineOutputFilename().c_str(), _timestamps.at(params->GetCurrentTimestep()), _dataMgr->GetMapProjection(), false);
+        rv = flow::OutputFlowlinesMaxTime(&_advection, params->GetFlowlineOutputFilename().c_str(), _timestamps.at(params->GetCurrentTimestep()), _dataMgr->GetMapProjection(), false, format);
     }
     if (rv != 0) {
         MyBase::SetErrMsg("Output flow lines wrong!");
@@ -146,9 +148,9 @@ int FlowRenderer::_outputFlowLines()
 
     if (_2ndAdvection) {    // bi-directional advection
         if (params->GetIsSteady()) {
-            rv = flow::OutputFlowlinesNumSteps(_2ndAdvection.get(), params->GetFlowlineOutputFilename().c_str(), params->GetSteadyNumOfSteps(), _dataMgr->GetMapProjection(), true);
+            rv = flow::OutputFlowlinesNumSteps(_2ndAdvection.get(), params->GetFlowlineOutputFilename().c_str(), params->GetSteadyNumOfSteps(), _dataMgr->GetMapProjection(), true, format);
         } else {
-            rv = flow::OutputFlowlinesMaxTime(_2ndAdvection.get(), params->GetFlowlineOutputFilename().c_str(), _timestamps.at(params->GetCurrentTimestep()), _dataMgr->GetMapProjection(), true);
+            rv = flow::OutputFlowlinesMaxTime(_2ndAdvection.get(), params->GetFlowlineOutputFilename().c_str(), _timestamps.at(params->GetCurrentTimestep()), _dataMgr->GetMapProjection(), true, format);
         }
         if (rv != 0) {
             MyBase::SetErrMsg("Output flow lines wrong!");
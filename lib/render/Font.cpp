@@ -4,12 +4,28 @@
 #include "vapor/ShaderManager.h"
 #include <glm/glm.hpp>
 #include "vapor/GLManager.h"
+#include "vapor/FontManager.h"
+#include <algorithm>
+#include <cstddef>
 
 using namespace VAPoR;
 using glm::vec2;
 using std::string;
 
-Font::Font(GLManager *glManager, const std::string &path, int size, FT_Library library) : _glManager(glManager), _library(nullptr), _size(size)
+namespace {
+// Empty texels left between glyphs so linear filtering does not bleed
+const int atlasPadding = 1;
+
+int nextPowerOfTwo(int n)
+{
+    int p = 1;
+    while (p < n) p *= 2;
+    return p;
+}
+}    // namespace
+
+Font::Font(GLManager *glManager, const std::string &path, int size, FT_Library library)
+: _glManager(glManager), _library(nullptr), _size(size), _atlasTexture(0), _atlasWidth(0), _atlasHeight(0), _shelfX(0), _shelfY(0), _shelfHeight(0)
 {
     if (library == nullptr) {
         int err = FT_Init_FreeType(&_library);
@@ -24,11 +40,27 @@ Font::Font(GLManager *glManager, const std::string &path, int size, FT_Library l
     glGenBuffers(1, &_VBO);
     glBindVertexArray(_VAO);
     glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-    glBufferData(GL_ARRAY_BUFFER, 6 * 4 * sizeof(float), NULL, GL_STREAM_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, texCoord));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, color));
     glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+
+    // Room for roughly the printable ASCII range; grows on demand
+    int side = nextPowerOfTwo(std::max(64, (_size + atlasPadding) * 10));
+    glGenTextures(1, &_atlasTexture);
+    ResizeAtlas(side, side);
+
+    // An opaque block for rectangles. Sampling the center of its middle
+    // texel is unaffected by linear filtering.
+    int x, y;
+    AllocateAtlasRegion(3, 3, x, y);
+    for (int row = 0; row < 3; row++) std::fill_n(_atlas.begin() + (y + row) * _atlasWidth + x, 3, 255);
+    ResizeAtlas(_atlasWidth, _atlasHeight);
+    _solidTexCoord = vec2(x + 1.5f, y + 1.5f);
 }
 
 Font::~Font()
@@ -38,29 +70,84 @@ Font::~Font()
 
     glDeleteVertexArrays(1, &_VAO);
     glDeleteBuffers(1, &_VBO);
-    for (auto it = _glyphMap.begin(); it != _glyphMap.end(); ++it) glDeleteTextures(1, &it->second.textureID);
+    glDeleteTextures(1, &_atlasTexture);
 }
 
-bool Font::LoadGlyph(int c)
+void Font::ResizeAtlas(int width, int height)
 {
-    if (FT_Load_Char(_face, c, FT_LOAD_RENDER)) {
-        printf("FAILED TO LOAD CHAR\n");
-        return false;
-    }
+    std::vector<unsigned char> atlas(width * height, 0);
+    for (int y = 0; y < _atlasHeight; y++) std::copy(_atlas.begin() + y * _atlasWidth, _atlas.begin() + (y + 1) * _atlasWidth, atlas.begin() + y * width);
+    _atlas.swap(atlas);
+    _atlasWidth = width;
+    _atlasHeight = height;
 
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, _face->glyph->bitmap.width, _face->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE, _face->glyph->bitmap.buffer);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, _atlasWidth, _atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, _atlas.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Font::AllocateAtlasRegion(int w, int h, int &x, int &y)
+{
+    w += atlasPadding;
+    h += atlasPadding;
+
+    if (w > _atlasWidth) ResizeAtlas(nextPowerOfTwo(w), _atlasHeight);
+
+    // Start a new shelf when this one is full
+    if (_shelfX + w > _atlasWidth) {
+        _shelfY += _shelfHeight;
+        _shelfX = 0;
+        _shelfHeight = 0;
+    }
 
-    _glyphMap[c] = {texture, (int)_face->glyph->bitmap.width, (int)_face->glyph->bitmap.rows, _face->glyph->bitmap_left, _face->glyph->bitmap_top, _face->glyph->advance.x};
+    int height = _atlasHeight;
+    while (_shelfY + h > height) height *= 2;
+    if (height != _atlasHeight) ResizeAtlas(_atlasWidth, height);
+
+    x = _shelfX;
+    y = _shelfY;
+    _shelfX += w;
+    _shelfHeight = std::max(_shelfHeight, h);
+}
+
+bool Font::LoadGlyph(int c)
+{
+    if (FT_Load_Char(_face, c, FT_LOAD_RENDER)) {
+        printf("FAILED TO LOAD CHAR\n");
+        return false;
+    }
+
+    const FT_Bitmap &bitmap = _face->glyph->bitmap;
+    int              w = bitmap.width;
+    int              h = bitmap.rows;
+    int              x = 0, y = 0;
+
+    // Blank glyphs such as spaces only advance the cursor
+    if (w > 0 && h > 0) {
+        AllocateAtlasRegion(w, h, x, y);
+
+        for (int row = 0; row < h; row++) {
+            const unsigned char *src = bitmap.buffer + row * bitmap.pitch;
+            std::copy(src, src + w, _atlas.begin() + (y + row) * _atlasWidth + x);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, _atlasWidth);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RED, GL_UNSIGNED_BYTE, _atlas.data() + y * _atlasWidth + x);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    _glyphMap[c] = {x, y, w, h, _face->glyph->bitmap_left, _face->glyph->bitmap_top, _face->glyph->advance.x};
 
     return true;
 }
@@ -77,14 +164,44 @@ Font::Glyph Font::GetGlyph(int c)
 
 void Font::DrawText(const std::string &text, const glm::vec4 &color)
 {
-    SmartShaderProgram shader = _glManager->shaderManager->GetSmartShader("font");
-    shader->SetUniform("MVP", _glManager->matrixManager->GetModelViewProjectionMatrix());
-    shader->SetUniform("color", color);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    QueueText(text, color);
+    if (!_glManager->fontManager->IsTextBatchOpen()) Flush();
+}
+
+// Start a new run if the depth state differs from that of the last one
+//
+void Font::BeginRun()
+{
+    GLboolean mask;
+    GLint     func;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &mask);
+    glGetIntegerv(GL_DEPTH_FUNC, &func);
+    DepthState depth = {glIsEnabled(GL_DEPTH_TEST) == GL_TRUE, mask == GL_TRUE, func};
+
+    if (_runs.empty() || !(_runs.back().depth == depth)) _runs.push_back({_batch.size(), depth});
+}
+
+void Font::PushQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::mat4 &MVP, const glm::vec4 &color)
+{
+    float quad[6][4] = {{x0, y1, u0, v0}, {x0, y0, u0, v1}, {x1, y0, u1, v1},
+
+                        {x0, y1, u0, v0}, {x1, y0, u1, v1}, {x1, y1, u1, v0}};
+    for (int v = 0; v < 6; v++) _batch.push_back({MVP * glm::vec4(quad[v][0], quad[v][1], 0.f, 1.f), glm::vec2(quad[v][2], quad[v][3]), color});
+}
+
+void Font::QueueRectangle(const glm::vec2 &min, const glm::vec2 &max, const glm::vec4 &color)
+{
+    const glm::mat4 MVP = _glManager->matrixManager->GetModelViewProjectionMatrix();
+
+    BeginRun();
+    PushQuad(min.x, min.y, max.x, max.y, _solidTexCoord.x, _solidTexCoord.y, _solidTexCoord.x, _solidTexCoord.y, MVP, color);
+}
+
+void Font::QueueText(const std::string &text, const glm::vec4 &color)
+{
+    const glm::mat4 MVP = _glManager->matrixManager->GetModelViewProjectionMatrix();
+
+    BeginRun();
 
     const float xStart = 0;
     const float yStart = 0;
@@ -92,6 +209,8 @@ void Font::DrawText(const std::string &text, const glm::vec4 &color)
     float cursorX = xStart;
     float cursorY = yStart;
 
+    _batch.reserve(_batch.size() + 6 * text.size());
+
     for (int i = 0; i < text.size(); i++) {
         if (text[i] == '\n') {
             cursorY -= LineHeight();
@@ -105,20 +224,63 @@ void Font::DrawText(const std::string &text, const glm::vec4 &color)
 
         Glyph ch = GetGlyph(text[i]);
 
-        float x = cursorX + ch.bearingX;
-        float y = cursorY - (ch.sizeY - ch.bearingY);
-        float w = ch.sizeX;
-        float h = ch.sizeY;
-
-        float vertices[6][4] = {{x, y + h, 0, 0}, {x, y, 0, 1},     {x + w, y, 1, 1},
+        if (ch.sizeX > 0 && ch.sizeY > 0) {
+            float x = cursorX + ch.bearingX;
+            float y = cursorY - (ch.sizeY - ch.bearingY);
+            float w = ch.sizeX;
+            float h = ch.sizeY;
 
-                                {x, y + h, 0, 0}, {x + w, y, 1, 1}, {x + w, y + h, 1, 0}};
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindTexture(GL_TEXTURE_2D, ch.textureID);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+            PushQuad(x, y, x + w, y + h, ch.atlasX, ch.atlasY, ch.atlasX + ch.sizeX, ch.atlasY + ch.sizeY, MVP, color);
+        }
 
         cursorX += ch.advance / 64;
     }
+}
+
+void Font::Flush()
+{
+    if (_batch.empty()) return;
+
+    SmartShaderProgram shader = _glManager->shaderManager->GetSmartShader("font");
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+    glBindVertexArray(_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, _VBO);
+    glBufferData(GL_ARRAY_BUFFER, _batch.size() * sizeof(Vertex), _batch.data(), GL_STREAM_DRAW);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Each run is drawn with the depth state it was queued under; the
+    // current state is restored afterwards
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean depthMask;
+    GLint     depthFunc;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+
+    for (size_t i = 0; i < _runs.size(); i++) {
+        size_t end = i + 1 < _runs.size() ? _runs[i + 1].first : _batch.size();
+        if (end == _runs[i].first) continue;
+
+        const DepthState &depth = _runs[i].depth;
+        if (depth.test)
+            glEnable(GL_DEPTH_TEST);
+        else
+            glDisable(GL_DEPTH_TEST);
+        glDepthMask(depth.mask);
+        glDepthFunc(depth.func);
+
+        glDrawArrays(GL_TRIANGLES, _runs[i].first, end - _runs[i].first);
+    }
+    _batch.clear();
+    _runs.clear();
+
+    if (depthTest)
+        glEnable(GL_DEPTH_TEST);
+    else
+        glDisable(GL_DEPTH_TEST);
+    glDepthMask(depthMask);
+    glDepthFunc(depthFunc);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -9,7 +9,7 @@ using std::map;
 using std::pair;
 using std::string;
 
-FontManager::FontManager(GLManager *glManager) : _glManager(glManager), _library(nullptr)
+FontManager::FontManager(GLManager *glManager) : _glManager(glManager), _library(nullptr), _batchDepth(0)
 {
     VAssert(glManager);
     VAssert(!FT_Init_FreeType(&_library));
@@ -22,6 +22,16 @@ FontManager::~FontManager()
     if (_library) FT_Done_FreeType(_library);
 }
 
+void FontManager::BeginTextBatch() { _batchDepth++; }
+
+void FontManager::EndTextBatch()
+{
+    VAssert(_batchDepth > 0);
+    if (--_batchDepth > 0) return;
+
+    for (auto it = _map.begin(); it != _map.end(); ++it) it->second->Flush();
+}
+
 Font *FontManager::GetFont(const std::string &name, unsigned int size) { return GetResource(pair<string, unsigned int>(name, size)); }
 
 int FontManager::LoadResourceByKey(const std::pair<std::string, unsigned int> &key)
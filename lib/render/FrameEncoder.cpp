@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <vapor/VAssert.h>
+#include <vapor/TaskScheduler.h>
+#include <vapor/ImageWriter.h>
+#include <vapor/FrameEncoder.h>
+
+using namespace VAPoR;
+using namespace Wasp;
+
+namespace {
+
+// Convert packed RGB to planar 8 bit Y'CbCr 4:4:4 using the BT.601
+// studio swing coefficients expected by most YUV4MPEG2 readers
+//
+void rgbToYUV444(const unsigned char *rgb, size_t n, unsigned char *yuv)
+{
+    unsigned char *Y = yuv;
+    unsigned char *U = yuv + n;
+    unsigned char *V = yuv + 2 * n;
+
+    for (size_t i = 0; i < n; i++) {
+        int r = rgb[3 * i + 0];
+        int g = rgb[3 * i + 1];
+        int b = rgb[3 * i + 2];
+
+        Y[i] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        U[i] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        V[i] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+};    // namespace
+
+FrameEncoder::FrameEncoder(int nthreads, size_t maxQueued)
+{
+    if (nthreads < 1) nthreads = std::min(TaskScheduler::Instance().GetNumThreads(), 4);
+    if (maxQueued < 1) maxQueued = 2 * nthreads;
+
+    _maxQueued = maxQueued;
+    _active = 0;
+    _shutdown = false;
+    _stream = NULL;
+    _streamWidth = 0;
+    _streamHeight = 0;
+    _streamSubmitted = 0;
+    _streamWritten = 0;
+
+    for (int i = 0; i < nthreads; i++) _threads.push_back(std::thread(&FrameEncoder::_worker, this));
+}
+
+FrameEncoder::~FrameEncoder()
+{
+    (void)CloseStream();
+    (void)Wait();
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _shutdown = true;
+    }
+    _workCV.notify_all();
+    for (auto &t : _threads) t.join();
+}
+
+void FrameEncoder::_worker()
+{
+    while (true) {
+        job_t *job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _workCV.wait(lock, [this] { return _shutdown || !_queue.empty(); });
+            if (_queue.empty()) return;
+
+            job = _queue.front();
+            _queue.pop_front();
+            _active++;
+        }
+
+        // A slot in the queue is now free
+        //
+        _doneCV.notify_all();
+
+        _encode(job);
+        delete job;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _active--;
+        }
+        _doneCV.notify_all();
+    }
+}
+
+void FrameEncoder::_encode(job_t *job)
+{
+    if (job->_writer) {
+        int rc = job->_writer->Write(job->_pixels.data(), job->_width, job->_height);
+        if (rc < 0) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _failed.push_back(job->_writer->GetPath());
+        }
+        delete job->_writer;
+        return;
+    }
+
+    // Stream frame. Conversion happens concurrently; writes are ordered
+    //
+    size_t                     n = (size_t)job->_width * job->_height;
+    std::vector<unsigned char> yuv(3 * n);
+    rgbToYUV444(job->_pixels.data(), n, yuv.data());
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _doneCV.wait(lock, [this, job] { return _streamWritten == job->_seq; });
+
+    // The file is only touched by the thread whose frame is next, so
+    // the lock need not be held while writing
+    //
+    lock.unlock();
+    bool ok = fputs("FRAME\n", _stream) >= 0 && fwrite(yuv.data(), 1, yuv.size(), _stream) == yuv.size();
+    lock.lock();
+
+    if (!ok) _failed.push_back(_streamPath);
+    _streamWritten++;
+    lock.unlock();
+    _doneCV.notify_all();
+}
+
+void FrameEncoder::_enqueue(job_t *job)
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _doneCV.wait(lock, [this] { return _queue.size() < _maxQueued; });
+        _queue.push_back(job);
+    }
+    _workCV.notify_one();
+}
+
+int FrameEncoder::_reportFailures()
+{
+    std::vector<std::string> failed;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        failed.swap(_failed);
+    }
+    if (failed.empty()) return (0);
+
+    SetErrMsg("Failed to write %d captured frame(s), first \"%s\"", (int)failed.size(), failed[0].c_str());
+    return (-1);
+}
+
+int FrameEncoder::Submit(ImageWriter *writer, std::vector<unsigned char> &pixels, int width, int height)
+{
+    VAssert(writer);
+    VAssert(pixels.size() >= (size_t)3 * width * height);
+
+    if (!writer->IsThreadSafe()) {
+        int rc = writer->Write(pixels.data(), width, height);
+        delete writer;
+        pixels.clear();
+        if (rc < 0) return (-1);
+        return (_reportFailures());
+    }
+
+    job_t *job = new job_t;
+    job->_writer = writer;
+    job->_pixels.swap(pixels);
+    job->_width = width;
+    job->_height = height;
+    job->_seq = -1;
+    _enqueue(job);
+
+    return (_reportFailures());
+}
+
+int FrameEncoder::OpenStream(const std::string &path, int width, int height, int fps)
+{
+    if (_stream) {
+        SetErrMsg("Video stream \"%s\" already open", _streamPath.c_str());
+        return (-1);
+    }
+
+    _stream = fopen(path.c_str(), "wb");
+    if (!_stream) {
+        SetErrMsg("fopen(%s) : %M", path.c_str());
+        return (-1);
+    }
+
+    if (fprintf(_stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps) < 0) {
+        SetErrMsg("Failed to write video stream header to \"%s\"", path.c_str());
+        fclose(_stream);
+        _stream = NULL;
+        return (-1);
+    }
+
+    _streamPath = path;
+    _streamWidth = width;
+    _streamHeight = height;
+    _streamSubmitted = 0;
+    _streamWritten = 0;
+    return (0);
+}
+
+int FrameEncoder::SubmitStreamFrame(std::vector<unsigned char> &pixels, int width, int height)
+{
+    if (!_stream) {
+        SetErrMsg("No video stream open");
+        return (-1);
+    }
+    if (width != _streamWidth || height != _streamHeight) {
+        SetErrMsg("Frame size %dx%d does not match video stream size %dx%d", width, height, _streamWidth, _streamHeight);
+        return (-1);
+    }
+    VAssert(pixels.size() >= (size_t)3 * width * height);
+
+    job_t *job = new job_t;
+    job->_writer = NULL;
+    job->_pixels.swap(pixels);
+    job->_width = width;
+    job->_height = height;
+    job->_seq = _streamSubmitted++;
+    _enqueue(job);
+
+    return (_reportFailures());
+}
+
+int FrameEncoder::CloseStream()
+{
+    if (!_stream) return (0);
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _doneCV.wait(lock, [this] { return _streamWritten == _streamSubmitted; });
+    }
+
+    int rc = fclose(_stream);
+    _stream = NULL;
+    if (rc != 0) {
+        SetErrMsg("Failed to close video stream \"%s\"", _streamPath.c_str());
+        (void)_reportFailures();
+        return (-1);
+    }
+
+    return (_reportFailures());
+}
+
+int FrameEncoder::Wait()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _doneCV.wait(lock, [this] { return _queue.empty() && _active == 0; });
+    }
+    return (_reportFailures());
+}
@@ -17,6 +17,36 @@ using namespace Wasp;
 
 namespace {
 
+// Destination of the calling thread's error messages, if any. See
+// GeoImage::SetThreadErrMsg()
+//
+thread_local string *threadErrMsg = NULL;
+
+void vErrMsg(const char *fmt, va_list ap)
+{
+    char buf[1024];
+
+#ifdef WIN32
+    _vsnprintf(buf, sizeof(buf), fmt, ap);
+#else
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+#endif
+
+    if (threadErrMsg) {
+        *threadErrMsg = buf;
+    } else {
+        MyBase::SetErrMsg("%s", buf);
+    }
+}
+
+void errMsg(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vErrMsg(fmt, ap);
+    va_end(ap);
+}
+
 // Error handling for TIFF library
 //
 void myTiffErrHandler(const char *module, const char *fmt, va_list ap)
@@ -30,9 +60,9 @@ void myTiffErrHandler(const char *module, const char *fmt, va_list ap)
 #endif
 
     if (module) {
-        MyBase::SetErrMsg("%s : %s", module, buf);
+        errMsg("%s : %s", module, buf);
     } else {
-        MyBase::SetErrMsg("%s", buf);
+        errMsg("%s", buf);
     }
 }
 
@@ -54,6 +84,8 @@ GeoImage::GeoImage() : _pixelsize(8), _nbands(4)
 
 GeoImage::~GeoImage() { GeoImage::TiffClose(); }
 
+void GeoImage::SetThreadErrMsg(string *msg) { threadErrMsg = msg; }
+
 int GeoImage::TiffOpen(string path)
 {
     TIFFSetErrorHandler(myTiffErrHandler);
@@ -64,7 +96,7 @@ int GeoImage::TiffOpen(string path)
     //
     struct stat statbuf;
     if (stat(path.c_str(), &statbuf) < 0) {
-        SetErrMsg("Invalid tiff file: %s\n", path.c_str());
+        errMsg("Invalid tiff file: %s\n", path.c_str());
         return -1;
     }
 
@@ -73,14 +105,14 @@ int GeoImage::TiffOpen(string path)
     //
     _tif = XTIFFOpen(path.c_str(), "rm");
     if (!_tif) {
-        SetErrMsg("Unable to open tiff file: %s\n", path.c_str());
+        errMsg("Unable to open tiff file: %s\n", path.c_str());
         return -1;
     }
 
     char emsg[1000];
     int  ok = TIFFRGBAImageOK(_tif, emsg);
     if (!ok) {
-        MyBase::SetErrMsg("Unable to process tiff file:\n %s\nError message: %s", path.c_str(), emsg);
+        errMsg("Unable to process tiff file:\n %s\nError message: %s", path.c_str(), emsg);
         return (-1);
     }
 
@@ -91,7 +123,7 @@ int GeoImage::TiffOpen(string path)
     ok = TIFFGetField(_tif, TIFFTAG_COMPRESSION, &compr);
     if (ok) {
         if (compr != COMPRESSION_NONE && compr != COMPRESSION_LZW && compr != COMPRESSION_JPEG && compr != COMPRESSION_CCITTRLE) {
-            MyBase::SetErrMsg("Unsupported Tiff compression");
+            errMsg("Unsupported Tiff compression");
             return (-1);
         }
     }
@@ -181,7 +213,7 @@ int GeoImage::TiffReadImage(int dirnum, unsigned char *texture) const
                 int revrow = h - row - 1;    // reverse, go bottom up
                 int rc = TIFFReadScanline(_tif, buf, row);
                 if (rc < 0) {
-                    MyBase::SetErrMsg("Error reading tiff file:\n %s\n", _path.c_str());
+                    errMsg("Error reading tiff file:\n %s\n", _path.c_str());
                     _TIFFfree(buf);
                     return (-1);
                 }
@@ -204,7 +236,7 @@ int GeoImage::TiffReadImage(int dirnum, unsigned char *texture) const
                 for (row = 0; row < h; row++) {
                     int rc = TIFFReadScanline(_tif, buf, row, s);
                     if (rc < 0) {
-                        MyBase::SetErrMsg("Error reading tiff file:\n %s\n", _path.c_str());
+                        errMsg("Error reading tiff file:\n %s\n", _path.c_str());
                         _TIFFfree(buf);
                         return (-1);
                     }
@@ -233,7 +265,7 @@ int GeoImage::TiffReadImage(int dirnum, unsigned char *texture) const
 
         ok = TIFFReadRGBAImage(_tif, w, h, texuint32, 0);
         if (!ok) {
-            MyBase::SetErrMsg("Error reading tiff file:\n %s\n", _path.c_str());
+            errMsg("Error reading tiff file:\n %s\n", _path.c_str());
             return -1;
         }
 
@@ -3,6 +3,8 @@
 #include "vapor/VAssert.h"
 #include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <algorithm>
 #ifdef WIN32
     #include <geotiff/geotiff.h>
     #include <geotiff/geo_normalize.h>
@@ -11,6 +13,7 @@
     #include <geo_normalize.h>
 #endif
 
+#include <vapor/TaskScheduler.h>
 #include <vapor/Proj4API.h>
 #include <vapor/GeoUtil.h>
 #include <vapor/GeoTileMercator.h>
@@ -20,7 +23,39 @@
 using namespace VAPoR;
 using namespace Wasp;
 
-GeoImageTMS::GeoImageTMS() : GeoImage(8, 4)
+namespace {
+
+// Decodes tiles on a worker thread. Each worker owns a reader so
+// that TIFF handles are never shared between threads.
+//
+class tileReader : public GeoImage {
+public:
+    tileReader() : GeoImage(8, 4) {}
+
+    int Initialize(string path, vector<double> times) { return (0); }
+
+    unsigned char *GetImage(size_t ts, size_t &width, size_t &height) { return (NULL); }
+
+    unsigned char *GetImage(size_t ts, const double pcsExtentsReq[4], string proj4StringReq, size_t maxWidthReq, size_t maxHeightReq, double pcsExtentsImg[4], double geoCornersImg[8],
+                            string &proj4StringImg, size_t &width, size_t &height)
+    {
+        return (NULL);
+    }
+
+    int Read(string path, unsigned char *tile)
+    {
+        int rc = TiffOpen(path);
+        if (rc < 0) return (-1);
+
+        rc = TiffReadImage(0, tile);
+        TiffClose();
+        return (rc);
+    }
+};
+
+};    // namespace
+
+GeoImageTMS::GeoImageTMS(int nthreads, size_t capacity) : GeoImage(8, 4)
 {
     _dir.clear();
     _currentLOD = -1;
@@ -30,6 +65,15 @@ GeoImageTMS::GeoImageTMS() : GeoImage(8, 4)
     _tileBuf = NULL;
     _tileBufSize = 0;
     _geotile = NULL;
+    _capacity = std::max(capacity, (size_t)1);
+    _async = true;
+    _imageComplete = true;
+    _generation = 0;
+    _shutdown = false;
+    ResetCacheStats();
+
+    if (nthreads < 1) nthreads = std::min(TaskScheduler::Instance().GetNumThreads(), 4);
+    for (int i = 0; i < nthreads; i++) _threads.push_back(std::thread(&GeoImageTMS::_worker, this));
 
     // The default projection string for imagery centered at 0 degrees
     // longitude. This string is modified (+lon_0 is edited) if a
@@ -42,6 +86,8 @@ GeoImageTMS::GeoImageTMS() : GeoImage(8, 4)
 
 GeoImageTMS::~GeoImageTMS()
 {
+    _stopThreads();
+
     if (_texture) delete[] _texture;
     _textureSize = 0;
 
@@ -55,6 +101,24 @@ int GeoImageTMS::Initialize(string dir, vector<double> times)
 {
     SetDiagMsg("GeoImageTMS::Initialize(%s)", dir.c_str());
 
+    // Abandon tiles requested for the previous database. Tiles that are
+    // being decoded are discarded by the workers when they finish.
+    //
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _generation++;
+        _demandQueue.clear();
+        _prefetchQueue.clear();
+        _pending.clear();
+        _pendingPrefetch.clear();
+        _done.clear();
+    }
+    _lru.clear();
+    _lruPos.clear();
+    _prefetchedResident.clear();
+    _failedTiles.clear();
+    _imageComplete = true;
+
     if (_geotile) delete _geotile;
     _geotile = NULL;
     _dir = dir;
@@ -90,6 +154,15 @@ int GeoImageTMS::Initialize(string dir, vector<double> times)
         _tileBufSize = size;
     }
 
+    // The single LOD 0 tile is the placeholder of last resort for every
+    // other tile, so it is read now and never evicted
+    //
+    rc = _tileRead(_dir, 0, 0, 0, _tileBuf);
+    if (rc < 0) return (-1);
+
+    rc = _geotile->Insert(_geotile->TileXYToQuadKey(0, 0, 0), _tileBuf);
+    VAssert(!(rc < 0));
+
     return (0);
 }
 
@@ -109,8 +182,9 @@ unsigned char *GeoImageTMS::GetImage(size_t ts, size_t &width, size_t &height)
     //
     // Just return the base texture
     //
-    int rc = _tileRead(_dir, 0, 0, 0, _texture);
-    if (rc < 0) return (NULL);
+    const unsigned char *tile = _geotile->GetTile(0, 0, 0);
+    VAssert(tile);
+    memcpy(_texture, tile, size);
 
     return (_texture);
 }
@@ -347,20 +421,34 @@ int GeoImageTMS::_getMap(const size_t pixelSW[2], const size_t pixelNE[2], int l
         nytiles = ntiles - ((tileY1 == tileY0) ? 0 : (tileY0 - tileY1 - 1));
     }
 
-    // Make sure tiles need for this map are loaded. If not, read
-    // and load them
+    // Pick up tiles decoded since the last call
+    //
+    _collect();
+
+    // Request the tiles needed for this map that are not resident
     //
-    size_t tileY = tileY0;
+    vector<size_t> missing;    // tileX, tileY pairs
+    vector<string> region;     // quadkeys of all tiles in the map
+    size_t         tileY = tileY0;
     for (size_t y = 0; y < nytiles; y++) {
         size_t tileX = tileX0;
         for (size_t x = 0; x < nxtiles; x++) {
             string quadkey = _geotile->TileXYToQuadKey(tileX, tileY, lod);
-            if (!_geotile->GetTile(quadkey)) {
-                int rc = _tileRead(_dir, tileX, tileY, lod, _tileBuf);
-                if (rc < 0) return (-1);
-
-                rc = _geotile->Insert(quadkey, _tileBuf);
-                VAssert(!(rc < 0));
+            if (_failedTiles.count(quadkey)) {
+                SetErrMsg("Tile %d %d %d does not exist or could not be read : %s", tileX, tileY, lod, _failedTiles[quadkey].c_str());
+                return (-1);
+            }
+            region.push_back(quadkey);
+
+            if (_geotile->GetTile(quadkey)) {
+                _stats.hits++;
+                if (_prefetchedResident.erase(quadkey)) _stats.prefetchHits++;
+                _touch(quadkey);
+            } else {
+                _stats.misses++;
+                _request(tileX, tileY, lod, false);
+                missing.push_back(tileX);
+                missing.push_back(tileY);
             }
             tileX = (tileX + 1) % ntiles;
         }
@@ -368,6 +456,347 @@ int GeoImageTMS::_getMap(const size_t pixelSW[2], const size_t pixelNE[2], int l
         tileY = (tileY + 1) % ntiles;
     }
 
+    _prefetch(tileX0, tileY0, nxtiles, nytiles, lod);
+
+    // Wait for the missing tiles, or substitute placeholders for the
+    // ones that have not arrived
+    //
+    vector<string> placeholders;
+    while (true) {
+        placeholders.clear();
+        for (size_t i = 0; i < missing.size(); i += 2) {
+            string quadkey = _geotile->TileXYToQuadKey(missing[i], missing[i + 1], lod);
+            if (_failedTiles.count(quadkey)) {
+                SetErrMsg("Tile %d %d %d does not exist or could not be read : %s", missing[i], missing[i + 1], lod, _failedTiles[quadkey].c_str());
+                return (-1);
+            }
+            if (!_geotile->GetTile(quadkey)) placeholders.push_back(quadkey);
+        }
+        if (placeholders.empty() || _async) break;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _doneCV.wait(lock, [this] { return !_done.empty(); });
+        }
+        _collect();
+    }
+
+    // Tiles collected while waiting, prefetches included, were inserted
+    // at the front of the LRU list. Move the tiles of this map back in
+    // front of them so that eviction can not drop a tile about to be
+    // drawn.
+    //
+    for (const auto &quadkey : region) {
+        if (_geotile->GetTile(quadkey)) _touch(quadkey);
+    }
+    _evict(std::max(_capacity, nxtiles * nytiles));
+
+    for (size_t i = 0; i < placeholders.size(); i++) {
+        size_t tileX, tileY;
+        int    dummyLOD;
+        (void)_geotile->QuadKeyToTileXY(placeholders[i], tileX, tileY, dummyLOD);
+
+        size_t w, h;
+        _geotile->GetTileSize(w, h);
+        if (!_makePlaceholder(tileX, tileY, lod, _tileBuf)) memset(_tileBuf, 0, w * h * 4);
+
+        int rc = _geotile->Insert(placeholders[i], _tileBuf);
+        VAssert(!(rc < 0));
+        _stats.placeholders++;
+    }
+    _imageComplete = placeholders.empty();
+
     int rc = _geotile->GetMap(pixelSW[0], pixelSW[1], pixelNE[0], pixelNE[1], lod, texture);
+
+    // Placeholders are only held for the duration of GetMap() so that
+    // the GeoTile contains nothing but real tiles
+    //
+    for (size_t i = 0; i < placeholders.size(); i++) _geotile->Remove(placeholders[i]);
+
     return (rc);
 }
+
+// Upsample the region covered by a tile from its nearest resident
+// ancestor. Returns false if no ancestor is resident.
+//
+bool GeoImageTMS::_makePlaceholder(size_t tileX, size_t tileY, int lod, unsigned char *tile) const
+{
+    size_t w, h;
+    _geotile->GetTileSize(w, h);
+
+    for (int k = 1; k <= lod; k++) {
+        const unsigned char *src = _geotile->GetTile(tileX >> k, tileY >> k, lod - k);
+        if (!src) continue;
+
+        // Pixel (i,j) of the tile is pixel ((tileX * w + i) >> k, ...) of
+        // the global map at lod - k
+        //
+        size_t mask = ((size_t)1 << k) - 1;
+        size_t x0 = (tileX & mask) * w;
+        size_t y0 = (tileY & mask) * h;
+        for (size_t j = 0; j < h; j++) {
+            const unsigned char *srcRow = src + ((y0 + j) >> k) * w * 4;
+            unsigned char *      dstRow = tile + j * w * 4;
+            for (size_t i = 0; i < w; i++) { memcpy(dstRow + i * 4, srcRow + ((x0 + i) >> k) * 4, 4); }
+        }
+        return (true);
+    }
+    return (false);
+}
+
+// Queue a tile for decoding unless it is resident, pending, or known to
+// be unreadable. A demand request for a tile that is waiting to be
+// prefetched moves it to the demand queue. Returns true if the tile
+// was newly queued.
+//
+bool GeoImageTMS::_request(size_t tileX, size_t tileY, int lod, bool prefetch)
+{
+    string quadkey = _geotile->TileXYToQuadKey(tileX, tileY, lod);
+    if (_geotile->GetTile(quadkey) || _failedTiles.count(quadkey)) return (false);
+
+    size_t w, h;
+    _geotile->GetTileSize(w, h);
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_pending.count(quadkey)) {
+            if (prefetch || !_pendingPrefetch.count(quadkey)) return (false);
+
+            for (auto itr = _prefetchQueue.begin(); itr != _prefetchQueue.end(); ++itr) {
+                if (itr->_quadkey != quadkey) continue;
+                _demandQueue.push_back(*itr);
+                _prefetchQueue.erase(itr);
+                break;
+            }
+            _pendingPrefetch.erase(quadkey);
+            return (false);
+        }
+
+        tileReq_t req;
+        req._quadkey = quadkey;
+        req._dir = _dir;
+        req._size = w * h * 4;
+        req._tileX = tileX;
+        req._tileY = tileY;
+        req._lod = lod;
+        req._generation = _generation;
+
+        _pending.insert(quadkey);
+        if (prefetch) {
+            _prefetchQueue.push_back(req);
+            _pendingPrefetch.insert(quadkey);
+        } else {
+            _demandQueue.push_back(req);
+        }
+    }
+    _workCV.notify_one();
+    return (true);
+}
+
+// Queue the tiles around a region, and the tiles covering it one LOD
+// coarser and one LOD finer. Prefetches left over from the previous
+// region are dropped. At most half of the cache capacity is prefetched.
+//
+void GeoImageTMS::_prefetch(size_t tileX0, size_t tileY0, size_t nxtiles, size_t nytiles, int lod)
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (const auto &req : _prefetchQueue) _pending.erase(req._quadkey);
+        _prefetchQueue.clear();
+        _pendingPrefetch.clear();
+    }
+
+    size_t budget = _capacity / 2;
+    size_t queued = 0;
+    size_t ntiles = (size_t)1 << lod;
+
+    // Coarser tiles first; they double as placeholders when zooming in
+    //
+    if (lod > 0) {
+        for (size_t y = 0; y < nytiles && queued < budget; y++) {
+            for (size_t x = 0; x < nxtiles && queued < budget; x++) {
+                size_t tileX = (tileX0 + x) % ntiles;
+                size_t tileY = (tileY0 + y) % ntiles;
+                if (_request(tileX >> 1, tileY >> 1, lod - 1, true)) queued++;
+            }
+        }
+    }
+
+    // One tile wide ring of neighbours
+    //
+    for (long y = -1; y <= (long)nytiles && queued < budget; y++) {
+        for (long x = -1; x <= (long)nxtiles && queued < budget; x++) {
+            if (x >= 0 && x < (long)nxtiles && y >= 0 && y < (long)nytiles) continue;
+
+            size_t tileX = (tileX0 + ntiles + x) % ntiles;
+            size_t tileY = (tileY0 + ntiles + y) % ntiles;
+            if (_request(tileX, tileY, lod, true)) queued++;
+        }
+    }
+
+    // Finer tiles, only if all four children of every tile fit
+    //
+    if (lod < _maxLOD && queued + 4 * nxtiles * nytiles <= budget) {
+        for (size_t y = 0; y < nytiles; y++) {
+            for (size_t x = 0; x < nxtiles; x++) {
+                size_t tileX = (tileX0 + x) % ntiles;
+                size_t tileY = (tileY0 + y) % ntiles;
+                for (int c = 0; c < 4; c++) {
+                    if (_request(2 * tileX + (c & 1), 2 * tileY + (c >> 1), lod + 1, true)) queued++;
+                }
+            }
+        }
+    }
+
+    _stats.prefetches += queued;
+}
+
+// Move tiles decoded by the workers into the GeoTile
+//
+void GeoImageTMS::_collect()
+{
+    std::deque<tileDone_t> done;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        done.swap(_done);
+    }
+
+    for (auto &tile : done) {
+        if (!tile._ok) {
+            _failedTiles[tile._quadkey] = tile._errMsg;
+            continue;
+        }
+        _insertTile(tile._quadkey, tile._pixels.data(), tile._prefetched);
+    }
+}
+
+void GeoImageTMS::_insertTile(const string &quadkey, const unsigned char *pixels, bool prefetched)
+{
+    int rc = _geotile->Insert(quadkey, pixels);
+    VAssert(!(rc < 0));
+
+    _touch(quadkey);
+    if (prefetched) _prefetchedResident.insert(quadkey);
+}
+
+// Mark a tile as most recently used. The LOD 0 tile is not tracked.
+//
+void GeoImageTMS::_touch(const string &quadkey)
+{
+    if (quadkey.empty()) return;
+
+    auto itr = _lruPos.find(quadkey);
+    if (itr != _lruPos.end()) {
+        _lru.splice(_lru.begin(), _lru, itr->second);
+    } else {
+        _lru.push_front(quadkey);
+        _lruPos[quadkey] = _lru.begin();
+    }
+}
+
+// Drop least recently used tiles until at most keep remain
+//
+void GeoImageTMS::_evict(size_t keep)
+{
+    while (_lru.size() > keep) {
+        string quadkey = _lru.back();
+        _lru.pop_back();
+        _lruPos.erase(quadkey);
+        _prefetchedResident.erase(quadkey);
+        _geotile->Remove(quadkey);
+        _stats.evictions++;
+    }
+}
+
+void GeoImageTMS::_worker()
+{
+    tileReader reader;
+
+    // MyBase error reporting is not thread safe. Errors are returned to
+    // the calling thread with the tile and reported there by _getMap()
+    //
+    string errMsg;
+    GeoImage::SetThreadErrMsg(&errMsg);
+
+    while (true) {
+        tileReq_t req;
+        bool      prefetch;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _workCV.wait(lock, [this] { return _shutdown || !_demandQueue.empty() || !_prefetchQueue.empty(); });
+            if (_shutdown) break;
+
+            // Tiles needed for display take precedence over prefetches
+            //
+            prefetch = _demandQueue.empty();
+            std::deque<tileReq_t> &queue = prefetch ? _prefetchQueue : _demandQueue;
+            req = queue.front();
+            queue.pop_front();
+            if (prefetch) _pendingPrefetch.erase(req._quadkey);
+        }
+
+        tileDone_t tile;
+        tile._quadkey = req._quadkey;
+        tile._prefetched = prefetch;
+        tile._pixels.resize(req._size);
+
+        errMsg.clear();
+        string path = TMSUtils::TilePath(req._dir, req._tileX, req._tileY, req._lod);
+        if (path.empty()) errMsg = "no such tile";
+        tile._ok = !path.empty() && reader.Read(path, tile._pixels.data()) == 0;
+        if (!tile._ok) {
+            tile._pixels.clear();
+            tile._errMsg = errMsg;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (req._generation == _generation) {
+                _pending.erase(req._quadkey);
+                _done.push_back(std::move(tile));
+            }
+        }
+        _doneCV.notify_all();
+    }
+
+    GeoImage::SetThreadErrMsg(NULL);
+}
+
+void GeoImageTMS::_stopThreads()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _shutdown = true;
+    }
+    _workCV.notify_all();
+    for (auto &t : _threads) t.join();
+    _threads.clear();
+}
+
+void GeoImageTMS::SetCacheCapacity(size_t ntiles)
+{
+    _capacity = std::max(ntiles, (size_t)1);
+    _evict(_capacity);
+}
+
+GeoImageTMS::CacheStats GeoImageTMS::GetCacheStats() const
+{
+    CacheStats stats = _stats;
+    stats.resident = _geotile ? _geotile->GetNumTiles() : 0;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    stats.pending = _pending.size();
+    return (stats);
+}
+
+void GeoImageTMS::ResetCacheStats()
+{
+    _stats.hits = 0;
+    _stats.misses = 0;
+    _stats.placeholders = 0;
+    _stats.prefetches = 0;
+    _stats.prefetchHits = 0;
+    _stats.evictions = 0;
+    _stats.resident = 0;
+    _stats.pending = 0;
+}
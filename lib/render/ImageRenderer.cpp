@@ -85,6 +85,7 @@ ImageRenderer::ImageRenderer(const ParamsMgr *pm, string winName, string dataSet
     _cacheRefLevel = 0;
     _cacheLod = 0;
     _cacheHgtVar = "";
+    _cacheDefaultZ = 0.0;
     _cacheGeoreferenced = -1;
     _cacheTimestepTex = 0;
     _cacheBoxExtentsTex.clear();
@@ -230,9 +231,14 @@ unsigned char *ImageRenderer::_getTexture(DataMgr *dataMgr)
     //
     vector<double> _pcsExtentsData = _getPCSExtentsData();
 
-    // Get a new texture if any relevant parameters have changed
+    // Get a new texture if any relevant parameters have changed, or if
+    // the current one still contains placeholders for tiles being loaded
     //
-    if (!_twoDTex || _imageStateDirty(times) || _texStateDirty(dataMgr)) {
+    bool refining = _twoDTex && !_imageStateDirty(times) && !_texStateDirty(dataMgr) && !_geoImage->IsImageComplete();
+    if (!_twoDTex || _imageStateDirty(times) || _texStateDirty(dataMgr) || refining) {
+        GLsizei prevWidth = _texWidth;
+        GLsizei prevHeight = _texHeight;
+
         // Get pro4 string for data if georeferencing is requested
         //
         string proj4StringData;
@@ -246,9 +252,10 @@ unsigned char *ImageRenderer::_getTexture(DataMgr *dataMgr)
 
         _texStateSet(dataMgr);
 
-        // Force recompute of mesh
+        // Force recompute of mesh. A refined image covers the same region
+        // at the same size, so the mesh is still valid.
         //
-        _gridStateClear();
+        if (!refining || _texWidth != prevWidth || _texHeight != prevHeight) _gridStateClear();
     }
     _imageStateSet(times);
 
@@ -262,13 +269,20 @@ bool ImageRenderer::_gridStateDirty() const
     int            refLevel = myParams->GetRefinementLevel();
     int            lod = myParams->GetCompressionLevel();
     string         hgtVar = myParams->GetHeightVariableName();
-    int            ts = myParams->GetCurrentTimestep();
+    size_t         ts = myParams->GetCurrentTimestep();
     vector<double> minExt, maxExt;
     myParams->GetBox()->GetExtents(minExt, maxExt);
     vector<double> boxExtents(minExt);
     boxExtents.insert(boxExtents.end(), maxExt.begin(), maxExt.end());
 
-    return (refLevel != _cacheRefLevel || lod != _cacheLod || hgtVar != _cacheHgtVar || ts != _cacheTimestep || boxExtents != _cacheBoxExtents);
+    // The time step only matters if the terrain varies with time. Changes
+    // to a time varying image force the mesh to be recomputed by
+    // clearing the grid state.
+    //
+    size_t meshTS = GetMeshTimeStep(_dataMgr, ts, "", hgtVar);
+    double defaultZ = GetDefaultZ(_dataMgr, ts);
+
+    return (refLevel != _cacheRefLevel || lod != _cacheLod || hgtVar != _cacheHgtVar || meshTS != _cacheTimestep || defaultZ != _cacheDefaultZ || boxExtents != _cacheBoxExtents);
 }
 
 void ImageRenderer::_gridStateClear()
@@ -277,6 +291,7 @@ void ImageRenderer::_gridStateClear()
     _cacheLod = 0;
     _cacheHgtVar.clear();
     _cacheTimestep = -1;
+    _cacheDefaultZ = 0.0;
     _cacheBoxExtents.clear();
 }
 
@@ -286,7 +301,8 @@ void ImageRenderer::_gridStateSet()
     _cacheRefLevel = myParams->GetRefinementLevel();
     _cacheLod = myParams->GetCompressionLevel();
     _cacheHgtVar = myParams->GetHeightVariableName();
-    _cacheTimestep = myParams->GetCurrentTimestep();
+    _cacheTimestep = GetMeshTimeStep(_dataMgr, myParams->GetCurrentTimestep(), "", _cacheHgtVar);
+    _cacheDefaultZ = GetDefaultZ(_dataMgr, myParams->GetCurrentTimestep());
     vector<double> minExt, maxExt;
     myParams->GetBox()->GetExtents(minExt, maxExt);
     _cacheBoxExtents = minExt;
@@ -482,7 +498,7 @@ int ImageRenderer::_getMeshDisplaced(DataMgr *dataMgr, GLsizei width, GLsizei he
 
     // (Re)allocate space for verts
     //
-    _nverts = width * height * 3;
+    _nverts = width * height;
     _sb_verts.Alloc(_nverts * 3 * sizeof(GLfloat));
     _sb_normals.Alloc(_nverts * 3 * sizeof(GLfloat));
 
@@ -542,29 +558,7 @@ int ImageRenderer::_getMeshDisplacedGeo(DataMgr *dataMgr, Grid *hgtGrid, GLsizei
 
     // Now find vertical coordinate
     //
-    double mv = hgtGrid ? hgtGrid->GetMissingValue() : 0.0;
-    for (int j = 0; j < height; j++) {
-        for (int i = 0; i < width; i++) {
-            float x = verts[j * width * 3 + i * 3];
-            float y = verts[j * width * 3 + i * 3 + 1];
-            float z = 0.0;
-
-            // Lookup vertical coordinate as a data element from the
-            // height variable. Note, missing values are possible if image
-            // extents are out side of extents for height variable, or if
-            // height variable itself contains missing values.
-            //
-            float deltaZ = 0.0;
-            if (hgtGrid) {
-                deltaZ = hgtGrid->GetValue(x, y, 0.0);
-                if (deltaZ == mv) deltaZ = 0.0;
-            }
-
-            z = deltaZ + defaultZ;
-
-            verts[j * width * 3 + i * 3 + 2] = z;
-        }
-    }
+    DisplaceVertices(hgtGrid, defaultZ, verts, width * height);
 
     // Take care of any boundary conditions to present meshes with
     // folds. Still needed?
@@ -588,33 +582,22 @@ int ImageRenderer::_getMeshDisplacedNoGeo(DataMgr *dataMgr, Grid *hgtGrid, GLsiz
     // vertical coordinate for now.
     //
     GLfloat *verts = (GLfloat *)_sb_verts.GetBuf();
-    double   mv = hgtGrid ? hgtGrid->GetMissingValue() : 0.0;
     for (int j = 0; j < height; j++) {
         double y = minExt[1] + (j * deltay);
 
         for (int i = 0; i < width; i++) {
             double x = minExt[0] + (i * deltax);
-            double z = 0.0;
 
             verts[j * width * 3 + i * 3] = x;
             verts[j * width * 3 + i * 3 + 1] = y;
-
-            // Lookup vertical coordinate as a data element from the
-            // height variable. Note, missing values are possible if image
-            // extents are out side of extents for height variable, or if
-            // height variable itself contains missing values.
-            //
-            float deltaZ = 0;
-            if (hgtGrid) {
-                deltaZ = hgtGrid->GetValue(x, y, 0.0);
-                if (deltaZ == mv) deltaZ = 0.0;
-            }
-            z = deltaZ + defaultZ;
-
-            verts[j * width * 3 + i * 3 + 2] = z;
         }
     }
 
+    // Lookup vertical coordinate as a data element from the
+    // height variable
+    //
+    DisplaceVertices(hgtGrid, defaultZ, verts, width * height);
+
     return (0);
 }
 
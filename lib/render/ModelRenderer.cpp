@@ -19,6 +19,8 @@
 //
 
 #include <string>
+#include <map>
+#include <cstddef>
 
 #include <vapor/glutil.h>    // Must be included first!!!
 
@@ -82,7 +84,8 @@ int ModelRenderer::_paintGL(bool fast)
     glDepthMask(GL_TRUE);
     glEnable(GL_DEPTH_TEST);
 
-    _scene.Render(_glManager, rp->GetCurrentTimestep());
+    bool merge = rp->GetValueLong(ModelParams::MergeMeshesTag, false);
+    _scene.Render(_glManager, glm::make_vec3(lightDir), merge, rp->GetCurrentTimestep());
     lgl->DisableLighting();
 
     return rc;
@@ -90,41 +93,156 @@ int ModelRenderer::_paintGL(bool fast)
 
 int ModelRenderer::_initializeGL() { return 0; }
 
-void ModelRenderer::Model::renderNode(GLManager *gl, const aiNode *nd) const
+ModelRenderer::Model::~Model() { releaseGPU(); }
+
+void ModelRenderer::Model::collectInstances(const aiNode *nd, glm::mat4 transform, std::vector<std::vector<glm::mat4>> &instances) const
 {
-    LegacyGL *     lgl = gl->legacy;
-    MatrixManager *mm = gl->matrixManager;
+    transform *= getMatrix(nd);
 
-    mm->PushMatrix();
-    mm->SetCurrentMatrix(mm->GetCurrentMatrix() * getMatrix(nd));
+    for (int m = 0; m < nd->mNumMeshes; m++) instances[nd->mMeshes[m]].push_back(transform);
 
-    for (int m = 0; m < nd->mNumMeshes; m++) {
-        const aiMesh *mesh = _scene->mMeshes[nd->mMeshes[m]];
-        const bool    hasNormals = mesh->HasNormals();
-        const bool    hasColor = mesh->GetNumColorChannels() > 0;
-        if (mesh->HasNormals())
-            lgl->EnableLighting();
-        else
-            lgl->DisableLighting();
-
-        lgl->Begin(GL_TRIANGLES);
-        for (int f = 0; f < mesh->mNumFaces; f++) {
-            const aiFace *face = &mesh->mFaces[f];
+    for (int c = 0; c < nd->mNumChildren; c++) collectInstances(nd->mChildren[c], transform, instances);
+}
 
-            if (face->mNumIndices != 3) continue;
+void ModelRenderer::Model::appendMesh(const aiMesh *mesh, const glm::mat4 *bake, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices) const
+{
+    const bool      hasNormals = mesh->HasNormals();
+    const bool      hasColor = mesh->GetNumColorChannels() > 0;
+    const size_t    base = vertices.size();
+    const glm::mat3 normalMatrix = bake ? glm::transpose(glm::inverse(glm::mat3(*bake))) : glm::mat3(1.f);
+
+    vertices.reserve(base + mesh->mNumVertices);
+    for (int v = 0; v < mesh->mNumVertices; v++) {
+        Vertex vertex;
+        vertex.position = glm::make_vec3(&mesh->mVertices[v].x);
+        vertex.normal = hasNormals ? glm::make_vec3(&mesh->mNormals[v].x) : glm::vec3(0.f);
+        vertex.color = hasColor ? glm::vec4(glm::make_vec3(&mesh->mColors[0][v].r), 1.f) : glm::vec4(1.f);
+        if (bake) {
+            vertex.position = glm::vec3(*bake * glm::vec4(vertex.position, 1.f));
+            vertex.normal = normalMatrix * vertex.normal;
+        }
+        vertices.push_back(vertex);
+    }
 
-            for (int v = 0; v < face->mNumIndices; v++) {
-                if (hasColor) lgl->Color3fv(&mesh->mColors[0][face->mIndices[v]].r);
-                if (hasNormals) lgl->Normal3fv(&mesh->mNormals[face->mIndices[v]].x);
-                lgl->Vertex3fv(&mesh->mVertices[face->mIndices[v]].x);
-            }
+    for (int f = 0; f < mesh->mNumFaces; f++) {
+        const aiFace *face = &mesh->mFaces[f];
+
+        if (face->mNumIndices != 3) continue;
+
+        for (int v = 0; v < face->mNumIndices; v++) indices.push_back(base + face->mIndices[v]);
+    }
+}
+
+void ModelRenderer::Model::uploadMesh(GPUMesh &g, const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, const std::vector<glm::mat4> &instances) const
+{
+    glGenVertexArrays(1, &g.VAO);
+    glGenBuffers(1, &g.VBO);
+    glGenBuffers(1, &g.EBO);
+    glGenBuffers(1, &g.instanceVBO);
+
+    glBindVertexArray(g.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, normal));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, color));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    std::vector<Instance> instanceData(instances.size());
+    for (size_t i = 0; i < instances.size(); i++) {
+        instanceData[i].transform = instances[i];
+        instanceData[i].normalMatrix = glm::transpose(glm::inverse(glm::mat3(instances[i])));
+    }
+
+    // The node transform is a per instance mat4, which takes four attribute
+    // slots, followed by its normal matrix, which takes three
+    glBindBuffer(GL_ARRAY_BUFFER, g.instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(Instance), instanceData.data(), GL_STATIC_DRAW);
+    for (int i = 0; i < 4; i++) {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)(offsetof(Instance, transform) + i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(3 + i, 1);
+        glEnableVertexAttribArray(3 + i);
+    }
+    for (int i = 0; i < 3; i++) {
+        glVertexAttribPointer(7 + i, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)(offsetof(Instance, normalMatrix) + i * sizeof(glm::vec3)));
+        glVertexAttribDivisor(7 + i, 1);
+        glEnableVertexAttribArray(7 + i);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    g.nIndices = indices.size();
+    g.nInstances = instances.size();
+}
+
+void ModelRenderer::Model::upload(bool merge)
+{
+    releaseGPU();
+
+    std::vector<std::vector<glm::mat4>> instances(_scene->mNumMeshes);
+    collectInstances(_scene->mRootNode, glm::mat4(1.0f), instances);
+
+    std::vector<Vertex>       vertices;
+    std::vector<unsigned int> indices;
+
+    if (!merge) {
+        for (int m = 0; m < _scene->mNumMeshes; m++) {
+            if (instances[m].empty()) continue;
+
+            vertices.clear();
+            indices.clear();
+            appendMesh(_scene->mMeshes[m], nullptr, vertices, indices);
+            if (indices.empty()) continue;
+
+            GPUMesh g;
+            g.hasNormals = _scene->mMeshes[m]->HasNormals();
+            uploadMesh(g, vertices, indices, instances[m]);
+            _meshes.push_back(g);
+        }
+    } else {
+        // Lighting is enabled per draw so meshes without normals are kept apart
+        std::map<std::pair<unsigned int, bool>, std::vector<int>> groups;
+        for (int m = 0; m < _scene->mNumMeshes; m++) {
+            const aiMesh *mesh = _scene->mMeshes[m];
+            if (!instances[m].empty()) groups[{mesh->mMaterialIndex, mesh->HasNormals()}].push_back(m);
+        }
+
+        const std::vector<glm::mat4> identity(1, glm::mat4(1.0f));
+        for (const auto &group : groups) {
+            vertices.clear();
+            indices.clear();
+            for (int m : group.second)
+                for (const glm::mat4 &transform : instances[m]) appendMesh(_scene->mMeshes[m], &transform, vertices, indices);
+            if (indices.empty()) continue;
+
+            GPUMesh g;
+            g.hasNormals = group.first.second;
+            uploadMesh(g, vertices, indices, identity);
+            _meshes.push_back(g);
         }
-        lgl->End();
     }
 
-    for (int c = 0; c < nd->mNumChildren; c++) renderNode(gl, nd->mChildren[c]);
+    _uploaded = true;
+    _uploadedMerged = merge;
+}
 
-    mm->PopMatrix();
+void ModelRenderer::Model::releaseGPU()
+{
+    for (GPUMesh &g : _meshes) {
+        glDeleteVertexArrays(1, &g.VAO);
+        glDeleteBuffers(1, &g.VBO);
+        glDeleteBuffers(1, &g.EBO);
+        glDeleteBuffers(1, &g.instanceVBO);
+    }
+    _meshes.clear();
+    _uploaded = false;
 }
 
 void ModelRenderer::Model::calculateBounds(const aiNode *nd, glm::mat4 transform)
@@ -161,12 +279,24 @@ glm::mat4 ModelRenderer::Model::getMatrix(const aiNode *nd) const
     return glm::make_mat4((float *)&m);
 }
 
-void ModelRenderer::Model::Render(GLManager *gl) const
+void ModelRenderer::Model::Render(GLManager *gl, const glm::vec3 &lightDir, bool merge)
 {
-    gl->legacy->Color3f(1, 1, 1);
-    gl->legacy->DisableTexture();
     VAssert(_scene);
-    renderNode(gl, _scene->mRootNode);
+    if (!_uploaded || merge != _uploadedMerged) upload(merge);
+
+    SmartShaderProgram shader = gl->shaderManager->GetSmartShader("Model");
+    if (!shader.IsValid()) return;
+
+    shader->SetUniform("P", gl->matrixManager->GetProjectionMatrix());
+    shader->SetUniform("MV", gl->matrixManager->GetModelViewMatrix());
+    shader->SetUniform("lightDir", lightDir);
+
+    for (const GPUMesh &g : _meshes) {
+        shader->SetUniform("lightingEnabled", g.hasNormals);
+        glBindVertexArray(g.VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, g.nIndices, GL_UNSIGNED_INT, 0, g.nInstances);
+    }
+    glBindVertexArray(0);
 }
 
 void ModelRenderer::Model::DrawBoundingBox(GLManager *gl) const
@@ -196,6 +326,7 @@ int ModelRenderer::Model::Load(const std::string &path)
         return -1;
     }
 
+    releaseGPU();
     if (_importer.GetScene()) _importer.FreeScene();
 
     _scene = _importer.ReadFile(path, aiProcessPreset_TargetRealtime_Quality | aiProcess_Triangulate);
@@ -233,7 +364,7 @@ int ModelRenderer::Scene::Load(const std::string &path)
     return rc;
 }
 
-void ModelRenderer::Scene::Render(GLManager *gl, const int ts)
+void ModelRenderer::Scene::Render(GLManager *gl, const glm::vec3 &lightDir, bool merge, const int ts)
 {
     MatrixManager *              mm = gl->matrixManager;
     const vector<ModelInstance> &keyframe = getInstances(ts);
@@ -253,7 +384,7 @@ void ModelRenderer::Scene::Render(GLManager *gl, const int ts)
         mm->Scale(scale.x, scale.y, scale.z);
         mm->Translate(-origin.x, -origin.y, -origin.z);
 
-        _models[instance.file]->Render(gl);
+        _models[instance.file]->Render(gl, lightDir, merge);
         mm->PopMatrix();
     }
 }
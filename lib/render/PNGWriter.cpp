@@ -1,7 +1,12 @@
 #include "vapor/PNGWriter.h"
 #include "vapor/VAssert.h"
 
-#define USE_PYTHON_PNG 1
+// Images are encoded with libpng unless the build did not find it, in
+// which case they are encoded by the Python interpreter
+//
+#ifndef USE_PYTHON_PNG
+    #define USE_PYTHON_PNG 0
+#endif
 
 #if USE_PYTHON_PNG
     #include "vapor/MyPython.h"
@@ -18,6 +23,8 @@ std::vector<std::string> PNGWriter::GetFileExtensions() { return {"png"}; }
 
 PNGWriter::PNGWriter(const string &path) : ImageWriter(path) {}
 
+bool PNGWriter::IsThreadSafe() const { return (!USE_PYTHON_PNG); }
+
 int PNGWriter::Write(const unsigned char *buffer, const unsigned int width, const unsigned int height)
 {
 #if USE_PYTHON_PNG
@@ -56,15 +63,12 @@ int PNGWriter::Write(const unsigned char *buffer, const unsigned int width, cons
         pValue = PyLong_FromLong((long)height);
         PyTuple_SetItem(pArgs, 2, pValue);
 
-        // The 4th argument: RGB buffer
+        // The 4th argument: RGB buffer, passed as a single bytes object
+        // rather than a list of per-byte Python integers
         long      nChars = width * height * 3;
-        PyObject *pListOfChars = PyList_New(nChars);
-        VAssert(pListOfChars);
-        for (long i = 0; i < nChars; i++) {
-            int rt = PyList_SetItem(pListOfChars, i, PyLong_FromLong((long)buffer[i]));
-            VAssert(rt == 0);
-        }
-        PyTuple_SetItem(pArgs, 3, pListOfChars);
+        PyObject *pBytes = PyBytes_FromStringAndSize((const char *)buffer, nChars);
+        VAssert(pBytes);
+        PyTuple_SetItem(pArgs, 3, pBytes);
 
         // Call the python routine
         pValue = PyObject_CallObject(pFunc, pArgs);
@@ -87,34 +91,51 @@ int PNGWriter::Write(const unsigned char *buffer, const unsigned int width, cons
 
     return 0;
 #else
-    int         code = 0;
-    FILE *      fp = NULL;
-    png_structp png_ptr = NULL;
-    png_infop   info_ptr = NULL;
-    png_bytep   row = NULL;
+    VAssert(format == Format::RGB);
 
-    fp = fopen(file, "wb");
-    if (!fp) return -1;
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp) {
+        MyBase::SetErrMsg("fopen(%s) : %M", path.c_str());
+        return (-1);
+    }
 
-    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (png_ptr == NULL) VAssert(0);
+    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop   info_ptr = png_ptr ? png_create_info_struct(png_ptr) : NULL;
+    if (!info_ptr) {
+        png_destroy_write_struct(&png_ptr, NULL);
+        fclose(fp);
+        MyBase::SetErrMsg("Failed to initialize libpng");
+        return (-1);
+    }
 
-    info_ptr = png_create_info_struct(png_ptr);
-    if (info_ptr == NULL) VAssert(0);
+    // libpng reports errors by longjmp'ing here
+    //
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        fclose(fp);
+        MyBase::SetErrMsg("Failed to write PNG file \"%s\"", path.c_str());
+        return (-1);
+    }
 
     png_init_io(png_ptr, fp);
 
+    // Captured frames are rewritten on every capture, so favor speed
+    // over file size
+    //
+    png_set_compression_level(png_ptr, 3);
     png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
-
     png_write_info(png_ptr, info_ptr);
 
-    #error Functionality Not Finished
+    for (unsigned int y = 0; y < height; y++) png_write_row(png_ptr, (png_const_bytep)(buffer + (size_t)y * width * 3));
 
     png_write_end(png_ptr, NULL);
-    if (fp) fclose(fp);
-    if (info_ptr) png_free_data(png_ptr, info_ptr, PNG_FREE_ALL, -1);
-    if (png_ptr) png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
 
-    return 0;
+    if (fclose(fp) != 0) {
+        MyBase::SetErrMsg("fclose(%s) : %M", path.c_str());
+        return (-1);
+    }
+
+    return (0);
 #endif
 }
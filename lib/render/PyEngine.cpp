@@ -3,6 +3,7 @@
 #include <vector>
 #include <map>
 #include <new>
+#include <algorithm>
 #include <vapor/utils.h>
 #include <vapor/DataMgrUtils.h>
 #include <vapor/PyEngine.h>
@@ -40,12 +41,6 @@ void free_arrays(vector<float *> &arrays)
     }
 }
 
-void free_arrays(vector<float *> &inputVarArrays, vector<float *> &outputVarArrays)
-{
-    free_arrays(inputVarArrays);
-    free_arrays(outputVarArrays);
-}
-
 int alloc_arrays(const vector<vector<size_t>> &dimsVectors, vector<float *> &arrays)
 {
     arrays.clear();
@@ -64,23 +59,6 @@ int alloc_arrays(const vector<vector<size_t>> &dimsVectors, vector<float *> &arr
     return (0);
 }
 
-int alloc_arrays(const vector<vector<size_t>> &inputVarDims, const vector<vector<size_t>> &outputVarDims, vector<float *> &inputVarArrays, vector<float *> &outputVarArrays)
-{
-    inputVarArrays.clear();
-    outputVarArrays.clear();
-
-    int rc = alloc_arrays(inputVarDims, inputVarArrays);
-    if (rc < 0) return (rc);
-
-    rc = alloc_arrays(outputVarDims, outputVarArrays);
-    if (rc < 0) {
-        free_arrays(inputVarArrays);
-        return (rc);
-    }
-
-    return (0);
-}
-
 void copy_region(const float *src, float *dst, const vector<size_t> &min, const vector<size_t> &max, const vector<size_t> &dims)
 {
     vector<size_t> coord = min;
@@ -117,43 +95,85 @@ void copy_coord(const Grid *g, int axis, float *dst)
     }
 }
 
-void grid2c(const vector<varinfo_t> &varInfoVec, const vector<float *> &inputVarArrays)
+// Return a pointer to the grid's sample data if it may be handed to
+// Python without copying. This requires the data to be stored in a single
+// block with the same dimensions as the grid, and missing values (if any)
+// to already be represented as infinity.
+//
+float *grid_data_view(const Grid *g)
 {
-    int idx = 0;
+    const vector<float *> &blks = g->GetBlks();
+    if (blks.size() != 1 || !blks[0]) return (NULL);
+
+    if (g->GetBlockSize() != g->GetDimensions()) return (NULL);
+
+    if (g->HasMissingData() && g->GetMissingValue() != std::numeric_limits<float>::infinity()) return (NULL);
+
+    return (blks[0]);
+}
+
+// Set up the input arrays for the grids, and any coordinate variables,
+// in varInfoVec. If zeroCopy is true grid data are referenced in place
+// when possible, and the corresponding elements of readOnly are set.
+// Arrays that are allocated are also returned in ownedArrays and must
+// be freed by the caller.
+//
+int grid2c(const vector<varinfo_t> &varInfoVec, bool zeroCopy, vector<float *> &inputVarArrays, vector<bool> &readOnly, vector<float *> &ownedArrays)
+{
+    inputVarArrays.clear();
+    readOnly.clear();
+    ownedArrays.clear();
+
     for (int i = 0; i < varInfoVec.size(); i++) {
         const varinfo_t &vref = varInfoVec[i];
 
         Grid *g = vref._g;
 
-        Grid::ConstIterator itr = g->cbegin();
-        Grid::ConstIterator enditr = g->cend();
-
-        VAssert(idx < inputVarArrays.size());
-        float *bufptr = inputVarArrays[idx];
-
-        // Copy data. Missing values are always set to infinity for
-        // easier Python handling
-        //
-        float mv = g->GetMissingValue();
-        for (; itr != enditr; ++itr) {
-            if (g->HasMissingData() && *itr == mv) {
-                *bufptr = std::numeric_limits<double>::infinity();
-            } else {
-                *bufptr = *itr;
+        float *view = zeroCopy ? grid_data_view(g) : NULL;
+        if (view) {
+            inputVarArrays.push_back(view);
+            readOnly.push_back(true);
+        } else {
+            float *bufptr = new (nothrow) float[VProduct(vref._dims)];
+            if (!bufptr) {
+                free_arrays(ownedArrays);
+                return (-1);
+            }
+            inputVarArrays.push_back(bufptr);
+            readOnly.push_back(false);
+            ownedArrays.push_back(bufptr);
+
+            Grid::ConstIterator itr = g->cbegin();
+            Grid::ConstIterator enditr = g->cend();
+
+            // Copy data. Missing values are always set to infinity for
+            // easier Python handling
+            //
+            float mv = g->GetMissingValue();
+            for (; itr != enditr; ++itr) {
+                if (g->HasMissingData() && *itr == mv) {
+                    *bufptr = std::numeric_limits<double>::infinity();
+                } else {
+                    *bufptr = *itr;
+                }
+                bufptr++;
             }
-            bufptr++;
         }
 
-        idx++;
         for (int j = 0; j < vref._coordNames.size(); j++) {
-            VAssert(idx < inputVarArrays.size());
-            float *bufptr = inputVarArrays[idx];
+            float *bufptr = new (nothrow) float[VProduct(vref._coordDims[j])];
+            if (!bufptr) {
+                free_arrays(ownedArrays);
+                return (-1);
+            }
+            inputVarArrays.push_back(bufptr);
+            readOnly.push_back(false);
+            ownedArrays.push_back(bufptr);
 
             copy_coord(g, vref._coordAxes[j], bufptr);
-
-            idx++;
         }
     }
+    return (0);
 }
 
 void get_var_info(DataMgr *dataMgr, const vector<Grid *> &gs, const vector<string> &varNames, bool coordFlag, vector<varinfo_t> &varinfoVec)
@@ -265,6 +285,7 @@ int PyEngine::AddFunction(string name, string script, const vector<string> &inpu
     for (int i = 0; i < outputVarNames.size(); i++) {
         string            vname = outputVarNames[i];
         DerivedPythonVar *dvar = new DerivedPythonVar(vname, "", DC::XType::FLOAT, outputVarMeshes[i], timeCoordVarName, true, inputVarNames, script, _dataMgr, coordFlag);
+        dvar->SetZeroCopy(_zeroCopy);
         dvars.push_back(dvar);
 
         if (dvar->Initialize() < 0) {
@@ -277,6 +298,10 @@ int PyEngine::AddFunction(string name, string script, const vector<string> &inpu
 
     _functions[name] = func_c(name, script, inputVarNames, outputVarNames, outputVarMeshes, dvars, coordFlag);
 
+    // The new variables may be inputs to other functions
+    //
+    _clearCaches();
+
     return (0);
 }
 
@@ -297,6 +322,30 @@ void PyEngine::RemoveFunction(string name)
     }
 
     _functions.erase(itr);
+
+    // Results of other functions may depend on the removed variables
+    //
+    _clearCaches();
+}
+
+void PyEngine::SetZeroCopyInputs(bool enable)
+{
+    _zeroCopy = enable;
+
+    map<string, func_c>::iterator itr;
+    for (itr = _functions.begin(); itr != _functions.end(); ++itr) {
+        const vector<DerivedPythonVar *> &dvars = itr->second._derivedVars;
+        for (int i = 0; i < dvars.size(); i++) dvars[i]->SetZeroCopy(enable);
+    }
+}
+
+void PyEngine::_clearCaches()
+{
+    map<string, func_c>::iterator itr;
+    for (itr = _functions.begin(); itr != _functions.end(); ++itr) {
+        const vector<DerivedPythonVar *> &dvars = itr->second._derivedVars;
+        for (int i = 0; i < dvars.size(); i++) dvars[i]->ClearCache();
+    }
 }
 
 vector<string> PyEngine::GetFunctionNames() const
@@ -362,9 +411,18 @@ PyEngine::~PyEngine()
 
 int PyEngine::Calculate(const string &script, vector<string> inputVarNames, vector<vector<size_t>> inputVarDims, vector<float *> inputVarArrays, vector<string> outputVarNames,
                         vector<vector<size_t>> outputVarDims, vector<float *> outputVarArrays)
+{
+    vector<bool> inputReadOnly(inputVarArrays.size(), false);
+
+    return (_calculate(script, inputVarNames, inputVarDims, inputVarArrays, inputReadOnly, outputVarNames, outputVarDims, outputVarArrays));
+}
+
+int PyEngine::_calculate(const string &script, const vector<string> &inputVarNames, const vector<vector<size_t>> &inputVarDims, const vector<float *> &inputVarArrays,
+                         const vector<bool> &inputReadOnly, const vector<string> &outputVarNames, const vector<vector<size_t>> &outputVarDims, const vector<float *> &outputVarArrays)
 {
     VAssert(inputVarNames.size() == inputVarDims.size());
     VAssert(inputVarNames.size() == inputVarArrays.size());
+    VAssert(inputVarNames.size() == inputReadOnly.size());
     VAssert(outputVarNames.size() == outputVarDims.size());
     VAssert(outputVarNames.size() == outputVarArrays.size());
 
@@ -384,9 +442,9 @@ int PyEngine::Calculate(const string &script, vector<string> inputVarNames, vect
     PyObject *mainDict = PyModule_GetDict(mainModule);
     VAssert(mainDict != NULL);
 
-    // Copy arrays into python environment
+    // Make arrays available in python environment
     //
-    int rc = _c2python(mainDict, inputVarNames, inputVarDims, inputVarArrays);
+    int rc = _c2python(mainDict, inputVarNames, inputVarDims, inputVarArrays, inputReadOnly);
     if (rc < 0) {
         _cleanupDict(mainDict, inputVarNames);
         return (-1);
@@ -425,7 +483,7 @@ void PyEngine::_cleanupDict(PyObject *mainDict, vector<string> keynames)
     }
 }
 
-int PyEngine::_c2python(PyObject *dict, vector<string> inputVarNames, vector<vector<size_t>> inputVarDims, vector<float *> inputVarArrays)
+int PyEngine::_c2python(PyObject *dict, const vector<string> &inputVarNames, const vector<vector<size_t>> &inputVarDims, const vector<float *> &inputVarArrays, const vector<bool> &inputReadOnly)
 {
     npy_intp pyDims[3];
     for (int i = 0; i < inputVarNames.size(); i++) {
@@ -435,6 +493,15 @@ int PyEngine::_c2python(PyObject *dict, vector<string> inputVarNames, vector<vec
         for (int j = 0; j < dims.size(); j++) { pyDims[dims.size() - j - 1] = dims[j]; }
 
         PyObject *pyArray = PyArray_SimpleNewFromData(dims.size(), pyDims, NPY_FLOAT32, inputVarArrays[i]);
+        if (!pyArray) {
+            SetErrMsg("PyArray_SimpleNewFromData() : %s", MyPython::Instance()->PyErr().c_str());
+            return (-1);
+        }
+
+        // Arrays that reference memory owned by the DataMgr must not be
+        // modified by the script
+        //
+        if (inputReadOnly[i]) PyArray_CLEARFLAGS((PyArrayObject *)pyArray, NPY_ARRAY_WRITEABLE);
 
         PyObject *ky = Py_BuildValue("s", inputVarNames[i].c_str());
         PyObject_SetItem(dict, ky, pyArray);
@@ -445,7 +512,7 @@ int PyEngine::_c2python(PyObject *dict, vector<string> inputVarNames, vector<vec
     return (0);
 }
 
-int PyEngine::_python2c(PyObject *dict, vector<string> outputVarNames, vector<vector<size_t>> outputVarDims, vector<float *> outputVarArrays)
+int PyEngine::_python2c(PyObject *dict, const vector<string> &outputVarNames, const vector<vector<size_t>> &outputVarDims, const vector<float *> &outputVarArrays)
 {
     for (int i = 0; i < outputVarNames.size(); i++) {
         const string &vname = outputVarNames[i];
@@ -453,6 +520,7 @@ int PyEngine::_python2c(PyObject *dict, vector<string> outputVarNames, vector<ve
         PyObject *ky = Py_BuildValue("s", vname.c_str());
 
         PyObject *o = PyDict_GetItem(dict, ky);
+        Py_DECREF(ky);
         if (!o || !PyArray_CheckExact(o)) {
             SetErrMsg("Variable %s not produced by script", vname.c_str());
             return -1;
@@ -481,11 +549,21 @@ int PyEngine::_python2c(PyObject *dict, vector<string> outputVarNames, vector<ve
             }
         }
 
-        float *dataArray = (float *)PyArray_DATA(varArray);
-        size_t nelements = VProduct(dims);
+        // Scripts may produce non-contiguous views (e.g. transposes or
+        // strided slices). Only these need to be made contiguous
+        // before copying
+        //
+        PyArrayObject *contig = (PyArrayObject *)PyArray_GETCONTIGUOUS(varArray);
+        if (!contig) {
+            SetErrMsg("PyArray_GETCONTIGUOUS() : %s", MyPython::Instance()->PyErr().c_str());
+            return -1;
+        }
+
+        const float *dataArray = (const float *)PyArray_DATA(contig);
+        size_t       nelements = VProduct(dims);
 
-        float *outArray = outputVarArrays[i];
-        for (size_t j = 0; j < nelements; j++) { outArray[j] = dataArray[j]; }
+        std::copy(dataArray, dataArray + nelements, outputVarArrays[i]);
+        Py_DECREF(contig);
     }
 
     return (0);
@@ -493,7 +571,7 @@ int PyEngine::_python2c(PyObject *dict, vector<string> outputVarNames, vector<ve
 
 PyEngine::DerivedPythonVar::DerivedPythonVar(string varName, string units, DC::XType type, string mesh, string time_coord_var, bool hasMissing, std::vector<string> inNames, string script,
                                              DataMgr *dataMgr, bool coordFlag)
-: DerivedDataVar(varName), _varInfo(varName, units, type, "", std::vector<size_t>(), std::vector<bool>(), mesh, time_coord_var, DC::Mesh::NODE)
+: DerivedDataVar(varName), _varInfo(varName, units, type, "", std::vector<size_t>(), std::vector<bool>(), mesh, time_coord_var, DC::Mesh::NODE), _resultCache(2, true)
 {
     _inNames = inNames;
     _script = script;
@@ -502,6 +580,7 @@ PyEngine::DerivedPythonVar::DerivedPythonVar(string varName, string units, DC::X
     _dims.clear();
     _meshMatchFlag = false;
     _stdoutString.clear();
+    _zeroCopy = false;
     if (hasMissing) {
         _varInfo.SetHasMissing(true);
         _varInfo.SetMissingValue(std::numeric_limits<double>::infinity());
@@ -606,13 +685,29 @@ int PyEngine::DerivedPythonVar::_readRegionAll(int fd, const std::vector<size_t>
 {
     DC::FileTable::FileObject *f = _fileTable.GetEntry(fd);
 
-    vector<Grid *> variables;
-
     size_t ts = f->GetTS();
     int    level = f->GetLevel();
     int    lod = f->GetLOD();
 
-    int rc = DataMgrUtils::GetGrids(_dataMgr, ts, _inNames, false, &level, &lod, variables);
+    vector<size_t> dims, dummy;
+    (void)GetDimLensAtLevel(level, dims, dummy);
+    vector<vector<size_t>> outputVarDims = {dims};
+
+    // The script always operates on the entire domain here, so requests
+    // for different regions of the same variable can share the result
+    //
+    std::ostringstream oss;
+    oss << ts << ":" << level << ":" << lod;
+    string key = oss.str();
+
+    const std::unique_ptr<const vector<float>> &cached = _resultCache.query(key);
+    if (cached) {
+        copy_region(cached->data(), region, min, max, outputVarDims[0]);
+        return (0);
+    }
+
+    vector<Grid *> variables;
+    int            rc = DataMgrUtils::GetGrids(_dataMgr, ts, _inNames, false, &level, &lod, variables);
     if (rc < 0) return (-1);
 
     vector<varinfo_t> varInfoVec;
@@ -631,41 +726,45 @@ int PyEngine::DerivedPythonVar::_readRegionAll(int fd, const std::vector<size_t>
         }
     }
 
-    vector<size_t> dims, dummy;
-    (void)GetDimLensAtLevel(level, dims, dummy);
-    vector<vector<size_t>> outputVarDims = {dims};
+    // Script output is written directly into the buffer that will be cached
+    //
+    vector<float> *result = new vector<float>(VProduct(outputVarDims[0]));
 
     vector<float *> inputVarArrays;
-    vector<float *> outputVarArrays;
-    rc = alloc_arrays(inputVarDims, outputVarDims, inputVarArrays, outputVarArrays);
-    if (rc < 0) {
+    vector<bool>    inputReadOnly;
+    vector<float *> ownedArrays;
+    if (grid2c(varInfoVec, _zeroCopy, inputVarArrays, inputReadOnly, ownedArrays) < 0) {
+        delete result;
         SetErrMsg("Error allocating  memory");
         return (-1);
     }
 
-    grid2c(varInfoVec, inputVarArrays);
-
     //
     // clear stdout from static class
     //
     (void)MyPython::Instance()->PyOut();
 
-    vector<string> outputVarNames = {_derivedVarName};
-    rc = PyEngine::Calculate(_script, inputNames, inputVarDims, inputVarArrays, outputVarNames, outputVarDims, outputVarArrays);
+    vector<string>  outputVarNames = {_derivedVarName};
+    vector<float *> outputVarArrays = {result->data()};
+    rc = PyEngine::_calculate(_script, inputNames, inputVarDims, inputVarArrays, inputReadOnly, outputVarNames, outputVarDims, outputVarArrays);
 
     //
     // Capture any stdout
     //
     _stdoutString = MyPython::Instance()->PyOut().c_str();
 
+    free_arrays(ownedArrays);
+
     if (rc < 0) {
-        free_arrays(inputVarArrays, outputVarArrays);
+        delete result;
         return (-1);
     }
 
-    copy_region(outputVarArrays[0], region, min, max, outputVarDims[0]);
+    copy_region(result->data(), region, min, max, outputVarDims[0]);
 
-    free_arrays(inputVarArrays, outputVarArrays);
+    // Cache takes ownership of result
+    //
+    _resultCache.insert(key, result);
 
     return (0);
 }
@@ -711,48 +810,63 @@ int PyEngine::DerivedPythonVar::_readRegionSubset(int fd, const std::vector<size
         outputVarDims.push_back(Dims(min, max));
     }
 
-    vector<float *> inputVarArrays;
+    // The min and max coordinates input to this method are relative to
+    // the entire domain. We need to correct them by substracting off the
+    // origin of the ROI contained in the Grid objects
+    //
+    vector<size_t> min_roi, max_roi;
+    bool           directFlag = Dims(min, max) == outputVarDims[0];
+    for (int i = 0; i < min.size(); i++) {
+        min_roi.push_back(min[i] - minAbs[i]);
+        max_roi.push_back(max[i] - minAbs[i]);
+        if (min_roi[i] != 0) directFlag = false;
+    }
+
+    // If the requested region is exactly the region computed by the
+    // script the output can be written directly into the caller's buffer
+    //
     vector<float *> outputVarArrays;
-    rc = alloc_arrays(inputVarDims, outputVarDims, inputVarArrays, outputVarArrays);
-    if (rc < 0) {
+    if (directFlag) {
+        outputVarArrays.push_back(region);
+    } else {
+        rc = alloc_arrays(outputVarDims, outputVarArrays);
+        if (rc < 0) {
+            SetErrMsg("Error allocating  memory");
+            return (-1);
+        }
+    }
+
+    vector<float *> inputVarArrays;
+    vector<bool>    inputReadOnly;
+    vector<float *> ownedArrays;
+    if (grid2c(varInfoVec, _zeroCopy, inputVarArrays, inputReadOnly, ownedArrays) < 0) {
+        if (!directFlag) free_arrays(outputVarArrays);
         SetErrMsg("Error allocating  memory");
         return (-1);
     }
 
-    grid2c(varInfoVec, inputVarArrays);
-
     //
     // clear stdout from static class
     //
     (void)MyPython::Instance()->PyOut();
 
     vector<string> outputVarNames = {_derivedVarName};
-    rc = PyEngine::Calculate(_script, inputNames, inputVarDims, inputVarArrays, outputVarNames, outputVarDims, outputVarArrays);
+    rc = PyEngine::_calculate(_script, inputNames, inputVarDims, inputVarArrays, inputReadOnly, outputVarNames, outputVarDims, outputVarArrays);
 
     //
     // Capture any stdout
     //
     _stdoutString = MyPython::Instance()->PyOut().c_str();
 
-    if (rc < 0) {
-        free_arrays(inputVarArrays, outputVarArrays);
-        return (-1);
-    }
+    free_arrays(ownedArrays);
 
-    // The min and max coordinates input to this method are relative to
-    // the entire domain. We need to correct them by substracting off the
-    // origin of the ROI contained in the Grid objects
-    //
-    vector<size_t> min_roi, max_roi;
-    for (int i = 0; i < min.size(); i++) {
-        min_roi.push_back(min[i] - minAbs[i]);
-        max_roi.push_back(max[i] - minAbs[i]);
-    }
-    copy_region(outputVarArrays[0], region, min_roi, max_roi, outputVarDims[0]);
+    if (directFlag) return (rc);
 
-    free_arrays(inputVarArrays, outputVarArrays);
+    if (rc == 0) copy_region(outputVarArrays[0], region, min_roi, max_roi, outputVarDims[0]);
 
-    return (0);
+    free_arrays(outputVarArrays);
+
+    return (rc);
 }
 
 int PyEngine::DerivedPythonVar::ReadRegion(int fd, const std::vector<size_t> &min, const std::vector<size_t> &max, float *region)
@@ -438,28 +438,27 @@ int RayCaster::UserCoordinates::Update2ndVariable(const RayCasterParams *params,
 
 void RayCaster::UserCoordinates::IterateAGrid(const StructuredGrid *grid, size_t numOfVert, float *dataBuf, unsigned char *maskBuf)
 {
-    StructuredGrid::ConstIterator valItr = grid->cbegin();
-
-    if (grid->HasMissingData()) {
-        float missingValue = grid->GetMissingValue();
-        float dataValue;
-        for (size_t i = 0; i < numOfVert; i++) {
-            dataValue = *valItr;
-            if (dataValue == missingValue) {
-                dataBuf[i] = 0.0f;
-                maskBuf[i] = 127u;
-            } else {
-                dataBuf[i] = dataValue;
-                maskBuf[i] = 0u;
+    const std::vector<size_t> &dims = grid->GetDimensions();
+    size_t                     nx = dims[0];
+    size_t                     ny = dims.size() > 1 ? dims[1] : 1;
+    VAssert(numOfVert == nx * ny * (dims.size() > 2 ? dims[2] : 1));
+
+    bool  hasMissing = grid->HasMissingData();
+    float missingValue = grid->GetMissingValue();
+
+    grid->ParallelForEach([&](int, const Grid::Span &span) {
+        size_t offset = span.index[0] + nx * (span.index[1] + ny * span.index[2]);
+        if (hasMissing) {
+            for (size_t i = 0; i < span.n; i++) {
+                float v = span.data[i];
+                bool  missing = v == missingValue;
+                dataBuf[offset + i] = missing ? 0.0f : v;
+                maskBuf[offset + i] = missing ? 127u : 0u;
             }
-            ++valItr;
-        }
-    } else {
-        for (size_t i = 0; i < numOfVert; i++) {
-            dataBuf[i] = *valItr;
-            ++valItr;
+        } else {
+            memcpy(dataBuf + offset, span.data, span.n * sizeof(*dataBuf));
         }
-    }
+    });
 }
 
 void RayCaster::UserCoordinates::FillCoordsXYPlane(const StructuredGrid *grid, size_t planeIdx, float *coords)
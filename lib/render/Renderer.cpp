@@ -36,10 +36,13 @@
 #include <vapor/VolumeIsoParams.h>
 
 #include <vapor/ViewpointParams.h>
+#include <vapor/CFuncs.h>
+#include <vapor/Trace.h>
 
 using namespace VAPoR;
 const int Renderer::_imgWid = 256;
 const int Renderer::_imgHgt = 256;
+bool      Renderer::_synchronousTiming = false;
 
 Renderer::Renderer(const ParamsMgr *pm, string winName, string dataSetName, string paramsType, string classType, string instName, DataMgr *dataMgr)
 : RendererBase(pm, winName, dataSetName, paramsType, classType, instName, dataMgr)
@@ -49,6 +52,8 @@ Renderer::Renderer(const ParamsMgr *pm, string winName, string dataSetName, stri
 
     _colorbarTexture = 0;
     _timestep = 0;
+    _lastPaintTime = 0.0;
+    _lastFetchTime = 0.0;
 
     _fontName = "arimo";
 }
@@ -146,7 +151,17 @@ int Renderer::paintGL(bool fast)
 
     mm->Scale(datasetScales[0], datasetScales[1], datasetScales[2]);
 
-    int rc = _paintGL(fast);
+    double t0 = Wasp::GetTime();
+    double fetch0 = _dataMgr ? _dataMgr->GetFetchTime() : 0.0;
+
+    int rc;
+    {
+        Wasp::TraceSpan span("Renderer::paintGL", "render", _classType);
+        rc = _paintGL(fast);
+        if (_synchronousTiming) glFinish();
+    }
+    _lastPaintTime = Wasp::GetTime() - t0;
+    _lastFetchTime = _dataMgr ? _dataMgr->GetFetchTime() - fetch0 : 0.0;
 
     mm->PopMatrix();
 
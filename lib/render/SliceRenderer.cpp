@@ -230,94 +230,29 @@ std::vector<double> SliceRenderer::_calculateDeltas() const
     return deltas;
 }
 
-void SliceRenderer::_populateDataXY(float *dataValues, Grid *grid) const
+void SliceRenderer::_getSamplePlane(std::vector<double> &origin, std::vector<double> &du, std::vector<double> &dv) const
 {
     std::vector<double> deltas = _calculateDeltas();
-    float               varValue, missingValue;
-    std::vector<double> coords(3, 0.0);
-    coords[X] = _cacheParams.domainMin[X] + deltas[X] / 2.f;
-    coords[Y] = _cacheParams.domainMin[Y] + deltas[Y] / 2.f;
-    coords[Z] = _cacheParams.boxMin[Z];
-
-    int index = 0;
-    for (int j = 0; j < _textureSideSize; j++) {
-        coords[X] = _cacheParams.domainMin[X];
-
-        for (int i = 0; i < _textureSideSize; i++) {
-            varValue = grid->GetValue(coords);
-            missingValue = grid->GetMissingValue();
-            if (varValue == missingValue)
-                dataValues[index + 1] = 1.f;
-            else
-                dataValues[index + 1] = 0.f;
-
-            dataValues[index] = varValue;
-
-            index += 2;
-            coords[X] += deltas[X];
-        }
-        coords[Y] += deltas[Y];
-    }
-}
 
-void SliceRenderer::_populateDataXZ(float *dataValues, Grid *grid) const
-{
-    std::vector<double> deltas = _calculateDeltas();
-    float               varValue, missingValue;
-    std::vector<double> coords(3, 0.0);
-    coords[X] = _cacheParams.domainMin[X];
-    coords[Y] = _cacheParams.boxMin[Y];
-    coords[Z] = _cacheParams.domainMin[Z];
-
-    int index = 0;
-    for (int j = 0; j < _textureSideSize; j++) {
-        coords[X] = _cacheParams.domainMin[X];
-
-        for (int i = 0; i < _textureSideSize; i++) {
-            varValue = grid->GetValue(coords);
-            missingValue = grid->GetMissingValue();
-            if (varValue == missingValue)
-                dataValues[index + 1] = 1.f;
-            else
-                dataValues[index + 1] = 0.f;
-
-            dataValues[index] = varValue;
-
-            index += 2;
-            coords[X] += deltas[X];
-        }
-        coords[Z] += deltas[Z];
-    }
-}
-
-void SliceRenderer::_populateDataYZ(float *dataValues, Grid *grid) const
-{
-    std::vector<double> deltas = _calculateDeltas();
-    float               varValue, missingValue;
-    std::vector<double> coords(3, 0.0);
-    coords[X] = _cacheParams.boxMin[X];
-    coords[Y] = _cacheParams.domainMin[Y];
-    coords[Z] = _cacheParams.domainMin[Z];
-
-    int index = 0;
-    for (int j = 0; j < _textureSideSize; j++) {
-        coords[Y] = _cacheParams.domainMin[Y];
-
-        for (int i = 0; i < _textureSideSize; i++) {
-            varValue = grid->GetValue(coords);
-            missingValue = grid->GetMissingValue();
-            if (varValue == missingValue)
-                dataValues[index + 1] = 1.f;
-            else
-                dataValues[index + 1] = 0.f;
-
-            dataValues[index] = varValue;
-
-            index += 2;
-            coords[Y] += deltas[Y];
-        }
-        coords[Z] += deltas[Z];
-    }
+    origin = _cacheParams.domainMin;
+    du.assign(3, 0.0);
+    dv.assign(3, 0.0);
+
+    if (_cacheParams.orientation == XY) {
+        origin[Y] += deltas[Y] / 2.f;
+        origin[Z] = _cacheParams.boxMin[Z];
+        du[X] = deltas[X];
+        dv[Y] = deltas[Y];
+    } else if (_cacheParams.orientation == XZ) {
+        origin[Y] = _cacheParams.boxMin[Y];
+        du[X] = deltas[X];
+        dv[Z] = deltas[Z];
+    } else if (_cacheParams.orientation == YZ) {
+        origin[X] = _cacheParams.boxMin[X];
+        du[Y] = deltas[Y];
+        dv[Z] = deltas[Z];
+    } else
+        VAssert(0);
 }
 
 int SliceRenderer::_saveTextureData()
@@ -336,17 +271,29 @@ int SliceRenderer::_saveTextureData()
 
     _setVertexPositions();
 
-    int    textureSize = 2 * _textureSideSize * _textureSideSize;
-    float *dataValues = new float[textureSize];
+    std::vector<double> origin, du, dv;
+    _getSamplePlane(origin, du, dv);
+    _resampler.SetPlane(origin, du, dv, _textureSideSize, _textureSideSize);
 
-    if (_cacheParams.orientation == XY)
-        _populateDataXY(dataValues, grid);
-    else if (_cacheParams.orientation == XZ)
-        _populateDataXZ(dataValues, grid);
-    else if (_cacheParams.orientation == YZ)
-        _populateDataYZ(dataValues, grid);
-    else
-        VAssert(0);
+    // The resampler caches the location of each texel in the grid, so
+    // changing only the variable or time step does not repeat the search
+    //
+    size_t             numTexels = _textureSideSize * _textureSideSize;
+    std::vector<float> varValues(numTexels);
+    rc = _resampler.Resample(grid, varValues.data());
+    if (rc < 0) {
+        _dataMgr->UnlockGrid(grid);
+        delete grid;
+        SetErrMsg("Unable to resample Grid for Slice texture");
+        return (rc);
+    }
+
+    float  missingValue = grid->GetMissingValue();
+    float *dataValues = new float[2 * numTexels];
+    for (size_t i = 0; i < numTexels; i++) {
+        dataValues[2 * i] = varValues[i];
+        dataValues[2 * i + 1] = varValues[i] == missingValue ? 1.f : 0.f;
+    }
 
     _createDataTexture(dataValues);
 
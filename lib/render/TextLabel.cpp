@@ -2,7 +2,6 @@
 #include "vapor/TextLabel.h"
 #include "vapor/GLManager.h"
 #include <vapor/FontManager.h>
-#include "vapor/LegacyGL.h"
 
 using namespace VAPoR;
 using glm::vec2;
@@ -21,7 +20,6 @@ void TextLabel::DrawText(const glm::vec3 &position, const std::string &text)
 {
     Font *         font = _glManager->fontManager->GetFont(FontName, FontSize);
     MatrixManager *mm = _glManager->matrixManager;
-    LegacyGL *     lgl = _glManager->legacy;
     glm::vec2      p = mm->ProjectToScreen(position);
 
     GLint viewport[4] = {0};
@@ -61,15 +59,8 @@ void TextLabel::DrawText(const glm::vec3 &position, const std::string &text)
 
     mm->Translate((int)x, (int)y, -z);
 
-    if (BackgroundColor.a > 0) {
-        lgl->Color(BackgroundColor);
-        lgl->Begin(LGL_QUADS);
-        lgl->Vertex2f(-Padding, -Padding);
-        lgl->Vertex2f(textDimensions.x + Padding, -Padding);
-        lgl->Vertex2f(textDimensions.x + Padding, textDimensions.y + Padding);
-        lgl->Vertex2f(-Padding, textDimensions.y + Padding);
-        lgl->End();
-    }
+    // Queued with the text so that, in a batch, labels stay in order
+    if (BackgroundColor.a > 0) font->QueueRectangle(vec2(-Padding), textDimensions + vec2(Padding), BackgroundColor);
 
     font->DrawText(text, ForegroundColor);
 
@@ -71,38 +71,6 @@ string getEffectInstance(bool useVertAttr)
         return (EffectName);
 }
 
-// Compute surface normal (gradient) for point (x,y) using 1st order
-// central differences. 'hgtGrid' is a displacement map for Z coordinate.
-//
-void computeNormal(const Grid *hgtGrid, float x, float y, float dx, float dy, float mv, float &nx, float &ny, float &nz)
-{
-    nx = ny = 0.0;
-    nz = 1.0;
-    if (!hgtGrid) return;
-
-    // Missing value?
-    //
-    if ((hgtGrid->GetValue(x, y)) == mv) return;
-
-    float z_xpdx = hgtGrid->GetValue(x + dx, y);
-    if (z_xpdx == mv) { z_xpdx = x; }
-
-    float z_xmdx = hgtGrid->GetValue(x - dx, y);
-    if (z_xmdx == mv) { z_xmdx = x; }
-
-    float z_ypdy = hgtGrid->GetValue(x, y + dy);
-    if (z_ypdy == mv) { z_ypdy = y; }
-
-    float z_ymdy = hgtGrid->GetValue(x, y - dy);
-    if (z_ymdy == mv) { z_ymdy = x; }
-
-    float dzx = z_xpdx - z_xmdx;
-    float dzy = z_ypdy - z_ymdy;
-
-    nx = dy * dzx;
-    ny = dx * dzy;
-    nz = 1.0;
-}
 }    // namespace
 
 TwoDDataRenderer::TwoDDataRenderer(const ParamsMgr *pm, string winName, string dataSetName, string instName, DataMgr *dataMgr)
@@ -234,9 +202,10 @@ int TwoDDataRenderer::GetMesh(DataMgr *dataMgr, GLfloat **verts, GLfloat **norma
     nindices = 0;
     nverts = 0;
 
-    // See if already in cache
+    // See if already in cache. The texture, fetched first, must have been
+    // built from a grid of the same size.
     //
-    if (!_gridStateDirty() && _sb_verts.GetBuf()) {
+    if (!_gridStateDirty() && _sb_verts.GetBuf() && _meshGridDims == _texGridDims) {
         width = _vertsWidth;
         height = _vertsHeight;
         *verts = (GLfloat *)_sb_verts.GetBuf();
@@ -283,6 +252,7 @@ int TwoDDataRenderer::GetMesh(DataMgr *dataMgr, GLfloat **verts, GLfloat **norma
         structuredMesh = false;
     }
 
+    _meshGridDims = g->GetDimensions();
     delete g;
 
     if (rc < 0) return (-1);
@@ -301,7 +271,7 @@ int TwoDDataRenderer::GetMesh(DataMgr *dataMgr, GLfloat **verts, GLfloat **norma
     return (0);
 }
 
-bool TwoDDataRenderer::_gridStateDirty() const
+TwoDDataRenderer::_grid_state_c TwoDDataRenderer::_getGridState() const
 {
     TwoDDataParams *rParams = (TwoDDataParams *)GetActiveParams();
 
@@ -311,28 +281,18 @@ bool TwoDDataRenderer::_gridStateDirty() const
     vector<double> minExts, maxExts;
     rParams->GetBox()->GetExtents(minExts, maxExts);
 
-    _grid_state_c current_state(_dataMgr->GetNumRefLevels(rParams->GetVariableName()), rParams->GetRefinementLevel(), rParams->GetCompressionLevel(), rParams->GetHeightVariableName(),
-                                dvar.GetMeshName(), rParams->GetCurrentTimestep(), minExts, maxExts);
+    size_t ts = rParams->GetCurrentTimestep();
+    size_t meshTS = GetMeshTimeStep(_dataMgr, ts, rParams->GetVariableName(), rParams->GetHeightVariableName());
 
-    return (_grid_state != current_state);
+    return (_grid_state_c(_dataMgr->GetNumRefLevels(rParams->GetVariableName()), rParams->GetRefinementLevel(), rParams->GetCompressionLevel(), rParams->GetHeightVariableName(),
+                          dvar.GetMeshName(), meshTS, GetDefaultZ(_dataMgr, ts), minExts, maxExts, rParams->GetMaxMeshDim()));
 }
 
-void TwoDDataRenderer::_gridStateClear() { _grid_state.clear(); }
-
-void TwoDDataRenderer::_gridStateSet()
-{
-    TwoDDataParams *rParams = (TwoDDataParams *)GetActiveParams();
-
-    DC::DataVar dvar;
-    _dataMgr->GetDataVarInfo(rParams->GetVariableName(), dvar);
+bool TwoDDataRenderer::_gridStateDirty() const { return (_grid_state != _getGridState()); }
 
-    vector<double> minExts, maxExts;
-    rParams->GetBox()->GetExtents(minExts, maxExts);
-    string meshName;
+void TwoDDataRenderer::_gridStateClear() { _grid_state.clear(); }
 
-    _grid_state = _grid_state_c(_dataMgr->GetNumRefLevels(rParams->GetVariableName()), rParams->GetRefinementLevel(), rParams->GetCompressionLevel(), rParams->GetHeightVariableName(),
-                                dvar.GetMeshName(), rParams->GetCurrentTimestep(), minExts, maxExts);
-}
+void TwoDDataRenderer::_gridStateSet() { _grid_state = _getGridState(); }
 
 bool TwoDDataRenderer::_texStateDirty(DataMgr *dataMgr) const
 {
@@ -341,7 +301,8 @@ bool TwoDDataRenderer::_texStateDirty(DataMgr *dataMgr) const
     vector<double> minExts, maxExts;
     rParams->GetBox()->GetExtents(minExts, maxExts);
 
-    _tex_state_c current_state(rParams->GetRefinementLevel(), rParams->GetCompressionLevel(), rParams->GetVariableName(), rParams->GetCurrentTimestep(), minExts, maxExts);
+    _tex_state_c current_state(rParams->GetRefinementLevel(), rParams->GetCompressionLevel(), rParams->GetVariableName(), rParams->GetCurrentTimestep(), minExts, maxExts,
+                               rParams->GetMaxMeshDim());
 
     return (_tex_state != current_state);
 }
@@ -353,12 +314,37 @@ void TwoDDataRenderer::_texStateSet(DataMgr *dataMgr)
     vector<double> minExts, maxExts;
     rParams->GetBox()->GetExtents(minExts, maxExts);
 
-    _tex_state = _tex_state_c(rParams->GetRefinementLevel(), rParams->GetCompressionLevel(), rParams->GetVariableName(), rParams->GetCurrentTimestep(), minExts, maxExts);
+    _tex_state = _tex_state_c(rParams->GetRefinementLevel(), rParams->GetCompressionLevel(), rParams->GetVariableName(), rParams->GetCurrentTimestep(), minExts, maxExts,
+                              rParams->GetMaxMeshDim());
 }
 
 void TwoDDataRenderer::_texStateClear() { _tex_state.clear(); }
 
-// Get mesh for a structured grid
+// Get the height variable, if one is specified, for the given extents.
+// Returns NULL if no height variable is specified or on error.
+//
+Grid *TwoDDataRenderer::_getHeightGrid(DataMgr *dataMgr, const vector<double> &minExts, const vector<double> &maxExts)
+{
+    TwoDDataParams *rParams = (TwoDDataParams *)GetActiveParams();
+
+    string hgtvar = rParams->GetHeightVariableName();
+    if (hgtvar.empty()) return (NULL);
+
+    size_t ts = rParams->GetCurrentTimestep();
+    int    refLevel = rParams->GetRefinementLevel();
+    int    lod = rParams->GetCompressionLevel();
+
+    // Try to get requested refinement level or the nearest acceptable level:
+    //
+    Grid *hgtGrid = NULL;
+    int   rc = DataMgrUtils::GetGrids(dataMgr, ts, hgtvar, minExts, maxExts, true, &refLevel, &lod, &hgtGrid);
+    if (rc < 0) return (NULL);
+    VAssert(hgtGrid);
+
+    return (hgtGrid);
+}
+
+// Get mesh for a structured grid, optionally displaced by a height field
 //
 int TwoDDataRenderer::_getMeshStructured(DataMgr *dataMgr, const StructuredGrid *g, double defaultZ)
 {
@@ -367,8 +353,14 @@ int TwoDDataRenderer::_getMeshStructured(DataMgr *dataMgr, const StructuredGrid
     vector<size_t> dims = g->GetDimensions();
     VAssert(dims.size() == 2);
 
-    _vertsWidth = dims[0];
-    _vertsHeight = dims[1];
+    // Very large grids are decimated
+    //
+    vector<size_t> iIndices, jIndices;
+    GetDecimatedIndices(dims[0], rParams->GetMaxMeshDim(), iIndices);
+    GetDecimatedIndices(dims[1], rParams->GetMaxMeshDim(), jIndices);
+
+    _vertsWidth = iIndices.size();
+    _vertsHeight = jIndices.size();
     _nindices = _vertsWidth * 2;
 
     // (Re)allocate space for verts
@@ -378,17 +370,24 @@ int TwoDDataRenderer::_getMeshStructured(DataMgr *dataMgr, const StructuredGrid
     _sb_normals.Alloc(_nverts * 3 * sizeof(GLfloat));
     _sb_indices.Alloc(2 * _vertsWidth * sizeof(GLuint));
 
-    int rc;
+    Grid *hgtGrid = NULL;
     if (!rParams->GetHeightVariableName().empty()) {
-        rc = _getMeshStructuredDisplaced(dataMgr, g, defaultZ);
-    } else {
-        rc = _getMeshStructuredPlane(dataMgr, g, defaultZ);
+        // Find box extents for ROI
+        //
+        vector<double> minExtsReq, maxExtsReq;
+        rParams->GetBox()->GetExtents(minExtsReq, maxExtsReq);
+
+        hgtGrid = _getHeightGrid(dataMgr, minExtsReq, maxExtsReq);
+        if (!hgtGrid) return (-1);
     }
-    if (rc < 0) return (rc);
+
+    GLfloat *verts = (GLfloat *)_sb_verts.GetBuf();
+    ComputeStructuredVertices(g, hgtGrid, defaultZ, iIndices, jIndices, verts);
+
+    if (hgtGrid) delete hgtGrid;
 
     // Compute vertex normals
     //
-    GLfloat *verts = (GLfloat *)_sb_verts.GetBuf();
     GLfloat *normals = (GLfloat *)_sb_normals.GetBuf();
     ComputeNormals(verts, _vertsWidth, _vertsHeight, normals);
 
@@ -443,76 +442,50 @@ int TwoDDataRenderer::_getMeshUnStructured(DataMgr *dataMgr, const Grid *g, doub
 int TwoDDataRenderer::_getMeshUnStructuredHelper(DataMgr *dataMgr, const Grid *g, double defaultZ)
 {
     TwoDDataParams *rParams = (TwoDDataParams *)GetActiveParams();
-    // Construct the displaced (terrain following) grid using
-    // a map projection, if specified.
-    //
-    size_t ts = rParams->GetCurrentTimestep();
-    int    refLevel = rParams->GetRefinementLevel();
-    int    lod = rParams->GetCompressionLevel();
 
     // Find box extents for ROI
     //
     vector<double> minExts, maxExts;
     g->GetUserExtents(minExts, maxExts);
 
-    // Try to get requested refinement level or the nearest acceptable level:
+    // Construct the displaced (terrain following) grid using
+    // a map projection, if specified.
     //
-    string hgtvar = rParams->GetHeightVariableName();
-
     Grid *hgtGrid = NULL;
-
-    if (!hgtvar.empty()) {
-        int rc = DataMgrUtils::GetGrids(dataMgr, ts, hgtvar, minExts, maxExts, true, &refLevel, &lod, &hgtGrid);
-
-        if (rc < 0) return (rc);
-        VAssert(hgtGrid);
+    if (!rParams->GetHeightVariableName().empty()) {
+        hgtGrid = _getHeightGrid(dataMgr, minExts, maxExts);
+        if (!hgtGrid) return (-1);
     }
 
     VAssert(g->GetTopologyDim() == 2);
-    vector<size_t> dims = g->GetDimensions();
 
     GLfloat *verts = (GLfloat *)_sb_verts.GetBuf();
     GLfloat *normals = (GLfloat *)_sb_normals.GetBuf();
     GLuint * indices = (GLuint *)_sb_indices.GetBuf();
 
-    double mv = hgtGrid ? hgtGrid->GetMissingValue() : 0.0;
-
-    // Hard-code dx and dy for gradient calculation :-(
-    //
-    float dx = (maxExts[0] - minExts[0]) / 1000.0;
-    float dy = (maxExts[1] - minExts[1]) / 1000.0;
-
     //
     // Visit each node in the grid, build a list of vertices
     //
     Grid::ConstNodeIterator nitr;
     Grid::ConstNodeIterator endnitr = g->ConstNodeEnd();
     size_t                  voffset = 0;
+    vector<double>          coords;
     for (nitr = g->ConstNodeBegin(); nitr != endnitr; ++nitr) {
-        vector<double> coords;
-
         g->GetUserCoordinates(*nitr, coords);
 
-        // Lookup vertical coordinate displacement as a data element
-        // from the
-        // height variable. Note, missing values are possible if image
-        // extents are out side of extents for height variable, or if
-        // height variable itself contains missing values.
-        //
-        double deltaZ = hgtGrid ? hgtGrid->GetValue(coords) : 0.0;
-        if (deltaZ == mv) deltaZ = 0.0;
-
         verts[voffset + 0] = coords[0];
         verts[voffset + 1] = coords[1];
-        verts[voffset + 2] = deltaZ + defaultZ;
-
-        // Compute the surface normal using central differences
-        //
-        computeNormal(hgtGrid, coords[0], coords[1], dx, dy, mv, normals[voffset + 0], normals[voffset + 1], normals[voffset + 2]);
-
         voffset += 3;
     }
 
+    // Displace vertices by the height field and compute the surface
+    // normals using central differences. Hard-code dx and dy for
+    // gradient calculation :-(
+    //
+    float dx = (maxExts[0] - minExts[0]) / 1000.0;
+    float dy = (maxExts[1] - minExts[1]) / 1000.0;
+    DisplaceVertices(hgtGrid, defaultZ, verts, voffset / 3, normals, dx, dy);
+
     //
     // Visit each cell in the grid. For each cell triangulate it and
     // and compute an index
@@ -546,94 +519,6 @@ int TwoDDataRenderer::_getMeshUnStructuredHelper(DataMgr *dataMgr, const Grid *g
     return (0);
 }
 
-// Get mesh for a structured grid displaced by a height field
-//
-int TwoDDataRenderer::_getMeshStructuredDisplaced(DataMgr *dataMgr, const StructuredGrid *g, double defaultZ)
-{
-    TwoDDataParams *rParams = (TwoDDataParams *)GetActiveParams();
-    // Construct the displaced (terrain following) grid using
-    // a map projection, if specified.
-    //
-    size_t ts = rParams->GetCurrentTimestep();
-    int    refLevel = rParams->GetRefinementLevel();
-    int    lod = rParams->GetCompressionLevel();
-
-    // Find box extents for ROI
-    //
-    vector<double> minExtsReq, maxExtsReq;
-    rParams->GetBox()->GetExtents(minExtsReq, maxExtsReq);
-
-    // Try to get requested refinement level or the nearest acceptable level:
-    //
-    string hgtvar = rParams->GetHeightVariableName();
-    VAssert(!hgtvar.empty());
-
-    Grid *hgtGrid = NULL;
-    int   rc = DataMgrUtils::GetGrids(dataMgr, ts, hgtvar, minExtsReq, maxExtsReq, true, &refLevel, &lod, &hgtGrid);
-    if (rc < 0) return (rc);
-    VAssert(hgtGrid);
-
-    vector<size_t> dims = g->GetDimensions();
-    VAssert(dims.size() == 2);
-
-    size_t   width = dims[0];
-    size_t   height = dims[1];
-    GLfloat *verts = (GLfloat *)_sb_verts.GetBuf();
-    double   mv = hgtGrid->GetMissingValue();
-    for (int j = 0; j < height; j++) {
-        for (int i = 0; i < width; i++) {
-            double x, y, zdummy;
-            g->GetUserCoordinates(i, j, x, y, zdummy);
-
-            // Lookup vertical coordinate displacement as a data element from the
-            // height variable. Note, missing values are possible if image
-            // extents are out side of extents for height variable, or if
-            // height variable itself contains missing values.
-            //
-            double deltaZ = hgtGrid->GetValue(x, y, 0.0);
-            if (deltaZ == mv) deltaZ = 0.0;
-
-            double z = deltaZ + defaultZ;
-
-            //
-            verts[j * width * 3 + i * 3] = x;
-            verts[j * width * 3 + i * 3 + 1] = y;
-            verts[j * width * 3 + i * 3 + 2] = z;
-        }
-    }
-
-    delete hgtGrid;
-
-    return (rc);
-}
-
-// Get mesh for a structured grid that is NOT displaced by a height field.
-// I.e. it's planar.
-//
-int TwoDDataRenderer::_getMeshStructuredPlane(DataMgr *dataMgr, const StructuredGrid *g, double defaultZ)
-{
-    vector<size_t> dims = g->GetDimensions();
-    VAssert(dims.size() == 2);
-
-    size_t   width = dims[0];
-    size_t   height = dims[1];
-    GLfloat *verts = (GLfloat *)_sb_verts.GetBuf();
-    for (int j = 0; j < height; j++) {
-        for (int i = 0; i < width; i++) {
-            double x, y, zdummy;
-            g->GetUserCoordinates(i, j, x, y, zdummy);
-
-            double z = defaultZ;
-
-            verts[j * width * 3 + i * 3] = x;
-            verts[j * width * 3 + i * 3 + 1] = y;
-            verts[j * width * 3 + i * 3 + 2] = z;
-        }
-    }
-
-    return (0);
-}
-
 int TwoDDataRenderer::_getOrientation(DataMgr *dataMgr, string varname)
 {
     vector<string> coordvars;
@@ -692,40 +577,69 @@ const GLvoid *TwoDDataRenderer::_getTexture(DataMgr *dataMgr)
 
     if (g->GetTopologyDim() != 2) {
         SetErrMsg("Invalid variable: %s ", varname.c_str());
+        delete g;
         return (NULL);
     }
 
-    // For structured grid variable data are stored in a 2D array.
-    // For structured grid variable data are stored in a 1D array.
+    // For structured grid variable data are stored in a 2D array, decimated
+    // in the same way as the mesh. For unstructured grids variable data are
+    // stored in a 1D array.
     //
     vector<size_t> dims = g->GetDimensions();
+    _texGridDims = dims;
+    float mv = g->GetMissingValue();
+
     if (dynamic_cast<StructuredGrid *>(g) && !ForceUnstructured) {
-        _texWidth = dims[0];
-        _texHeight = dims[1];
+        vector<size_t> iIndices, jIndices;
+        GetDecimatedIndices(dims[0], rParams->GetMaxMeshDim(), iIndices);
+        GetDecimatedIndices(dims[1], rParams->GetMaxMeshDim(), jIndices);
+        _texWidth = iIndices.size();
+        _texHeight = jIndices.size();
+
+        GLfloat *texture = (float *)_sb_texture.Alloc(_texWidth * _texHeight * _texelSize);
+        if (_texWidth == dims[0] && _texHeight == dims[1]) {
+            g->ParallelForEach([&](int, const Grid::Span &span) {
+                GLfloat *texptr = texture + 2 * (span.index[0] + _texWidth * span.index[1]);
+                for (size_t i = 0; i < span.n; i++) {
+                    float v = span.data[i];
+                    bool  missing = v == mv;
+                    texptr[2 * i] = missing ? 0.0 : v;          // Data value
+                    texptr[2 * i + 1] = missing ? 1.0 : 0.0;    // Missing value flag
+                }
+            });
+        } else {
+            GLfloat *texptr = texture;
+            for (size_t j = 0; j < jIndices.size(); j++) {
+                for (size_t i = 0; i < iIndices.size(); i++) {
+                    float v = g->AccessIJK(iIndices[i], jIndices[j], 0);
+                    *texptr++ = v == mv ? 0.0 : v;
+                    *texptr++ = v == mv ? 1.0 : 0.0;
+                }
+            }
+        }
     } else {
         _texWidth = std::accumulate(dims.begin(), dims.end(), 1, std::multiplies<size_t>());
         _texHeight = 1;
-    }
 
-    size_t         texSize = _texWidth * _texHeight;
-    GLfloat *      texture = (float *)_sb_texture.Alloc(texSize * _texelSize);
-    GLfloat *      texptr = texture;
-    Grid::Iterator itr;
-    Grid::Iterator enditr = g->end();
-    //	for (itr = g->begin(minBoxReq, maxBoxReq); itr != enditr; ++itr) {
-    for (itr = g->begin(); itr != enditr; ++itr) {
-        float v = *itr;
-
-        if (v == g->GetMissingValue()) {
-            *texptr++ = 0.0;    // Data value
-            *texptr++ = 1.0;    // Missing value flag
-        } else {
-            *texptr++ = v;
-            *texptr++ = 0;
+        GLfloat *      texture = (float *)_sb_texture.Alloc(_texWidth * _texHeight * _texelSize);
+        GLfloat *      texptr = texture;
+        Grid::Iterator itr;
+        Grid::Iterator enditr = g->end();
+        for (itr = g->begin(); itr != enditr; ++itr) {
+            float v = *itr;
+
+            if (v == mv) {
+                *texptr++ = 0.0;    // Data value
+                *texptr++ = 1.0;    // Missing value flag
+            } else {
+                *texptr++ = v;
+                *texptr++ = 0;
+            }
         }
     }
+    delete g;
 
     _texStateSet(dataMgr);
 
-    return (texture);
+    return ((const GLvoid *)_sb_texture.GetBuf());
 }
@@ -9,15 +9,57 @@
 #include <vapor/glutil.h>    // Must be included first!!!
 #include <cstdlib>
 #include <cstdio>
+#include <algorithm>
 
 #include <vapor/ViewpointParams.h>
 #include <vapor/MyBase.h>
+#include <vapor/TaskScheduler.h>
 #include <vapor/TwoDRenderer.h>
+#include <vapor/Trace.h>
 #include "vapor/GLManager.h"
 
 using namespace VAPoR;
 using namespace Wasp;
 
+namespace {
+
+// Compute surface normal (gradient) for point (x,y) using 1st order
+// central differences. 'hgtGrid' is a displacement map for Z coordinate.
+// Missing neighbors are replaced by the value at (x,y).
+//
+void computeNormal(const Grid *hgtGrid, float x, float y, float dx, float dy, float mv, float &nx, float &ny, float &nz)
+{
+    nx = ny = 0.0;
+    nz = 1.0;
+    if (!hgtGrid) return;
+
+    // Missing value?
+    //
+    float z = hgtGrid->GetValue(x, y);
+    if (z == mv) return;
+
+    float z_xpdx = hgtGrid->GetValue(x + dx, y);
+    if (z_xpdx == mv) { z_xpdx = z; }
+
+    float z_xmdx = hgtGrid->GetValue(x - dx, y);
+    if (z_xmdx == mv) { z_xmdx = z; }
+
+    float z_ypdy = hgtGrid->GetValue(x, y + dy);
+    if (z_ypdy == mv) { z_ypdy = z; }
+
+    float z_ymdy = hgtGrid->GetValue(x, y - dy);
+    if (z_ymdy == mv) { z_ymdy = z; }
+
+    float dzx = z_xpdx - z_xmdx;
+    float dzy = z_ypdy - z_ymdy;
+
+    nx = dy * dzx;
+    ny = dx * dzy;
+    nz = 1.0;
+}
+
+};    // namespace
+
 //----------------------------------------------------------------------------
 //
 //----------------------------------------------------------------------------
@@ -123,6 +165,9 @@ void TwoDRenderer::_openGLInit()
         glBindTexture(GL_TEXTURE_2D, _textureID);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+        Wasp::TraceSpan span("TwoDRenderer texture upload", "gl");
+        Wasp::Trace::Count("GL upload bytes", (double)_texWidth * _texHeight * _texelSize);
         glTexImage2D(GL_TEXTURE_2D, 0, _texInternalFormat, _texWidth, _texHeight, 0, _texFormat, _texType, _texture);
     }
 
@@ -243,41 +288,126 @@ void TwoDRenderer::ComputeNormals(const GLfloat *verts, GLsizei w, GLsizei h, GL
     // Go over the grid of vertices, calculating normals
     // by looking at adjacent x,y,z coords.
     //
-    for (int j = 0; j < h; j++) {
-        for (int i = 0; i < w; i++) {
-            const GLfloat *point = verts + 3 * (i + w * j);
-            GLfloat *      norm = normals + 3 * (i + w * j);
-            // do differences of right point vs left point,
-            // except at edges of grid just do differences
-            // between current point and adjacent point:
-            float dx = 0.f, dy = 0.f, dzx = 0.f, dzy = 0.f;
-            if (i > 0 && i < w - 1) {
-                dx = *(point + 3) - *(point - 3);
-                dzx = *(point + 5) - *(point - 1);
-            } else if (i == 0) {
-                dx = *(point + 3) - *(point);
-                dzx = *(point + 5) - *(point + 2);
-            } else if (i == w - 1) {
-                dx = *(point) - *(point - 3);
-                dzx = *(point + 2) - *(point - 1);
+    Wasp::ParallelFor(0, h, 8, [verts, w, h, normals](size_t n0, size_t n1) {
+        for (int j = n0; j < n1; j++) {
+            for (int i = 0; i < w; i++) {
+                const GLfloat *point = verts + 3 * (i + w * j);
+                GLfloat *      norm = normals + 3 * (i + w * j);
+                // do differences of right point vs left point,
+                // except at edges of grid just do differences
+                // between current point and adjacent point:
+                float dx = 0.f, dy = 0.f, dzx = 0.f, dzy = 0.f;
+                if (i > 0 && i < w - 1) {
+                    dx = *(point + 3) - *(point - 3);
+                    dzx = *(point + 5) - *(point - 1);
+                } else if (i == 0) {
+                    dx = *(point + 3) - *(point);
+                    dzx = *(point + 5) - *(point + 2);
+                } else if (i == w - 1) {
+                    dx = *(point) - *(point - 3);
+                    dzx = *(point + 2) - *(point - 1);
+                }
+                if (j > 0 && j < h - 1) {
+                    dy = *(point + 1 + 3 * w) - *(point + 1 - 3 * w);
+                    dzy = *(point + 2 + 3 * w) - *(point + 2 - 3 * w);
+                } else if (j == 0) {
+                    dy = *(point + 1 + 3 * w) - *(point + 1);
+                    dzy = *(point + 2 + 3 * w) - *(point + 2);
+                } else if (j == h - 1) {
+                    dy = *(point + 1) - *(point + 1 - 3 * w);
+                    dzy = *(point + 2) - *(point + 2 - 3 * w);
+                }
+                norm[0] = dy * dzx;
+                norm[1] = dx * dzy;
+                norm[2] = 1.0;
+            }
+        }
+    });
+}
+
+void TwoDRenderer::DisplaceVertices(const Grid *hgtGrid, double defaultZ, GLfloat *verts, size_t nverts, GLfloat *normals, float dx, float dy) const
+{
+    // Populate the grid's lazily computed extents before it is shared
+    // between threads
+    //
+    if (hgtGrid) {
+        DblArr3 minu, maxu;
+        hgtGrid->GetUserExtents(minu, maxu);
+    }
+
+    float mv = hgtGrid ? hgtGrid->GetMissingValue() : 0.0;
+
+    Wasp::ParallelFor(0, nverts, 1024, [hgtGrid, defaultZ, verts, normals, dx, dy, mv](size_t n0, size_t n1) {
+        for (size_t v = n0; v < n1; v++) {
+            GLfloat *vert = verts + 3 * v;
+
+            // Lookup vertical coordinate displacement as a data element from the
+            // height variable. Note, missing values are possible if mesh
+            // extents are out side of extents for height variable, or if
+            // height variable itself contains missing values.
+            //
+            float deltaZ = 0.0;
+            if (hgtGrid) {
+                deltaZ = hgtGrid->GetValue(vert[0], vert[1], 0.0);
+                if (deltaZ == mv) deltaZ = 0.0;
             }
-            if (j > 0 && j < h - 1) {
-                dy = *(point + 1 + 3 * w) - *(point + 1 - 3 * w);
-                dzy = *(point + 2 + 3 * w) - *(point + 2 - 3 * w);
-            } else if (j == 0) {
-                dy = *(point + 1 + 3 * w) - *(point + 1);
-                dzy = *(point + 2 + 3 * w) - *(point + 2);
-            } else if (j == h - 1) {
-                dy = *(point + 1) - *(point + 1 - 3 * w);
-                dzy = *(point + 2) - *(point + 2 - 3 * w);
+            vert[2] = deltaZ + defaultZ;
+
+            if (normals) {
+                GLfloat *norm = normals + 3 * v;
+                computeNormal(hgtGrid, vert[0], vert[1], dx, dy, mv, norm[0], norm[1], norm[2]);
             }
-            norm[0] = dy * dzx;
-            norm[1] = dx * dzy;
-            norm[2] = 1.0;
+        }
+    });
+}
 
-            // vnormal(norm);
+void TwoDRenderer::ComputeStructuredVertices(const StructuredGrid *g, const Grid *hgtGrid, double defaultZ, const std::vector<size_t> &iIndices, const std::vector<size_t> &jIndices,
+                                             GLfloat *verts) const
+{
+    size_t width = iIndices.size();
+
+    Wasp::ParallelFor(0, jIndices.size(), 8, [&](size_t n0, size_t n1) {
+        for (size_t j = n0; j < n1; j++) {
+            GLfloat *row = verts + 3 * j * width;
+            for (size_t i = 0; i < width; i++) {
+                double x, y, zdummy;
+                g->GetUserCoordinates(iIndices[i], jIndices[j], x, y, zdummy);
+                row[3 * i] = x;
+                row[3 * i + 1] = y;
+            }
         }
+    });
+
+    DisplaceVertices(hgtGrid, defaultZ, verts, iIndices.size() * jIndices.size());
+}
+
+void TwoDRenderer::GetDecimatedIndices(size_t n, size_t maxn, std::vector<size_t> &indices)
+{
+    indices.clear();
+    if (maxn == 0 || n <= maxn) {
+        for (size_t i = 0; i < n; i++) indices.push_back(i);
+        return;
+    }
+
+    maxn = std::max(maxn, (size_t)2);
+    for (size_t i = 0; i < maxn; i++) indices.push_back(i * (n - 1) / (maxn - 1));
+}
+
+size_t TwoDRenderer::GetMeshTimeStep(const DataMgr *dataMgr, size_t ts, const string &meshVar, const string &hgtVar)
+{
+    vector<string> vars;
+    if (!meshVar.empty()) dataMgr->GetVarCoordVars(meshVar, true, vars);
+    if (!hgtVar.empty()) {
+        vars.push_back(hgtVar);
+        vector<string> hgtCoordVars;
+        dataMgr->GetVarCoordVars(hgtVar, true, hgtCoordVars);
+        vars.insert(vars.end(), hgtCoordVars.begin(), hgtCoordVars.end());
     }
+
+    for (const auto &v : vars) {
+        if (dataMgr->IsTimeVarying(v)) return (ts);
+    }
+    return (0);
 }
 
 void TwoDRenderer::_computeTexCoords(GLfloat *tcoords, size_t w, size_t h) const
@@ -61,6 +61,11 @@ Visualizer::Visualizer(const ParamsMgr *pm, const DataStatus *dataStatus, string
     _insideGLContext = false;
     _imageCaptureEnabled = false;
     _animationCaptureEnabled = false;
+    _capturePBO[0] = _capturePBO[1] = 0;
+    _capturePBOIndex = 0;
+    _pendingCapture[0].valid = _pendingCapture[1].valid = false;
+    _pendingCapture[0].writer = _pendingCapture[1].writer = nullptr;
+    _frameEncoder = nullptr;
 
     _renderers.clear();
     _renderersToDestroy.clear();
@@ -80,6 +85,12 @@ Visualizer::~Visualizer()
 
     if (_vizFeatures) delete _vizFeatures;
 
+    // Flush any frames of an animation capture still in flight
+    //
+    if (_animationCaptureEnabled) (void)_finishCapture();
+    if (_frameEncoder) delete _frameEncoder;
+    if (_capturePBO[0]) glDeleteBuffers(2, _capturePBO);
+
     if (_screenQuadVAO) glDeleteVertexArrays(1, &_screenQuadVAO);
     if (_screenQuadVBO) glDeleteBuffers(1, &_screenQuadVBO);
 }
@@ -233,8 +244,8 @@ int Visualizer::paintEvent(bool fast)
     if (_imageCaptureEnabled) {
         captureImageSuccess = _captureImage(_captureImageFile);
     } else if (_animationCaptureEnabled) {
-        captureImageSuccess = _captureImage(_captureImageFile);
-        _incrementPath(_captureImageFile);
+        captureImageSuccess = _captureAnimationFrame(_captureImageFile);
+        if (FileUtils::Extension(_captureImageFile) != "y4m") _incrementPath(_captureImageFile);
     }
     if (captureImageSuccess < 0) {
         SetErrMsg("Failed to save image");
@@ -391,6 +402,24 @@ void Visualizer::DestroyAllRenderers(bool hasOpenGLContext)
 
 bool Visualizer::HasRenderer(string renderType, string renderName) const { return (_getRenderer(renderType, renderName) != nullptr); }
 
+void Visualizer::GetRenderTimes(vector<string> &renderTypes, vector<string> &renderNames, vector<double> &paintTimes, vector<double> &fetchTimes) const
+{
+    renderTypes.clear();
+    renderNames.clear();
+    paintTimes.clear();
+    fetchTimes.clear();
+
+    for (int i = 0; i < _renderers.size(); i++) {
+        double paintTime, fetchTime;
+        _renderers[i]->GetLastPaintTime(paintTime, fetchTime);
+
+        renderTypes.push_back(_renderers[i]->GetMyType());
+        renderNames.push_back(_renderers[i]->GetMyName());
+        paintTimes.push_back(paintTime);
+        fetchTimes.push_back(fetchTime);
+    }
+}
+
 void Visualizer::ClearRenderCache()
 {
     for (int i = 0; i < _renderers.size(); i++) { _renderers[i]->ClearCache(); }
@@ -493,18 +522,125 @@ AnnotationParams *Visualizer::getActiveAnnotationParams() const { return _params
 
 #include <vapor/STLUtils.h>
 
+namespace {
+
+// Copy the region [cropMin, cropMax) of a packed RGB image to dst. Crop
+// coordinates have their origin at the top left. If flip is true the rows
+// of src are stored bottom row first, as returned by glReadPixels.
+//
+void cropFrame(const unsigned char *src, int width, int height, bool flip, const int cropMin[2], const int cropMax[2], vector<unsigned char> &dst)
+{
+    int croppedWidth = cropMax[0] - cropMin[0];
+    int croppedHeight = cropMax[1] - cropMin[1];
+
+    dst.resize(3 * (size_t)croppedWidth * croppedHeight);
+    for (int y = 0; y < croppedHeight; y++) {
+        int row = cropMin[1] + y;
+        if (flip) row = height - 1 - row;
+        memcpy(&dst[3 * (size_t)y * croppedWidth], &src[3 * ((size_t)row * width + cropMin[0])], 3 * croppedWidth);
+    }
+}
+
+};    // namespace
+
+int Visualizer::_prepareCapture(std::string path, int width, int height, ImageWriter **writer, int cropMin[2], int cropMax[2])
+{
+    *writer = nullptr;
+    cropMin[0] = cropMin[1] = 0;
+    cropMax[0] = width;
+    cropMax[1] = height;
+
+    ViewpointParams *vpParams = getActiveViewpointParams();
+
+    if (FileUtils::Extension(path) == "") path += ".png";
+    bool geoTiffOutput = vpParams->GetProjectionType() == ViewpointParams::MapOrthographic && (FileUtils::Extension(path) == "tif" || FileUtils::Extension(path) == "tiff");
+
+    if (!geoTiffOutput) {
+        *writer = ImageWriter::CreateImageWriterForFile(path);
+        return (*writer == nullptr ? -1 : 0);
+    }
+
+    VAssert(_dataStatus->GetDataMgrNames().size());
+    string projString = _dataStatus->GetDataMgr(_dataStatus->GetDataMgrNames()[0])->GetMapProjection();
+
+    vector<double> dataMinExtents, dataMaxExtents;
+    _dataStatus->GetActiveExtents(_paramsMgr, _winName, _getCurrentTimestep(), dataMinExtents, dataMaxExtents);
+
+    double m[16];
+    vpParams->GetModelViewMatrix(m);
+    double posvec[3], upvec[3], dirvec[3];
+    vpParams->ReconstructCamera(m, posvec, upvec, dirvec);
+
+    float s = vpParams->GetOrthoProjectionSize();
+    float x = posvec[0];
+    float y = posvec[1];
+    float aspect = width / (float)height;
+
+    float pixelScale[2] = {s * aspect * 2 / (float)width, s * 2 / (float)height};
+
+    // Crop to data extents
+
+    double cameraMinExtents[2] = {x - s * aspect, y - s};
+    double cameraMaxExtents[2] = {x + s * aspect, y + s};
+
+    double newCameraMinExtents[2] = {cameraMinExtents[0], cameraMinExtents[1]};
+    for (int i = 0; i < 2; i++) {
+        if (cameraMinExtents[i] < dataMinExtents[i]) {
+            newCameraMinExtents[i] = dataMinExtents[i];
+            cropMin[i] = (dataMinExtents[i] - cameraMinExtents[i]) / pixelScale[i];
+        }
+    }
+
+    double newCameraMaxExtents[2] = {cameraMaxExtents[0], cameraMaxExtents[1]};
+    for (int i = 0; i < 2; i++) {
+        if (cameraMaxExtents[i] > dataMaxExtents[i]) {
+            newCameraMaxExtents[i] = dataMaxExtents[i];
+            cropMax[i] = cropMax[i] - (cameraMaxExtents[i] - dataMaxExtents[i]) / pixelScale[i];
+        }
+    }
+
+    int croppedWidth = cropMax[0] - cropMin[0];
+    int croppedHeight = cropMax[1] - cropMin[1];
+
+    if (croppedWidth <= 0 || croppedHeight <= 0) {
+        MyBase::SetErrMsg("Dataset not visible");
+        return -1;
+    }
+
+    // flip Y
+    int temp = cropMin[1];
+    cropMin[1] = height - cropMax[1];
+    cropMax[1] = height - temp;
+
+    s *= croppedHeight / (float)height;
+
+    x = (newCameraMaxExtents[0] - newCameraMinExtents[0]) / 2 + newCameraMinExtents[0];
+    y = (newCameraMaxExtents[1] - newCameraMinExtents[1]) / 2 + newCameraMinExtents[1];
+
+    aspect = croppedWidth / (float)croppedHeight;
+
+    GeoTIFWriter *geo = new GeoTIFWriter(path);
+    geo->SetTiePoint(x, y, croppedWidth / 2.f, croppedHeight / 2.f);
+    geo->SetPixelScale(s * aspect * 2 / (float)croppedWidth, s * 2 / (float)croppedHeight);
+    if (geo->ConfigureFromProj4(projString) < 0) {
+        delete geo;
+        return -1;
+    }
+
+    *writer = geo;
+    return 0;
+}
+
 int Visualizer::_captureImage(std::string path)
 {
     // Turn off the single capture flag
     _imageCaptureEnabled = false;
 
-    ViewpointParams *vpParams = getActiveViewpointParams();
-    int              width, height;
+    int width, height;
     //	vpParams->GetWindowSize(width, height);
     _framebuffer.GetSize(&width, &height);
 
     vector<unsigned char> framebuffer(3 * width * height);
-    int            writeReturn = -1;
     _getPixelData(framebuffer.data());
 
     if (STLUtils::BeginsWith(path, ":RAM:")) {
@@ -516,101 +652,148 @@ int Visualizer::_captureImage(std::string path)
         return 0;
     }
 
-    if (FileUtils::Extension(path) == "") path += ".png";
-    bool         geoTiffOutput = vpParams->GetProjectionType() == ViewpointParams::MapOrthographic && (FileUtils::Extension(path) == "tif" || FileUtils::Extension(path) == "tiff");
-    ImageWriter *writer = nullptr;
-
-    if (geoTiffOutput)
-        writer = new GeoTIFWriter(path);
-    else
-        writer = ImageWriter::CreateImageWriterForFile(path);
-    if (writer == nullptr) goto captureImageEnd;
+    ImageWriter *writer;
+    int          cropMin[2], cropMax[2];
+    if (_prepareCapture(path, width, height, &writer, cropMin, cropMax) < 0) return -1;
 
-    if (geoTiffOutput) {
-        VAssert(_dataStatus->GetDataMgrNames().size());
-        string projString = _dataStatus->GetDataMgr(_dataStatus->GetDataMgrNames()[0])->GetMapProjection();
+    if (cropMin[0] != 0 || cropMin[1] != 0 || cropMax[0] != width || cropMax[1] != height) {
+        vector<unsigned char> croppedFB;
+        cropFrame(framebuffer.data(), width, height, false, cropMin, cropMax, croppedFB);
+        framebuffer.swap(croppedFB);
+        width = cropMax[0] - cropMin[0];
+        height = cropMax[1] - cropMin[1];
+    }
 
-        vector<double> dataMinExtents, dataMaxExtents;
-        _dataStatus->GetActiveExtents(_paramsMgr, _winName, _getCurrentTimestep(), dataMinExtents, dataMaxExtents);
+    int writeReturn = writer->Write(framebuffer.data(), width, height);
+    delete writer;
 
-        double m[16];
-        vpParams->GetModelViewMatrix(m);
-        double posvec[3], upvec[3], dirvec[3];
-        vpParams->ReconstructCamera(m, posvec, upvec, dirvec);
+    return writeReturn;
+}
 
-        float s = vpParams->GetOrthoProjectionSize();
-        float x = posvec[0];
-        float y = posvec[1];
-        float aspect = width / (float)height;
+int Visualizer::SetAnimationCaptureEnabled(bool onOff, string filename)
+{
+    if (_imageCaptureEnabled) {
+        SetErrMsg("Image capture concurrent with Animation Capture\n");
+        return -1;
+    }
+    if (_animationCaptureEnabled == onOff) {
+        SetErrMsg("Animation capture in incorrect state\n");
+        return -1;
+    }
 
-        float pixelScale[2] = {s * aspect * 2 / (float)width, s * 2 / (float)height};
+    int rc = 0;
+    if (!onOff) rc = _finishCapture();
 
-        // Crop to data extents
+    _animationCaptureEnabled = onOff;
+    if (onOff)
+        _captureImageFile = filename;
+    else
+        _captureImageFile = "";
+    return rc;
+}
 
-        double cameraMinExtents[2] = {x - s * aspect, y - s};
-        double cameraMaxExtents[2] = {x + s * aspect, y + s};
+int Visualizer::_captureAnimationFrame(std::string path)
+{
+    int width, height;
+    _framebuffer.GetSize(&width, &height);
 
-        int    cropMin[2] = {0, 0};
-        double newCameraMinExtents[2] = {cameraMinExtents[0], cameraMinExtents[1]};
-        for (int i = 0; i < 2; i++) {
-            if (cameraMinExtents[i] < dataMinExtents[i]) {
-                newCameraMinExtents[i] = dataMinExtents[i];
-                cropMin[i] = (dataMinExtents[i] - cameraMinExtents[i]) / pixelScale[i];
-            }
-        }
+    if (!_frameEncoder) _frameEncoder = new FrameEncoder();
 
-        int    cropMax[2] = {(int)width, (int)height};
-        double newCameraMaxExtents[2] = {cameraMaxExtents[0], cameraMaxExtents[1]};
-        for (int i = 0; i < 2; i++) {
-            if (cameraMaxExtents[i] > dataMaxExtents[i]) {
-                newCameraMaxExtents[i] = dataMaxExtents[i];
-                cropMax[i] = cropMax[i] - (cameraMaxExtents[i] - dataMaxExtents[i]) / pixelScale[i];
-            }
-        }
+    int  index = _capturePBOIndex;
+    auto &pending = _pendingCapture[index];
 
-        int croppedWidth = cropMax[0] - cropMin[0];
-        int croppedHeight = cropMax[1] - cropMin[1];
+    // Slot still holds a frame if the previous frame could not be finished
+    //
+    if (pending.valid && _finishPendingCapture(index) < 0) return -1;
+
+    pending.writer = nullptr;
+    pending.width = width;
+    pending.height = height;
+    pending.cropMin[0] = pending.cropMin[1] = 0;
+    pending.cropMax[0] = width;
+    pending.cropMax[1] = height;
+
+    if (FileUtils::Extension(path) == "y4m") {
+        if (!_frameEncoder->IsStreamOpen() && _frameEncoder->OpenStream(path, width, height) < 0) return -1;
+    } else {
+        if (_prepareCapture(path, width, height, &pending.writer, pending.cropMin, pending.cropMax) < 0) return -1;
+    }
 
-        if (croppedWidth <= 0 || croppedHeight <= 0) {
-            MyBase::SetErrMsg("Dataset not visible");
-            writeReturn = -1;
-            goto captureImageEnd;
-        }
+    if (!_capturePBO[0]) glGenBuffers(2, _capturePBO);
 
-        // flip Y
-        int temp = cropMin[1];
-        cropMin[1] = height - cropMax[1];
-        cropMax[1] = height - temp;
+    // Must clear previous errors first.
+    while (glGetError() != GL_NO_ERROR)
+        ;
 
-        vector<unsigned char> croppedFB(3 * croppedWidth * croppedHeight);
-        for (int y = 0; y < croppedHeight; y++) memcpy(&croppedFB[3 * y * croppedWidth], &framebuffer[3 * ((y + cropMin[1]) * width + cropMin[0])], 3 * croppedWidth);
+    // Start an asynchronous transfer of the frame into a pixel buffer object.
+    // The transfer is completed when the next frame is captured.
+    //
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _capturePBO[index]);
+    glBufferData(GL_PIXEL_PACK_BUFFER, 3 * (size_t)width * height, NULL, GL_STREAM_READ);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (glGetError() != GL_NO_ERROR) {
+        SetErrMsg("Error obtaining GL framebuffer data");
+        if (pending.writer) delete pending.writer;
+        pending.writer = nullptr;
+        return -1;
+    }
 
-        framebuffer = croppedFB;
+    pending.valid = true;
+    _capturePBOIndex = 1 - index;
 
-        s *= croppedHeight / (float)height;
+    if (_pendingCapture[_capturePBOIndex].valid) return _finishPendingCapture(_capturePBOIndex);
+    return 0;
+}
 
-        x = (newCameraMaxExtents[0] - newCameraMinExtents[0]) / 2 + newCameraMinExtents[0];
-        y = (newCameraMaxExtents[1] - newCameraMinExtents[1]) / 2 + newCameraMinExtents[1];
+int Visualizer::_finishPendingCapture(int index)
+{
+    auto &pending = _pendingCapture[index];
+    VAssert(pending.valid);
+    pending.valid = false;
 
-        width = croppedWidth;
-        height = croppedHeight;
-        aspect = width / (float)height;
+    ImageWriter *writer = pending.writer;
+    pending.writer = nullptr;
 
-        GeoTIFWriter *geo = (GeoTIFWriter *)writer;
-        geo->SetTiePoint(x, y, width / 2.f, height / 2.f);
-        geo->SetPixelScale(s * aspect * 2 / (float)width, s * 2 / (float)height);
-        if (geo->ConfigureFromProj4(projString) < 0) {
-            writeReturn = -1;
-            goto captureImageEnd;
-        }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _capturePBO[index]);
+    const unsigned char *src = (const unsigned char *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 3 * (size_t)pending.width * pending.height, GL_MAP_READ_BIT);
+    if (!src) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        SetErrMsg("Error obtaining GL framebuffer data");
+        if (writer) delete writer;
+        return -1;
     }
 
-    writeReturn = writer->Write(framebuffer.data(), width, height);
+    vector<unsigned char> pixels;
+    cropFrame(src, pending.width, pending.height, true, pending.cropMin, pending.cropMax, pixels);
 
-captureImageEnd:
-    if (writer) delete writer;
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-    return writeReturn;
+    int width = pending.cropMax[0] - pending.cropMin[0];
+    int height = pending.cropMax[1] - pending.cropMin[1];
+
+    if (writer) return _frameEncoder->Submit(writer, pixels, width, height);
+    return _frameEncoder->SubmitStreamFrame(pixels, width, height);
+}
+
+int Visualizer::_finishCapture()
+{
+    int rc = 0;
+
+    // Oldest frame first
+    //
+    for (int i = 0; i < 2; i++) {
+        int index = (_capturePBOIndex + i) % 2;
+        if (_pendingCapture[index].valid && _finishPendingCapture(index) < 0) rc = -1;
+    }
+
+    if (_frameEncoder) {
+        if (_frameEncoder->CloseStream() < 0) rc = -1;
+        if (_frameEncoder->Wait() < 0) rc = -1;
+    }
+    return rc;
 }
 
 bool Visualizer::_getPixelData(unsigned char *data) const
@@ -10,6 +10,10 @@
 #include <vapor/ViewpointParams.h>
 #include <vapor/AnnotationParams.h>
 #include <vapor/Progress.h>
+#include <vapor/TaskScheduler.h>
+#include <vapor/DataMgr.h>
+#include <algorithm>
+#include <sstream>
 
 using glm::mat4;
 using glm::vec3;
@@ -28,6 +32,144 @@ using namespace VAPoR;
 
 static VolumeAlgorithmRegistrar<VolumeOSPRay> registration;
 
+namespace {
+
+// Number of chunks long running loops are split into so that progress
+// can be reported and cancellation checked between them
+//
+const size_t ProgressChunks = 16;
+
+size_t numNodes(const Grid *grid)
+{
+    size_t n = 1;
+    for (auto d : grid->GetDimensions()) n *= d;
+    return n;
+}
+
+// Return the data values of the grid if they are stored contiguously,
+// in a single block, and contain no missing values, in which case they
+// can be handed to OSPRay without being copied
+//
+const float *sharableData(const Grid *grid)
+{
+    if (grid->HasMissingData()) return nullptr;
+
+    const vector<float *> &blks = grid->GetBlks();
+    if (blks.size() != 1) return nullptr;
+
+    const vector<size_t> &dims = grid->GetDimensions();
+    const vector<size_t> &bs = grid->GetBlockSize();
+    if (bs.size() < dims.size()) return nullptr;
+    for (int i = 0; i + 1 < dims.size(); i++) {
+        if (bs[i] != dims[i]) return nullptr;
+    }
+    return blks[0];
+}
+
+// Copy the data values of the grid to data, replacing missing values
+// with NaN
+//
+void copyData(const Grid *grid, float *data)
+{
+    const vector<size_t> &dims = grid->GetDimensions();
+    size_t                nx = dims[0];
+    size_t                ny = dims.size() > 1 ? dims[1] : 1;
+    bool                  hasMissing = grid->HasMissingData();
+    float                 mv = grid->GetMissingValue();
+
+    grid->ParallelForEach([=](int, const Grid::Span &span) {
+        float *dst = data + span.index[0] + nx * (span.index[1] + ny * span.index[2]);
+        if (!hasMissing) {
+            std::copy(span.data, span.data + span.n, dst);
+            return;
+        }
+        for (size_t i = 0; i < span.n; i++) dst[i] = span.data[i] == mv ? NAN : span.data[i];
+    });
+}
+
+class coords_state {
+public:
+    const Grid *_grid;
+    vec3 *      _coords;
+    size_t      _nx;
+    size_t      _ny;
+    size_t      _n0;    // First node
+    size_t      _n1;    // One past last node
+};
+
+void *runCoordsThread(void *arg)
+{
+    coords_state *s = (coords_state *)arg;
+
+    for (size_t n = s->_n0; n < s->_n1; n++) {
+        Size_tArr3 indices = {n % s->_nx, (n / s->_nx) % s->_ny, n / (s->_nx * s->_ny)};
+        DblArr3    coords;
+        s->_grid->GetUserCoordinates(indices, coords);
+        s->_coords[n] = vec3(coords[0], coords[1], coords[2]);
+    }
+    return (0);
+}
+
+// Compute the user coordinates of every node of the grid
+//
+void computeCoords(const Grid *grid, vector<vec3> &coords)
+{
+    const vector<size_t> &dims = grid->GetDimensions();
+    coords.resize(numNodes(grid));
+
+    coords_state proto;
+    proto._grid = grid;
+    proto._coords = coords.data();
+    proto._nx = dims[0];
+    proto._ny = dims.size() > 1 ? dims[1] : 1;
+
+    Wasp::ParallelFor(0, coords.size(), 4096, [&proto](size_t n0, size_t n1) {
+        coords_state s = proto;
+        s._n0 = n0;
+        s._n1 = n1;
+        runCoordsThread(&s);
+    });
+}
+
+// Node indices of a hexahedron, or the first six of a wedge
+//
+typedef struct {
+    union {
+        struct {
+            unsigned int i0, i1, i2, i3, i4, i5, i6, i7;
+        };
+        unsigned int i[8];
+    };
+} Cell;
+
+class structured_cells_state {
+public:
+    const vec3 *          _coords;
+    Cell *                _hexes;    // One hexahedron per cell, indexed by cell
+    int                   _xd;
+    int                   _yd;
+    vector<unsigned int>  _starts;    // Hexahedron offset into _hexes, or wedge number into _wedges
+    vector<unsigned char> _types;
+    vector<Cell>          _wedges;
+    size_t                _n0;    // First layer of cells
+    size_t                _n1;    // One past last layer of cells
+};
+
+class unstructured_cells_state {
+public:
+    const Grid *          _grid;
+    const vec3 *          _coords;
+    size_t                _nodeDim0;
+    size_t                _cellDim0;
+    vector<unsigned int>  _indices;
+    vector<unsigned int>  _starts;    // Offsets into _indices
+    vector<unsigned char> _types;
+    size_t                _n0;    // First cell
+    size_t                _n1;    // One past last cell
+};
+
+};    // namespace
+
 VolumeOSPRay::VolumeOSPRay(GLManager *gl, VolumeRenderer *renderer) : VolumeAlgorithm(gl, renderer)
 {
     _ospCamera = ospNewCamera("perspective");
@@ -74,6 +216,7 @@ VolumeOSPRay::~VolumeOSPRay()
     if (_ospLightDistant) ospRelease(_ospLightDistant);
     if (_ospIso) ospRelease(_ospIso);
     if (_ospIsoModel) ospRelease(_ospIsoModel);
+    _releaseTopology();
 }
 
 void VolumeOSPRay::SaveDepthBuffer(bool fast)
@@ -480,29 +623,124 @@ float VolumeOSPRay::_guessSamplingRateScalar(const Grid *grid) const
     return longest < 3E6f ? glm::mix(1.f, 0.1f, longest / 3E6f) : glm::mix(0.1f, 0.001f, (longest - 3E6f) / (4.05E7f - 3E6f));
 }
 
+OSPData VolumeOSPRay::_newScalarData(const Grid *grid, uint64_t n1, uint64_t n2, uint64_t n3)
+{
+    // The values of the current volume are released here, so this must
+    // only be called once the new volume can no longer fail to load
+    //
+    const float *shared = sharableData(grid);
+    _sharesGridData = shared != nullptr;
+
+    if (shared) {
+        vector<float>().swap(_scalarData);
+    } else {
+        vector<float> values(n1 * n2 * n3);
+        copyData(grid, values.data());
+        _scalarData.swap(values);
+    }
+
+    OSPData data = ospNewSharedData(shared ? shared : _scalarData.data(), OSP_FLOAT, n1, 0, n2, 0, n3, 0);
+    ospCommit(data);
+    return data;
+}
+
+// The node coordinates and cells of a grid are determined by its mesh,
+// the coordinate variables of the mesh, the time step if any of them
+// varies with time, the refinement and compression levels, and the index
+// box that was read
+//
+string VolumeOSPRay::_topologyKey(const Grid *grid) const
+{
+    VolumeParams *vp = GetParams();
+    DataMgr *     dataMgr = GetDataMgr();
+    string        varName = vp->GetVariableName();
+
+    std::ostringstream key;
+    key << grid->GetType();
+
+    DC::DataVar dvar;
+    if (dataMgr->GetDataVarInfo(varName, dvar)) key << "|" << dvar.GetMeshName();
+
+    vector<string> coordVars;
+    dataMgr->GetVarCoordVars(varName, true, coordVars);
+    bool timeVarying = false;
+    for (const auto &cvar : coordVars) {
+        key << "|" << cvar;
+        if (dataMgr->IsTimeVarying(cvar)) timeVarying = true;
+    }
+
+    key << "|" << (timeVarying ? vp->GetCurrentTimestep() : 0) << "|" << vp->GetRefinementLevel() << "|" << vp->GetCompressionLevel();
+
+    vector<size_t> minAbs = grid->GetMinAbs();
+    vector<size_t> dims = grid->GetDimensions();
+    for (int i = 0; i < minAbs.size(); i++) key << "|" << minAbs[i];
+    for (int i = 0; i < dims.size(); i++) key << "|" << dims[i];
+
+    return key.str();
+}
+
+bool VolumeOSPRay::_isTopologyCached(const Grid *grid, string &key) const
+{
+    key = _topologyKey(grid);
+    return _topology.position && _topology.key == key;
+}
+
+void VolumeOSPRay::_cacheTopology(const string &key, vector<vec3> &coords, vector<unsigned int> &indices, vector<unsigned int> &cellStarts,
+                                  vector<unsigned char> &cellTypes)
+{
+    _releaseTopology();
+
+    _topology.key = key;
+    _topology.coords.swap(coords);
+    _topology.indices.swap(indices);
+    _topology.cellStarts.swap(cellStarts);
+    _topology.cellTypes.swap(cellTypes);
+
+    _topology.position = ospNewSharedData(_topology.coords.data(), OSP_VEC3F, _topology.coords.size());
+    ospCommit(_topology.position);
+    _topology.index = ospNewSharedData(_topology.indices.data(), OSP_UINT, _topology.indices.size());
+    ospCommit(_topology.index);
+    _topology.cellIndex = ospNewSharedData(_topology.cellStarts.data(), OSP_UINT, _topology.cellStarts.size());
+    ospCommit(_topology.cellIndex);
+    _topology.cellType = ospNewSharedData(_topology.cellTypes.data(), OSP_UCHAR, _topology.cellTypes.size());
+    ospCommit(_topology.cellType);
+}
+
+void VolumeOSPRay::_setTopology(OSPVolume volume) const
+{
+    VAssert(_topology.position);
+    ospSetObject(volume, "vertex.position", _topology.position);
+    ospSetObject(volume, "index", _topology.index);
+    ospSetObject(volume, "cell.index", _topology.cellIndex);
+    ospSetObject(volume, "cell.type", _topology.cellType);
+}
+
+void VolumeOSPRay::_releaseTopology()
+{
+    if (_topology.position) ospRelease(_topology.position);
+    if (_topology.index) ospRelease(_topology.index);
+    if (_topology.cellIndex) ospRelease(_topology.cellIndex);
+    if (_topology.cellType) ospRelease(_topology.cellType);
+    _topology.position = _topology.index = _topology.cellIndex = _topology.cellType = nullptr;
+
+    _topology.key.clear();
+    vector<vec3>().swap(_topology.coords);
+    vector<unsigned int>().swap(_topology.indices);
+    vector<unsigned int>().swap(_topology.cellStarts);
+    vector<unsigned char>().swap(_topology.cellTypes);
+}
+
 OSPVolume VolumeOSPRay::_loadVolumeRegular(const Grid *grid)
 {
     const vector<size_t> dims = grid->GetDimensions();
-    const size_t         nVerts = dims[0] * dims[1] * dims[2];
     std::vector<double>  dataMinExtD, dataMaxExtD;
     grid->GetUserExtents(dataMinExtD, dataMaxExtD);
-    vec3  dataMinExt(dataMinExtD[0], dataMinExtD[1], dataMinExtD[2]);
-    vec3  dataMaxExt(dataMaxExtD[0], dataMaxExtD[1], dataMaxExtD[2]);
-    vec3  dimsf(dims[0], dims[1], dims[2]);
-    vec3  gridSpacing = (dataMaxExt - dataMinExt) / (dimsf - 1.f);
-    float missingValue = grid->HasMissingData() ? grid->GetMissingValue() : NAN;
-
-    float *fdata = new float[nVerts];
-    if (!fdata) {
-        Wasp::MyBase::SetErrMsg("Could not allocate enough RAM to load data");
-        return nullptr;
-    }
-    auto dataIt = grid->cbegin();
-    for (size_t i = 0; i < nVerts; ++i, ++dataIt) { fdata[i] = *dataIt == missingValue ? NAN : *dataIt; }
+    vec3 dataMinExt(dataMinExtD[0], dataMinExtD[1], dataMinExtD[2]);
+    vec3 dataMaxExt(dataMaxExtD[0], dataMaxExtD[1], dataMaxExtD[2]);
+    vec3 dimsf(dims[0], dims[1], dims[2]);
+    vec3 gridSpacing = (dataMaxExt - dataMinExt) / (dimsf - 1.f);
 
-    OSPData data = VOSP::NewCopiedData(fdata, OSP_FLOAT, dims[0], dims[1], dims[2]);
-    ospCommit(data);
-    delete[] fdata;
+    OSPData data = _newScalarData(grid, dims[0], dims[1], dims[2]);
 
     OSPVolume volume = ospNewVolume("structuredRegular");
 
@@ -535,64 +773,25 @@ bool VolumeOSPRay::isQuadCoPlanar(const vec3 &a, const vec3 &b, const vec3 &c, c
     return fabsf(s) <= FLT_EPSILON;
 }
 
-OSPVolume VolumeOSPRay::_loadVolumeStructured(const Grid *grid)
+void *VolumeOSPRay::_buildStructuredCells(void *arg)
 {
-    const vector<size_t> dims = grid->GetDimensions();
-    const size_t         nVerts = dims[0] * dims[1] * dims[2];
-    float                missingValue = grid->HasMissingData() ? grid->GetMissingValue() : NAN;
-
-    Progress::Start("Loading Grid", 2, false);
-    float *vdata = new float[nVerts];
-    auto   dataIt = grid->cbegin();
-    for (size_t i = 0; i < nVerts; ++i, ++dataIt) vdata[i] = *dataIt == missingValue ? NAN : *dataIt;
-    Progress::Update(1);
-
-    float *cdata = new float[nVerts * 3];
-    auto   coord = grid->ConstCoordBegin();
-    for (size_t i = 0; i < nVerts; ++i, ++coord) {
-        cdata[i * 3] = (*coord)[0];
-        cdata[i * 3 + 1] = (*coord)[1];
-        cdata[i * 3 + 2] = (*coord)[2];
-    }
-    Progress::Finish();
-
-    int xd = dims[0];
-    int yd = dims[1];
-    int zd = dims[2];
-    int cxd = xd - 1;
-    int cyd = yd - 1;
-    int czd = zd - 1;
-
-    if (cxd * cyd * czd == 0) {
-        MyBase::SetErrMsg("Volume rendering a flat grid not supported with this method");
-        return nullptr;
-    }
+    structured_cells_state *s = (structured_cells_state *)arg;
+    const vec3 *            coords = s->_coords;
+    int                     xd = s->_xd;
+    int                     yd = s->_yd;
+    int                     cxd = xd - 1;
+    int                     cyd = yd - 1;
 
-    // "indexPrefixed" is broken
-
-    typedef struct {
-        union {
-            struct {
-                unsigned int i0, i1, i2, i3, i4, i5, i6, i7;
-            };
-            unsigned int i[8];
-        };
-    } Cell;
-    vector<Cell> indices(cxd * cyd * czd);
+    //    bool decompose = GetActiveParams()->GetValueLong("osp_decompose", false);
+    const bool decompose = true;
 
 #define I(x, y, z) (unsigned int)((z)*yd * xd + (y)*xd + (x))
 
-    Progress::Start("Convert Grid", czd, true);
-    for (int z = 0; z < czd; z++) {
-        Progress::Update(z);
-        if (Progress::Cancelled()) {
-            delete[] vdata;
-            delete[] cdata;
-            return nullptr;
-        }
+    for (int z = s->_n0; z < s->_n1; z++) {
         for (int y = 0; y < cyd; y++) {
             for (int x = 0; x < cxd; x++) {
-                indices[z * cyd * cxd + y * cxd + x] = {{{
+                size_t i = (size_t)z * cyd * cxd + y * cxd + x;
+                Cell   c = {{{
                     I(x, y, z),
                     I(x + 1, y, z),
                     I(x + 1, y + 1, z),
@@ -602,132 +801,146 @@ OSPVolume VolumeOSPRay::_loadVolumeStructured(const Grid *grid)
                     I(x + 1, y + 1, z + 1),
                     I(x, y + 1, z + 1),
                 }}};
+                s->_hexes[i] = c;
+
+                bool discard = false;
+                for (int j = 0; j < 4; j++) {
+                    if (fabsf((coords[c.i[j + 4]] - coords[c.i[j]]).z) < FLT_EPSILON) {
+                        discard = true;
+                        break;
+                    }
+                }
+                if (discard) continue;
+
+                if (decompose && (!isQuadCoPlanar(coords[c.i0], coords[c.i1], coords[c.i2], coords[c.i3]) || !isQuadCoPlanar(coords[c.i4], coords[c.i5], coords[c.i6], coords[c.i7]))) {
+                    Cell w1 = {{{c.i0, c.i1, c.i3, c.i4, c.i5, c.i7, 0, 0}}};
+                    Cell w2 = {{{c.i1, c.i2, c.i3, c.i5, c.i6, c.i7, 0, 0}}};
+
+                    if (CW == getWindingOrderRespectToZ(coords[w1.i0], coords[w1.i1], coords[w1.i2])) {
+                        std::swap(w1.i1, w1.i2);
+                        std::swap(w1.i4, w1.i5);
+                    }
+                    if (CW == getWindingOrderRespectToZ(coords[w2.i0], coords[w2.i1], coords[w2.i2])) {
+                        std::swap(w2.i1, w2.i2);
+                        std::swap(w2.i4, w2.i5);
+                    }
+
+                    s->_starts.push_back(s->_wedges.size());
+                    s->_types.push_back(OSP_WEDGE);
+                    s->_wedges.push_back(w1);
+                    s->_starts.push_back(s->_wedges.size());
+                    s->_types.push_back(OSP_WEDGE);
+                    s->_wedges.push_back(w2);
+                    continue;
+                }
+
+                s->_starts.push_back(i * 8);
+                s->_types.push_back(OSP_HEXAHEDRON);
             }
         }
     }
-    Progress::Finish();
 #undef I
+    return (0);
+}
 
-    const int maxCells = INT_MAX;
-    const int nCells = min(maxCells, czd * cyd * cxd);
-    vec3 *    coords = (vec3 *)cdata;
+OSPVolume VolumeOSPRay::_loadVolumeStructured(const Grid *grid)
+{
+    const vector<size_t> dims = grid->GetDimensions();
+    const size_t         nVerts = dims[0] * dims[1] * dims[2];
 
-    //    for (int i = 0; i < 8; i++) {
-    //        int ci = indices[nCells-1].i[i];
-    //        printf("cells[%i][%i] = (%f, %f, %f)\n", nCells-1, i, coords[ci].x, coords[ci].y, coords[ci].z);
-    //    }
+    int xd = dims[0];
+    int yd = dims[1];
+    int zd = dims[2];
+    int cxd = xd - 1;
+    int cyd = yd - 1;
+    int czd = zd - 1;
 
-    //    for (int i = 0; i < 4; i++) {
-    //        int bi = indices[nCells-1].i[i];
-    //        int ti = indices[nCells-1].i[i+4];
-    //        auto &b = coords[bi];
-    //        auto &t = coords[ti];
-    //        float zdiff = (t-b).z;
-    //        printf("ZDiff[%i] = %f%s\n", i, zdiff, zdiff < FLT_EPSILON ? " (< EPSILON)" : "");
-    //    }
+    if (cxd * cyd * czd == 0) {
+        MyBase::SetErrMsg("Volume rendering a flat grid not supported with this method");
+        return nullptr;
+    }
 
-    //    bool decompose = GetActiveParams()->GetValueLong("osp_decompose", false);
-    const bool decompose = true;
-    unsigned   nDecomposed = 0;
-    unsigned   nDiscarded = 0;
-
-    Progress::Start("Preprocess Grid", nCells, true);
-    vector<unsigned int>  startIndex;
-    vector<unsigned char> cellType;
-    for (int i = 0; i < nCells; i++) {
-        Progress::Update(i);
-        if (Progress::Cancelled()) {
-            delete[] vdata;
-            delete[] cdata;
-            return nullptr;
-        }
-        bool discard = false;
-        for (int j = 0; j < 4; j++) {
-            if (fabsf((coords[indices[i].i[j + 4]] - coords[indices[i].i[j]]).z) < FLT_EPSILON) {
-                discard = true;
-                break;
+    string topologyKey;
+    if (!_isTopologyCached(grid, topologyKey)) {
+        Progress::StartIndefinite("Loading Grid");
+        vector<vec3> coords;
+        computeCoords(grid, coords);
+        Progress::Finish();
+
+        // "indexPrefixed" is broken
+        //
+        // Every cell is stored as a hexahedron. Cells that are not
+        // parallelepipeds are decomposed into two wedges, which are
+        // appended after the hexahedra.
+        //
+        const size_t          nCells = (size_t)czd * cyd * cxd;
+        vector<unsigned int>  indices(nCells * 8);
+        vector<Cell>          wedges;
+        vector<unsigned int>  startIndex;
+        vector<unsigned char> cellType;
+
+        structured_cells_state proto;
+        proto._coords = coords.data();
+        proto._hexes = (Cell *)indices.data();
+        proto._xd = xd;
+        proto._yd = yd;
+
+        // Wedge starting indices are not known until all hexahedra have
+        // been counted, so the positions in startIndex of wedges are
+        // recorded and their indices resolved below
+        //
+        vector<size_t> wedgeCells;
+
+        Progress::Start("Convert Grid", ProgressChunks, true);
+        vector<structured_cells_state> states;
+        for (size_t chunk = 0; chunk < ProgressChunks; chunk++) {
+            Progress::Update(chunk);
+            if (Progress::Cancelled()) return nullptr;
+
+            size_t z0 = czd * chunk / ProgressChunks;
+            size_t z1 = czd * (chunk + 1) / ProgressChunks;
+            if (z0 == z1) continue;
+
+            states.assign(Wasp::NumParts(z1 - z0, 1), proto);
+            Wasp::ParallelForParts(z0, z1, states.size(), [&states](size_t p, size_t n0, size_t n1) {
+                states[p]._n0 = n0;
+                states[p]._n1 = n1;
+                _buildStructuredCells(&states[p]);
+            });
+            for (const auto &st : states) {
+                for (size_t j = 0; j < st._starts.size(); j++) {
+                    if (st._types[j] == OSP_WEDGE) {
+                        wedgeCells.push_back(startIndex.size());
+                        startIndex.push_back(wedges.size() + st._starts[j]);
+                    } else {
+                        startIndex.push_back(st._starts[j]);
+                    }
+                }
+                cellType.insert(cellType.end(), st._types.begin(), st._types.end());
+                wedges.insert(wedges.end(), st._wedges.begin(), st._wedges.end());
             }
         }
-        if (discard) {
-            nDiscarded++;
-            continue;
-        }
-
-        if (decompose
-            && (!isQuadCoPlanar(coords[indices[i].i0], coords[indices[i].i1], coords[indices[i].i2], coords[indices[i].i3])
-                || !isQuadCoPlanar(coords[indices[i].i4], coords[indices[i].i5], coords[indices[i].i6], coords[indices[i].i7]))) {
-            Cell c = indices[i];
-            Cell w1 = {{{c.i0, c.i1, c.i3, c.i4, c.i5, c.i7, 0, 0}}};
-            Cell w2 = {{{c.i1, c.i2, c.i3, c.i5, c.i6, c.i7, 0, 0}}};
+        Progress::Finish();
 
-            if (CW == getWindingOrderRespectToZ(coords[w1.i0], coords[w1.i1], coords[w1.i2])) {
-                std::swap(w1.i1, w1.i2);
-                std::swap(w1.i4, w1.i5);
-            }
-            if (CW == getWindingOrderRespectToZ(coords[w2.i0], coords[w2.i1], coords[w2.i2])) {
-                std::swap(w2.i1, w2.i2);
-                std::swap(w2.i4, w2.i5);
-            }
-
-            startIndex.push_back(indices.size() * 8);
-            cellType.push_back(OSP_WEDGE);
-            indices.push_back(w1);
-            startIndex.push_back(indices.size() * 8);
-            cellType.push_back(OSP_WEDGE);
-            indices.push_back(w2);
-            nDecomposed++;
-            continue;
+        VAssert(cellType.size() == startIndex.size());
+        if (startIndex.empty()) {
+            MyBase::SetErrMsg("Grid has no cells that can be volume rendered");
+            return nullptr;
         }
 
-        startIndex.push_back(i * 8);
-        cellType.push_back(OSP_HEXAHEDRON);
-    }
-    Progress::Finish();
+        for (auto c : wedgeCells) startIndex[c] = (nCells + startIndex[c]) * 8;
+        for (const auto &w : wedges) indices.insert(indices.end(), w.i, w.i + 8);
+        vector<Cell>().swap(wedges);
 
-    //    printf("Discarded %i cells\n", nDiscarded);
-    //    printf("Decomposed %i cells\n", nDecomposed);
-    VAssert(cellType.size() == startIndex.size());
+        _cacheTopology(topologyKey, coords, indices, startIndex, cellType);
+    }
 
+    Progress::StartIndefinite("Copy data to OSPRay");
     OSPVolume volume = ospNewVolume("unstructured");
-    OSPData   data;
-    Progress::Start("Copy data to OSPRay", 5, false);
-
-    data = VOSP::NewCopiedData(vdata, OSP_FLOAT, nVerts);
-    ospCommit(data);
+    OSPData   data = _newScalarData(grid, nVerts);
     ospSetObject(volume, "vertex.data", data);
     ospRelease(data);
-    delete[] vdata;
-    Progress::Update(1);
-
-    data = VOSP::NewCopiedData(cdata, OSP_VEC3F, nVerts);
-    ospCommit(data);
-    ospSetObject(volume, "vertex.position", data);
-    ospRelease(data);
-    delete[] cdata;
-    Progress::Update(2);
-
-    // Was cxd*cyd*czd*8
-    // need to potentially modify when replacing non-parallelpiped cells.
-    data = VOSP::NewCopiedData(indices.data(), OSP_UINT, indices.size() * 8);
-    ospCommit(data);
-    ospSetObject(volume, "index", data);
-    ospRelease(data);
-    indices.clear();
-    Progress::Update(3);
-
-    data = VOSP::NewCopiedData(startIndex.data(), OSP_UINT, startIndex.size());
-    ospCommit(data);
-    ospSetObject(volume, "cell.index", data);
-    ospRelease(data);
-    startIndex.clear();
-    Progress::Update(4);
-
-    data = VOSP::NewCopiedData(cellType.data(), OSP_UCHAR, cellType.size());
-    ospCommit(data);
-    ospSetObject(volume, "cell.type", data);
-    ospRelease(data);
-    cellType.clear();
-    Progress::Update(5);
+    _setTopology(volume);
     Progress::Finish();
 
     Progress::StartIndefinite("Commit OSPRay");
@@ -738,75 +951,33 @@ OSPVolume VolumeOSPRay::_loadVolumeStructured(const Grid *grid)
     return volume;
 }
 
-OSPVolume VolumeOSPRay::_loadVolumeUnstructured(const Grid *grid)
+void *VolumeOSPRay::_buildUnstructuredCells(void *arg)
 {
-    const vector<size_t> nodeDims = grid->GetDimensions();
-    size_t               nodeDim = nodeDims.size();
-    const size_t         nVerts = nodeDims[0] * nodeDims[1];
-    const vector<size_t> cellDims = grid->GetCellDimensions();
-    const size_t         nCells = cellDims[0] * cellDims[1];
-    VAssert(nodeDim == 2 && cellDims.size() == 2);
-
-    float  missingValue = grid->HasMissingData() ? grid->GetMissingValue() : NAN;
-    size_t maxNodes = grid->GetMaxVertexPerCell();
-    //    size_t *nodes = (size_t*)alloca(sizeof(size_t) * maxNodes * nodeDim);
-    std::vector<Size_tArr3> nodes(maxNodes * nodeDim);
-
-    Progress::Start("Loading Grid Data", 2, false);
-    float *vdata = new float[nVerts];
-    auto   dataIt = grid->cbegin();
-    for (size_t i = 0; i < nVerts; ++i, ++dataIt) vdata[i] = *dataIt == missingValue ? NAN : *dataIt;
-    Progress::Update(1);
-
-    float *cdata = new float[nVerts * 3];
-    auto   coord = grid->ConstCoordBegin();
-    for (size_t i = 0; i < nVerts; ++i, ++coord) {
-        cdata[i * 3] = (*coord)[0];
-        cdata[i * 3 + 1] = (*coord)[1];
-        cdata[i * 3 + 2] = (*coord)[2];
-    }
-    Progress::Update(2);
-    Progress::Finish();
-
-    vector<unsigned int>  cellIndices;
-    vector<unsigned int>  cellStarts;
-    vector<unsigned char> cellTypes;
+    unstructured_cells_state *s = (unstructured_cells_state *)arg;
+    const vec3 *              coords = s->_coords;
+    vector<unsigned int> &    cellIndices = s->_indices;
+    vector<Size_tArr3>        nodes(s->_grid->GetMaxVertexPerCell() * s->_grid->GetDimensions().size());
 
-    long added[32] = {0};
-    long skipped[32] = {0};
+#define add(i) cellIndices.push_back(nodes[i][0] + nodes[i][1] * s->_nodeDim0);
+#define C(i)   coords[cellIndices[start + (i)]]
 
-    //    int maxCells = std::min((int)nCells, (int)GetActiveParams()->GetValueLong("osp_max_cells", 1));
-
-    auto cellIt = grid->ConstCellBegin();
-    Progress::Start("Loading Grid", nCells, true);
-    for (size_t cellCounter = 0; cellCounter < nCells; ++cellIt, ++cellCounter) {
-        Progress::Update(cellCounter);
-        if (Progress::Cancelled()) {
-            delete[] vdata;
-            delete[] cdata;
-            return nullptr;
-        }
-        const vector<size_t> &cell = *cellIt;
-        grid->GetCellNodes(cell.data(), nodes);
+    for (size_t cellCounter = s->_n0; cellCounter < s->_n1; cellCounter++) {
+        Size_tArr3 cell = {cellCounter % s->_cellDim0, cellCounter / s->_cellDim0, 0};
+        s->_grid->GetCellNodes(cell, nodes);
         int numNodes = nodes.size();
 
-        if (numNodes == 4) {
-            cellStarts.push_back(cellIndices.size());
-            cellTypes.push_back(OSP_TETRAHEDRON);
-            added[numNodes]++;
-
-            for (int i = 0; i < 4; i++) cellIndices.push_back(nodes[i][0] + nodes[i][1] * nodeDims[0]);
-        } else if (numNodes == 6) {
-            cellStarts.push_back(cellIndices.size());
-            cellTypes.push_back(OSP_WEDGE);
-            added[numNodes]++;
-
-            for (int i = 0; i < 6; i++) cellIndices.push_back(nodes[i][0] + nodes[i][1] * nodeDims[0]);
-        } else if (numNodes == 12) {    // Hexagonal Prism
-#define add(i) cellIndices.push_back(nodes[i][0] + nodes[i][1] * nodeDims[0]);
-            for (int i = 0; i < 4; i++) {
-                cellStarts.push_back(cellIndices.size());
-                cellTypes.push_back(OSP_WEDGE);
+        // Cells other than tetrahedra, wedges, and hexagonal prisms,
+        // which are split into four wedges, are skipped
+        //
+        int nCells = numNodes == 4 ? 1 : numNodes == 6 ? 1 : numNodes == 12 ? 4 : 0;
+
+        for (int i = 0; i < nCells; i++) {
+            size_t start = cellIndices.size();
+            if (numNodes == 4) {
+                for (int j = 0; j < 4; j++) add(j);
+            } else if (numNodes == 6) {
+                for (int j = 0; j < 6; j++) add(j);
+            } else {    // Hexagonal Prism
                 add(0);
                 add(i + 1);
                 add(i + 2);
@@ -814,161 +985,117 @@ OSPVolume VolumeOSPRay::_loadVolumeUnstructured(const Grid *grid)
                 add(6 + i + 1);
                 add(6 + i + 2);
             }
-#undef add
-            added[numNodes]++;
-        } else {
-            skipped[numNodes]++;
-        }
-
-        //        if (cellCounter >= maxCells-1) {
-        //            printf("WARNING BREAKING EARLY\n");
-        //            break;
-        //        }
-    }
-    Progress::Finish();
-    //    printf("done\n");
-
-    //    long totalAdded=0, totalSkipped=0;
-    //    for (int i = 0; i < 32; i++) {
-    //        if (added[i] > 0) printf("\tAdded[%i] = %li\n", i, added[i]);
-    //        if (skipped[i] > 0) printf("\tSkipped[%i] = %li\n", i, skipped[i]);
-    //        totalAdded += added[i];
-    //        totalSkipped += skipped[i];
-    //    }
-    //    printf("\tTotal Added = %li\n", totalAdded);
-    //    printf("\tTotal Skipped = %li\n", totalSkipped);
-    //    printf("# Coords = %li\n", nVerts);
-
-    vec3 *       coords = (vec3 *)cdata;
-    vector<bool> erase(cellStarts.size(), false);
-
-    Progress::Start("Preprocessing Cells", cellStarts.size(), true);
-    for (unsigned i = 0; i < cellStarts.size(); i++) {
-        Progress::Update(i);
-        if (Progress::Cancelled()) {
-            delete[] vdata;
-            delete[] cdata;
-            return nullptr;
-        }
-        unsigned start = cellStarts[i];
-        unsigned type = cellTypes[i];
 
-        if (type == OSP_WEDGE) {
-            if (CW == getWindingOrderRespectToZ(coords[cellIndices[start + 0]], coords[cellIndices[start + 1]], coords[cellIndices[start + 2]])) {
-                std::swap(cellIndices[start + 1], cellIndices[start + 2]);
-                std::swap(cellIndices[start + 1 + 3], cellIndices[start + 2 + 3]);
+            // Fix winding orders and discard degenerate cells
+            //
+            bool valid = true;
+            if (numNodes == 4) {
+                WindingOrder w = getWindingOrderTetra(C(0), C(1), C(2), C(3));
+                if (w == CW) std::swap(cellIndices[start + 1], cellIndices[start + 2]);
+                valid = w != INVALID;
+                VAssert(!valid || CCW == getWindingOrderTetra(C(0), C(1), C(2), C(3)));
+            } else {
+                if (CW == getWindingOrderRespectToZ(C(0), C(1), C(2))) {
+                    std::swap(cellIndices[start + 1], cellIndices[start + 2]);
+                    std::swap(cellIndices[start + 1 + 3], cellIndices[start + 2 + 3]);
+                }
+                WindingOrder w1 = getWindingOrderTetra(C(0), C(1), C(2), C(3));
+                WindingOrder w2 = getWindingOrderTetra(C(0), C(1), C(2), C(4));
+                WindingOrder w3 = getWindingOrderTetra(C(0), C(1), C(2), C(5));
+                valid = w1 != INVALID && w2 != INVALID && w3 != INVALID;
             }
-            WindingOrder w1 = getWindingOrderTetra(coords[cellIndices[start + 0]], coords[cellIndices[start + 1]], coords[cellIndices[start + 2]], coords[cellIndices[start + 3]]);
-            WindingOrder w2 = getWindingOrderTetra(coords[cellIndices[start + 0]], coords[cellIndices[start + 1]], coords[cellIndices[start + 2]], coords[cellIndices[start + 4]]);
-            WindingOrder w3 = getWindingOrderTetra(coords[cellIndices[start + 0]], coords[cellIndices[start + 1]], coords[cellIndices[start + 2]], coords[cellIndices[start + 5]]);
-            if (w1 == INVALID || w2 == INVALID || w3 == INVALID) {
-                erase[i] = true;
-                continue;
-            }
-        } else if (type == OSP_TETRAHEDRON) {
-            WindingOrder w = getWindingOrderTetra(coords[cellIndices[start + 0]], coords[cellIndices[start + 1]], coords[cellIndices[start + 2]], coords[cellIndices[start + 3]]);
-            if (w == CW) std::swap(cellIndices[start + 1], cellIndices[start + 2]);
-            if (w == INVALID) {
-                erase[i] = true;
+
+            if (!valid) {
+                cellIndices.resize(start);
                 continue;
             }
-            VAssert(CCW == getWindingOrderTetra(coords[cellIndices[start + 0]], coords[cellIndices[start + 1]], coords[cellIndices[start + 2]], coords[cellIndices[start + 3]]));
-            //            if (CCW != GetWindingOrderTetra(coords[cellIndices[start+0]], coords[cellIndices[start+1]], coords[cellIndices[start+2]], coords[cellIndices[start+3]])) {
-            //                PrintVec3(coords[cellIndices[start+0]]);
-            //                PrintVec3(coords[cellIndices[start+1]]);
-            //                PrintVec3(coords[cellIndices[start+2]]);
-            //                PrintVec3(coords[cellIndices[start+3]]);
-            //                printf("Winding = %s\n", to_string(GetWindingOrderTetra(coords[cellIndices[start+0]], coords[cellIndices[start+1]], coords[cellIndices[start+2]],
-            //                coords[cellIndices[start+3]]))); assert(0);
-            //            }
+            s->_starts.push_back(start);
+            s->_types.push_back(numNodes == 4 ? OSP_TETRAHEDRON : OSP_WEDGE);
         }
     }
-    Progress::Finish();
-    {
-        vector<unsigned int>  cellStartsNew;
-        vector<unsigned char> cellTypesNew;
-
-        for (int i = 0; i < cellStarts.size(); i++) {
-            if (!erase[i]) {
-                cellStartsNew.push_back(cellStarts[i]);
-                cellTypesNew.push_back(cellTypes[i]);
+#undef C
+#undef add
+    return (0);
+}
+
+OSPVolume VolumeOSPRay::_loadVolumeUnstructured(const Grid *grid)
+{
+    const vector<size_t> nodeDims = grid->GetDimensions();
+    size_t               nodeDim = nodeDims.size();
+    const size_t         nVerts = nodeDims[0] * nodeDims[1];
+    const vector<size_t> cellDims = grid->GetCellDimensions();
+    const size_t         nCells = cellDims[0] * cellDims[1];
+    VAssert(nodeDim == 2 && cellDims.size() == 2);
+
+    string topologyKey;
+    if (!_isTopologyCached(grid, topologyKey)) {
+        Progress::StartIndefinite("Loading Grid");
+        vector<vec3> coords;
+        computeCoords(grid, coords);
+        Progress::Finish();
+
+        vector<unsigned int>  cellIndices;
+        vector<unsigned int>  cellStarts;
+        vector<unsigned char> cellTypes;
+
+        unstructured_cells_state proto;
+        proto._grid = grid;
+        proto._coords = coords.data();
+        proto._nodeDim0 = nodeDims[0];
+        proto._cellDim0 = cellDims[0];
+
+        Progress::Start("Loading Grid", ProgressChunks, true);
+        vector<unstructured_cells_state> states;
+        for (size_t chunk = 0; chunk < ProgressChunks; chunk++) {
+            Progress::Update(chunk);
+            if (Progress::Cancelled()) return nullptr;
+
+            size_t c0 = nCells * chunk / ProgressChunks;
+            size_t c1 = nCells * (chunk + 1) / ProgressChunks;
+            if (c0 == c1) continue;
+
+            states.assign(Wasp::NumParts(c1 - c0, 1024), proto);
+            Wasp::ParallelForParts(c0, c1, states.size(), [&states](size_t p, size_t n0, size_t n1) {
+                states[p]._n0 = n0;
+                states[p]._n1 = n1;
+                _buildUnstructuredCells(&states[p]);
+            });
+            for (const auto &st : states) {
+                size_t offset = cellIndices.size();
+                for (auto start : st._starts) cellStarts.push_back(offset + start);
+                cellTypes.insert(cellTypes.end(), st._types.begin(), st._types.end());
+                cellIndices.insert(cellIndices.end(), st._indices.begin(), st._indices.end());
             }
         }
+        Progress::Finish();
 
-        cellStarts = cellStartsNew;
-        cellTypes = cellTypesNew;
-    }
+        if (cellStarts.empty()) {
+            MyBase::SetErrMsg("Grid has no cells that can be volume rendered");
+            return nullptr;
+        }
 
-    //    Progress::Finish();
-    //    printf("done\n");
-
-    //    int testCell = std::min(cellStarts.size()-1, (size_t)GetActiveParams()->GetValueLong("osp_test_cells", 0));
-    //    int testCell = 0;
-    //    if (testCell >= 0) {
-    //        int testCellNodes = cellTypes[testCell] == OSP_TETRAHEDRON ? 4 : 6;
-    //        printf("Test Cell[%i].nodes = %i\n", testCell, testCellNodes);
-    //        vec3 testCellCoords[testCellNodes];
-    //        for (int i = 0; i < testCellNodes; i++) {
-    //            int idx = cellIndices[cellStarts[testCell]+i];
-    //            testCellCoords[i] = coords[idx];
-    //            printf("\tCells[%i].vert[%i] = coords[%i] = (%f, %f, %f)\n", testCell, i, idx, coords[idx].x, coords[idx].y, coords[idx].z);
-    //        }
-    //        printf("\tWinding bottom = %s\n", to_string(GetWindingOrderRespectToZ(testCellCoords[0], testCellCoords[1], testCellCoords[2])));
-    //        if (testCellNodes == 6)
-    //            printf("\tWinding top = %s\n", to_string(GetWindingOrderRespectToZ(testCellCoords[3], testCellCoords[4], testCellCoords[5])));
-    //    }
-
-    Progress::Start("Sanity Checks", 5, false);
-    for (auto i : cellIndices) VAssert(i < nVerts);
-    Progress::Update(1);
-    for (auto i : cellStarts) VAssert(i < cellIndices.size());
-    Progress::Update(2);
-    for (auto i : cellTypes) VAssert(i == OSP_WEDGE || i == OSP_TETRAHEDRON);
-    Progress::Update(3);
-    VAssert(cellStarts[cellStarts.size() - 1] + (cellTypes[cellTypes.size() - 1] == OSP_WEDGE ? 6 : 4) <= cellIndices.size());
-    Progress::Update(4);
-    VAssert(cellStarts.size() == cellTypes.size());
-    Progress::Update(5);
-    Progress::Finish();
+        Progress::Start("Sanity Checks", 5, false);
+        for (auto i : cellIndices) VAssert(i < nVerts);
+        Progress::Update(1);
+        for (auto i : cellStarts) VAssert(i < cellIndices.size());
+        Progress::Update(2);
+        for (auto i : cellTypes) VAssert(i == OSP_WEDGE || i == OSP_TETRAHEDRON);
+        Progress::Update(3);
+        VAssert(cellStarts[cellStarts.size() - 1] + (cellTypes[cellTypes.size() - 1] == OSP_WEDGE ? 6 : 4) <= cellIndices.size());
+        Progress::Update(4);
+        VAssert(cellStarts.size() == cellTypes.size());
+        Progress::Update(5);
+        Progress::Finish();
+
+        _cacheTopology(topologyKey, coords, cellIndices, cellStarts, cellTypes);
+    }
 
-    Progress::Start("Copy data to OSPRay", 5, false);
+    Progress::StartIndefinite("Copy data to OSPRay");
     OSPVolume volume = ospNewVolume("unstructured");
-    OSPData   data;
-
-    data = VOSP::NewCopiedData(vdata, OSP_FLOAT, nVerts);
-    ospCommit(data);
+    OSPData   data = _newScalarData(grid, nVerts);
     ospSetObject(volume, "vertex.data", data);
     ospRelease(data);
-    delete[] vdata;
-    Progress::Update(1);
-
-    data = VOSP::NewCopiedData(cdata, OSP_VEC3F, nVerts);
-    ospCommit(data);
-    ospSetObject(volume, "vertex.position", data);
-    ospRelease(data);
-    delete[] cdata;
-    Progress::Update(2);
-
-    data = VOSP::NewCopiedData(cellIndices.data(), OSP_UINT, cellIndices.size());
-    ospCommit(data);
-    ospSetObject(volume, "index", data);
-    ospRelease(data);
-    cellIndices.clear();
-    Progress::Update(3);
-
-    data = VOSP::NewCopiedData(cellStarts.data(), OSP_UINT, cellStarts.size());
-    ospCommit(data);
-    ospSetObject(volume, "cell.index", data);
-    ospRelease(data);
-    cellStarts.clear();
-    Progress::Update(4);
-
-    data = VOSP::NewCopiedData(cellTypes.data(), OSP_UCHAR, cellTypes.size());
-    ospCommit(data);
-    ospSetObject(volume, "cell.type", data);
-    ospRelease(data);
-    cellTypes.clear();
-    Progress::Update(5);
+    _setTopology(volume);
     Progress::Finish();
 
     Progress::Start("Commit OSPRay", 1, false);
@@ -1,5 +1,6 @@
 #include <vapor/VolumeRegular.h>
 #include <vector>
+#include <algorithm>
 #include <vapor/glutil.h>
 #include <glm/glm.hpp>
 #include <vapor/GLManager.h>
@@ -58,29 +59,39 @@ int VolumeRegular::_loadDataDirect(const Grid *grid, Texture3D *dataTexture, Tex
         return -1;
     }
 
-    Progress::Start("Load volume data", nVerts, true);
-    auto dataIt = grid->cbegin();
-    for (size_t i = 0; i < nVerts; ++i, ++dataIt) {
-        Progress::Update(i);
+    *hasMissingData = grid->HasMissingData();
+    const float    missingValue = grid->GetMissingValue();
+    unsigned char *missingMask = nullptr;
+    if (*hasMissingData) missingMask = new unsigned char[nVerts];
+
+    // Copy the data, and build the missing value mask, a few slices at a
+    // time so that progress can be reported and the load cancelled
+    //
+    const size_t nChunks = std::min(dims[2], (size_t)16);
+    Progress::Start("Load volume data", nChunks, true);
+    for (size_t c = 0; c < nChunks; ++c) {
+        Progress::Update(c);
         if (Progress::Cancelled()) {
             delete[] data;
+            if (missingMask) delete[] missingMask;
             return -1;
         }
-        data[i] = *dataIt;
+
+        Size_tArr3 min = {0, 0, dims[2] * c / nChunks};
+        Size_tArr3 max = {dims[0] - 1, dims[1] - 1, dims[2] * (c + 1) / nChunks - 1};
+        grid->ParallelForEach(min, max, [&](int, const Grid::Span &span) {
+            size_t offset = span.index[0] + dims[0] * (span.index[1] + dims[1] * span.index[2]);
+            memcpy(data + offset, span.data, span.n * sizeof(*data));
+            if (missingMask) {
+                for (size_t i = 0; i < span.n; i++) missingMask[offset + i] = span.data[i] == missingValue ? 255 : 0;
+            }
+        });
     }
     Progress::Finish();
 
     dataTexture->TexImage(GL_R32F, dims[0], dims[1], dims[2], GL_RED, GL_FLOAT, data);
 
-    *hasMissingData = grid->HasMissingData();
     if (*hasMissingData) {
-        const float    missingValue = grid->GetMissingValue();
-        unsigned char *missingMask = new unsigned char[nVerts];
-        memset(missingMask, 0, nVerts);
-
-        for (size_t i = 0; i < nVerts; i++)
-            if (data[i] == missingValue) missingMask[i] = 255;
-
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         missingTexture->TexImage(GL_R8, dims[0], dims[1], dims[2], GL_RED, GL_UNSIGNED_BYTE, missingMask);
         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
@@ -64,6 +64,7 @@ VolumeRenderer::~VolumeRenderer()
     if (_VBOChunked) glDeleteBuffers(1, &_VBOChunked);
     if (_cache.tf) delete _cache.tf;
     if (_algorithm) delete _algorithm;
+    _releaseSharedGrid();
 }
 
 int VolumeRenderer::_initializeGL()
@@ -310,6 +311,7 @@ int VolumeRenderer::_initializeAlgorithm()
         _cache.algorithmName = vp->GetAlgorithm();
         if (_cache.algorithmName == "") _cache.algorithmName = "NULL";
         if (_algorithm) delete _algorithm;
+        _releaseSharedGrid();
         _algorithm = VolumeAlgorithm::NewAlgorithm(_cache.algorithmName, _glManager, this);
         _cache.needsUpdate = true;
     }
@@ -334,11 +336,15 @@ int VolumeRenderer::_loadData()
     CheckCache(_cache.ospMaxCells, RP->GetValueLong("osp_max_cells", 1));
     if (!_cache.needsUpdate) return 0;
 
-    Grid *grid = _dataMgr->GetVariable(_cache.ts, _cache.var, _cache.refinement, _cache.compression, _cache.minExt, _cache.maxExt);
+    // The grid is locked so that algorithms that share its memory rather
+    // than copying it can keep using it after it is loaded
+    //
+    Grid *grid = _dataMgr->GetVariable(_cache.ts, _cache.var, _cache.refinement, _cache.compression, _cache.minExt, _cache.maxExt, true);
     if (!grid) return -1;
 
     if (dynamic_cast<const UnstructuredGrid *>(grid) && !dynamic_cast<VolumeOSPRay *>(_algorithm)) {
         MyBase::SetErrMsg("Unstructured grids are not supported by the GPU renderer");
+        _releaseGrid(grid);
         return -1;
     }
 
@@ -350,17 +356,40 @@ int VolumeRenderer::_loadData()
     if (_needToSetDefaultAlgorithm()) {
         RP->SetAlgorithm(_getDefaultAlgorithmForGrid(grid));
         if (_initializeAlgorithm() < 0) {
-            delete grid;
+            _releaseGrid(grid);
             return -1;
         }
     }
 
     int ret = _algorithm->LoadData(grid);
     _lastRenderTime = 10000;
-    delete grid;
+
+    // If loading failed the algorithm still references the previous grid
+    //
+    if (ret >= 0) {
+        _releaseSharedGrid();
+        if (_algorithm->SharesGridData()) {
+            _sharedGrid = grid;
+            return ret;
+        }
+    }
+    _releaseGrid(grid);
     return ret;
 }
 
+void VolumeRenderer::_releaseGrid(Grid *grid)
+{
+    _dataMgr->UnlockGrid(grid);
+    delete grid;
+}
+
+void VolumeRenderer::_releaseSharedGrid()
+{
+    if (!_sharedGrid) return;
+    _releaseGrid(_sharedGrid);
+    _sharedGrid = nullptr;
+}
+
 int VolumeRenderer::_loadSecondaryData()
 {
     VolumeParams *vp = (VolumeParams *)GetActiveParams();
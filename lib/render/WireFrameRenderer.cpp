@@ -21,10 +21,13 @@
 #include <sstream>
 #include <string>
 #include <iterator>
+#include <algorithm>
+#include <cstdint>
 
 #include <vapor/glutil.h>    // Must be included first!!!
 
 #include <vapor/Renderer.h>
+#include <vapor/Trace.h>
 #include <vapor/WireFrameParams.h>
 #include <vapor/WireFrameRenderer.h>
 #include <vapor/regionparams.h>
@@ -35,21 +38,78 @@
 #include "vapor/GLManager.h"
 #include "vapor/debug.h"
 #include <vapor/Progress.h>
+#include <vapor/TaskScheduler.h>
+#include <vapor/StructuredGrid.h>
 
 using namespace VAPoR;
+using namespace Wasp;
+
+namespace {
 
 #pragma pack(push, 4)
-struct WireFrameRenderer::VertexData {
+struct VertexData {
     float x, y, z;
     float v;
     float missing;
 };
 #pragma pack(pop)
 
+// Number of chunks the cache building loops are split into, so that
+// progress can be reported and cancellation checked between them
+//
+const size_t ProgressChunks = 64;
+
+// Call body(c0, c1) on ProgressChunks consecutive chunks [c0, c1) of
+// [0, n), reporting done + c1 elements completed after each. Return
+// false if the user cancelled.
+//
+template<class F> bool forEachProgressChunk(size_t n, long done, const F &body)
+{
+    for (size_t chunk = 0; chunk < ProgressChunks; chunk++) {
+        size_t c0 = n * chunk / ProgressChunks;
+        size_t c1 = n * (chunk + 1) / ProgressChunks;
+        if (c0 < c1) body(c0, c1);
+
+        Progress::Update(done + c1);
+        if (Progress::Cancelled()) return (false);
+    }
+    return (true);
+}
+
+// Advance a multi-dimensional index by one in the fastest varying
+// dimension, carrying into slower ones
+//
+inline void incrementIndex(Size_tArr3 &index, const std::vector<size_t> &dims)
+{
+    for (int d = 0; d < dims.size(); d++) {
+        if (++index[d] < dims[d]) return;
+        index[d] = 0;
+    }
+}
+
+inline Size_tArr3 vectorizeIndex(size_t offset, const std::vector<size_t> &dims)
+{
+    Size_tArr3 index = {0, 0, 0};
+    Wasp::VectorizeCoords(offset, dims.data(), index.data(), dims.size());
+    return index;
+}
+
+// Edges are packed into a single 64 bit key, smaller node index first
+//
+inline uint64_t edgeKey(GLuint idx0, GLuint idx1)
+{
+    if (idx1 < idx0) std::swap(idx0, idx1);
+    return ((uint64_t)idx0 << 32) | idx1;
+}
+
+inline size_t edgePartition(uint64_t key, size_t nparts) { return ((key * 0x9E3779B97F4A7C15ULL) >> 32) % nparts; }
+
+};    // namespace
+
 static RendererRegistrar<WireFrameRenderer> registrar(WireFrameRenderer::GetClassType(), WireFrameParams::GetClassType());
 
 WireFrameRenderer::WireFrameRenderer(const ParamsMgr *pm, string winName, string dataSetName, string instName, DataMgr *dataMgr)
-: Renderer(pm, winName, dataSetName, WireFrameParams::GetClassType(), WireFrameRenderer::GetClassType(), instName, dataMgr), _VAO(0), _VBO(0), _EBO(0)
+: Renderer(pm, winName, dataSetName, WireFrameParams::GetClassType(), WireFrameRenderer::GetClassType(), instName, dataMgr), _VAO(0), _VBO(0), _EBO(0), _nIndices(0), _topologyValid(false)
 {
 }
 
@@ -90,126 +150,47 @@ bool WireFrameRenderer::_isCacheDirty() const
     return false;
 }
 
+// Generate the vertices shared by all line segments. Vertex i holds the
+// coordinates and value of grid node i.
 //
-// Generate wireframe line drawing list of line segments for a single
-// cell. Make use of drawList to avoid drawing line segments shared
-// by multiple cells
-//
-void WireFrameRenderer::_drawCell(const GLuint *cellNodeIndices, int n, bool layered, const vector<GLuint> &nodeMap, GLuint invalidIndex, vector<unsigned int> &indices, DrawList &drawList) const
+void WireFrameRenderer::_buildCacheVertices(const Grid *grid, const Grid *heightGrid, bool *GPUOutOfMemory) const
 {
-    int count = layered ? n / 2 : n;
-    for (int i = 0; i < count; i++) {
-        GLuint idx0 = nodeMap[cellNodeIndices[i]];
-        VAssert(idx0 != invalidIndex);
-
-        GLuint idx1 = nodeMap[cellNodeIndices[(i + 1) % count]];
-        VAssert(idx1 != invalidIndex);
-
-        // Don't draw line segment if it's already been drawn
-        //
-        if (drawList.InList(idx0, idx1)) continue;
-
-        indices.push_back(idx0);
-        indices.push_back(idx1);
-    }
-
-    if (!layered) return;
-
-    // if layered the coordinates are ordered bottom face first, then top face
-    //
-    for (int i = 0; i < count; i++) {
-        GLuint idx0 = nodeMap[cellNodeIndices[i + count]];
-        VAssert(idx0 != invalidIndex);
-
-        GLuint idx1 = nodeMap[cellNodeIndices[((i + 1) % count) + count]];
-        VAssert(idx1 != invalidIndex);
-
-        if (drawList.InList(idx0, idx1)) continue;
-
-        indices.push_back(idx0);
-        indices.push_back(idx1);
-    }
-
-    // Now draw edges between top and bottom face
-    //
-    for (int i = 0; i < count; i++) {
-        GLuint idx0 = nodeMap[cellNodeIndices[i]];
-        VAssert(idx0 != invalidIndex);
-
-        GLuint idx1 = nodeMap[cellNodeIndices[i + count]];
-        VAssert(idx1 != invalidIndex);
-
-        if (drawList.InList(idx0, idx1)) continue;
+    size_t numNodes = Wasp::VProduct(grid->GetDimensions());
 
-        indices.push_back(idx0);
-        indices.push_back(idx1);
-    }
-}
+    vector<VertexData> vertices(numNodes);
 
-// Generate list of vertices shared by all line segments, and populate
-// 'nodeMap': a map from a node's Grid index to its offset in the
-// list of vertices.
-//
-void WireFrameRenderer::_buildCacheVertices(const Grid *grid, const Grid *heightGrid, vector<GLuint> &nodeMap, bool *GPUOutOfMemory) const
-{
-    double mv = grid->GetMissingValue();
-    float  defaultZ = GetDefaultZ(_dataMgr, _cacheParams.ts);
-    size_t numNodes = Wasp::VProduct(grid->GetDimensions());
+    const vector<size_t> &dims = grid->GetDimensions();
+    bool                  has3DCoords = grid->GetGeometryDim() > 2;
+    float                 defaultZ = GetDefaultZ(_dataMgr, _cacheParams.ts);
+    double                mv = grid->GetMissingValue();
 
-    // Pre-allocate vertices vector upfront for better performance
-    //
-    vector<VertexData> vertices;
-    vertices.reserve(numNodes);
-
-    // Visit each grid node. For each node store node's coordinates and
-    // assigned color in 'vertices'. Create 'nodeMap': mapping from a
-    // grid node's index to its offset in 'vertices'
-    //
-    Grid::ConstNodeIterator nodeItr = grid->ConstNodeBegin();
-    Grid::ConstNodeIterator nodeEnd = grid->ConstNodeEnd();
-    Grid::ConstCoordItr     coordItr = grid->ConstCoordBegin();
-    Grid::ConstCoordItr     coordEnd = grid->ConstCoordEnd();
     Progress::Start("Load Grid", numNodes);
-    long done = 0;
-    for (; nodeItr != nodeEnd; ++nodeItr, ++coordItr, ++done) {
-        Progress::Update(done);
+    forEachProgressChunk(numNodes, 0, [&](size_t c0, size_t c1) {
+        Wasp::ParallelFor(c0, c1, 4096, [&](size_t n0, size_t n1) {
+            Size_tArr3 index = vectorizeIndex(n0, dims);
+            DblArr3    coord;
+            for (size_t i = n0; i < n1; i++, incrementIndex(index, dims)) {
+                grid->GetUserCoordinates(index, coord);
+
+                if (!has3DCoords) {
+                    if (heightGrid) {
+                        coord[2] = heightGrid->GetValueAtIndex(index);
+                    } else {
+                        coord[2] = defaultZ;
+                    }
+                }
 
-        // Get current node's coordinates
-        //
-        double coord[3];
-        coord[0] = (*coordItr)[0];
-        coord[1] = (*coordItr)[1];
-
-        if (grid->GetGeometryDim() > 2) {
-            coord[2] = (*coordItr)[2];
-        } else {
-            if (heightGrid) {
-                coord[2] = heightGrid->GetValueAtIndex(*nodeItr);
-            } else {
-                coord[2] = defaultZ;
+                float dataValue = grid->GetValueAtIndex(index);
+                vertices[i] = {(float)coord[0], (float)coord[1], (float)coord[2], dataValue, mv == dataValue ? 1.f : 0.f};
             }
-        }
-
-        float dataValue = grid->GetValueAtIndex(*nodeItr);
-
-        // Create an entry in nodeMap
-        //
-        size_t index = Wasp::LinearizeCoords(*nodeItr, grid->GetDimensions());
-
-        if (vertices.size() > std::numeric_limits<GLuint>::max()) {
-#ifndef NDEBUG
-            MyBase::SetDiagMsg("WireFrameRenderer() : exceeded numeric limits");
-#endif
-            continue;
-        }
-        nodeMap[index] = vertices.size();
-
-        vertices.push_back({(float)coord[0], (float)coord[1], (float)coord[2], dataValue, mv == dataValue ? 1.f : 0.f});
-    }
+        });
+    });
 
     glBindVertexArray(_VAO);
     glBindBuffer(GL_ARRAY_BUFFER, _VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexData), vertices.data(), GL_DYNAMIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     GLenum err;
     while ((err = glGetError()) != GL_NO_ERROR)
@@ -217,64 +198,145 @@ void WireFrameRenderer::_buildCacheVertices(const Grid *grid, const Grid *height
 }
 
 //
-// Generate connectivity list for line segments joining cell nodes.
+// Generate connectivity list for line segments joining cell nodes. Each
+// unique edge appears exactly once. Returns 0 if the user cancelled.
 //
-size_t WireFrameRenderer::_buildCacheConnectivity(const Grid *grid, const vector<GLuint> &nodeMap, bool *GPUOutOfMemory) const
+size_t WireFrameRenderer::_buildCacheConnectivity(const Grid *grid, bool *GPUOutOfMemory) const
 {
-    size_t             invalidIndex = std::numeric_limits<size_t>::max();
-    size_t             numNodes = Wasp::VProduct(grid->GetDimensions());
-    bool               layered = grid->GetTopologyDim() == 3;
-    size_t             maxVertsPerCell = grid->GetMaxVertexPerCell();
-    vector<Size_tArr3> cellNodeIndices(maxVertsPerCell);
-    vector<GLuint>     cellNodeIndicesLinear(maxVertsPerCell);
+    const vector<size_t> &dims = grid->GetDimensions();
+    vector<GLuint>        indices;
+
+    if (dynamic_cast<const StructuredGrid *>(grid)) {
+        size_t totalEdges = 0;
+        for (int axis = 0; axis < dims.size(); axis++) {
+            if (dims[axis] < 2) continue;
+            vector<size_t> edims = dims;
+            edims[axis] -= 1;
+            totalEdges += Wasp::VProduct(edims);
+        }
+        Progress::Start("Generate Connectivity", totalEdges, true);
 
-    size_t numCells = Wasp::VProduct(grid->GetCellDimensions());
-    size_t maxLineIndices = numCells * (layered ? maxVertsPerCell / 2 * 3 : maxVertsPerCell * 2);
+        // Axis aligned edges, one axis at a time
+        //
+        size_t stride = 1;
+        for (int axis = 0; axis < dims.size(); axis++) {
+            if (dims[axis] < 2) {
+                stride *= dims[axis];
+                continue;
+            }
 
-    // Pre-allocate memory for (much) better performance.
-    //
-    vector<unsigned int> indices;
-    indices.reserve(maxLineIndices);
+            // Each node has one edge to its next neighbor along the axis,
+            // so edges can be enumerated directly without duplicates
+            //
+            vector<size_t> edims = dims;
+            edims[axis] -= 1;
+
+            size_t nEdges = Wasp::VProduct(edims);
+            size_t offset = indices.size();
+            indices.resize(offset + 2 * nEdges);
+            GLuint *out = indices.data() + offset;
+
+            bool ok = forEachProgressChunk(nEdges, offset / 2, [&](size_t c0, size_t c1) {
+                Wasp::ParallelFor(c0, c1, 4096, [&](size_t n0, size_t n1) {
+                    Size_tArr3 index = vectorizeIndex(n0, edims);
+                    for (size_t e = n0; e < n1; e++, incrementIndex(index, edims)) {
+                        GLuint idx0 = Wasp::LinearizeCoords(index.data(), dims.data(), dims.size());
+                        out[2 * e] = idx0;
+                        out[2 * e + 1] = idx0 + stride;
+                    }
+                });
+            });
+            if (!ok) return (0);
+
+            stride *= dims[axis];
+        }
+    } else {
+        // Unstructured cells share edges in ways that can't be enumerated
+        // directly. Emit every cell edge, hash partition the edges, and
+        // remove duplicates from each partition in parallel.
+        //
+        vector<size_t> cdims = grid->GetCellDimensions();
+        bool           layered = grid->GetTopologyDim() == 3;
+        size_t         nparts = Wasp::TaskScheduler::Instance().GetNumThreads();
 
-    {
-        // drawList keeps track of line segments that have already been
-        // drawn so that we can avoid duplicates. Avoiding duplicates
-        // reduces the memory requirements substantially
+        size_t nCells = Wasp::VProduct(cdims);
+        Progress::Start("Generate Connectivity", nCells, true);
+
+        // Each emitting part hashes the edges of its cells into nparts
+        // partitions. Edges shared by several cells are emitted once per
+        // cell. Each chunk appends its parts to emitted; duplicates are
+        // removed across all parts, so their order does not matter.
         //
-        DrawList drawList(numNodes, 10);
+        vector<vector<vector<uint64_t>>> emitted;
+        bool                             ok = forEachProgressChunk(nCells, 0, [&](size_t c0, size_t c1) {
+            size_t first = emitted.size();
+            emitted.resize(first + Wasp::NumParts(c1 - c0, 4096), vector<vector<uint64_t>>(nparts));
+            Wasp::ParallelForParts(c0, c1, emitted.size() - first, [&](size_t p, size_t n0, size_t n1) {
+                vector<vector<uint64_t>> &parts = emitted[first + p];
+                vector<Size_tArr3>        cellNodes(grid->GetMaxVertexPerCell());
+                vector<GLuint>            nodes;
+
+                auto emit = [&parts, nparts](GLuint idx0, GLuint idx1) {
+                    if (idx0 == idx1) return;
+                    uint64_t key = edgeKey(idx0, idx1);
+                    parts[edgePartition(key, nparts)].push_back(key);
+                };
+
+                Size_tArr3 cindex = vectorizeIndex(n0, cdims);
+                for (size_t c = n0; c < n1; c++, incrementIndex(cindex, cdims)) {
+                    grid->GetCellNodes(cindex, cellNodes);
+
+                    nodes.resize(cellNodes.size());
+                    for (int i = 0; i < cellNodes.size(); i++) nodes[i] = Wasp::LinearizeCoords(cellNodes[i].data(), dims.data(), dims.size());
+
+                    // If layered the nodes are ordered bottom face first, then top face
+                    //
+                    int count = layered ? nodes.size() / 2 : nodes.size();
+                    for (int i = 0; i < count; i++) emit(nodes[i], nodes[(i + 1) % count]);
+
+                    if (!layered) continue;
+
+                    for (int i = 0; i < count; i++) emit(nodes[i + count], nodes[((i + 1) % count) + count]);
+
+                    // Edges between top and bottom face
+                    //
+                    for (int i = 0; i < count; i++) emit(nodes[i], nodes[i + count]);
+                }
+            });
+        });
+        if (!ok) return (0);
 
-        // Loop over cells, drawing edges of each cell
+        // Gather each partition from every emitting part and remove
+        // duplicates
         //
-        Grid::ConstCellIterator cellItr = grid->ConstCellBegin();
-        Grid::ConstCellIterator cellEnd = grid->ConstCellEnd();
-        Progress::Start("Generate Connectivity", numCells, true);
-        for (int done = 0; cellItr != cellEnd; ++cellItr, ++done) {
-            Progress::Update(done);
-            if (Progress::Cancelled()) return 0;
-
-            grid->GetCellNodes((*cellItr).data(), cellNodeIndices);
-
-            for (int i = 0; i < cellNodeIndices.size(); i++) {
-                int    ndim = grid->GetDimensions().size();
-                size_t idx = Wasp::LinearizeCoords(cellNodeIndices[i].data(), grid->GetDimensions().data(), ndim);
-
-                if (idx > std::numeric_limits<GLuint>::max()) {
-#ifndef NDEBUG
-                    MyBase::SetDiagMsg("WireFrameRenderer() : exceeded numeric limits");
-#endif
-                    continue;
+        vector<vector<uint64_t>> unique(nparts);
+        Wasp::ParallelFor(0, nparts, 1, [&](size_t p0, size_t p1) {
+            for (size_t p = p0; p < p1; p++) {
+                vector<uint64_t> &u = unique[p];
+                for (auto &e : emitted) {
+                    u.insert(u.end(), e[p].begin(), e[p].end());
+                    vector<uint64_t>().swap(e[p]);
                 }
-                cellNodeIndicesLinear[i] = idx;
+                std::sort(u.begin(), u.end());
+                u.erase(std::unique(u.begin(), u.end()), u.end());
+            }
+        });
+
+        size_t nEdges = 0;
+        for (const auto &u : unique) nEdges += u.size();
+        indices.reserve(2 * nEdges);
+        for (const auto &u : unique) {
+            for (uint64_t key : u) {
+                indices.push_back((GLuint)(key >> 32));
+                indices.push_back((GLuint)(key & 0xffffffff));
             }
-
-            _drawCell(cellNodeIndicesLinear.data(), cellNodeIndices.size(), layered, nodeMap, invalidIndex, indices, drawList);
         }
     }
 
+    glBindVertexArray(_VAO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_DYNAMIC_DRAW);
     glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     GLenum err;
@@ -304,14 +366,34 @@ int WireFrameRenderer::_buildCache()
         }
     }
 
-    size_t         numNodes = Wasp::VProduct(grid->GetDimensions());
-    GLuint         invalidIndex = std::numeric_limits<GLuint>::max();
-    vector<GLuint> nodeMap(numNodes, invalidIndex);
+    size_t numNodes = Wasp::VProduct(grid->GetDimensions());
+    if (numNodes > std::numeric_limits<GLuint>::max()) {
+        SetErrMsg("Grid too large for wireframe rendering");
+        delete grid;
+        if (heightGrid) delete heightGrid;
+        return (-1);
+    }
+
+    topology           topo;
+    VAPoR::DC::DataVar dvar;
+    topo.gridType = grid->GetType();
+    if (_dataMgr->GetDataVarInfo(_cacheParams.varName, dvar)) topo.meshName = dvar.GetMeshName();
+    topo.dims = grid->GetDimensions();
+    topo.minAbs = grid->GetMinAbs();
+
     _GPUOutOfMemory = false;
 
-    _buildCacheVertices(grid, heightGrid, nodeMap, &_GPUOutOfMemory);
+    {
+        Wasp::TraceSpan span("WireFrameRenderer vertex cache", "render");
+        _buildCacheVertices(grid, heightGrid, &_GPUOutOfMemory);
+    }
 
-    _nIndices = _buildCacheConnectivity(grid, nodeMap, &_GPUOutOfMemory);
+    if (!_topologyValid || !(topo == _topology)) {
+        Wasp::TraceSpan span("WireFrameRenderer connectivity cache", "render");
+        _nIndices = _buildCacheConnectivity(grid, &_GPUOutOfMemory);
+        _topology = topo;
+        _topologyValid = !_GPUOutOfMemory && !Progress::Cancelled();
+    }
 
     if (grid) delete grid;
     if (heightGrid) delete heightGrid;
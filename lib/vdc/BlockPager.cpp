@@ -0,0 +1,129 @@
+#include <algorithm>
+#include "vapor/VAssert.h"
+#include <vapor/BlockPager.h>
+
+using namespace VAPoR;
+
+BlockPager::BlockPager(size_t nblocks, size_t blockSize, size_t maxResident, Loader loader, float fillValue)
+: _blockSize(blockSize), _maxResident(std::max(maxResident, (size_t)1)), _loader(loader), _fillValue(fillValue), _nresident(0), _peakResident(0), _nloads(0), _nerrors(0)
+{
+    block_t b;
+    b._data = NULL;
+    b._pins = 0;
+    b._loading = false;
+    _blocks.assign(nblocks, b);
+}
+
+BlockPager::~BlockPager()
+{
+    for (auto &b : _blocks) {
+        VAssert(b._pins == 0);
+        if (b._data) delete[] b._data;
+    }
+}
+
+// Evict the least recently used block that is not acquired and return
+// its memory, or return NULL if there is none. Called with _mutex held.
+//
+float *BlockPager::_evict()
+{
+    if (_lru.empty()) return (NULL);
+
+    block_t &b = _blocks[_lru.front()];
+    _lru.pop_front();
+
+    float *data = b._data;
+    b._data = NULL;
+    _nresident--;
+    return (data);
+}
+
+float *BlockPager::Acquire(size_t index)
+{
+    VAssert(index < _blocks.size());
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    block_t &                    b = _blocks[index];
+
+    // Another thread may be loading the same block
+    //
+    _loadedCV.wait(lock, [&b] { return !b._loading; });
+
+    if (b._data) {
+        if (b._pins == 0) _lru.erase(b._lru);
+        b._pins++;
+        return (b._data);
+    }
+
+    // Reuse the memory of an evicted block if the resident set is full.
+    // Acquired blocks can not be evicted, so the set may temporarily
+    // exceed its limit.
+    //
+    float *data = NULL;
+    if (_nresident >= _maxResident) data = _evict();
+    if (!data) data = new float[_blockSize];
+
+    b._pins = 1;
+    b._loading = true;
+    _nresident++;
+    _peakResident = std::max(_peakResident, _nresident);
+    lock.unlock();
+
+    int rc = _loader(index, data);
+    if (rc < 0) std::fill(data, data + _blockSize, _fillValue);
+
+    lock.lock();
+    _nloads++;
+    if (rc < 0) _nerrors++;
+    b._data = data;
+    b._loading = false;
+    _loadedCV.notify_all();
+
+    return (data);
+}
+
+void BlockPager::Release(size_t index)
+{
+    VAssert(index < _blocks.size());
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    block_t &                    b = _blocks[index];
+    VAssert(b._pins > 0);
+
+    if (--b._pins > 0) return;
+
+    b._lru = _lru.insert(_lru.end(), index);
+
+    // Shrink back to the limit once blocks that held the set above it
+    // are released
+    //
+    while (_nresident > _maxResident) {
+        float *data = _evict();
+        if (!data) break;
+        delete[] data;
+    }
+}
+
+BlockPager::BlockRef BlockPager::Get(size_t index)
+{
+    float *data = Acquire(index);
+    return (BlockRef(data, [this, index](float *) { Release(index); }));
+}
+
+size_t BlockPager::GetNumLoads() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return (_nloads);
+}
+
+size_t BlockPager::GetNumLoadErrors() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return (_nerrors);
+}
+
+size_t BlockPager::GetPeakResident() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return (_peakResident);
+}
@@ -347,45 +347,7 @@ void CurvilinearGrid::ConstCoordItrCG::next(const long &offset)
     }
 }
 
-float CurvilinearGrid::GetValueNearestNeighbor(const DblArr3 &coords) const
-{
-    // Clamp coordinates on periodic boundaries to grid extents
-    //
-    DblArr3 cCoords;
-    ClampCoord(coords, cCoords);
-
-    double lambda[4], zwgt[2];
-    size_t i, j, k;
-    double x = cCoords[0];
-    double y = cCoords[1];
-    double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
-    bool   inside = _insideGrid(x, y, z, i, j, k, lambda, zwgt);
-
-    if (!inside) return (GetMissingValue());
-
-    // Find closest point within face
-    //
-    double maxl = lambda[0];
-    int    maxidx = 0;
-    for (int idx = 1; idx < 4; idx++) {
-        if (lambda[idx] > maxl) {
-            maxl = lambda[idx];
-            maxidx = idx;
-        }
-    }
-    if (maxidx == 1) {
-        i++;
-    } else if (maxidx == 2) {
-        i++;
-        j++;
-    } else if (maxidx == 3) {
-        j++;
-    }
-
-    if (zwgt[1] > zwgt[0]) k++;
-
-    return (AccessIJK(i, j, k));
-}
+float CurvilinearGrid::GetValueNearestNeighbor(const DblArr3 &coords) const { return (GetValueWithStencil(coords, 0)); }
 
 namespace {
 
@@ -424,28 +386,67 @@ float interpolateQuad(const float values[4], const double lambda[4], float mv)
 }
 };    // namespace
 
-float CurvilinearGrid::GetValueLinear(const DblArr3 &coords) const
+float CurvilinearGrid::GetValueLinear(const DblArr3 &coords) const { return (GetValueWithStencil(coords, 1)); }
+
+bool CurvilinearGrid::GetInterpolationStencilHelper(const DblArr3 &coords, InterpolationStencil &stencil) const
 {
-    // Clamp coordinates on periodic boundaries to grid extents
-    //
-    DblArr3 cCoords;
-    ClampCoord(coords, cCoords);
+    stencil.order = stencil.order == 0 ? 0 : 1;
 
     // Get Wachspress coordinates for horizontal weights, and
     // simple linear interpolation weights for vertical axis. _insideGrid
     // handlese case where grid is 2D. I.e. if 2d then zwgt[0] == 1 &&
     // zwgt[1] = 0.0
     //
-    double lambda[4], zwgt[2];
-    size_t i, j, k;
-    double x = cCoords[0];
-    double y = cCoords[1];
-    double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
-    bool   inside = _insideGrid(x, y, z, i, j, k, lambda, zwgt);
+    double *lambda = stencil.wgts;
+    double *zwgt = stencil.wgts + 4;
+    size_t  i, j, k;
+    double  x = coords[0];
+    double  y = coords[1];
+    double  z = GetGeometryDim() == 3 ? coords[2] : 0.0;
+
+    stencil.inside = _insideGrid(x, y, z, i, j, k, lambda, zwgt);
+    if (!stencil.inside) return (true);
+
+    // For nearest neighbor the stencil holds the closest node within
+    // the face
+    //
+    if (stencil.order == 0) {
+        double maxl = lambda[0];
+        int    maxidx = 0;
+        for (int idx = 1; idx < 4; idx++) {
+            if (lambda[idx] > maxl) {
+                maxl = lambda[idx];
+                maxidx = idx;
+            }
+        }
+        if (maxidx == 1) {
+            i++;
+        } else if (maxidx == 2) {
+            i++;
+            j++;
+        } else if (maxidx == 3) {
+            j++;
+        }
 
-    float mv = GetMissingValue();
+        if (zwgt[1] > zwgt[0]) k++;
+    }
+
+    stencil.indices = {i, j, k};
+    return (true);
+}
 
-    if (!inside) return (mv);
+float CurvilinearGrid::InterpolateStencilHelper(const InterpolationStencil &stencil) const
+{
+    size_t i = stencil.indices[0];
+    size_t j = stencil.indices[1];
+    size_t k = stencil.indices[2];
+
+    if (stencil.order == 0) return (AccessIJK(i, j, k));
+
+    const double *lambda = stencil.wgts;
+    double        zwgt[2] = {stencil.wgts[4], stencil.wgts[5]};
+
+    float mv = GetMissingValue();
 
     // Use Wachspress coordinates as weights to do linear interpolation
     // along XY plane
@@ -36,6 +36,10 @@ const string maxEdgesDimName = "maxEdges";
 const string maxEdges2DimName = "maxEdges2";
 const string vertexDegreeDimName = "vertexDegree";
 
+// Upper bound on memory held by the mesh variable cache
+//
+const size_t meshVarCacheMaxBytes = 1024 * 1024 * 1024;
+
 const vector<string> requiredDimNames = {timeDimName, nCellsDimName, nVerticesDimName, nEdgesDimName, maxEdgesDimName, maxEdges2DimName, vertexDegreeDimName};
 
 const vector<string> optionalVertDimNames = {nVertLevelsDimName};
@@ -228,6 +232,9 @@ DCMPAS::DCMPAS()
     _pointVars.clear();
     _edgeVars.clear();
     _hasVertical = false;
+    _nEdgesOnCellTS = -1;
+    _coordinatesTS = -1;
+    _meshVarCacheBytes = 0;
 }
 
 DCMPAS::~DCMPAS()
@@ -327,6 +334,11 @@ int DCMPAS::initialize(const vector<string> &files, const std::vector<string> &o
     }
 
     _ncdfc = ncdfc;
+    _nEdgesOnCellTS = -1;
+    _coordinatesTS = -1;
+    _meshVarCache.clear();
+    _meshVarLRU.clear();
+    _meshVarCacheBytes = 0;
 
     return (0);
 }
@@ -538,6 +550,8 @@ int DCMPAS::getDimLensAtLevel(string varname, int, std::vector<size_t> &dims_at_
 //
 int DCMPAS::_read_nEdgesOnCell(size_t ts)
 {
+    if (_isMeshVarCurrent(nEdgesOnCellVarName, _nEdgesOnCellTS, ts)) return (0);
+
     DC::Dimension dimension;
     bool          ok = GetDimension(nCellsDimName, dimension);
     if (!ok) {
@@ -547,13 +561,11 @@ int DCMPAS::_read_nEdgesOnCell(size_t ts)
 
     int *buf = (int *)_nEdgesOnCellBuf.Alloc(dimension.GetLength() * sizeof(*buf));
 
-    int fd = _ncdfc->OpenRead(ts, nEdgesOnCellVarName);
-    if (fd < 0) return (fd);
-
-    int rc = _ncdfc->Read(buf, fd);
-    if (rc < 0) return (fd);
+    int rc = _xgetVar(_ncdfc, ts, nEdgesOnCellVarName, buf);
+    if (rc < 0) return (rc);
 
-    return (_ncdfc->Close(fd));
+    _nEdgesOnCellTS = ts;
+    return (0);
 }
 
 // Read a floating point variable (data or coordinate) into a SmartBuf
@@ -583,12 +595,17 @@ int DCMPAS::_readVarToSmartBuf(size_t ts, string varname, Wasp::SmartBuf &smartB
 //
 int DCMPAS::_readCoordinates(size_t ts)
 {
+    if (_isMeshVarCurrent(lonCellVarName, _coordinatesTS, ts) && _isMeshVarCurrent(lonVertexVarName, _coordinatesTS, ts)) return (0);
+
+    _coordinatesTS = -1;
+
     int rc = _readVarToSmartBuf(ts, lonCellVarName, _lonCellSmartBuf);
     if (rc < 0) return (rc);
 
     rc = _readVarToSmartBuf(ts, lonVertexVarName, _lonVertexSmartBuf);
     if (rc < 0) return (rc);
 
+    _coordinatesTS = ts;
     return (0);
 }
 
@@ -698,6 +715,92 @@ void DCMPAS::_splitOnBoundary(string varname, int *connData) const
     }
 }
 
+// Return true if a mesh variable read for time step cachedTS may be
+// used for time step ts
+//
+bool DCMPAS::_isMeshVarCurrent(string varname, long cachedTS, size_t ts) const
+{
+    if (cachedTS < 0) return (false);
+    return (cachedTS == ts || !_ncdfc->IsTimeVarying(varname));
+}
+
+// Return the contents of an integer mesh variable, reading it if it is
+// not already cached. Connectivity variables are post-processed with
+// _addMissingFlag() and _splitOnBoundary(). Returns NULL on failure.
+//
+std::shared_ptr<const std::vector<int>> DCMPAS::_getMeshVar(size_t ts, string varname)
+{
+    auto itr = _meshVarCache.find(varname);
+    if (itr != _meshVarCache.end() && _isMeshVarCurrent(varname, itr->second.ts, ts)) {
+        _meshVarLRU.remove(varname);
+        _meshVarLRU.push_front(varname);
+        return (itr->second.data);
+    }
+
+    if (varname == verticesOnCellVarName) {
+        if (_read_nEdgesOnCell(ts) < 0) return (NULL);
+    }
+
+    if (is_connectivity_var(varname)) {
+        if (_readCoordinates(ts) < 0) return (NULL);
+    }
+
+    std::shared_ptr<std::vector<int>> data(new std::vector<int>(vproduct(_ncdfc->GetSpatialDims(varname))));
+
+    int rc = _xgetVar(_ncdfc, ts, varname, data->data());
+    if (rc < 0) return (NULL);
+
+    if (varname == verticesOnCellVarName) { _addMissingFlag(data->data()); }
+
+    if (is_connectivity_var(varname)) { _splitOnBoundary(varname, data->data()); }
+
+    // Replace any stale copy, then release least recently used variables
+    // until the cache fits
+    //
+    if (itr != _meshVarCache.end()) {
+        _meshVarCacheBytes -= itr->second.data->size() * sizeof(int);
+        _meshVarLRU.remove(varname);
+    }
+
+    meshVar_t &cached = _meshVarCache[varname];
+    cached.ts = ts;
+    cached.data = data;
+    _meshVarCacheBytes += data->size() * sizeof(int);
+    _meshVarLRU.push_front(varname);
+
+    while (_meshVarCacheBytes > meshVarCacheMaxBytes && _meshVarLRU.size() > 1) {
+        auto victim = _meshVarCache.find(_meshVarLRU.back());
+        _meshVarCacheBytes -= victim->second.data->size() * sizeof(int);
+        _meshVarCache.erase(victim);
+        _meshVarLRU.pop_back();
+    }
+
+    return (data);
+}
+
+int DCMPAS::_readRegionMeshVar(MPASFileObject *w, const vector<size_t> &min, const vector<size_t> &max, int *region)
+{
+    VAssert(min.size() == 1 || min.size() == 2);
+    VAssert(min.size() == max.size());
+
+    std::shared_ptr<const std::vector<int>> meshVar = _getMeshVar(w->GetTS(), w->GetVarname());
+    if (!meshVar) return (-1);
+    const int *data = meshVar->data();
+
+    // Spatial dimensions are ordered slowest to fastest
+    //
+    size_t nx = _ncdfc->GetSpatialDims(w->GetVarname()).back();
+
+    size_t j0 = min.size() == 2 ? min[1] : 0;
+    size_t j1 = max.size() == 2 ? max[1] : 0;
+    for (size_t j = j0; j <= j1; j++) {
+        const int *row = data + j * nx;
+        region = std::copy(row + min[0], row + max[0] + 1, region);
+    }
+
+    return (0);
+}
+
 int DCMPAS::openVariableRead(size_t ts, string varname, int, int)
 {
     int  aux;
@@ -708,16 +811,6 @@ int DCMPAS::openVariableRead(size_t ts, string varname, int, int)
     } else {
         aux = _ncdfc->OpenRead(ts, varname);
         derivedFlag = false;
-
-        // Special handling for some auxiliary variables
-        //
-        if (varname == verticesOnCellVarName) {
-            if (_read_nEdgesOnCell(ts) < 0) return (-1);
-        }
-
-        if (is_connectivity_var(varname)) {
-            if (_readCoordinates(ts) < 0) return (-1);
-        }
     }
 
     MPASFileObject *w = new MPASFileObject(ts, varname, 0, 0, aux, derivedFlag);
@@ -760,9 +853,9 @@ int DCMPAS::_readRegionTransposed(MPASFileObject *w, const vector<size_t> &min,
     vector<size_t> ncdf_count;
     for (int i = 0; i < ncdf_start.size(); i++) { ncdf_count.push_back(ncdf_max[i] - ncdf_start[i] + 1); }
 
-    float *buf = new float[vproduct(ncdf_count)];
-
     if (min.size() == 2) {
+        float *buf = (float *)_transposeBuf.Alloc(vproduct(ncdf_count) * sizeof(*buf));
+
         int rc = _ncdfc->Read(ncdf_start, ncdf_count, buf, aux);
         if (rc < 0) return (-1);
 
@@ -783,15 +876,12 @@ int DCMPAS::_readRegionEdgeVariable(MPASFileObject *w, const vector<size_t> &min
     VAssert(min.size() == 1 || min.size() == 2);
     VAssert(min.size() == max.size());
 
-    vector<size_t> dims = _ncdfc->GetDims(edgesOnVertexVarName);
-    int *          edgesOnVertex = new int[vproduct(dims)];
-    int            rc = _xgetVar(_ncdfc, w->GetTS(), edgesOnVertexVarName, edgesOnVertex);
-    if (rc < 0) {
-        delete[] edgesOnVertex;
-        return (-1);
-    }
+    std::shared_ptr<const std::vector<int>> meshVar = _getMeshVar(w->GetTS(), edgesOnVertexVarName);
+    if (!meshVar) return (-1);
+    const int *edgesOnVertex = meshVar->data();
 
-    size_t vertexDegree = dims[1];
+    vector<size_t> dims = _ncdfc->GetSpatialDims(edgesOnVertexVarName);
+    size_t         vertexDegree = dims[1];
     VAssert(vertexDegree == 3);
 
     string varname = w->GetVarname();
@@ -799,7 +889,7 @@ int DCMPAS::_readRegionEdgeVariable(MPASFileObject *w, const vector<size_t> &min
     // Don't need to reverse dims because we have to do a tranpose anyway
     //
     dims = _ncdfc->GetSpatialDims(varname);
-    float *edgeVariable = new float[vproduct(dims)];
+    float *edgeVariable = (float *)_edgeVarBuf.Alloc(vproduct(dims) * sizeof(*edgeVariable));
 
     vector<size_t> minAll, maxAll;
     for (int i = 0; i < dims.size(); i++) {
@@ -807,12 +897,8 @@ int DCMPAS::_readRegionEdgeVariable(MPASFileObject *w, const vector<size_t> &min
         maxAll.push_back(dims[i] - 1);
     }
 
-    rc = _readRegionTransposed(w, minAll, maxAll, edgeVariable);
-    if (rc < 0) {
-        delete[] edgesOnVertex;
-        delete[] edgeVariable;
-        return (-1);
-    }
+    int rc = _readRegionTransposed(w, minAll, maxAll, edgeVariable);
+    if (rc < 0) return (-1);
 
     size_t j0 = min.size() == 2 ? min[1] : 0;
     size_t j1 = max.size() == 2 ? max[1] : 0;
@@ -828,9 +914,6 @@ int DCMPAS::_readRegionEdgeVariable(MPASFileObject *w, const vector<size_t> &min
         }
     }
 
-    delete[] edgesOnVertex;
-    delete[] edgeVariable;
-
     return (0);
 }
 
@@ -854,6 +937,10 @@ template<class T> int DCMPAS::_readRegionTemplate(int fd, const vector<size_t> &
     } else if (isTransposed(_ncdfc, varname)) {
         VAssert((std::is_same<float *, T *>::value) == true);
         return (_readRegionTransposed(w, min, max, (float *)region));
+
+    } else if (is_connectivity_var(varname)) {
+        VAssert((std::is_same<int *, T *>::value) == true);
+        return (_readRegionMeshVar(w, min, max, (int *)region));
     }
 
     // Need to reverse coordinate ordering for NetCDFCollection API, which
@@ -878,12 +965,6 @@ template<class T> int DCMPAS::_readRegionTemplate(int fd, const vector<size_t> &
     //
     if (is_lat_or_lon(varname)) { rad2degrees((float *)region, max[0] - min[0] + 1); }
 
-    // Special handling for some auxiliary variables
-    //
-    if (varname == verticesOnCellVarName) { _addMissingFlag((int *)region); }
-
-    if (is_connectivity_var(varname)) { _splitOnBoundary(varname, (int *)region); }
-
     return (0);
 }
 
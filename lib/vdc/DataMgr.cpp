@@ -4,16 +4,23 @@
 #include <cstring>
 #include "vapor/VAssert.h"
 #include <cfloat>
+#include <cmath>
 #include <vector>
 #include <map>
+#include <set>
 #include <type_traits>
+#include <vapor/CFuncs.h>
 #include <vapor/GeoUtil.h>
 #include <vapor/VDCNetCDF.h>
 #include <vapor/DCWRF.h>
 #include <vapor/DCCF.h>
 #include <vapor/DCMPAS.h>
 #include <vapor/DerivedVar.h>
+#include <vapor/DerivedExpressionVar.h>
+#include <vapor/BlockPager.h>
+#include <vapor/TaskScheduler.h>
 #include <vapor/DataMgr.h>
+#include <vapor/Trace.h>
 #ifdef WIN32
     #include <float.h>
 #endif
@@ -489,6 +496,30 @@ template<typename T, enable_if_t<std::is_integral<T>::value, int> = 0> void _san
 
 template<typename T> bool contains(const vector<T> &v, T element) { return (find(v.begin(), v.end(), element) != v.end()); }
 
+// Accumulate the wall time spent in the outermost of a set of nested
+// calls. The public GetVariable() methods call each other, so only the
+// first one entered is timed. Nesting is tracked per thread, and the
+// total is updated atomically, so concurrent fetches are safe.
+//
+thread_local int fetchDepth = 0;
+
+class fetch_timer {
+public:
+    fetch_timer(std::atomic<double> &total) : _total(total) { _t0 = fetchDepth++ == 0 ? GetTime() : 0.0; }
+    ~fetch_timer()
+    {
+        if (--fetchDepth > 0) return;
+
+        double dt = GetTime() - _t0;
+        double t = _total.load();
+        while (!_total.compare_exchange_weak(t, t + dt)) {}
+    }
+
+private:
+    std::atomic<double> &_total;
+    double               _t0;
+};
+
 };    // namespace
 
 DataMgr::DataMgr(string format, size_t mem_size, int nthreads)
@@ -519,6 +550,7 @@ DataMgr::DataMgr(string format, size_t mem_size, int nthreads)
     _proj4String.clear();
     _proj4StringDefault.clear();
     _bs = {64, 64, 64};
+    _fetchTime = 0.0;
 }
 
 DataMgr::~DataMgr()
@@ -894,6 +926,7 @@ vector<size_t> DataMgr::GetCRatios(string varname) const
 Grid *DataMgr::GetVariable(size_t ts, string varname, int level, int lod, bool lock)
 {
     SetDiagMsg("DataMgr::GetVariable(%d,%s,%d,%d,%d, %d)", ts, varname.c_str(), level, lod, lock);
+    fetch_timer timer(_fetchTime);
 
     int rc = _level_correction(varname, level);
     if (rc < 0) return (NULL);
@@ -915,6 +948,7 @@ Grid *DataMgr::GetVariable(size_t ts, string varname, int level, int lod, vector
     VAssert(min.size() == max.size());
 
     SetDiagMsg("DataMgr::GetVariable(%d, %s, %d, %d, %s, %s, %d)", ts, varname.c_str(), level, lod, vector_to_string(min).c_str(), vector_to_string(max).c_str(), lock);
+    fetch_timer timer(_fetchTime);
 
     int rc = _level_correction(varname, level);
     if (rc < 0) return (NULL);
@@ -1264,9 +1298,11 @@ Grid *DataMgr::_getVariable(size_t ts, string varname, int level, int lod, vecto
 
         _ugrid_setup(dvar, vertexDims, faceDims, edgeDims, location, maxVertexPerFace, maxFacePerVertex, vertexOffset, faceOffset);
 
+        TraceSpan span("DataMgr grid construction", "data", varname);
         rg = _gridHelper.MakeGridUnstructured(gridType, ts, level, lod, dvar, cvarsinfo, roi_dims, dimsvec[0], blkvec, bsvec, bminvec, bmaxvec, conn_blkvec, conn_bsvec, conn_bminvec, conn_bmaxvec,
                                               vertexDims, faceDims, edgeDims, location, maxVertexPerFace, maxFacePerVertex, vertexOffset, faceOffset);
     } else {
+        TraceSpan span("DataMgr grid construction", "data", varname);
         rg = _gridHelper.MakeGridStructured(gridType, ts, level, lod, dvar, cvarsinfo, roi_dims, dimsvec[0], blkvec, bsvec, bminvec, bmaxvec);
     }
     VAssert(rg);
@@ -1302,6 +1338,8 @@ Grid *DataMgr::GetVariable(size_t ts, string varname, int level, int lod, vector
     VAssert(min.size() == max.size());
 
     SetDiagMsg("DataMgr::GetVariable(%d, %s, %d, %d, %s, %s, %d)", ts, varname.c_str(), level, lod, vector_to_string(min).c_str(), vector_to_string(max).c_str(), lock);
+    fetch_timer timer(_fetchTime);
+    TraceSpan   span("DataMgr::GetVariable", "data", varname);
 
     int rc = _level_correction(varname, level);
     if (rc < 0) return (NULL);
@@ -1329,6 +1367,142 @@ Grid *DataMgr::GetVariable(size_t ts, string varname, int level, int lod, vector
     return (rg);
 }
 
+Grid *DataMgr::GetVariableStreamed(size_t ts, string varname, int level, int lod, size_t max_resident_mb, bool lock)
+{
+    SetDiagMsg("DataMgr::GetVariableStreamed(%d,%s,%d,%d,%d,%d)", ts, varname.c_str(), level, lod, max_resident_mb, lock);
+
+    int rc = _level_correction(varname, level);
+    if (rc < 0) return (NULL);
+
+    rc = _lod_correction(varname, lod);
+    if (rc < 0) return (NULL);
+
+    vector<size_t> dims_at_level;
+    rc = GetDimLensAtLevel(varname, level, dims_at_level);
+    if (rc < 0) {
+        SetErrMsg("Invalid variable reference : %s", varname.c_str());
+        return (NULL);
+    }
+
+    vector<size_t> min(dims_at_level.size(), 0);
+    vector<size_t> max;
+    for (int i = 0; i < dims_at_level.size(); i++) max.push_back(dims_at_level[i] - 1);
+
+    return (_getVariableStreamed(ts, varname, level, lod, min, max, max_resident_mb, lock));
+}
+
+Grid *DataMgr::GetVariableStreamed(size_t ts, string varname, int level, int lod, vector<double> min, vector<double> max, size_t max_resident_mb, bool lock)
+{
+    VAssert(min.size() == max.size());
+
+    SetDiagMsg("DataMgr::GetVariableStreamed(%d, %s, %d, %d, %s, %s, %d, %d)", ts, varname.c_str(), level, lod, vector_to_string(min).c_str(), vector_to_string(max).c_str(), max_resident_mb, lock);
+
+    int rc = _level_correction(varname, level);
+    if (rc < 0) return (NULL);
+
+    rc = _lod_correction(varname, lod);
+    if (rc < 0) return (NULL);
+
+    vector<size_t> min_ui, max_ui;
+    rc = _find_bounding_grid(ts, varname, level, lod, min, max, min_ui, max_ui);
+    if (rc < 0) return (NULL);
+
+    if (!min_ui.size()) return (new RegularGrid());
+
+    return (_getVariableStreamed(ts, varname, level, lod, min_ui, max_ui, max_resident_mb, lock));
+}
+
+bool DataMgr::ExceedsCache(size_t ts, string varname, int level, int lod, vector<double> min, vector<double> max)
+{
+    VAssert(min.size() == max.size());
+
+    if (_level_correction(varname, level) < 0) return (false);
+    if (_lod_correction(varname, lod) < 0) return (false);
+
+    vector<size_t> min_ui, max_ui;
+    int            rc = _find_bounding_grid(ts, varname, level, lod, min, max, min_ui, max_ui);
+    if (rc < 0) return (false);
+
+    double nbytes = sizeof(float);
+    for (int i = 0; i < min_ui.size(); i++) nbytes *= max_ui[i] - min_ui[i] + 1;
+
+    return (nbytes > (double)_mem_size * 1048576.0 / 2.0);
+}
+
+Grid *DataMgr::_getVariableStreamed(size_t ts, string varname, int level, int lod, const vector<size_t> &min, const vector<size_t> &max, size_t max_resident_mb, bool lock)
+{
+    TraceSpan span("DataMgr::GetVariableStreamed", "data", varname);
+
+    // Derived variables are computed from other variables via the
+    // cache, and unstructured grids are not read in blocks
+    //
+    if (_getDerivedVar(varname) || _gridHelper.IsUnstructured(_get_grid_type(varname))) {
+        SetDiagMsg("DataMgr::GetVariableStreamed() - %s is not streamed", varname.c_str());
+        return (GetVariable(ts, varname, level, lod, min, max, lock));
+    }
+
+    if (!VariableExists(ts, varname, level, lod)) {
+        SetErrMsg("Invalid variable reference : %s", varname.c_str());
+        return (NULL);
+    }
+
+    // Read the coordinates only. The data blocks are paged in by the
+    // loader below.
+    //
+    Grid *rg = _getVariable(ts, varname, level, lod, min, max, lock, true);
+    if (!rg) return (NULL);
+
+    vector<size_t> dims, file_dims, file_bs;
+    int            rc = GetDimLensAtLevel(varname, level, dims);
+    VAssert(rc >= 0);
+    rc = GetDimLensAtLevel(varname, level, file_dims, file_bs);
+    VAssert(rc >= 0);
+
+    vector<size_t> bs(_bs.begin(), _bs.begin() + dims.size());
+    vector<size_t> bmin, bmax;
+    map_vox_to_blk(bs, min, bmin);
+    map_vox_to_blk(bs, max, bmax);
+
+    DC::BaseVar var;
+    rc = GetBaseVarInfo(varname, var);
+    VAssert(rc >= 0);
+
+    int    nlods = var.GetCRatios().size();
+    size_t my_ts = IsTimeVarying(varname) ? ts : 0;
+    if (lod < -nlods) lod = -nlods;
+
+    bool blocked = is_blocked(file_bs) && level >= -(int)GetNumRefLevels(varname);
+
+    // Reads go through the DC, which is not thread safe, and use no
+    // cache memory. The loader runs inside ParallelForEach tasks, so the
+    // DC's own parallel decoding must not help run sibling tasks while
+    // _streamMutex is held: such a task could call the loader again on
+    // this thread and deadlock.
+    //
+    auto loader = [this, my_ts, varname, level, lod, dims, bs, bmin, bmax, file_dims, file_bs, blocked](size_t index, float *data) {
+        std::unique_lock<std::mutex>     lock(_streamMutex);
+        Wasp::TaskScheduler::SerialScope serial;
+        TraceSpan                        span("DataMgr page in", "io", varname);
+
+        vector<size_t> bcoord = Wasp::VectorizeCoords(index, bmin, bmax);
+        vector<size_t> grid_min, grid_max;
+        map_blk_to_vox(bs, dims, bcoord, bcoord, grid_min, grid_max);
+
+        if (!blocked) return (_get_unblocked_region_from_fs(my_ts, varname, level, lod, dims, bs, grid_min, grid_max, data));
+        return (_get_blocked_region_from_fs(my_ts, varname, level, lod, file_bs, file_dims, dims, bs, grid_min, grid_max, data));
+    };
+
+    if (!max_resident_mb) max_resident_mb = std::min(std::max(_mem_size / 4, (size_t)1), (size_t)1024);
+
+    size_t blockSize = VProduct(bs);
+    size_t nblocks = VProduct(Dims(bmin, bmax));
+    size_t maxResident = max_resident_mb * 1024 * 1024 / (blockSize * sizeof(float));
+
+    rg->SetBlockPager(std::make_shared<BlockPager>(nblocks, blockSize, maxResident, loader, rg->GetMissingValue()));
+
+    return (rg);
+}
+
 int DataMgr::GetVariableExtents(size_t ts, string varname, int level, int lod, vector<double> &min, vector<double> &max)
 {
     SetDiagMsg("DataMgr::GetVariableExtents(%d, %s, %d, %d)", ts, varname.c_str(), level, lod);
@@ -1432,6 +1606,108 @@ int DataMgr::GetDataRange(size_t ts, string varname, int level, int lod, vector<
     return (0);
 }
 
+int DataMgr::GetProbeTimeSeries(string varname, const vector<vector<double>> &points, size_t ts0, size_t ts1, int level, int lod, vector<vector<float>> &values, float &missing_value)
+{
+    SetDiagMsg("DataMgr::GetProbeTimeSeries(%s, %d, %d, %d, %d)", varname.c_str(), ts0, ts1, level, lod);
+    TraceSpan span("DataMgr::GetProbeTimeSeries", "data", varname);
+
+    values.clear();
+    missing_value = INFINITY;
+
+    if (ts1 < ts0) {
+        SetErrMsg("Invalid time step range (%d, %d)", ts0, ts1);
+        return (-1);
+    }
+
+    DC::DataVar dvar;
+    if (!GetDataVarInfo(varname, dvar)) {
+        SetErrMsg("Invalid variable reference : %s", varname.c_str());
+        return (-1);
+    }
+    if (dvar.GetHasMissing()) missing_value = dvar.GetMissingValue();
+
+    int rc = _level_correction(varname, level);
+    if (rc < 0) return (-1);
+
+    rc = _lod_correction(varname, lod);
+    if (rc < 0) return (-1);
+
+    vector<string> scvars;
+    string         tcvar;
+    bool           ok = _get_coord_vars(varname, scvars, tcvar);
+    if (!ok) return (-1);
+
+    for (int i = 0; i < points.size(); i++) {
+        if (points[i].size() < scvars.size()) {
+            SetErrMsg("Probe point dimension does not match variable %s", varname.c_str());
+            return (-1);
+        }
+    }
+
+    // Block regions only need to be located once unless the coordinates
+    // change with time
+    //
+    bool coordsVary = false;
+    for (int i = 0; i < scvars.size(); i++) {
+        if (IsTimeVarying(scvars[i])) coordsVary = true;
+    }
+
+    values.assign(points.size(), vector<float>(ts1 - ts0 + 1, missing_value));
+
+    // Indices of the probe points contained in each region of blocks
+    //
+    map<pair<vector<size_t>, vector<size_t>>, vector<size_t>> groups;
+
+    for (size_t ts = ts0; ts <= ts1; ts++) {
+        if (ts == ts0 || coordsVary) {
+            groups.clear();
+
+            vector<double> minu, maxu;
+            rc = GetVariableExtents(ts, varname, level, lod, minu, maxu);
+            if (rc < 0) return (-1);
+
+            for (size_t i = 0; i < points.size(); i++) {
+                // Points outside the domain would otherwise map to the
+                // entire grid
+                //
+                bool inside = true;
+                for (int j = 0; j < minu.size(); j++) {
+                    if (points[i][j] < minu[j] || points[i][j] > maxu[j]) inside = false;
+                }
+                if (!inside) continue;
+
+                vector<size_t> min_ui, max_ui;
+                rc = _find_bounding_grid(ts, varname, level, lod, points[i], points[i], min_ui, max_ui);
+                if (rc < 0) return (-1);
+
+                groups[make_pair(min_ui, max_ui)].push_back(i);
+            }
+        }
+
+        for (const auto &g : groups) {
+            set<const void *> cached;
+            for (const region_t &region : _regionsList) cached.insert(region.blks);
+
+            Grid *rg = GetVariable(ts, varname, level, lod, g.first.first, g.first.second, false);
+            if (!rg) return (-1);
+
+            for (size_t i : g.second) values[i][ts - ts0] = rg->GetValue(points[i]);
+            delete rg;
+
+            // Release the time-varying regions this read added to the
+            // cache. They will not be needed for any later time step.
+            //
+            vector<region_t> added;
+            for (const region_t &region : _regionsList) {
+                if (!cached.count(region.blks) && region.lock_counter == 0 && IsTimeVarying(region.varname)) added.push_back(region);
+            }
+            for (const region_t &region : added) _free_region(region.ts, region.varname, region.level, region.lod, region.bmin, region.bmax);
+        }
+    }
+
+    return (0);
+}
+
 int DataMgr::GetDimLensAtLevel(string varname, int level, std::vector<size_t> &dims_at_level, std::vector<size_t> &bs_at_level) const
 {
     VAssert(_dc);
@@ -1623,14 +1899,45 @@ int DataMgr::AddDerivedVar(DerivedDataVar *derivedVar)
     return (0);
 }
 
+int DataMgr::AddExpressionVar(string varname, string expression, string mesh, string units)
+{
+    VAssert(_dc);
+
+    DC::BaseVar bvar;
+    if (GetBaseVarInfo(varname, bvar)) {
+        SetErrMsg("Variable named %s already defined", varname.c_str());
+        return (-1);
+    }
+
+    DerivedExpressionVar *var = new DerivedExpressionVar(varname, this, expression, mesh, units, _nthreads);
+    int                   rc = var->Initialize();
+    if (rc < 0) {
+        delete var;
+        SetErrMsg("Failed to initialize derived variable %s", varname.c_str());
+        return (-1);
+    }
+
+    rc = AddDerivedVar(var);
+    if (rc < 0) {
+        delete var;
+        return (-1);
+    }
+    _expressionVarNames.insert(varname);
+
+    return (0);
+}
+
 void DataMgr::RemoveDerivedVar(string varname)
 {
     if (!_dvm.HasVar(varname)) return;
 
-    _dvm.RemoveVar(_dvm.GetVar(varname));
+    DerivedVar *var = _dvm.GetVar(varname);
+    _dvm.RemoveVar(var);
 
     _free_var(varname);
 
+    if (_expressionVarNames.erase(varname)) delete var;
+
     //
     // Clear variable name cache
     //
@@ -1897,7 +2204,13 @@ T *DataMgr::_get_region(size_t ts, string varname, int level, int lod, int nlods
     // file system.
     //
     T *blks = _get_region_from_cache<T>(ts, varname, level, lod, bmin, bmax, lock);
-    if (!blks) { blks = (T *)_get_region_from_fs<T>(ts, varname, level, lod, dims, bs, bmin, bmax, lock); }
+    if (blks) {
+        Trace::Count("DataMgr cache hits");
+    } else {
+        Trace::Count("DataMgr cache misses");
+        TraceSpan span("DataMgr read region", "io", varname);
+        blks = (T *)_get_region_from_fs<T>(ts, varname, level, lod, dims, bs, bmin, bmax, lock);
+    }
     if (!blks) {
         SetErrMsg("Failed to read region from variable/timestep/level/lod (%s, %d, %d, %d)", varname.c_str(), ts, level, lod);
         return (NULL);
@@ -3174,6 +3487,14 @@ int DataMgr::_initHorizontalCoordVars()
 
     vector<string> meshnames = _dc->GetMeshNames();
 
+    // The X and Y coordinates of every mesh share a cache of projected
+    // coordinates, so that a single transform serves both axes. Its keys
+    // include the lat-lon variable names, so meshes do not collide. The
+    // cache may use an eighth of the DataMgr's memory.
+    //
+    size_t                                                   cacheBytes = _mem_size / 8 * 1024 * 1024;
+    std::shared_ptr<DerivedCoordVar_PCSFromLatLon::PCSCache> cache = std::make_shared<DerivedCoordVar_PCSFromLatLon::PCSCache>(cacheBytes);
+
     vector<string> coordvars;
     for (int i = 0; i < meshnames.size(); i++) {
         if (!_hasHorizontalXForm(meshnames[i])) continue;
@@ -3193,7 +3514,7 @@ int DataMgr::_initHorizontalCoordVars()
         // no duplicates
         //
         if (!_getDerivedCoordVar(derivedCoordvars[0])) {
-            DerivedCoordVar_PCSFromLatLon *derivedVar = new DerivedCoordVar_PCSFromLatLon(derivedCoordvars[0], _dc, coordvars, _proj4String, m.GetMeshType() != DC::Mesh::STRUCTURED, true);
+            DerivedCoordVar_PCSFromLatLon *derivedVar = new DerivedCoordVar_PCSFromLatLon(derivedCoordvars[0], _dc, coordvars, _proj4String, m.GetMeshType() != DC::Mesh::STRUCTURED, true, cache);
 
             rc = derivedVar->Initialize();
             if (rc < 0) {
@@ -3205,7 +3526,7 @@ int DataMgr::_initHorizontalCoordVars()
         }
 
         if (!_getDerivedCoordVar(derivedCoordvars[1])) {
-            DerivedCoordVar_PCSFromLatLon *derivedVar = new DerivedCoordVar_PCSFromLatLon(derivedCoordvars[1], _dc, coordvars, _proj4String, m.GetMeshType() != DC::Mesh::STRUCTURED, false);
+            DerivedCoordVar_PCSFromLatLon *derivedVar = new DerivedCoordVar_PCSFromLatLon(derivedCoordvars[1], _dc, coordvars, _proj4String, m.GetMeshType() != DC::Mesh::STRUCTURED, false, cache);
 
             rc = derivedVar->Initialize();
             if (rc < 0) {
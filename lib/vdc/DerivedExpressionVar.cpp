@@ -0,0 +1,949 @@
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <vapor/utils.h>
+#include <vapor/TaskScheduler.h>
+#include <vapor/DataMgr.h>
+#include <vapor/DerivedExpressionVar.h>
+
+using namespace VAPoR;
+using namespace Wasp;
+
+namespace {
+
+typedef DerivedExpressionVar::Instruction Instruction;
+typedef DerivedExpressionVar::OpCode      OpCode;
+
+const float missingValue = std::numeric_limits<float>::infinity();
+
+//
+// Element-wise kernels. Each is applied to a whole row at a time so that
+// the loops may be vectorized by the compiler. They are also used with a
+// row length of one to fold constant expressions at compile time.
+//
+template<class F> void unaryRow(size_t n, const float *a, float *d, F f)
+{
+    for (size_t i = 0; i < n; i++) d[i] = f(a[i]);
+}
+
+template<class F> void binaryRow(size_t n, const float *a, const float *b, float *d, F f)
+{
+    for (size_t i = 0; i < n; i++) d[i] = f(a[i], b[i]);
+}
+
+// Comparisons, logical operators, min() and max() map NaN operands to
+// finite values, so these variants test for NaN explicitly in order to
+// propagate missing values
+//
+template<class F> void unaryRowNaN(size_t n, const float *a, float *d, F f)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (size_t i = 0; i < n; i++) d[i] = std::isnan(a[i]) ? nan : f(a[i]);
+}
+
+template<class F> void binaryRowNaN(size_t n, const float *a, const float *b, float *d, F f)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (size_t i = 0; i < n; i++) d[i] = (std::isnan(a[i]) || std::isnan(b[i])) ? nan : f(a[i], b[i]);
+}
+
+void applyUnary(OpCode op, size_t n, const float *a, float *d)
+{
+    switch (op) {
+    case DerivedExpressionVar::OP_NEG: unaryRow(n, a, d, [](float x) { return -x; }); break;
+    case DerivedExpressionVar::OP_NOT: unaryRowNaN(n, a, d, [](float x) { return x == 0.0f ? 1.0f : 0.0f; }); break;
+    case DerivedExpressionVar::OP_ABS: unaryRow(n, a, d, [](float x) { return std::fabs(x); }); break;
+    case DerivedExpressionVar::OP_SQRT: unaryRow(n, a, d, [](float x) { return std::sqrt(x); }); break;
+    case DerivedExpressionVar::OP_EXP: unaryRow(n, a, d, [](float x) { return std::exp(x); }); break;
+    case DerivedExpressionVar::OP_LOG: unaryRow(n, a, d, [](float x) { return std::log(x); }); break;
+    case DerivedExpressionVar::OP_LOG10: unaryRow(n, a, d, [](float x) { return std::log10(x); }); break;
+    case DerivedExpressionVar::OP_SIN: unaryRow(n, a, d, [](float x) { return std::sin(x); }); break;
+    case DerivedExpressionVar::OP_COS: unaryRow(n, a, d, [](float x) { return std::cos(x); }); break;
+    case DerivedExpressionVar::OP_TAN: unaryRow(n, a, d, [](float x) { return std::tan(x); }); break;
+    case DerivedExpressionVar::OP_ASIN: unaryRow(n, a, d, [](float x) { return std::asin(x); }); break;
+    case DerivedExpressionVar::OP_ACOS: unaryRow(n, a, d, [](float x) { return std::acos(x); }); break;
+    case DerivedExpressionVar::OP_ATAN: unaryRow(n, a, d, [](float x) { return std::atan(x); }); break;
+    case DerivedExpressionVar::OP_FLOOR: unaryRow(n, a, d, [](float x) { return std::floor(x); }); break;
+    case DerivedExpressionVar::OP_CEIL: unaryRow(n, a, d, [](float x) { return std::ceil(x); }); break;
+    default: VAssert(0); break;
+    }
+}
+
+void applyBinary(OpCode op, size_t n, const float *a, const float *b, float *d)
+{
+    switch (op) {
+    case DerivedExpressionVar::OP_ADD: binaryRow(n, a, b, d, [](float x, float y) { return x + y; }); break;
+    case DerivedExpressionVar::OP_SUB: binaryRow(n, a, b, d, [](float x, float y) { return x - y; }); break;
+    case DerivedExpressionVar::OP_MUL: binaryRow(n, a, b, d, [](float x, float y) { return x * y; }); break;
+    case DerivedExpressionVar::OP_DIV: binaryRow(n, a, b, d, [](float x, float y) { return x / y; }); break;
+    case DerivedExpressionVar::OP_POW: binaryRow(n, a, b, d, [](float x, float y) { return std::pow(x, y); }); break;
+    case DerivedExpressionVar::OP_ATAN2: binaryRow(n, a, b, d, [](float x, float y) { return std::atan2(x, y); }); break;
+    case DerivedExpressionVar::OP_MIN: binaryRowNaN(n, a, b, d, [](float x, float y) { return std::min(x, y); }); break;
+    case DerivedExpressionVar::OP_MAX: binaryRowNaN(n, a, b, d, [](float x, float y) { return std::max(x, y); }); break;
+    case DerivedExpressionVar::OP_LT: binaryRowNaN(n, a, b, d, [](float x, float y) { return x < y ? 1.0f : 0.0f; }); break;
+    case DerivedExpressionVar::OP_LE: binaryRowNaN(n, a, b, d, [](float x, float y) { return x <= y ? 1.0f : 0.0f; }); break;
+    case DerivedExpressionVar::OP_GT: binaryRowNaN(n, a, b, d, [](float x, float y) { return x > y ? 1.0f : 0.0f; }); break;
+    case DerivedExpressionVar::OP_GE: binaryRowNaN(n, a, b, d, [](float x, float y) { return x >= y ? 1.0f : 0.0f; }); break;
+    case DerivedExpressionVar::OP_EQ: binaryRowNaN(n, a, b, d, [](float x, float y) { return x == y ? 1.0f : 0.0f; }); break;
+    case DerivedExpressionVar::OP_NE: binaryRowNaN(n, a, b, d, [](float x, float y) { return x != y ? 1.0f : 0.0f; }); break;
+    case DerivedExpressionVar::OP_AND: binaryRowNaN(n, a, b, d, [](float x, float y) { return (x != 0.0f && y != 0.0f) ? 1.0f : 0.0f; }); break;
+    case DerivedExpressionVar::OP_OR: binaryRowNaN(n, a, b, d, [](float x, float y) { return (x != 0.0f || y != 0.0f) ? 1.0f : 0.0f; }); break;
+    default: VAssert(0); break;
+    }
+}
+
+// A NaN condition selects neither operand, so it yields NaN
+//
+void applyWhere(size_t n, const float *c, const float *a, const float *b, float *d)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (size_t i = 0; i < n; i++) d[i] = std::isnan(c[i]) ? nan : (c[i] != 0.0f ? a[i] : b[i]);
+}
+
+struct function_t {
+    const char *name;
+    OpCode      op;
+    int         nargs;
+};
+
+const function_t functions[] = {
+    {"abs", DerivedExpressionVar::OP_ABS, 1},     {"sqrt", DerivedExpressionVar::OP_SQRT, 1},   {"exp", DerivedExpressionVar::OP_EXP, 1},
+    {"log", DerivedExpressionVar::OP_LOG, 1},     {"log10", DerivedExpressionVar::OP_LOG10, 1}, {"sin", DerivedExpressionVar::OP_SIN, 1},
+    {"cos", DerivedExpressionVar::OP_COS, 1},     {"tan", DerivedExpressionVar::OP_TAN, 1},     {"asin", DerivedExpressionVar::OP_ASIN, 1},
+    {"acos", DerivedExpressionVar::OP_ACOS, 1},   {"atan", DerivedExpressionVar::OP_ATAN, 1},   {"floor", DerivedExpressionVar::OP_FLOOR, 1},
+    {"ceil", DerivedExpressionVar::OP_CEIL, 1},   {"atan2", DerivedExpressionVar::OP_ATAN2, 2}, {"pow", DerivedExpressionVar::OP_POW, 2},
+    {"min", DerivedExpressionVar::OP_MIN, 2},     {"max", DerivedExpressionVar::OP_MAX, 2},     {"where", DerivedExpressionVar::OP_WHERE, 3},
+    {"ddx", DerivedExpressionVar::OP_DDX, -1},    {"ddy", DerivedExpressionVar::OP_DDY, -1},    {"ddz", DerivedExpressionVar::OP_DDZ, -1},
+    {"vsum", DerivedExpressionVar::OP_VSUM, -1},  {"vmean", DerivedExpressionVar::OP_VMEAN, -1}, {"vmin", DerivedExpressionVar::OP_VMIN, -1},
+    {"vmax", DerivedExpressionVar::OP_VMAX, -1},
+};
+
+bool isStencil(OpCode op) { return (op == DerivedExpressionVar::OP_DDX || op == DerivedExpressionVar::OP_DDY || op == DerivedExpressionVar::OP_DDZ); }
+
+bool isReduction(OpCode op)
+{
+    return (op == DerivedExpressionVar::OP_VSUM || op == DerivedExpressionVar::OP_VMEAN || op == DerivedExpressionVar::OP_VMIN || op == DerivedExpressionVar::OP_VMAX);
+}
+
+// The value of a compiled sub-expression: either a constant known at
+// compile time, or a register computed at run time
+//
+class operand_t {
+public:
+    operand_t() : _isConst(true), _value(0.0), _reg(-1) {}
+
+    bool  _isConst;
+    float _value;
+    int   _reg;
+};
+
+// Recursive descent compiler. Emits instructions directly while parsing,
+// folding operations whose operands are all constant.
+//
+class compiler_c {
+public:
+    compiler_c(const string &expr, vector<Instruction> &program, vector<string> &inNames, vector<bool> &inReduced, vector<bool> &inStencil)
+    : _expr(expr), _pos(0), _program(program), _inNames(inNames), _inReduced(inReduced), _inStencil(inStencil), _numRegisters(0)
+    {
+    }
+
+    // Returns false and sets the error message on failure
+    //
+    bool Compile(int &result, int &numRegisters)
+    {
+        operand_t o;
+        if (!parseOr(o)) return (false);
+
+        skipSpace();
+        if (_pos != _expr.size()) return (error("unexpected character"));
+
+        if (o._isConst) {
+            _err = "expression must reference at least one variable";
+            return (false);
+        }
+        result = o._reg;
+        numRegisters = _numRegisters;
+        return (true);
+    }
+
+    string GetError() const { return (_err); }
+
+private:
+    const string &        _expr;
+    size_t                _pos;
+    vector<Instruction> & _program;
+    vector<string> &      _inNames;
+    vector<bool> &        _inReduced;
+    vector<bool> &        _inStencil;
+    int                   _numRegisters;
+    string                _err;
+
+    bool error(const string &msg)
+    {
+        std::ostringstream oss;
+        oss << msg << " at position " << _pos;
+        _err = oss.str();
+        return (false);
+    }
+
+    void skipSpace()
+    {
+        while (_pos < _expr.size() && isspace((unsigned char)_expr[_pos])) _pos++;
+    }
+
+    bool accept(const char *tok)
+    {
+        skipSpace();
+        size_t len = strlen(tok);
+        if (_expr.compare(_pos, len, tok) != 0) return (false);
+
+        // Don't mistake "<=" for "<", etc.
+        //
+        if (len == 1 && _pos + 1 < _expr.size() && _expr[_pos + 1] == '=' && strchr("<>=!", tok[0])) return (false);
+
+        _pos += len;
+        return (true);
+    }
+
+    // Materialize an operand in a register
+    //
+    int reg(const operand_t &o)
+    {
+        if (!o._isConst) return (o._reg);
+
+        Instruction instr(DerivedExpressionVar::OP_CONST, _numRegisters++);
+        instr._value = o._value;
+        _program.push_back(instr);
+        return (instr._dst);
+    }
+
+    void emitUnary(OpCode op, operand_t &o)
+    {
+        if (o._isConst) {
+            float v = o._value;
+            applyUnary(op, 1, &v, &o._value);
+            return;
+        }
+        Instruction instr(op, _numRegisters++, o._reg);
+        _program.push_back(instr);
+        o._reg = instr._dst;
+    }
+
+    void emitBinary(OpCode op, operand_t &lhs, const operand_t &rhs)
+    {
+        if (lhs._isConst && rhs._isConst) {
+            float v = lhs._value;
+            applyBinary(op, 1, &v, &rhs._value, &lhs._value);
+            return;
+        }
+        Instruction instr(op, _numRegisters++, reg(lhs), reg(rhs));
+        _program.push_back(instr);
+        lhs._isConst = false;
+        lhs._reg = instr._dst;
+    }
+
+    int addInput(const string &name, bool reduced, bool stencil)
+    {
+        vector<string>::iterator itr = std::find(_inNames.begin(), _inNames.end(), name);
+        int                      index = itr - _inNames.begin();
+        if (itr == _inNames.end()) {
+            _inNames.push_back(name);
+            _inReduced.push_back(reduced);
+            _inStencil.push_back(stencil);
+        } else {
+            if (_inReduced[index] != reduced) return (-1);
+            _inStencil[index] = _inStencil[index] || stencil;
+        }
+        return (index);
+    }
+
+    bool parseName(string &name)
+    {
+        skipSpace();
+        name.clear();
+        if (_pos < _expr.size() && _expr[_pos] == '\'') {
+            size_t end = _expr.find('\'', _pos + 1);
+            if (end == string::npos) return (error("unterminated quoted name"));
+            name = _expr.substr(_pos + 1, end - _pos - 1);
+            _pos = end + 1;
+            return (true);
+        }
+        while (_pos < _expr.size() && (isalnum((unsigned char)_expr[_pos]) || _expr[_pos] == '_')) { name += _expr[_pos++]; }
+        if (name.empty()) return (error("expected name"));
+        return (true);
+    }
+
+    bool parseOr(operand_t &o)
+    {
+        if (!parseAnd(o)) return (false);
+        while (accept("||")) {
+            operand_t rhs;
+            if (!parseAnd(rhs)) return (false);
+            emitBinary(DerivedExpressionVar::OP_OR, o, rhs);
+        }
+        return (true);
+    }
+
+    bool parseAnd(operand_t &o)
+    {
+        if (!parseCompare(o)) return (false);
+        while (accept("&&")) {
+            operand_t rhs;
+            if (!parseCompare(rhs)) return (false);
+            emitBinary(DerivedExpressionVar::OP_AND, o, rhs);
+        }
+        return (true);
+    }
+
+    bool parseCompare(operand_t &o)
+    {
+        if (!parseAdd(o)) return (false);
+
+        const struct {
+            const char *tok;
+            OpCode      op;
+        } ops[] = {{"<=", DerivedExpressionVar::OP_LE}, {">=", DerivedExpressionVar::OP_GE}, {"==", DerivedExpressionVar::OP_EQ},
+                   {"!=", DerivedExpressionVar::OP_NE}, {"<", DerivedExpressionVar::OP_LT},  {">", DerivedExpressionVar::OP_GT}};
+
+        for (int i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+            if (accept(ops[i].tok)) {
+                operand_t rhs;
+                if (!parseAdd(rhs)) return (false);
+                emitBinary(ops[i].op, o, rhs);
+                break;
+            }
+        }
+        return (true);
+    }
+
+    bool parseAdd(operand_t &o)
+    {
+        if (!parseMul(o)) return (false);
+        for (;;) {
+            OpCode op;
+            if (accept("+"))
+                op = DerivedExpressionVar::OP_ADD;
+            else if (accept("-"))
+                op = DerivedExpressionVar::OP_SUB;
+            else
+                break;
+
+            operand_t rhs;
+            if (!parseMul(rhs)) return (false);
+            emitBinary(op, o, rhs);
+        }
+        return (true);
+    }
+
+    bool parseMul(operand_t &o)
+    {
+        if (!parseUnary(o)) return (false);
+        for (;;) {
+            OpCode op;
+            if (accept("*"))
+                op = DerivedExpressionVar::OP_MUL;
+            else if (accept("/"))
+                op = DerivedExpressionVar::OP_DIV;
+            else
+                break;
+
+            operand_t rhs;
+            if (!parseUnary(rhs)) return (false);
+            emitBinary(op, o, rhs);
+        }
+        return (true);
+    }
+
+    bool parseUnary(operand_t &o)
+    {
+        if (accept("-")) {
+            if (!parseUnary(o)) return (false);
+            emitUnary(DerivedExpressionVar::OP_NEG, o);
+            return (true);
+        }
+        if (accept("+")) return (parseUnary(o));
+        if (accept("!")) {
+            if (!parseUnary(o)) return (false);
+            emitUnary(DerivedExpressionVar::OP_NOT, o);
+            return (true);
+        }
+        return (parsePower(o));
+    }
+
+    // Exponentiation is right associative and binds tighter than unary
+    // minus, i.e. -2^2 == -4
+    //
+    bool parsePower(operand_t &o)
+    {
+        if (!parsePrimary(o)) return (false);
+        if (accept("^")) {
+            operand_t rhs;
+            if (!parseUnary(rhs)) return (false);
+            emitBinary(DerivedExpressionVar::OP_POW, o, rhs);
+        }
+        return (true);
+    }
+
+    bool parseNumber(operand_t &o)
+    {
+        const char *start = _expr.c_str() + _pos;
+        char *      end;
+        double      v = strtod(start, &end);
+        if (end == start) return (error("expected number"));
+
+        _pos += end - start;
+        o._isConst = true;
+        o._value = v;
+        return (true);
+    }
+
+    bool parseFunction(const function_t &f, operand_t &o)
+    {
+        // Stencils and reductions operate directly on input variables
+        //
+        if (f.nargs < 0) {
+            string name;
+            if (!parseName(name)) return (false);
+            if (!accept(")")) return (error("expected ')'"));
+
+            int input = addInput(name, isReduction(f.op), isStencil(f.op));
+            if (input < 0) return (error("variable " + name + " may not be both reduced and not reduced"));
+
+            Instruction instr(f.op, _numRegisters++);
+            instr._input = input;
+            _program.push_back(instr);
+            o._isConst = false;
+            o._reg = instr._dst;
+            return (true);
+        }
+
+        vector<operand_t> args;
+        for (int i = 0; i < f.nargs; i++) {
+            if (i > 0 && !accept(",")) return (error("expected ','"));
+            operand_t arg;
+            if (!parseOr(arg)) return (false);
+            args.push_back(arg);
+        }
+        if (!accept(")")) return (error("expected ')'"));
+
+        o = args[0];
+        if (f.nargs == 1) {
+            emitUnary(f.op, o);
+        } else if (f.nargs == 2) {
+            emitBinary(f.op, o, args[1]);
+        } else if (args[0]._isConst && !std::isnan(args[0]._value)) {
+            o = args[0]._value != 0.0f ? args[1] : args[2];
+        } else {
+            Instruction instr(f.op, _numRegisters++, reg(args[0]), reg(args[1]), reg(args[2]));
+            _program.push_back(instr);
+            o._isConst = false;
+            o._reg = instr._dst;
+        }
+        return (true);
+    }
+
+    bool parsePrimary(operand_t &o)
+    {
+        skipSpace();
+        if (_pos >= _expr.size()) return (error("unexpected end of expression"));
+
+        char c = _expr[_pos];
+        if (isdigit((unsigned char)c) || c == '.') return (parseNumber(o));
+
+        if (accept("(")) {
+            if (!parseOr(o)) return (false);
+            if (!accept(")")) return (error("expected ')'"));
+            return (true);
+        }
+
+        bool   quoted = c == '\'';
+        string name;
+        if (!parseName(name)) return (false);
+
+        if (!quoted && accept("(")) {
+            for (int i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+                if (name == functions[i].name) return (parseFunction(functions[i], o));
+            }
+            return (error("unknown function " + name));
+        }
+
+        int input = addInput(name, false, false);
+        if (input < 0) return (error("variable " + name + " may not be both reduced and not reduced"));
+
+        Instruction instr(DerivedExpressionVar::OP_LOAD, _numRegisters++);
+        instr._input = input;
+        _program.push_back(instr);
+        o._isConst = false;
+        o._reg = instr._dst;
+        return (true);
+    }
+};
+
+// Input variable data for a region, padded to three dimensions. Missing
+// values are replaced with NaN so that they propagate through the
+// expression
+//
+class input_t {
+public:
+    vector<float> _data;
+    vector<float> _coords[3];
+    size_t        _dims[3];
+    size_t        _minAbs[3];
+
+    size_t offset(size_t i, size_t j, size_t k) const { return (i + _dims[0] * (j + _dims[1] * k)); }
+};
+
+int readInput(DataMgr *dataMgr, size_t ts, const string &name, int level, int lod, const vector<size_t> &min, const vector<size_t> &max, bool coordsFlag, input_t &input)
+{
+    Grid *g = dataMgr->GetVariable(ts, name, level, lod, min, max, false);
+    if (!g) return (-1);
+
+    vector<size_t> dims = g->GetDimensions();
+    vector<size_t> minAbs = g->GetMinAbs();
+    for (int i = 0; i < 3; i++) {
+        input._dims[i] = i < dims.size() ? dims[i] : 1;
+        input._minAbs[i] = i < minAbs.size() ? minAbs[i] : 0;
+    }
+
+    // The input is copied into a dense array, with missing values
+    // replaced by NaN, so that rows can be addressed directly
+    //
+    input._data.resize(VProduct(dims));
+
+    float *     dptr = input._data.data();
+    float       mv = g->GetMissingValue();
+    bool        hasMissing = g->HasMissingData();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    size_t      nx = input._dims[0];
+    size_t      ny = input._dims[1];
+    g->ParallelForEach([&](int, const Grid::Span &span) {
+        float *dst = dptr + span.index[0] + nx * (span.index[1] + ny * span.index[2]);
+        for (size_t i = 0; i < span.n; i++) dst[i] = (hasMissing && span.data[i] == mv) ? nan : span.data[i];
+    });
+
+    if (coordsFlag) {
+        for (int i = 0; i < dims.size(); i++) input._coords[i].resize(input._data.size());
+
+        size_t               idx = 0;
+        Grid::ConstCoordItr  citr = g->ConstCoordBegin();
+        Grid::ConstCoordItr  cenditr = g->ConstCoordEnd();
+        for (; citr != cenditr; ++citr, ++idx) {
+            const vector<double> &c = *citr;
+            for (int i = 0; i < dims.size() && i < c.size(); i++) input._coords[i][idx] = c[i];
+        }
+    }
+
+    delete g;
+    return (0);
+}
+
+// Centered finite difference along axis, one-sided at the boundary
+//
+void stencilRow(const input_t &in, int axis, size_t base, size_t pos0, size_t n, float *d)
+{
+    const float *v = in._data.data();
+    const float *c = in._coords[axis].data();
+    size_t       stride = axis == 0 ? 1 : (axis == 1 ? in._dims[0] : in._dims[0] * in._dims[1]);
+    size_t       last = in._dims[axis] - 1;
+
+    for (size_t i = 0; i < n; i++) {
+        size_t idx = base + i;
+        size_t pos = axis == 0 ? pos0 + i : pos0;
+        size_t im = pos > 0 ? idx - stride : idx;
+        size_t ip = pos < last ? idx + stride : idx;
+
+        float dc = c[ip] - c[im];
+        d[i] = dc != 0.0f ? (v[ip] - v[im]) / dc : 0.0f;
+    }
+}
+
+// Reduction along the last axis of a variable with one more dimension
+// than the output. Missing values are ignored.
+//
+void reduceRow(const input_t &in, OpCode op, int axis, size_t base, size_t n, float *d, vector<float> &count)
+{
+    const float *v = in._data.data();
+    size_t       stride = axis == 1 ? in._dims[0] : in._dims[0] * in._dims[1];
+    size_t       nk = in._dims[axis];
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    std::fill(d, d + n, op == DerivedExpressionVar::OP_VSUM || op == DerivedExpressionVar::OP_VMEAN ? 0.0f : nan);
+    std::fill(count.begin(), count.begin() + n, 0.0f);
+
+    for (size_t k = 0; k < nk; k++) {
+        const float *vk = v + base + k * stride;
+        for (size_t i = 0; i < n; i++) {
+            float x = vk[i];
+            if (std::isnan(x)) continue;
+
+            count[i] += 1.0f;
+            if (op == DerivedExpressionVar::OP_VMIN)
+                d[i] = std::isnan(d[i]) ? x : std::min(d[i], x);
+            else if (op == DerivedExpressionVar::OP_VMAX)
+                d[i] = std::isnan(d[i]) ? x : std::max(d[i], x);
+            else
+                d[i] += x;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (count[i] == 0.0f)
+            d[i] = nan;
+        else if (op == DerivedExpressionVar::OP_VMEAN)
+            d[i] /= count[i];
+    }
+}
+
+// Per-thread evaluation state. Each thread evaluates a contiguous range
+// of rows (runs of elements along the first axis) of the output region
+//
+class eval_state {
+public:
+    const vector<Instruction> *_program;
+    const vector<input_t> *    _inputs;
+    const vector<bool> *       _inReduced;
+    int                        _numRegisters;
+    int                        _result;
+    size_t                     _rank;
+    size_t                     _min[3];
+    size_t                     _max[3];
+    size_t                     _row0;
+    size_t                     _row1;
+    float *                    _region;
+};
+
+void evalRows(const eval_state *s)
+{
+    const vector<Instruction> &program = *s->_program;
+    const vector<input_t> &    inputs = *s->_inputs;
+
+    size_t nx = s->_max[0] - s->_min[0] + 1;
+    size_t ny = s->_max[1] - s->_min[1] + 1;
+
+    // Register storage. Loads reference input data directly, so only
+    // the register pointers are updated for them.
+    //
+    vector<float>         storage((size_t)s->_numRegisters * nx);
+    vector<const float *> regs(s->_numRegisters);
+    vector<float>         count(nx);
+    for (int r = 0; r < s->_numRegisters; r++) regs[r] = storage.data() + r * nx;
+
+    for (int p = 0; p < program.size(); p++) {
+        const Instruction &instr = program[p];
+        if (instr._op == DerivedExpressionVar::OP_CONST) std::fill(storage.begin() + instr._dst * nx, storage.begin() + (instr._dst + 1) * nx, instr._value);
+    }
+
+    for (size_t row = s->_row0; row < s->_row1; row++) {
+        size_t j = s->_min[1] + row % ny;
+        size_t k = s->_min[2] + row / ny;
+
+        for (int p = 0; p < program.size(); p++) {
+            const Instruction &instr = program[p];
+            float *            d = storage.data() + instr._dst * nx;
+
+            if (instr._input >= 0) {
+                const input_t &in = inputs[instr._input];
+                size_t         i0 = s->_min[0] - in._minAbs[0];
+                size_t         j0 = j - in._minAbs[1];
+
+                if ((*s->_inReduced)[instr._input]) {
+                    int axis = (int)s->_rank;
+                    reduceRow(in, instr._op, axis, in.offset(i0, j0, 0), nx, d, count);
+                    regs[instr._dst] = d;
+                    continue;
+                }
+
+                size_t k0 = k - in._minAbs[2];
+                size_t base = in.offset(i0, j0, k0);
+                if (instr._op == DerivedExpressionVar::OP_LOAD) {
+                    regs[instr._dst] = in._data.data() + base;
+                } else {
+                    int    axis = instr._op - DerivedExpressionVar::OP_DDX;
+                    size_t pos0 = axis == 0 ? i0 : (axis == 1 ? j0 : k0);
+                    stencilRow(in, axis, base, pos0, nx, d);
+                    regs[instr._dst] = d;
+                }
+                continue;
+            }
+
+            switch (instr._op) {
+            case DerivedExpressionVar::OP_CONST: break;
+            case DerivedExpressionVar::OP_WHERE: applyWhere(nx, regs[instr._a], regs[instr._b], regs[instr._c], d); break;
+            default:
+                if (instr._b < 0)
+                    applyUnary(instr._op, nx, regs[instr._a], d);
+                else
+                    applyBinary(instr._op, nx, regs[instr._a], regs[instr._b], d);
+                break;
+            }
+        }
+
+        const float *src = regs[s->_result];
+        float *      dst = s->_region + row * nx;
+        for (size_t i = 0; i < nx; i++) dst[i] = std::isfinite(src[i]) ? src[i] : missingValue;
+    }
+}
+};    // namespace
+
+DerivedExpressionVar::DerivedExpressionVar(string varName, DataMgr *dataMgr, string expression, string mesh, string units, int nthreads)
+: DerivedDataVar(varName), _varInfo(varName, units, DC::XType::FLOAT, "", std::vector<size_t>(), std::vector<bool>(), mesh, "", DC::Mesh::NODE)
+{
+    VAssert(dataMgr != NULL);
+
+    _dataMgr = dataMgr;
+    _expression = expression;
+    _mesh = mesh;
+    _units = units;
+
+    if (nthreads < 1) nthreads = Wasp::TaskScheduler::Instance().GetNumThreads();
+    if (nthreads < 1) nthreads = 1;
+    _nthreads = nthreads;
+
+    _numRegisters = 0;
+    _result = -1;
+    _rank = 0;
+}
+
+int DerivedExpressionVar::Initialize()
+{
+    int rc = _compile();
+    if (rc < 0) return (-1);
+
+    return (_setupVar());
+}
+
+int DerivedExpressionVar::_compile()
+{
+    _inNames.clear();
+    _inReduced.clear();
+    _inStencil.clear();
+    _program.clear();
+
+    compiler_c compiler(_expression, _program, _inNames, _inReduced, _inStencil);
+    if (!compiler.Compile(_result, _numRegisters)) {
+        SetErrMsg("Invalid expression \"%s\" : %s", _expression.c_str(), compiler.GetError().c_str());
+        return (-1);
+    }
+
+    return (0);
+}
+
+int DerivedExpressionVar::_setupVar()
+{
+    // Validate inputs, and find a reference variable, preferably one that
+    // is not reduced, from which the output dimensions are derived
+    //
+    _refVar.clear();
+    bool refReduced = true;
+    for (int i = 0; i < _inNames.size(); i++) {
+        DC::DataVar dvar;
+        if (!_dataMgr->GetDataVarInfo(_inNames[i], dvar)) {
+            SetErrMsg("Invalid expression \"%s\" : unknown variable %s", _expression.c_str(), _inNames[i].c_str());
+            return (-1);
+        }
+
+        if (_refVar.empty() || (refReduced && !_inReduced[i])) {
+            _refVar = _inNames[i];
+            refReduced = _inReduced[i];
+        }
+    }
+    VAssert(!_refVar.empty());
+
+    DC::DataVar refInfo;
+    bool        ok = _dataMgr->GetDataVarInfo(_refVar, refInfo);
+    VAssert(ok);
+
+    if (_mesh.empty()) {
+        if (refReduced) {
+            SetErrMsg("A mesh must be specified when all variables are reduced");
+            return (-1);
+        }
+        _mesh = refInfo.GetMeshName();
+    }
+
+    DC::Mesh m;
+    if (!_dataMgr->GetMesh(_mesh, m)) {
+        SetErrMsg("Invalid mesh : %s", _mesh.c_str());
+        return (-1);
+    }
+    _rank = m.GetDimNames().size();
+
+    // Derivatives are only defined along the axes of the mesh
+    //
+    for (int p = 0; p < _program.size(); p++) {
+        if (!isStencil(_program[p]._op)) continue;
+
+        int axis = _program[p]._op - OP_DDX;
+        if (axis >= (int)_rank) {
+            SetErrMsg("Invalid expression \"%s\" : %s requires a mesh with at least %d dimensions, mesh %s has %d", _expression.c_str(), axis == 1 ? "ddy" : "ddz", axis + 1, _mesh.c_str(), (int)_rank);
+            return (-1);
+        }
+    }
+
+    for (int i = 0; i < _inNames.size(); i++) {
+        DC::DataVar dvar;
+        ok = _dataMgr->GetDataVarInfo(_inNames[i], dvar);
+        VAssert(ok);
+
+        size_t rank = _dataMgr->GetNumDimensions(_inNames[i]);
+        if (_inReduced[i]) {
+            if (rank != _rank + 1 || rank < 2) {
+                SetErrMsg("Reduced variable %s must have one more dimension than mesh %s", _inNames[i].c_str(), _mesh.c_str());
+                return (-1);
+            }
+        } else if (dvar.GetMeshName() != _mesh) {
+            SetErrMsg("Variable %s is not sampled on mesh %s", _inNames[i].c_str(), _mesh.c_str());
+            return (-1);
+        }
+
+        if (_varInfo.GetTimeCoordVar().empty() && !dvar.GetTimeCoordVar().empty()) _varInfo.SetTimeCoordVar(dvar.GetTimeCoordVar());
+    }
+
+    _varInfo.SetMeshName(_mesh);
+    _varInfo.SetHasMissing(true);
+    _varInfo.SetMissingValue(missingValue);
+    if (!refReduced) _varInfo.SetCRatios(refInfo.GetCRatios());
+
+    return (0);
+}
+
+bool DerivedExpressionVar::GetBaseVarInfo(DC::BaseVar &var) const
+{
+    var = _varInfo;
+    return (true);
+}
+
+bool DerivedExpressionVar::GetDataVarInfo(DC::DataVar &cvar) const
+{
+    cvar = _varInfo;
+    return (true);
+}
+
+int DerivedExpressionVar::GetDimLensAtLevel(int level, std::vector<size_t> &dims_at_level, std::vector<size_t> &bs_at_level) const
+{
+    int rc = _dataMgr->GetDimLensAtLevel(_refVar, level, dims_at_level);
+    if (rc < 0) return (-1);
+
+    // A reduced reference variable has an extra (last) dimension
+    //
+    dims_at_level.resize(_rank);
+
+    // No blocking
+    //
+    bs_at_level = vector<size_t>(dims_at_level.size(), 1);
+
+    return (0);
+}
+
+size_t DerivedExpressionVar::GetNumRefLevels() const
+{
+    size_t n = _dataMgr->GetNumRefLevels(_refVar);
+    for (int i = 0; i < _inNames.size(); i++) n = std::min(n, _dataMgr->GetNumRefLevels(_inNames[i]));
+
+    return (n);
+}
+
+int DerivedExpressionVar::OpenVariableRead(size_t ts, int level, int lod)
+{
+    DC::FileTable::FileObject *f = new DC::FileTable::FileObject(ts, _derivedVarName, level, lod);
+
+    return (_fileTable.AddEntry(f));
+}
+
+int DerivedExpressionVar::CloseVariable(int fd)
+{
+    DC::FileTable::FileObject *f = _fileTable.GetEntry(fd);
+
+    if (!f) {
+        SetErrMsg("Invalid file descriptor : %d", fd);
+        return (-1);
+    }
+
+    _fileTable.RemoveEntry(fd);
+    delete f;
+    return (0);
+}
+
+int DerivedExpressionVar::ReadRegion(int fd, const std::vector<size_t> &min, const std::vector<size_t> &max, float *region)
+{
+    DC::FileTable::FileObject *f = _fileTable.GetEntry(fd);
+
+    if (!f) {
+        SetErrMsg("Invalid file descriptor : %d", fd);
+        return (-1);
+    }
+
+    size_t ts = f->GetTS();
+    int    level = f->GetLevel();
+    int    lod = f->GetLOD();
+
+    VAssert(min.size() == _rank && max.size() == _rank);
+
+    // Read each input over the requested region. Stencils need a one
+    // element halo, and reductions the entire extent of the reduced axis.
+    //
+    vector<input_t> inputs(_inNames.size());
+    for (int i = 0; i < _inNames.size(); i++) {
+        vector<size_t> dims;
+        int            rc = _dataMgr->GetDimLensAtLevel(_inNames[i], level, dims);
+        if (rc < 0) return (-1);
+
+        vector<size_t> inMin = min;
+        vector<size_t> inMax = max;
+        if (_inReduced[i]) {
+            inMin.push_back(0);
+            inMax.push_back(dims[_rank] - 1);
+        } else if (_inStencil[i]) {
+            for (int j = 0; j < _rank; j++) {
+                if (inMin[j] > 0) inMin[j]--;
+                if (inMax[j] < dims[j] - 1) inMax[j]++;
+            }
+        }
+
+        rc = readInput(_dataMgr, ts, _inNames[i], level, lod, inMin, inMax, _inStencil[i], inputs[i]);
+        if (rc < 0) {
+            SetErrMsg("Failed to read variable %s", _inNames[i].c_str());
+            return (-1);
+        }
+    }
+
+    eval_state state;
+    state._program = &_program;
+    state._inputs = &inputs;
+    state._inReduced = &_inReduced;
+    state._numRegisters = _numRegisters;
+    state._result = _result;
+    state._rank = _rank;
+    state._region = region;
+    for (int i = 0; i < 3; i++) {
+        state._min[i] = i < _rank ? min[i] : 0;
+        state._max[i] = i < _rank ? max[i] : 0;
+    }
+
+    size_t nrows = (state._max[1] - state._min[1] + 1) * (state._max[2] - state._min[2] + 1);
+
+    // Each part allocates its own registers, so parts are limited to the
+    // thread count rather than split finely
+    //
+    size_t nparts = std::min(std::min((size_t)_nthreads, nrows), Wasp::NumParts(nrows, 1));
+    Wasp::ParallelForParts(0, nrows, nparts, [&state](size_t, size_t r0, size_t r1) {
+        eval_state s = state;
+        s._row0 = r0;
+        s._row1 = r1;
+        evalRows(&s);
+    });
+
+    return (0);
+}
+
+bool DerivedExpressionVar::VariableExists(size_t ts, int reflevel, int lod) const
+{
+    for (int i = 0; i < _inNames.size(); i++) {
+        if (!_dataMgr->VariableExists(ts, _inNames[i], reflevel, lod)) { return (false); }
+    }
+    return (true);
+}
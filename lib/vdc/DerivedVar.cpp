@@ -485,7 +485,8 @@ int DerivedVar::_getVarBlock(DC *dc, size_t ts, string varname, int level, int l
 //
 //////////////////////////////////////////////////////////////////////////////
 
-DerivedCoordVar_PCSFromLatLon::DerivedCoordVar_PCSFromLatLon(string derivedVarName, DC *dc, vector<string> inNames, string proj4String, bool uGridFlag, bool lonFlag) : DerivedCoordVar(derivedVarName)
+DerivedCoordVar_PCSFromLatLon::DerivedCoordVar_PCSFromLatLon(string derivedVarName, DC *dc, vector<string> inNames, string proj4String, bool uGridFlag, bool lonFlag, std::shared_ptr<PCSCache> cache)
+: DerivedCoordVar(derivedVarName)
 {
     VAssert(inNames.size() == 2);
 
@@ -497,6 +498,52 @@ DerivedCoordVar_PCSFromLatLon::DerivedCoordVar_PCSFromLatLon(string derivedVarNa
     _uGridFlag = uGridFlag;
     _lonFlag = lonFlag;
     _dimLens.clear();
+    _timeVarying = true;
+
+    // A private cache holds at most the coordinates of a few large
+    // regions
+    //
+    _cache = cache ? cache : std::make_shared<PCSCache>(256 * 1024 * 1024);
+}
+
+bool DerivedCoordVar_PCSFromLatLon::PCSCache::Get(const string &key, bool xFlag, float *region, size_t n)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto itr = _entries.begin(); itr != _entries.end(); ++itr) {
+        if (itr->first != key) continue;
+
+        const vector<float> &v = xFlag ? itr->second->x : itr->second->y;
+        if (v.size() != n) return (false);
+
+        std::copy(v.begin(), v.end(), region);
+        _entries.splice(_entries.begin(), _entries, itr);
+        return (true);
+    }
+    return (false);
+}
+
+void DerivedCoordVar_PCSFromLatLon::PCSCache::Insert(const string &key, std::unique_ptr<PCSCoords> coords)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto itr = _entries.begin(); itr != _entries.end(); ++itr) {
+        if (itr->first != key) continue;
+        _bytes -= _size(*itr->second);
+        _entries.erase(itr);
+        break;
+    }
+
+    size_t size = _size(*coords);
+    if (size > _maxBytes) return;
+
+    while (!_entries.empty() && _bytes + size > _maxBytes) {
+        _bytes -= _size(*_entries.back().second);
+        _entries.pop_back();
+    }
+
+    _entries.emplace_front(key, std::move(coords));
+    _bytes += size;
 }
 
 int DerivedCoordVar_PCSFromLatLon::Initialize()
@@ -596,103 +643,64 @@ int DerivedCoordVar_PCSFromLatLon::_readRegionHelperCylindrical(DC::FileTable::F
     return (rc);
 }
 
-int DerivedCoordVar_PCSFromLatLon::_readRegionHelper1D(DC::FileTable::FileObject *f, const vector<size_t> &min, const vector<size_t> &max, float *region)
+int DerivedCoordVar_PCSFromLatLon::_readRegionHelper1D(DC::FileTable::FileObject *f, const vector<size_t> &min, const vector<size_t> &max, float *lonBuf, float *latBuf)
 {
     size_t ts = f->GetTS();
-    string varname = f->GetVarname();
     int    lod = f->GetLOD();
 
-    // Need temporary buffer space for the X or Y coordinate
-    // NOT being returned (we still need to calculate it)
-    //
-    size_t nElements = numElements(min, max);
-    float *buf = new float[nElements];
-
     vector<size_t> roidims;
     for (int i = 0; i < min.size(); i++) { roidims.push_back(max[i] - min[i] + 1); }
 
-    // Assign temporary buffer 'buf' as appropriate
-    //
-    float *lonBufPtr;
-    float *latBufPtr;
-    if (_lonFlag) {
-        lonBufPtr = region;
-        latBufPtr = buf;
-    } else {
-        lonBufPtr = buf;
-        latBufPtr = region;
-    }
-
     // Reading 1D data so no blocking
     //
     vector<size_t> lonMin = {min[0]};
     vector<size_t> lonMax = {max[0]};
-    int            rc = _getVar(_dc, ts, _lonName, -1, lod, lonMin, lonMax, lonBufPtr);
-    if (rc < 0) {
-        delete[] buf;
-        return (rc);
-    }
+    int            rc = _getVar(_dc, ts, _lonName, -1, lod, lonMin, lonMax, lonBuf);
+    if (rc < 0) return (rc);
 
     vector<size_t> latMin = {min[1]};
     vector<size_t> latMax = {max[1]};
-    rc = _getVar(_dc, ts, _latName, -1, lod, latMin, latMax, latBufPtr);
-    if (rc < 0) {
-        delete[] buf;
-        return (rc);
-    }
+    rc = _getVar(_dc, ts, _latName, -1, lod, latMin, latMax, latBuf);
+    if (rc < 0) return (rc);
 
     // Combine the 2 1D arrays into a 2D array
     //
-    make2D(lonBufPtr, latBufPtr, roidims);
+    make2D(lonBuf, latBuf, roidims);
 
-    rc = _proj4API.Transform(lonBufPtr, latBufPtr, vproduct(roidims));
-
-    delete[] buf;
-
-    return (rc);
+    return (_proj4API.Transform(lonBuf, latBuf, vproduct(roidims)));
 }
 
-int DerivedCoordVar_PCSFromLatLon::_readRegionHelper2D(DC::FileTable::FileObject *f, const vector<size_t> &min, const vector<size_t> &max, float *region)
+int DerivedCoordVar_PCSFromLatLon::_readRegionHelper2D(DC::FileTable::FileObject *f, const vector<size_t> &min, const vector<size_t> &max, float *lonBuf, float *latBuf)
 {
     size_t ts = f->GetTS();
-    string varname = f->GetVarname();
     int    lod = f->GetLOD();
 
-    // Need temporary buffer space for the X or Y coordinate
-    // NOT being returned (we still need to calculate it)
-    //
     size_t nElements = numElements(min, max);
-    float *buf = new float[nElements];
 
-    // Assign temporary buffer 'buf' as appropriate
-    //
-    float *lonBufPtr;
-    float *latBufPtr;
-    if (_lonFlag) {
-        lonBufPtr = region;
-        latBufPtr = buf;
-    } else {
-        lonBufPtr = buf;
-        latBufPtr = region;
-    }
+    int rc = _getVar(_dc, ts, _lonName, -1, lod, min, max, lonBuf);
+    if (rc < 0) return (rc);
 
-    int rc = _getVar(_dc, ts, _lonName, -1, lod, min, max, lonBufPtr);
-    if (rc < 0) {
-        delete[] buf;
-        return (rc);
-    }
+    rc = _getVar(_dc, ts, _latName, -1, lod, min, max, latBuf);
+    if (rc < 0) return (rc);
 
-    rc = _getVar(_dc, ts, _latName, -1, lod, min, max, latBufPtr);
-    if (rc < 0) {
-        delete[] buf;
-        return (rc);
-    }
+    return (_proj4API.Transform(lonBuf, latBuf, nElements));
+}
 
-    rc = _proj4API.Transform(lonBufPtr, latBufPtr, nElements);
+string DerivedCoordVar_PCSFromLatLon::_cacheKey(size_t ts, int lod, const vector<size_t> &min, const vector<size_t> &max) const
+{
+    ostringstream oss;
+    oss << _lonName << " " << _latName << " " << _proj4String << " ";
 
-    delete[] buf;
+    // Time invariant coordinates are shared by all time steps
+    //
+    oss << (_timeVarying ? (long)ts : -1L) << " " << lod;
 
-    return (rc);
+    // Cylindrical projections are computed separately for each axis
+    //
+    if (min.size() == 1) oss << (_lonFlag ? " x" : " y");
+
+    for (int i = 0; i < min.size(); i++) { oss << " " << min[i] << ":" << max[i]; }
+    return (oss.str());
 }
 
 int DerivedCoordVar_PCSFromLatLon::ReadRegion(int fd, const vector<size_t> &min, const vector<size_t> &max, float *region)
@@ -704,20 +712,40 @@ int DerivedCoordVar_PCSFromLatLon::ReadRegion(int fd, const vector<size_t> &min,
         return (-1);
     }
 
+    string key = _cacheKey(f->GetTS(), f->GetLOD(), min, max);
+
+    size_t nElements = numElements(min, max);
+    if (_cache->Get(key, _lonFlag, region, nElements)) return (0);
+
+    std::unique_ptr<PCSCoords> coords(new PCSCoords());
+    int                        rc;
+
     if (min.size() == 1) {
         // Lat and Lon are 1D variables
         //
-        return (_readRegionHelperCylindrical(f, min, max, region));
+        rc = _readRegionHelperCylindrical(f, min, max, region);
+        if (rc == 0) (_lonFlag ? coords->x : coords->y).assign(region, region + nElements);
     } else {
+        coords->x.resize(nElements);
+        coords->y.resize(nElements);
         if (_make2DFlag) {
             // Lat and Lon are 1D variables but projections to PCS
             // result in X and Y coordinate variables that are 2D
             //
-            return (_readRegionHelper1D(f, min, max, region));
+            rc = _readRegionHelper1D(f, min, max, coords->x.data(), coords->y.data());
         } else {
-            return (_readRegionHelper2D(f, min, max, region));
+            rc = _readRegionHelper2D(f, min, max, coords->x.data(), coords->y.data());
+        }
+        if (rc == 0) {
+            const vector<float> &v = _lonFlag ? coords->x : coords->y;
+            std::copy(v.begin(), v.end(), region);
         }
     }
+
+    if (rc < 0) return (rc);
+
+    _cache->Insert(key, std::move(coords));
+    return (0);
 }
 
 bool DerivedCoordVar_PCSFromLatLon::VariableExists(size_t ts, int, int) const { return (_dc->VariableExists(ts, _lonName, -1, -1) && _dc->VariableExists(ts, _latName, -1, -1)); }
@@ -791,6 +819,7 @@ int DerivedCoordVar_PCSFromLatLon::_setupVar()
         return (-1);
     }
     string timeDimName = lonVar.GetTimeDimName();
+    _timeVarying = !timeDimName.empty();
 
     DC::XType    xtype = lonVar.GetXType();
     vector<bool> periodic = lonVar.GetPeriodic();
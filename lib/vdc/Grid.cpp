@@ -15,6 +15,8 @@
 #endif
 
 #include <vapor/utils.h>
+#include <vapor/TaskScheduler.h>
+#include <vapor/BlockPager.h>
 #include <vapor/Grid.h>
 
 using namespace std;
@@ -69,8 +71,27 @@ void Grid::GetUserExtents(DblArr3 &minu, DblArr3 &maxu) const
     maxu = _maxuCache;
 }
 
+void Grid::SetBlockPager(const std::shared_ptr<BlockPager> &pager)
+{
+    VAssert(_blks.empty());
+    VAssert(pager->GetNumBlocks() == std::accumulate(_bdims.begin(), _bdims.end(), 1, std::multiplies<size_t>()));
+    VAssert(pager->GetBlockSize() == _bs[0] * _bs[1] * _bs[2]);
+
+    _pager = pager;
+    _blks = vector<float *>(pager->GetNumBlocks(), NULL);
+}
+
 float Grid::GetValueAtIndex(const Size_tArr3 &indices) const
 {
+    if (_pager) {
+        size_t blk, offset;
+        _getBlockOffset(indices, blk, offset);
+
+        float v = _pager->Acquire(blk)[offset];
+        _pager->Release(blk);
+        return (v);
+    }
+
     float *fptr = GetValuePtrAtIndex(_blks, indices);
     if (!fptr) return (GetMissingValue());
     return (*fptr);
@@ -83,10 +104,8 @@ void Grid::SetValue(const Size_tArr3 &indices, float v)
     *fptr = v;
 }
 
-float *Grid::GetValuePtrAtIndex(const std::vector<float *> &blks, const Size_tArr3 &indices) const
+void Grid::_getBlockOffset(const Size_tArr3 &indices, size_t &blk, size_t &offset) const
 {
-    if (!blks.size()) return (NULL);
-
     Size_tArr3 cIndices;
     ClampIndex(indices, cIndices);
 
@@ -98,8 +117,21 @@ float *Grid::GetValuePtrAtIndex(const std::vector<float *> &blks, const Size_tAr
     size_t y = cIndices[1] % _bs[1];
     size_t z = cIndices[2] % _bs[2];
 
-    float *blk = blks[zb * _bdims[0] * _bdims[1] + yb * _bdims[0] + xb];
-    return (&blk[z * _bs[0] * _bs[1] + y * _bs[0] + x]);
+    blk = zb * _bdims[0] * _bdims[1] + yb * _bdims[0] + xb;
+    offset = z * _bs[0] * _bs[1] + y * _bs[0] + x;
+}
+
+float *Grid::GetValuePtrAtIndex(const std::vector<float *> &blks, const Size_tArr3 &indices) const
+{
+    if (!blks.size()) return (NULL);
+
+    size_t blk, offset;
+    _getBlockOffset(indices, blk, offset);
+
+    // Blocks of a paged grid are not addressable
+    //
+    if (!blks[blk]) return (NULL);
+    return (&blks[blk][offset]);
 }
 
 float Grid::AccessIJK(size_t i, size_t j, size_t k) const
@@ -114,76 +146,217 @@ void Grid::SetValueIJK(size_t i, size_t j, size_t k, float v)
     return (SetValue(indices, v));
 }
 
-void Grid::GetRange(float range[2]) const
+namespace {
+
+class span_state {
+public:
+    const std::vector<float *> *_blks;
+    BlockPager *                _pager;
+    Size_tArr3                  _bs;
+    Size_tArr3                  _bdims;
+    Size_tArr3                  _min;
+    Size_tArr3                  _max;
+    size_t                      _r0;    // First row, or block of a paged grid
+    size_t                      _r1;    // One past last row or block
+    int                         _id;
+    const std::function<void(int, const Grid::Span &)> *_fn;
+};
+
+// Walk the blocks [_r0, _r1) of the box, enumerated with the first axis
+// varying fastest, acquiring each block once
+//
+void *runBlockSpanThread(span_state *s)
 {
-    float               missingValue = GetMissingValue();
-    Grid::ConstIterator itr = this->cbegin();
-    Grid::ConstIterator enditr = this->cend();
+    const Size_tArr3 &bs = s->_bs;
+    const Size_tArr3 &bdims = s->_bdims;
 
-    // Edge case: all values are missing values.
-    //
-    range[0] = range[1] = missingValue;
-    while (*itr == missingValue && itr != enditr) { ++itr; }
-    if (itr == enditr) return;
-
-    range[0] = *itr;
-    range[1] = range[0];
-    while (itr != enditr) {
-        if (*itr < range[0] && *itr != missingValue)
-            range[0] = *itr;
-        else if (*itr > range[1] && *itr != missingValue)
-            range[1] = *itr;
-        ++itr;
+    Size_tArr3 bmin, nb;
+    for (int i = 0; i < 3; i++) {
+        bmin[i] = s->_min[i] / bs[i];
+        nb[i] = s->_max[i] / bs[i] - bmin[i] + 1;
     }
+
+    Grid::Span span;
+    for (size_t b = s->_r0; b < s->_r1; b++) {
+        size_t xb = bmin[0] + b % nb[0];
+        size_t yb = bmin[1] + (b / nb[0]) % nb[1];
+        size_t zb = bmin[2] + b / (nb[0] * nb[1]);
+
+        size_t i0 = std::max(s->_min[0], xb * bs[0]);
+        size_t i1 = std::min(s->_max[0], xb * bs[0] + bs[0] - 1);
+        size_t j0 = std::max(s->_min[1], yb * bs[1]);
+        size_t j1 = std::min(s->_max[1], yb * bs[1] + bs[1] - 1);
+        size_t k0 = std::max(s->_min[2], zb * bs[2]);
+        size_t k1 = std::min(s->_max[2], zb * bs[2] + bs[2] - 1);
+
+        size_t       blk = zb * bdims[0] * bdims[1] + yb * bdims[0] + xb;
+        const float *data = s->_pager->Acquire(blk);
+
+        for (size_t k = k0; k <= k1; k++) {
+            for (size_t j = j0; j <= j1; j++) {
+                span.data = data + (k % bs[2]) * bs[0] * bs[1] + (j % bs[1]) * bs[0] + (i0 % bs[0]);
+                span.n = i1 - i0 + 1;
+                span.index = {i0, j, k};
+                (*s->_fn)(s->_id, span);
+            }
+        }
+
+        s->_pager->Release(blk);
+    }
+    return (0);
 }
 
-void Grid::GetRange(const Size_tArr3 &min, const Size_tArr3 &max, float range[2]) const
+// Walk the rows [_r0, _r1) of the box, splitting each row at block
+// boundaries
+//
+void *runSpanThread(void *arg)
 {
-    Size_tArr3 cMin;
-    ClampIndex(min, cMin);
+    span_state *s = (span_state *)arg;
+    if (s->_pager) return (runBlockSpanThread(s));
 
-    Size_tArr3 cMax;
-    ClampIndex(max, cMax);
+    const Size_tArr3 &bs = s->_bs;
+    const Size_tArr3 &bdims = s->_bdims;
+    size_t            ny = s->_max[1] - s->_min[1] + 1;
 
-    const vector<size_t> &dims = GetDimensions();
+    Grid::Span span;
+    for (size_t r = s->_r0; r < s->_r1; r++) {
+        size_t j = s->_min[1] + r % ny;
+        size_t k = s->_min[2] + r / ny;
 
-    float mv = GetMissingValue();
+        size_t blkOffset = (k / bs[2]) * bdims[0] * bdims[1] + (j / bs[1]) * bdims[0];
+        size_t rowOffset = (k % bs[2]) * bs[0] * bs[1] + (j % bs[1]) * bs[0];
+
+        for (size_t i = s->_min[0]; i <= s->_max[0];) {
+            size_t xb = i / bs[0];
+            size_t n = std::min(s->_max[0] + 1, (xb + 1) * bs[0]) - i;
+
+            span.data = (*s->_blks)[blkOffset + xb] + rowOffset + (i % bs[0]);
+            span.n = n;
+            span.index = {i, j, k};
+            (*s->_fn)(s->_id, span);
+
+            i += n;
+        }
+    }
+    return (0);
+}
+
+};    // namespace
 
-    range[0] = range[1] = mv;
+int Grid::GetNumThreads(int nthreads)
+{
+    if (nthreads < 1) nthreads = Wasp::TaskScheduler::Instance().GetNumThreads();
+    return (std::max(1, nthreads));
+}
+
+void Grid::ParallelForEach(const Size_tArr3 &min, const Size_tArr3 &max, const std::function<void(int, const Span &)> &fn, int nthreads) const
+{
+    if (!_blks.size()) return;
+
+    Size_tArr3 cMin, cMax;
+    ClampIndex(GetDimensions(), min, cMin);
+    ClampIndex(GetDimensions(), max, cMax);
+    for (int i = 0; i < 3; i++) {
+        if (cMin[i] > cMax[i]) return;
+    }
 
-    size_t jmin = 0;
-    size_t jmax = 0;
-    if (dims.size() > 1) {
-        jmin = cMin[1];
-        jmax = cMax[1];
+    span_state proto;
+    proto._blks = &_blks;
+    proto._pager = _pager.get();
+    proto._bs = _bs;
+    proto._bdims = _bdims;
+    proto._min = cMin;
+    proto._max = cMax;
+    proto._id = 0;
+    proto._fn = &fn;
+
+    size_t nrows = (cMax[1] - cMin[1] + 1) * (cMax[2] - cMin[2] + 1);
+    size_t nvalues = nrows * (cMax[0] - cMin[0] + 1);
+
+    // Paged grids are divided among threads by blocks rather than rows
+    //
+    if (_pager) {
+        nrows = 1;
+        for (int i = 0; i < 3; i++) nrows *= cMax[i] / _bs[i] - cMin[i] / _bs[i] + 1;
     }
 
-    size_t kmin = 0;
-    size_t kmax = 0;
-    if (dims.size() > 2) {
-        kmin = cMin[2];
-        kmax = cMax[2];
+    // Callers size per-thread state with GetNumThreads(), so never use
+    // more slots than it reports. Small boxes, such as the handful of
+    // rows of a coordinate block, are cheaper to process serially than
+    // to hand to the scheduler. Loading a paged block always outweighs
+    // the cost of a task.
+    //
+    const size_t minParallelValues = 1 << 16;
+    int          nslots = (int)std::min((size_t)GetNumThreads(nthreads), nrows);
+    if (!_pager && nvalues < minParallelValues) nslots = 1;
+
+    if (nslots < 2) {
+        proto._r0 = 0;
+        proto._r1 = nrows;
+        runSpanThread(&proto);
+        return;
     }
 
-    bool first = true;
-    for (size_t k = kmin; k <= kmax; k++) {
-        for (size_t j = jmin; j <= jmax; j++) {
-            for (size_t i = cMin[0]; i <= cMax[0]; i++) {
-                float v = AccessIJK(i, j, k);
-                if (first && v != mv) {
-                    range[0] = range[1] = v;
-                    first = false;
-                }
-
-                if (!first) {
-                    if (v < range[0] && v != mv)
-                        range[0] = v;
-                    else if (v > range[1] && v != mv)
-                        range[1] = v;
-                }
-            }
+    // Each slot is run by exactly one task, so the slot number can be
+    // used to index per-thread state
+    //
+    Wasp::ParallelForParts(0, nrows, nslots, [&proto](size_t t, size_t r0, size_t r1) {
+        span_state s = proto;
+        s._id = (int)t;
+        s._r0 = r0;
+        s._r1 = r1;
+        runSpanThread(&s);
+    });
+}
+
+void Grid::ParallelForEach(const std::function<void(int, const Span &)> &fn, int nthreads) const
+{
+    const vector<size_t> &dims = GetDimensions();
+    Size_tArr3            max = {0, 0, 0};
+    for (int i = 0; i < dims.size(); i++) max[i] = dims[i] - 1;
+
+    ParallelForEach({0, 0, 0}, max, fn, nthreads);
+}
+
+void Grid::GetRange(float range[2]) const
+{
+    const vector<size_t> &dims = GetDimensions();
+    Size_tArr3            max = {0, 0, 0};
+    for (int i = 0; i < dims.size(); i++) max[i] = dims[i] - 1;
+
+    GetRange({0, 0, 0}, max, range);
+}
+
+void Grid::GetRange(const Size_tArr3 &min, const Size_tArr3 &max, float range[2]) const
+{
+    float mv = GetMissingValue();
+
+    // Written without branches so that the inner loop vectorizes
+    //
+    using MinMax = std::array<float, 2>;
+    auto spanOp = [mv](MinMax &r, const Span &span) {
+        float vmin = r[0];
+        float vmax = r[1];
+        for (size_t i = 0; i < span.n; i++) {
+            float v = span.data[i];
+            bool  valid = v != mv;
+            vmin = (valid && v < vmin) ? v : vmin;
+            vmax = (valid && v > vmax) ? v : vmax;
         }
+        r = {vmin, vmax};
+    };
+    auto combine = [](const MinMax &a, const MinMax &b) { return MinMax{std::min(a[0], b[0]), std::max(a[1], b[1])}; };
+
+    MinMax r = ParallelReduce(min, max, MinMax{std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()}, spanOp, combine);
+
+    // Edge case: all values are missing values, or the grid is dataless
+    //
+    if (r[0] > r[1]) {
+        range[0] = range[1] = mv;
+        return;
     }
+    range[0] = r[0];
+    range[1] = r[1];
 }
 
 float Grid::GetValue(const DblArr3 &coords) const
@@ -208,6 +381,39 @@ float Grid::GetValue(const DblArr3 &coords) const
     }
 }
 
+bool Grid::GetInterpolationStencil(const DblArr3 &coords, InterpolationStencil &stencil) const
+{
+    DblArr3 cCoords;
+    ClampCoord(coords, cCoords);
+
+    stencil.inside = false;
+    stencil.order = _interpolationOrder;
+    return (GetInterpolationStencilHelper(cCoords, stencil));
+}
+
+float Grid::InterpolateStencil(const InterpolationStencil &stencil) const
+{
+    if (!_blks.size() || !stencil.inside) return (GetMissingValue());
+
+    return (InterpolateStencilHelper(stencil));
+}
+
+float Grid::GetValueWithStencil(const DblArr3 &coords, int order) const
+{
+    DblArr3 cCoords;
+    ClampCoord(coords, cCoords);
+
+    InterpolationStencil stencil;
+    stencil.inside = false;
+    stencil.order = order;
+    bool ok = GetInterpolationStencilHelper(cCoords, stencil);
+    VAssert(ok);
+
+    if (!stencil.inside) return (GetMissingValue());
+
+    return (InterpolateStencilHelper(stencil));
+}
+
 void Grid::_getUserCoordinatesHelper(const vector<double> &coords, double &x, double &y, double &z) const
 {
     if (GetDimensions().size() >= 1) { x = coords[0]; }
@@ -501,6 +707,7 @@ template<class T> Grid::ForwardIterator<T>::ForwardIterator(T *rg, bool begin, c
         _bs3d.push_back(1);
     }
     _blocksize = Wasp::VProduct(_bs3d);
+    _blkIndex = 0;
 
     _index = vector<size_t>(3, 0);
     _indexL = 0;
@@ -515,9 +722,11 @@ template<class T> Grid::ForwardIterator<T>::ForwardIterator(T *rg, bool begin, c
         return;
     }
 
+    _pager = rg->GetBlockPager();
+
     _coordItr = rg->ConstCoordBegin();
     _xb = 0;
-    _itr = &_blks[0][0];
+    _itr = _blockData(0);
 
     if (!_pred(*_coordItr)) { operator++(); }
 }
@@ -538,6 +747,9 @@ template<class T> Grid::ForwardIterator<T>::ForwardIterator(ForwardIterator<T> &
     _itr = rhs._itr;
     rhs._itr = nullptr;
     _pred = rhs._pred;
+    _pager = std::move(rhs._pager);
+    _blkRef = std::move(rhs._blkRef);
+    _blkIndex = rhs._blkIndex;
 }
 
 template<class T> Grid::ForwardIterator<T>::ForwardIterator()
@@ -554,6 +766,7 @@ template<class T> Grid::ForwardIterator<T>::ForwardIterator()
     _end_indexL = 0;
     _xb = 0;
     _itr = nullptr;
+    _blkIndex = 0;
     //_pred = xx;
 }
 
@@ -614,7 +827,7 @@ template<class T> Grid::ForwardIterator<T> &Grid::ForwardIterator<T>::operator++
         z = _index[2] % _bs3d[2];
         zb = _index[2] / _bs3d[2];
 
-        float *blk = _blks[zb * _bdims3d[0] * _bdims3d[1] + yb * _bdims3d[0] + xb];
+        float *blk = _blockData(zb * _bdims3d[0] * _bdims3d[1] + yb * _bdims3d[0] + xb);
         _itr = &blk[z * _bs3d[0] * _bs3d[1] + y * _bs3d[0] + x];
 
     } while (_indexL != _end_indexL && !_pred(*_coordItr));
@@ -622,6 +835,21 @@ template<class T> Grid::ForwardIterator<T> &Grid::ForwardIterator<T>::operator++
     return (*this);
 }
 
+// Return the data of block \p blk. A block of a paged grid is held
+// until the iterator moves to another block.
+//
+template<class T> float *Grid::ForwardIterator<T>::_blockData(size_t blk)
+{
+    if (!_pager) return (_blks[blk]);
+
+    if (!_blkRef || blk != _blkIndex) {
+        _blkRef.reset();    // release before acquiring, so the resident limit holds
+        _blkRef = _pager->Get(blk);
+        _blkIndex = blk;
+    }
+    return (_blkRef.get());
+}
+
 template<class T> Grid::ForwardIterator<T> Grid::ForwardIterator<T>::operator++(int)
 {
     ForwardIterator temp(*this);
@@ -675,7 +903,7 @@ template<class T> Grid::ForwardIterator<T> &Grid::ForwardIterator<T>::operator+=
         size_t z = _index[2] % _bs3d[2];
         size_t zb = _index[2] / _bs3d[2];
 
-        float *blk = _blks[zb * _bdims3d[0] * _bdims3d[1] + yb * _bdims3d[0] + xb];
+        float *blk = _blockData(zb * _bdims3d[0] * _bdims3d[1] + yb * _bdims3d[0] + xb);
         _itr = &blk[z * _bs3d[0] * _bs3d[1] + y * _bs3d[0] + x];
 
     } while (_indexL != _end_indexL && !_pred(*_coordItr));
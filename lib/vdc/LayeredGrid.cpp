@@ -167,26 +167,42 @@ bool LayeredGrid::_insideGrid(const DblArr3 &coords, Size_tArr3 &indices, double
     return (true);
 }
 
-float LayeredGrid::GetValueNearestNeighbor(const DblArr3 &coords) const
+float LayeredGrid::GetValueNearestNeighbor(const DblArr3 &coords) const { return (GetValueWithStencil(coords, 0)); }
+
+float LayeredGrid::GetValueLinear(const DblArr3 &coords) const { return (GetValueWithStencil(coords, 1)); }
+
+bool LayeredGrid::GetInterpolationStencilHelper(const DblArr3 &coords, InterpolationStencil &stencil) const
 {
+    // Quadratic interpolation is only used with at least three layers,
+    // and is not supported by stencils
+    //
+    if (stencil.order > 1) {
+        if (GetDimensions()[2] >= 3) return (false);
+        stencil.order = 1;
+    }
+
     Size_tArr3 indices;
-    double     wgts[3];
-    bool       found = _insideGrid(coords, indices, wgts);
-    if (!found) return (GetMissingValue());
+    double *   wgts = stencil.wgts;
+    stencil.inside = _insideGrid(coords, indices, wgts);
+    if (!stencil.inside) return (true);
 
-    if (wgts[0] < 0.5) indices[0] += 1;
-    if (wgts[1] < 0.5) indices[1] += 1;
-    if (wgts[2] < 0.5) indices[2] += 1;
+    // For nearest neighbor the stencil holds the closest node
+    //
+    if (stencil.order == 0) {
+        if (wgts[0] < 0.5) indices[0] += 1;
+        if (wgts[1] < 0.5) indices[1] += 1;
+        if (wgts[2] < 0.5) indices[2] += 1;
+    }
 
-    return (AccessIJK(indices[0], indices[1], indices[2]));
+    stencil.indices = indices;
+    return (true);
 }
 
-float LayeredGrid::GetValueLinear(const DblArr3 &coords) const
+float LayeredGrid::InterpolateStencilHelper(const InterpolationStencil &stencil) const
 {
-    Size_tArr3 indices;
-    double     wgts[3];
-    bool       found = _insideGrid(coords, indices, wgts);
-    if (!found) return (GetMissingValue());
+    const Size_tArr3 &indices = stencil.indices;
+
+    if (stencil.order == 0) return (AccessIJK(indices[0], indices[1], indices[2]));
 
     size_t i0 = indices[0];
     size_t j0 = indices[1];
@@ -199,9 +215,9 @@ float LayeredGrid::GetValueLinear(const DblArr3 &coords) const
     // perform tri-linear interpolation
     //
     double p0, p1, p2, p3, p4, p5, p6, p7;
-    double iwgt = 1.0 - wgts[0];    // Oops. Weights reversed.
-    double jwgt = 1.0 - wgts[1];
-    double kwgt = 1.0 - wgts[2];
+    double iwgt = 1.0 - stencil.wgts[0];    // Oops. Weights reversed.
+    double jwgt = 1.0 - stencil.wgts[1];
+    double kwgt = 1.0 - stencil.wgts[2];
 
     p0 = AccessIJK(i0, j0, k0);
     if (p0 == GetMissingValue()) return (GetMissingValue());
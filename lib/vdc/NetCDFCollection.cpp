@@ -1,8 +1,20 @@
 #include <iostream>
+#include <fstream>
 #include <algorithm>
 #include <utility>
+#include <cstdio>
+#include <cstdint>
+#include <sys/stat.h>
+#ifdef WIN32
+    #include <io.h>
+    #include <fcntl.h>
+#else
+    #include <unistd.h>
+#endif
 #include "vapor/VAssert.h"
 #include <netcdf.h>
+#include <vapor/FileUtils.h>
+#include <vapor/TaskScheduler.h>
 #include <vapor/NetCDFCollection.h>
 
 using namespace VAPoR;
@@ -43,8 +55,175 @@ bool readOK(vector<size_t> dims, size_t start[], size_t count[])
     return (true);
 }
 
+//
+// Metadata index files. One index is kept in each directory containing
+// files of a collection.
+//
+const string   indexFileName = ".vapor_ncindex";
+const uint32_t indexMagic = 0x56444349;
+const uint32_t indexVersion = 1;
+
+// Number of bytes read from the start of each file to prefetch its header
+//
+const size_t headerPrefetchSize = 64 * 1024;
+
+template<typename T> void writeValue(ostream &o, const T &v) { o.write((const char *)&v, sizeof(v)); }
+
+template<typename T> bool readValue(istream &in, T &v) { return ((bool)in.read((char *)&v, sizeof(v))); }
+
+void writeString(ostream &o, const string &s)
+{
+    writeValue(o, (uint64_t)s.size());
+    o.write(s.data(), s.size());
+}
+
+// Return the number of bytes between the read position and the end of a
+// stream of size bytes. Lengths read from an index are checked against
+// this before anything is allocated, so that a corrupt or truncated
+// index can not trigger a huge allocation.
+//
+uint64_t remaining(istream &in, uint64_t size)
+{
+    streamoff pos = in.tellg();
+    if (pos < 0 || (uint64_t)pos > size) return (0);
+    return (size - pos);
+}
+
+bool readString(istream &in, uint64_t size, string &s)
+{
+    uint64_t n;
+    if (!readValue(in, n)) return (false);
+    if (n > remaining(in, size)) return (false);
+    s.resize(n);
+    return (n == 0 || (bool)in.read(&s[0], n));
+}
+
+string indexPath(const string &file) { return (FileUtils::JoinPaths({FileUtils::Dirname(file), indexFileName})); }
+
+// Read the index file at path into entries, keyed by file base name.
+// A missing or invalid index yields no entries, so that every file is
+// rescanned
+//
+template<typename Entry> void readIndex(const string &path, map<string, Entry> &entries)
+{
+    entries.clear();
+
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in) return;
+
+    streamoff fileSize = in.tellg();
+    if (fileSize < 0) return;
+    uint64_t size = fileSize;
+    in.seekg(0);
+
+    uint32_t magic, version;
+    uint64_t n;
+    if (!readValue(in, magic) || !readValue(in, version) || !readValue(in, n)) return;
+    if (magic != indexMagic || version != indexVersion) return;
+
+    for (uint64_t i = 0; i < n; i++) {
+        string   name;
+        Entry    e;
+        uint32_t ntcvs;
+        if (!readString(in, size, name) || !readValue(in, e._size) || !readValue(in, e._mtime) || !readString(in, size, e._metadata) || !readValue(in, ntcvs)) {
+            entries.clear();
+            return;
+        }
+        for (uint32_t j = 0; j < ntcvs; j++) {
+            string   tcv;
+            uint64_t ntimes;
+            if (!readString(in, size, tcv) || !readValue(in, ntimes) || ntimes > remaining(in, size) / sizeof(double)) {
+                entries.clear();
+                return;
+            }
+            vector<double> &times = e._tcvs[tcv];
+            times.resize(ntimes);
+            if (ntimes && !in.read((char *)times.data(), ntimes * sizeof(double))) {
+                entries.clear();
+                return;
+            }
+        }
+        entries[name] = e;
+    }
+}
+
+// Create an empty file with a unique name beginning with prefix and
+// return its name, or an empty string on failure
+//
+string makeTempFile(const string &prefix)
+{
+    string tmpl = prefix + ".XXXXXX";
+    #ifdef WIN32
+    if (_mktemp_s(&tmpl[0], tmpl.size() + 1) != 0) return ("");
+    int fd = _open(tmpl.c_str(), _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) return ("");
+    _close(fd);
+    #else
+    int fd = mkstemp(&tmpl[0]);
+    if (fd < 0) return ("");
+
+    // mkstemp() creates the file readable only by its owner, but the
+    // index is shared by everyone reading the directory
+    //
+    (void)fchmod(fd, 0644);
+    close(fd);
+    #endif
+    return (tmpl);
+}
+
+// Write entries to the index file at path. The index is written to a
+// uniquely named temporary file first, so that concurrent writers do not
+// interleave and readers never see a partial index. Returns false on
+// failure.
+//
+template<typename Entry> bool writeIndex(const string &path, const map<string, Entry> &entries)
+{
+    string tmpPath = makeTempFile(path);
+    if (tmpPath.empty()) return (false);
+    {
+        ofstream o(tmpPath, ios::binary | ios::trunc);
+        if (!o) {
+            (void)remove(tmpPath.c_str());
+            return (false);
+        }
+
+        writeValue(o, indexMagic);
+        writeValue(o, indexVersion);
+        writeValue(o, (uint64_t)entries.size());
+        for (const auto &itr : entries) {
+            const Entry &e = itr.second;
+            writeString(o, itr.first);
+            writeValue(o, e._size);
+            writeValue(o, e._mtime);
+            writeString(o, e._metadata);
+            writeValue(o, (uint32_t)e._tcvs.size());
+            for (const auto &tcv : e._tcvs) {
+                writeString(o, tcv.first);
+                writeValue(o, (uint64_t)tcv.second.size());
+                o.write((const char *)tcv.second.data(), tcv.second.size() * sizeof(double));
+            }
+        }
+        if (!o) {
+            o.close();
+            (void)remove(tmpPath.c_str());
+            return (false);
+        }
+    }
+
+    #ifdef WIN32
+    (void)remove(path.c_str());
+    #endif
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        (void)remove(tmpPath.c_str());
+        return (false);
+    }
+    return (true);
+}
+
 };    // namespace
 
+bool NetCDFCollection::_useMetadataIndex = true;
+
 NetCDFCollection::NetCDFCollection()
 {
     _variableList.clear();
@@ -82,6 +261,128 @@ void NetCDFCollection::ReInitialize()
     _ovr_table.clear();
     _ncdfmap.clear();
     _failedVars.clear();
+    _index.clear();
+}
+
+int NetCDFCollection::_ScanFiles(const vector<string> &files)
+{
+    //
+    // Load the index for each directory, and look up each file
+    //
+    map<string, map<string, indexEntry>> dirIndices;
+    if (_useMetadataIndex) {
+        for (int i = 0; i < files.size(); i++) {
+            string path = indexPath(files[i]);
+            if (dirIndices.find(path) == dirIndices.end()) readIndex(path, dirIndices[path]);
+
+            map<string, indexEntry> &entries = dirIndices[path];
+            auto                     itr = entries.find(FileUtils::Basename(files[i]));
+            if (itr != entries.end()) _index[files[i]] = itr->second;
+        }
+    }
+
+    //
+    // Stat all files in parallel, prefetching the headers of those that
+    // are not indexed
+    //
+    vector<long long> sizes(files.size(), -1);
+    vector<long long> mtimes(files.size(), -1);
+    vector<bool>      prefetch(files.size());
+    for (int i = 0; i < files.size(); i++) prefetch[i] = _index.find(files[i]) == _index.end();
+
+    // Files that must be rescanned have the start of the file read so
+    // that the (serial) netCDF header parse is served from the operating
+    // system's cache. The netCDF library is not thread safe, so the
+    // headers themselves can not be parsed in parallel.
+    //
+    ParallelFor(0, files.size(), 1, [&](size_t first, size_t last) {
+        vector<char> buf(headerPrefetchSize);
+        for (size_t i = first; i < last; i++) {
+            struct STAT64_T st;
+            if (STAT64(files[i].c_str(), &st) == 0) {
+                sizes[i] = st.st_size;
+                mtimes[i] = st.st_mtime;
+            }
+
+            if (!prefetch[i]) continue;
+
+            FILE *fp = fopen(files[i].c_str(), "rb");
+            if (!fp) continue;
+            (void)fread(buf.data(), 1, buf.size(), fp);
+            fclose(fp);
+        }
+    });
+
+    //
+    // Initialize each file from its index entry if the file is unchanged,
+    // otherwise from the file itself
+    //
+    for (int i = 0; i < files.size(); i++) {
+        if (_ncdfmap.find(files[i]) != _ncdfmap.end()) continue;
+
+        NetCDFSimple *netcdf = new NetCDFSimple();
+        _ncdfmap[files[i]] = netcdf;
+
+        auto itr = _index.find(files[i]);
+        if (itr != _index.end()) {
+            indexEntry &e = itr->second;
+            if (e._size == sizes[i] && e._mtime == mtimes[i]) {
+                istringstream in(e._metadata);
+                bool          enable = EnableErrMsg(false);
+                int           rc = netcdf->ReadMetadata(in, files[i]);
+                (void)EnableErrMsg(enable);
+                if (rc == 0) continue;
+                SetErrCode(0);
+            }
+            _index.erase(itr);
+        }
+
+        int rc = netcdf->Initialize(files[i]);
+        if (rc < 0) {
+            SetErrMsg("NetCDFSimple::Initialize(%s)", files[i].c_str());
+            return (-1);
+        }
+
+        if (_useMetadataIndex && sizes[i] >= 0) {
+            indexEntry &e = _index[files[i]];
+            e._size = sizes[i];
+            e._mtime = mtimes[i];
+            ostringstream o;
+            netcdf->WriteMetadata(o);
+            e._metadata = o.str();
+            e._dirty = true;
+        }
+    }
+    return (0);
+}
+
+void NetCDFCollection::_WriteIndex() const
+{
+    if (!_useMetadataIndex) return;
+
+    //
+    // Group modified entries by directory
+    //
+    map<string, vector<string>> dirtyFiles;
+    for (auto itr = _index.begin(); itr != _index.end(); ++itr) {
+        if (itr->second._dirty) dirtyFiles[indexPath(itr->first)].push_back(itr->first);
+    }
+
+    //
+    // Merge with the current contents of each index, which may hold
+    // entries for files not in this collection
+    //
+    for (auto itr = dirtyFiles.begin(); itr != dirtyFiles.end(); ++itr) {
+        map<string, indexEntry> entries;
+        readIndex(itr->first, entries);
+
+        for (const string &file : itr->second) {
+            indexEntry e = _index.find(file)->second;
+            e._dirty = false;
+            entries[FileUtils::Basename(file)] = e;
+        }
+        (void)writeIndex(itr->first, entries);
+    }
 }
 
 int NetCDFCollection::Initialize(const vector<string> &files, const vector<string> &time_dimnames, const vector<string> &time_coordvars)
@@ -90,14 +391,22 @@ int NetCDFCollection::Initialize(const vector<string> &files, const vector<strin
 
     ReInitialize();
 
+    //
+    // Read the metadata for all of the files
+    //
+    int rc = _ScanFiles(files);
+    if (rc < 0) return (-1);
+
     //
     // Build a hash table to map a variable's time dimension
     // to its time coordinates
     //
     int file_org;    // case 1, 2, 3 (3a or 3b)
-    int rc = NetCDFCollection::_InitializeTimesMap(files, l_time_dimnames, time_coordvars, _timesMap, _times, file_org);
+    rc = NetCDFCollection::_InitializeTimesMap(files, l_time_dimnames, time_coordvars, _timesMap, _times, file_org);
     if (rc < 0) return (-1);
 
+    _WriteIndex();
+
     //
     // If no time dimension specified we create one. Really only need
     // to do this if there are multiple files with the same variable(s)
@@ -110,14 +419,7 @@ int NetCDFCollection::Initialize(const vector<string> &files, const vector<strin
     }
 
     for (int i = 0; i < files.size(); i++) {
-        NetCDFSimple *netcdf = new NetCDFSimple();
-        _ncdfmap[files[i]] = netcdf;
-
-        rc = netcdf->Initialize(files[i]);
-        if (rc < 0) {
-            SetErrMsg("NetCDFSimple::Initialize(%s)", files[i].c_str());
-            return (-1);
-        }
+        NetCDFSimple *netcdf = _ncdfmap[files[i]];
 
         //
         // Get dimension names and lengths
@@ -843,7 +1145,7 @@ int NetCDFCollection::ReadNative(int *data, int fd)
 }
 
 int NetCDFCollection::_InitializeTimesMap(const vector<string> &files, const vector<string> &time_dimnames, const vector<string> &time_coordvars, map<string, vector<double>> &timesMap,
-                                          vector<double> &times, int &file_org) const
+                                          vector<double> &times, int &file_org)
 {
     timesMap.clear();
     if (time_coordvars.size() && (time_coordvars.size() != time_dimnames.size())) {
@@ -908,13 +1210,7 @@ int NetCDFCollection::_InitializeTimesMapCase1(const vector<string> &files, map<
     //
 
     for (int i = 0; i < files.size(); i++) {
-        NetCDFSimple *netcdf = new NetCDFSimple();
-
-        int rc = netcdf->Initialize(files[i]);
-        if (rc < 0) {
-            SetErrMsg("NetCDFSimple::Initialize(%s)", files[i].c_str());
-            return (-1);
-        }
+        const NetCDFSimple *netcdf = _ncdfmap.find(files[i])->second;
 
         const vector<NetCDFSimple::Variable> &variables = netcdf->GetVariables();
 
@@ -937,7 +1233,6 @@ int NetCDFCollection::_InitializeTimesMapCase1(const vector<string> &files, map<
 
             currentTime[varname] += 1.0;
         }
-        delete netcdf;
     }
     return (0);
 }
@@ -957,13 +1252,7 @@ int NetCDFCollection::_InitializeTimesMapCase2(const vector<string> &files, cons
     //
 
     for (int i = 0; i < files.size(); i++) {
-        NetCDFSimple *netcdf = new NetCDFSimple();
-
-        int rc = netcdf->Initialize(files[i]);
-        if (rc < 0) {
-            SetErrMsg("NetCDFSimple::Initialize(%s)", files[i].c_str());
-            return (-1);
-        }
+        const NetCDFSimple *netcdf = _ncdfmap.find(files[i])->second;
 
         const vector<NetCDFSimple::Variable> &variables = netcdf->GetVariables();
 
@@ -998,12 +1287,11 @@ int NetCDFCollection::_InitializeTimesMapCase2(const vector<string> &files, cons
 
             timesMap[key] = times;
         }
-        delete netcdf;
     }
     return (0);
 }
 
-int NetCDFCollection::_InitializeTimesMapCase3(const vector<string> &files, const vector<string> &time_dimnames, const vector<string> &time_coordvars, map<string, vector<double>> &timesMap) const
+int NetCDFCollection::_InitializeTimesMapCase3(const vector<string> &files, const vector<string> &time_dimnames, const vector<string> &time_coordvars, map<string, vector<double>> &timesMap)
 {
     timesMap.clear();
 
@@ -1017,13 +1305,15 @@ int NetCDFCollection::_InitializeTimesMapCase3(const vector<string> &files, cons
     for (int i = 0; i < time_coordvars.size(); i++) { tcvcount[time_coordvars[i]] = 0; }
 
     for (int i = 0; i < files.size(); i++) {
-        NetCDFSimple *netcdf = new NetCDFSimple();
-
-        int rc = netcdf->Initialize(files[i]);
-        if (rc < 0) return (-1);
+        NetCDFSimple *netcdf = _ncdfmap[files[i]];
 
         const vector<NetCDFSimple::Variable> &variables = netcdf->GetVariables();
 
+        // Time coordinates may be cached in the metadata index
+        //
+        auto        indexItr = _index.find(files[i]);
+        indexEntry *entry = indexItr != _index.end() ? &indexItr->second : NULL;
+
         //
         // For each TCV see if it exists in current file, if so
         // read it and add times to timesMap
@@ -1037,19 +1327,28 @@ int NetCDFCollection::_InitializeTimesMapCase3(const vector<string> &files, cons
 
             tcvcount[time_coordvars[j]] += 1;
 
-            // Read TCV
-            float *buf = _Get1DVar(netcdf, variables[index]);
-            if (!buf) {
-                SetErrMsg("Failed to read time coordinate variable \"%s\"", time_coordvars[j].c_str());
-                return (-1);
-            }
-
             string timedim = variables[index].GetDimNames()[0];
             size_t timedimlen = netcdf->DimLen(timedim);
 
             vector<double> times;
-            for (int t = 0; t < timedimlen; t++) { times.push_back(buf[t]); }
-            delete[] buf;
+            if (entry && entry->_tcvs.find(time_coordvars[j]) != entry->_tcvs.end() && entry->_tcvs[time_coordvars[j]].size() == timedimlen) {
+                times = entry->_tcvs[time_coordvars[j]];
+            } else {
+                // Read TCV
+                float *buf = _Get1DVar(netcdf, variables[index]);
+                if (!buf) {
+                    SetErrMsg("Failed to read time coordinate variable \"%s\"", time_coordvars[j].c_str());
+                    return (-1);
+                }
+
+                for (int t = 0; t < timedimlen; t++) { times.push_back(buf[t]); }
+                delete[] buf;
+
+                if (entry) {
+                    entry->_tcvs[time_coordvars[j]] = times;
+                    entry->_dirty = true;
+                }
+            }
 
             //
             // The hash key for timesMap is the file plus the
@@ -1069,8 +1368,6 @@ int NetCDFCollection::_InitializeTimesMapCase3(const vector<string> &files, cons
                 for (int t = 0; t < times.size(); t++) { timesref.push_back(times[t]); }
             }
         }
-
-        delete netcdf;
     }
 
     //
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <list>
+#include <mutex>
 #include "vapor/VAssert.h"
 #include <netcdf.h>
 #include <vapor/NetCDFSimple.h>
@@ -7,6 +9,251 @@ using namespace VAPoR;
 using namespace Wasp;
 using namespace std;
 
+namespace {
+
+// The netCDF library is not thread safe, even for distinct files, so
+// every nc_* call in the process is made while holding this lock. Like
+// the pool below it is never destroyed.
+//
+std::mutex &ncMutex()
+{
+    static std::mutex *mutex = new std::mutex();
+    return (*mutex);
+}
+
+// A process-wide pool of open netCDF handles, shared by all NetCDFSimple
+// instances. Handles are reference counted while in use, and unused
+// handles are kept open in least-recently-used order until the pool
+// exceeds its capacity.
+//
+class ncid_pool {
+public:
+    ncid_pool() : _capacity(64) {}
+
+    // Return an open handle for path in ncid, opening the file if needed.
+    // Returns a netCDF status code
+    //
+    int Acquire(const string &path, int &ncid)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        for (auto itr = _entries.begin(); itr != _entries.end(); ++itr) {
+            if (itr->_path == path) {
+                itr->_refs++;
+                _entries.splice(_entries.begin(), _entries, itr);
+                ncid = itr->_ncid;
+                return (0);
+            }
+        }
+
+        int rc;
+        {
+            std::lock_guard<std::mutex> ncGuard(ncMutex());
+            rc = nc_open(path.c_str(), NC_NOWRITE, &ncid);
+        }
+        if (rc != 0) return (rc);
+
+        entry_t e;
+        e._path = path;
+        e._ncid = ncid;
+        e._refs = 1;
+        _entries.push_front(e);
+
+        _evict();
+        return (0);
+    }
+
+    // Release a handle previously returned by Acquire()
+    //
+    void Release(int ncid)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        for (auto &e : _entries) {
+            if (e._ncid == ncid) {
+                VAssert(e._refs > 0);
+                e._refs--;
+                break;
+            }
+        }
+        _evict();
+    }
+
+    void SetCapacity(size_t capacity)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        _capacity = capacity;
+        _evict();
+    }
+
+    size_t GetCapacity() const { return (_capacity); }
+
+private:
+    class entry_t {
+    public:
+        string _path;
+        int    _ncid;
+        int    _refs;
+    };
+
+    std::list<entry_t> _entries;
+    std::mutex         _mutex;
+    size_t             _capacity;
+
+    // Close least recently used handles that are not in use until the
+    // pool is within capacity. Handles in use are never closed, so the
+    // pool may temporarily exceed its capacity.
+    //
+    void _evict()
+    {
+        auto itr = _entries.end();
+        while (_entries.size() > _capacity && itr != _entries.begin()) {
+            --itr;
+            if (itr->_refs > 0) continue;
+
+            {
+                std::lock_guard<std::mutex> ncGuard(ncMutex());
+                (void)nc_close(itr->_ncid);
+            }
+            itr = _entries.erase(itr);
+        }
+    }
+};
+
+// The pool is never destroyed so that it outlives any static
+// NetCDFSimple instances. Open files are closed at process exit.
+//
+ncid_pool &getPool()
+{
+    static ncid_pool *pool = new ncid_pool();
+    return (*pool);
+}
+
+//
+// Binary encoding of metadata. Values are written in native byte order;
+// the encoding is only intended for caching on the host that wrote it.
+//
+template<typename T> void writeValue(ostream &o, const T &v) { o.write((const char *)&v, sizeof(v)); }
+
+template<typename T> bool readValue(istream &in, T &v) { return ((bool)in.read((char *)&v, sizeof(v))); }
+
+void writeString(ostream &o, const string &s)
+{
+    writeValue(o, (uint32_t)s.size());
+    o.write(s.data(), s.size());
+}
+
+// Return the number of bytes left in a stream of size bytes. Counts
+// read from a corrupt stream are checked against it before anything is
+// allocated
+//
+uint64_t remaining(istream &in, uint64_t size)
+{
+    streamoff pos = in.tellg();
+    if (pos < 0 || (uint64_t)pos > size) return (0);
+    return (size - pos);
+}
+
+// Read a count of n elements, each of which occupies at least
+// elementSize bytes in the stream
+//
+bool readCount(istream &in, uint64_t size, size_t elementSize, uint32_t &n)
+{
+    if (!readValue(in, n)) return (false);
+    return (n <= remaining(in, size) / elementSize);
+}
+
+bool readString(istream &in, uint64_t size, string &s)
+{
+    uint32_t n;
+    if (!readCount(in, size, 1, n)) return (false);
+    s.resize(n);
+    return (n == 0 || (bool)in.read(&s[0], n));
+}
+
+template<typename T> void writeVector(ostream &o, const vector<T> &v)
+{
+    writeValue(o, (uint32_t)v.size());
+    for (const T &x : v) writeValue(o, x);
+}
+
+template<typename T> bool readVector(istream &in, uint64_t size, vector<T> &v)
+{
+    uint32_t n;
+    if (!readCount(in, size, sizeof(T), n)) return (false);
+    v.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        if (!readValue(in, v[i])) return (false);
+    }
+    return (true);
+}
+
+void writeStrings(ostream &o, const vector<string> &v)
+{
+    writeValue(o, (uint32_t)v.size());
+    for (const string &x : v) writeString(o, x);
+}
+
+bool readStrings(istream &in, uint64_t size, vector<string> &v)
+{
+    uint32_t n;
+    if (!readCount(in, size, sizeof(uint32_t), n)) return (false);
+    v.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        if (!readString(in, size, v[i])) return (false);
+    }
+    return (true);
+}
+
+void writeAtts(ostream &o, const vector<pair<string, vector<double>>> &flt_atts, const vector<pair<string, vector<long>>> &int_atts, const vector<pair<string, string>> &str_atts)
+{
+    writeValue(o, (uint32_t)flt_atts.size());
+    for (const auto &a : flt_atts) {
+        writeString(o, a.first);
+        writeVector(o, a.second);
+    }
+    writeValue(o, (uint32_t)int_atts.size());
+    for (const auto &a : int_atts) {
+        writeString(o, a.first);
+        writeVector(o, a.second);
+    }
+    writeValue(o, (uint32_t)str_atts.size());
+    for (const auto &a : str_atts) {
+        writeString(o, a.first);
+        writeString(o, a.second);
+    }
+}
+
+// Each attribute is encoded as a name followed by a value, two counts of
+// at least sizeof(uint32_t) bytes each
+//
+bool readAtts(istream &in, uint64_t size, vector<pair<string, vector<double>>> &flt_atts, vector<pair<string, vector<long>>> &int_atts, vector<pair<string, string>> &str_atts)
+{
+    const size_t attSize = 2 * sizeof(uint32_t);
+
+    uint32_t n;
+    if (!readCount(in, size, attSize, n)) return (false);
+    flt_atts.resize(n);
+    for (auto &a : flt_atts) {
+        if (!readString(in, size, a.first) || !readVector(in, size, a.second)) return (false);
+    }
+
+    if (!readCount(in, size, attSize, n)) return (false);
+    int_atts.resize(n);
+    for (auto &a : int_atts) {
+        if (!readString(in, size, a.first) || !readVector(in, size, a.second)) return (false);
+    }
+
+    if (!readCount(in, size, attSize, n)) return (false);
+    str_atts.resize(n);
+    for (auto &a : str_atts) {
+        if (!readString(in, size, a.first) || !readString(in, size, a.second)) return (false);
+    }
+    return (true);
+}
+};    // namespace
+
 NetCDFSimple::NetCDFSimple()
 {
     _ncid = -1;
@@ -23,17 +270,23 @@ NetCDFSimple::NetCDFSimple()
 
 NetCDFSimple::~NetCDFSimple()
 {
-    if (_ncid != -1) {
-        int rc = nc_close(_ncid);
-        if (rc != 0) {
-            SetErrMsg("nc_close(%d) : %s", _ncid, nc_strerror(rc));
-            return;
-        }
-    }
+    if (_ncid != -1) getPool().Release(_ncid);
 }
 
+void NetCDFSimple::SetMaxOpenFiles(size_t n) { getPool().SetCapacity(n); }
+
+size_t NetCDFSimple::GetMaxOpenFiles() { return (getPool().GetCapacity()); }
+
 int NetCDFSimple::Initialize(string path)
 {
+    // Discard any open variables from a previous initialization
+    //
+    if (_ncid != -1) {
+        getPool().Release(_ncid);
+        _ncid = -1;
+    }
+    _ovr_table.clear();
+
     _dimnames.clear();
     _dims.clear();
     _unlimited_dimnames.clear();
@@ -43,14 +296,28 @@ int NetCDFSimple::Initialize(string path)
     _variables.clear();
     _path = path;
 
+    // The handle is left open in the pool, so a subsequent OpenRead()
+    // will not need to re-open the file
+    //
     int ncid;
-    int rc = nc_open(path.c_str(), NC_NOWRITE, &ncid);
+    int rc = getPool().Acquire(path, ncid);
     if (rc != 0) {
         SetErrMsg("nc_open(%s,) : %s", path.c_str(), nc_strerror(rc));
         return (-1);
     }
 
+    std::unique_lock<std::mutex> guard(ncMutex());
+    rc = _GetMetadata(ncid);
+    guard.unlock();
+
+    getPool().Release(ncid);
+    return (rc);
+}
+
+int NetCDFSimple::_GetMetadata(int ncid)
+{
     int ndims;
+    int rc;
     rc = nc_inq_ndims(ncid, &ndims);
     if (rc != 0) {
         SetErrMsg("nc_inq_ndims(%d) : %s", ncid, nc_strerror(rc));
@@ -134,18 +401,18 @@ int NetCDFSimple::Initialize(string path)
         _variables.push_back(var);
     }
 
-    nc_close(ncid);
     return (0);
 }
 
 int NetCDFSimple::OpenRead(const NetCDFSimple::Variable &variable)
 {
     //
-    // If _ncid is not valid open the NetCDF file
+    // If _ncid is not valid get a handle for the NetCDF file from the
+    // pool, which will only open the file if it is not already open
     //
     if (_ncid == -1) {
         int ncid;
-        int rc = nc_open(_path.c_str(), NC_NOWRITE, &ncid);
+        int rc = getPool().Acquire(_path, ncid);
         if (rc != 0) {
             SetErrMsg("nc_open(%s,) : %s", _path.c_str(), nc_strerror(rc));
             return (-1);
@@ -154,7 +421,11 @@ int NetCDFSimple::OpenRead(const NetCDFSimple::Variable &variable)
     }
 
     int varid;
-    int rc = nc_inq_varid(_ncid, variable.GetName().c_str(), &varid);
+    int rc;
+    {
+        std::lock_guard<std::mutex> guard(ncMutex());
+        rc = nc_inq_varid(_ncid, variable.GetName().c_str(), &varid);
+    }
     if (rc != 0) {
         SetErrMsg("nc_inq_varid(%d, %s, ) : %s", _ncid, variable.GetName().c_str(), nc_strerror(rc));
         return (-1);
@@ -181,7 +452,11 @@ int NetCDFSimple::Read(const size_t start[], const size_t count[], float *data,
     }
     int varid = itr->second;
 
-    int rc = nc_get_vara_float(_ncid, varid, start, count, data);
+    int rc;
+    {
+        std::lock_guard<std::mutex> guard(ncMutex());
+        rc = nc_get_vara_float(_ncid, varid, start, count, data);
+    }
     if (rc != 0) {
         SetErrMsg("nc_get_vara_float(%d, %d) : %s", _ncid, varid, nc_strerror(rc));
         return (-1);
@@ -198,7 +473,11 @@ int NetCDFSimple::Read(const size_t start[], const size_t count[], int *data, in
     }
     int varid = itr->second;
 
-    int rc = nc_get_vara_int(_ncid, varid, start, count, data);
+    int rc;
+    {
+        std::lock_guard<std::mutex> guard(ncMutex());
+        rc = nc_get_vara_int(_ncid, varid, start, count, data);
+    }
     if (rc != 0) {
         SetErrMsg("nc_get_vara_int(%d, %d) : %s", _ncid, varid, nc_strerror(rc));
         return (-1);
@@ -215,7 +494,11 @@ int NetCDFSimple::Read(const size_t start[], const size_t count[], char *data, i
     }
     int varid = itr->second;
 
-    int rc = nc_get_vara_text(_ncid, varid, start, count, data);
+    int rc;
+    {
+        std::lock_guard<std::mutex> guard(ncMutex());
+        rc = nc_get_vara_text(_ncid, varid, start, count, data);
+    }
     if (rc != 0) {
         SetErrMsg("nc_get_vara_text(%d, %d) : %s", _ncid, varid, nc_strerror(rc));
         return (-1);
@@ -233,11 +516,73 @@ int NetCDFSimple::Close(int fd)
 
     _ovr_table.erase(itr);
 
+    // Return the handle to the pool. The file stays open, subject to
+    // the pool capacity, for subsequent reads
+    //
     if (_ovr_table.empty() && _ncid != -1) {
-        (void)nc_close(_ncid);
+        getPool().Release(_ncid);
+        _ncid = -1;
+    }
+
+    return (0);
+}
+
+void NetCDFSimple::WriteMetadata(ostream &o) const
+{
+    writeStrings(o, _dimnames);
+    writeVector(o, _dims);
+    writeStrings(o, _unlimited_dimnames);
+    writeAtts(o, _flt_atts, _int_atts, _str_atts);
+
+    writeValue(o, (uint32_t)_variables.size());
+    for (const Variable &var : _variables) {
+        writeString(o, var._name);
+        writeStrings(o, var._dimnames);
+        writeValue(o, (int32_t)var._type);
+        writeAtts(o, var._flt_atts, var._int_atts, var._str_atts);
+    }
+}
+
+int NetCDFSimple::ReadMetadata(istream &in, string path)
+{
+    if (_ncid != -1) {
+        getPool().Release(_ncid);
         _ncid = -1;
     }
+    _ovr_table.clear();
+    _path = path;
+
+    // Size of the stream, against which every count read is checked
+    //
+    uint64_t       size = 0;
+    std::streampos start = in.tellg();
+    bool           ok = start >= 0 && (bool)in.seekg(0, std::ios::end);
+    if (ok) {
+        size = (uint64_t)(std::streamoff)in.tellg();
+        ok = (bool)in.seekg(start);
+    }
+
+    ok = ok && readStrings(in, size, _dimnames) && readVector(in, size, _dims) && readStrings(in, size, _unlimited_dimnames) && readAtts(in, size, _flt_atts, _int_atts, _str_atts);
+
+    // Each variable occupies at least a name, a list of dimension names,
+    // a type and three attribute counts
+    //
+    uint32_t nvars = 0;
+    ok = ok && readCount(in, size, 6 * sizeof(uint32_t), nvars);
+
+    _variables.clear();
+    for (uint32_t i = 0; ok && i < nvars; i++) {
+        Variable var;
+        int32_t  type;
+        ok = readString(in, size, var._name) && readStrings(in, size, var._dimnames) && readValue(in, type) && readAtts(in, size, var._flt_atts, var._int_atts, var._str_atts);
+        var._type = type;
+        _variables.push_back(var);
+    }
 
+    if (!ok || _dimnames.size() != _dims.size()) {
+        SetErrMsg("Invalid metadata for %s", path.c_str());
+        return (-1);
+    }
     return (0);
 }
 
@@ -1,18 +1,102 @@
 #define ACCEPT_USE_OF_DEPRECATED_PROJ_API_H 1
 
 #include <iostream>
+#include <algorithm>
 #include <proj_api.h>
 #include <vapor/ResourcePath.h>
+#include <vapor/TaskScheduler.h>
 #include <vapor/Proj4API.h>
 
 using namespace VAPoR;
 using namespace Wasp;
 
-Proj4API::Proj4API()
+namespace {
+
+// Arrays smaller than this many points per thread are not worth
+// splitting across threads
+//
+const size_t minPointsPerThread = 65536;
+
+// Transform coordinates in place, converting between degrees and radians
+// as needed. Returns the pj_transform() status.
+//
+int transformHelper(projPJ pjSrc, projPJ pjDst, double *x, double *y, double *z, size_t n, int offset)
+{
+    //
+    // Convert from degrees to radians if source is in
+    // geographic coordinates
+    //
+    if (pj_is_latlong(pjSrc)) {
+        if (x) {
+            for (size_t i = 0; i < n; i++) { x[i * (size_t)offset] *= DEG_TO_RAD; }
+        }
+        if (y) {
+            for (size_t i = 0; i < n; i++) { y[i * (size_t)offset] *= DEG_TO_RAD; }
+        }
+        if (z) {
+            for (size_t i = 0; i < n; i++) { z[i * (size_t)offset] *= DEG_TO_RAD; }
+        }
+    }
+
+    int rc = pj_transform(pjSrc, pjDst, n, offset, x, y, NULL);
+    if (rc != 0) return (rc);
+
+    //
+    // Convert from radians degrees if destination is in
+    // geographic coordinates
+    //
+    if (pj_is_latlong(pjDst)) {
+        if (x) {
+            for (size_t i = 0; i < n; i++) { x[i * (size_t)offset] *= RAD_TO_DEG; }
+        }
+        if (y) {
+            for (size_t i = 0; i < n; i++) { y[i * (size_t)offset] *= RAD_TO_DEG; }
+        }
+        if (z) {
+            for (size_t i = 0; i < n; i++) { z[i * (size_t)offset] *= RAD_TO_DEG; }
+        }
+    }
+    return (0);
+}
+
+// Per-part state for parallel transforms. proj4 projection objects
+// are not safe to share between threads, so each part gets its own
+// context and copies of the source and destination projections
+//
+class transform_state {
+public:
+    transform_state() : _ctx(NULL), _pjSrc(NULL), _pjDst(NULL), _rc(0) {}
+    ~transform_state()
+    {
+        if (_pjSrc) pj_free(_pjSrc);
+        if (_pjDst) pj_free(_pjDst);
+        if (_ctx) pj_ctx_free(_ctx);
+    }
+
+    projCtx _ctx;
+    projPJ  _pjSrc;
+    projPJ  _pjDst;
+    int     _rc;
+};
+
+projPJ copyProj(projCtx ctx, projPJ pj)
+{
+    char * def = pj_get_def(pj, 0);
+    projPJ copy = pj_init_plus_ctx(ctx, def);
+    pj_dalloc(def);
+    return (copy);
+}
+};    // namespace
+
+Proj4API::Proj4API(int nthreads)
 {
     _pjSrc = NULL;
     _pjDst = NULL;
 
+    if (nthreads < 1) nthreads = TaskScheduler::Instance().GetNumThreads();
+    if (nthreads < 1) nthreads = 1;
+    _nthreads = nthreads;
+
     string path = GetSharePath("proj");
     if (!path.empty()) {
 #ifdef WIN32
@@ -134,41 +218,55 @@ int Proj4API::_Transform(void *pjSrc, void *pjDst, double *x, double *y, double
     //
     if (pjSrc == NULL || pjDst == NULL) return (0);
 
-    //
-    // Convert from degrees to radians if source is in
-    // geographic coordinates
-    //
-    if (pj_is_latlong(pjSrc)) {
-        if (x) {
-            for (size_t i = 0; i < n; i++) { x[i * (size_t)offset] *= DEG_TO_RAD; }
-        }
-        if (y) {
-            for (size_t i = 0; i < n; i++) { y[i * (size_t)offset] *= DEG_TO_RAD; }
-        }
-        if (z) {
-            for (size_t i = 0; i < n; i++) { z[i * (size_t)offset] *= DEG_TO_RAD; }
-        }
-    }
+    int nthreads = (int)std::min((size_t)_nthreads, n / minPointsPerThread);
+    if (nthreads > 1) return (_TransformParallel(pjSrc, pjDst, x, y, z, n, offset, nthreads));
 
-    int rc = pj_transform(pjSrc, pjDst, n, offset, x, y, NULL);
+    int rc = transformHelper(pjSrc, pjDst, x, y, z, n, offset);
     if (rc != 0) {
         SetErrMsg("pj_transform() : %s", ProjErr().c_str());
         return (-1);
     }
+    return (0);
+}
 
+int Proj4API::_TransformParallel(void *pjSrc, void *pjDst, double *x, double *y, double *z, size_t n, int offset, int nthreads) const
+{
+    vector<transform_state> states(nthreads);
+
+    // Set up the per-part projections in the calling thread. Fall back
+    // to a serial transform if anything goes wrong.
     //
-    // Convert from radians degrees if destination is in
-    // geographic coordinates
-    //
-    if (pj_is_latlong(pjDst)) {
-        if (x) {
-            for (size_t i = 0; i < n; i++) { x[i * (size_t)offset] *= RAD_TO_DEG; }
+    bool ok = true;
+    for (int i = 0; i < states.size() && ok; i++) {
+        transform_state &s = states[i];
+
+        s._ctx = pj_ctx_alloc();
+        if (s._ctx) {
+            s._pjSrc = copyProj(s._ctx, pjSrc);
+            s._pjDst = copyProj(s._ctx, pjDst);
         }
-        if (y) {
-            for (size_t i = 0; i < n; i++) { y[i * (size_t)offset] *= RAD_TO_DEG; }
+        ok = s._ctx && s._pjSrc && s._pjDst;
+    }
+
+    if (!ok) {
+        int rc = transformHelper(pjSrc, pjDst, x, y, z, n, offset);
+        if (rc != 0) {
+            SetErrMsg("pj_transform() : %s", ProjErr().c_str());
+            return (-1);
         }
-        if (z) {
-            for (size_t i = 0; i < n; i++) { z[i * (size_t)offset] *= RAD_TO_DEG; }
+        return (0);
+    }
+
+    size_t stride = (size_t)offset;
+    ParallelForParts(0, n, states.size(), [&](size_t part, size_t b, size_t e) {
+        transform_state &s = states[part];
+        s._rc = transformHelper(s._pjSrc, s._pjDst, x ? x + b * stride : NULL, y ? y + b * stride : NULL, z ? z + b * stride : NULL, e - b, offset);
+    });
+
+    for (int i = 0; i < states.size(); i++) {
+        if (states[i]._rc != 0) {
+            SetErrMsg("pj_transform() : %s", pj_strerrno(pj_ctx_get_errno(states[i]._ctx)));
+            return (-1);
         }
     }
     return (0);
@@ -63,82 +63,66 @@ vector<size_t> RegularGrid::GetCoordDimensions(size_t dim) const
     }
 }
 
-float RegularGrid::GetValueNearestNeighbor(const DblArr3 &coords) const
-{
-    DblArr3 cCoords;
-    ClampCoord(coords, cCoords);
+float RegularGrid::GetValueNearestNeighbor(const DblArr3 &coords) const { return (GetValueWithStencil(coords, 0)); }
+
+float RegularGrid::GetValueLinear(const DblArr3 &coords) const { return (GetValueWithStencil(coords, 1)); }
 
-    if (!InsideGrid(cCoords)) return (GetMissingValue());
+bool RegularGrid::GetInterpolationStencilHelper(const DblArr3 &coords, InterpolationStencil &stencil) const
+{
+    stencil.order = stencil.order == 0 ? 0 : 1;
+    stencil.inside = InsideGrid(coords);
+    if (!stencil.inside) return (true);
 
     size_t i = 0;
     size_t j = 0;
     size_t k = 0;
 
-    if (_delta[0] != 0.0) i = (size_t)floor((cCoords[0] - _minu[0]) / _delta[0]);
-    if (_delta[1] != 0.0) j = (size_t)floor((cCoords[1] - _minu[1]) / _delta[1]);
-
-    const vector<size_t> &dims = GetDimensions();
+    if (_delta[0] != 0.0) { i = (size_t)floor((coords[0] - _minu[0]) / _delta[0]); }
+    if (_delta[1] != 0.0) { j = (size_t)floor((coords[1] - _minu[1]) / _delta[1]); }
 
-    if (GetGeometryDim() == 3)
-        if (_delta[2] != 0.0) k = (size_t)floor((cCoords[2] - _minu[2]) / _delta[2]);
+    if (GetGeometryDim() == 3 && _delta[2] != 0.0) { k = (size_t)floor((coords[2] - _minu[2]) / _delta[2]); }
 
+    const vector<size_t> &dims = GetDimensions();
     VAssert(i < dims[0]);
     VAssert(j < dims[1]);
 
-    if (dims.size() == 3) VAssert(k < dims[2]);
+    if (dims.size() == 3) { VAssert(k < dims[2]); }
 
     double iwgt = 0.0;
     double jwgt = 0.0;
     double kwgt = 0.0;
 
-    if (_delta[0] != 0.0) { iwgt = ((cCoords[0] - _minu[0]) - (i * _delta[0])) / _delta[0]; }
-
-    if (_delta[1] != 0.0) { jwgt = ((cCoords[1] - _minu[1]) - (j * _delta[1])) / _delta[1]; }
-
-    if (GetGeometryDim() == 3) {
-        if (_delta[2] != 0.0) { kwgt = ((cCoords[2] - _minu[2]) - (k * _delta[2])) / _delta[2]; }
-    }
+    if (_delta[0] != 0.0) { iwgt = ((coords[0] - _minu[0]) - (i * _delta[0])) / _delta[0]; }
+    if (_delta[1] != 0.0) { jwgt = ((coords[1] - _minu[1]) - (j * _delta[1])) / _delta[1]; }
 
-    if (iwgt > 0.5) i++;
-    if (jwgt > 0.5) j++;
+    if (GetGeometryDim() == 3 && _delta[2] != 0.0) { kwgt = ((coords[2] - _minu[2]) - (k * _delta[2])) / _delta[2]; }
 
-    if (dims.size() == 3) {
-        if (kwgt > 0.5) k++;
+    // For nearest neighbor the stencil holds the closest node
+    //
+    if (stencil.order == 0) {
+        if (iwgt > 0.5) i++;
+        if (jwgt > 0.5) j++;
+        if (dims.size() == 3 && kwgt > 0.5) k++;
     }
 
-    return (AccessIJK(i, j, k));
+    stencil.indices = {i, j, k};
+    stencil.wgts[0] = iwgt;
+    stencil.wgts[1] = jwgt;
+    stencil.wgts[2] = kwgt;
+    return (true);
 }
 
-float RegularGrid::GetValueLinear(const DblArr3 &coords) const
+float RegularGrid::InterpolateStencilHelper(const InterpolationStencil &stencil) const
 {
-    DblArr3 cCoords;
-    ClampCoord(coords, cCoords);
-
-    if (!InsideGrid(cCoords)) return (GetMissingValue());
-
-    size_t i = 0;
-    size_t j = 0;
-    size_t k = 0;
-
-    if (_delta[0] != 0.0) { i = (size_t)floor((cCoords[0] - _minu[0]) / _delta[0]); }
-    if (_delta[1] != 0.0) { j = (size_t)floor((cCoords[1] - _minu[1]) / _delta[1]); }
-
-    if (GetGeometryDim() == 3 && _delta[2] != 0.0) { k = (size_t)floor((cCoords[2] - _minu[2]) / _delta[2]); }
-
-    const vector<size_t> &dims = GetDimensions();
-    VAssert(i < dims[0]);
-    VAssert(j < dims[1]);
-
-    if (dims.size() == 3) { VAssert(k < dims[2]); }
-
-    double iwgt = 0.0;
-    double jwgt = 0.0;
-    double kwgt = 0.0;
+    size_t i = stencil.indices[0];
+    size_t j = stencil.indices[1];
+    size_t k = stencil.indices[2];
 
-    if (_delta[0] != 0.0) { iwgt = ((cCoords[0] - _minu[0]) - (i * _delta[0])) / _delta[0]; }
-    if (_delta[1] != 0.0) { jwgt = ((cCoords[1] - _minu[1]) - (j * _delta[1])) / _delta[1]; }
+    if (stencil.order == 0) return (AccessIJK(i, j, k));
 
-    if (GetGeometryDim() == 3 && _delta[2] != 0.0) { kwgt = ((cCoords[2] - _minu[2]) - (k * _delta[2])) / _delta[2]; }
+    double iwgt = stencil.wgts[0];
+    double jwgt = stencil.wgts[1];
+    double kwgt = stencil.wgts[2];
 
     float  missingValue = GetMissingValue();
     double p0, p1, p2, p3, p4, p5, p6, p7;
@@ -248,47 +248,51 @@ void StretchedGrid::ConstCoordItrSG::next(const long &offset)
     _coords[2] = _sg->_zcoords[_index[2]];
 }
 
-float StretchedGrid::GetValueNearestNeighbor(const DblArr3 &coords) const
-{
-    // Clamp coordinates on periodic boundaries to grid extents
-    //
-    DblArr3 cCoords;
-    ClampCoord(coords, cCoords);
+float StretchedGrid::GetValueNearestNeighbor(const DblArr3 &coords) const { return (GetValueWithStencil(coords, 0)); }
 
-    double xwgt[2], ywgt[2], zwgt[2];
-    size_t i, j, k;
-    double x = cCoords[0];
-    double y = cCoords[1];
-    double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
-    bool   inside = _insideGrid(x, y, z, i, j, k, xwgt, ywgt, zwgt);
+float StretchedGrid::GetValueLinear(const DblArr3 &coords) const { return (GetValueWithStencil(coords, 1)); }
 
-    if (xwgt[1] > xwgt[0]) i++;
-    if (ywgt[1] > ywgt[0]) j++;
-    if (zwgt[1] > zwgt[0]) k++;
+bool StretchedGrid::GetInterpolationStencilHelper(const DblArr3 &coords, InterpolationStencil &stencil) const
+{
+    stencil.order = stencil.order == 0 ? 0 : 1;
 
-    if (!inside) return (GetMissingValue());
+    // handlese case where grid is 2D. I.e. if 2d then zwgt[0] == 1 &&
+    // zwgt[1] = 0.0
+    //
+    double *xwgt = stencil.wgts;
+    double *ywgt = stencil.wgts + 2;
+    double *zwgt = stencil.wgts + 4;
+    size_t  i, j, k;
+    double  x = coords[0];
+    double  y = coords[1];
+    double  z = GetGeometryDim() == 3 ? coords[2] : 0.0;
+
+    stencil.inside = _insideGrid(x, y, z, i, j, k, xwgt, ywgt, zwgt);
+    if (!stencil.inside) return (true);
+
+    // For nearest neighbor the stencil holds the closest node
+    //
+    if (stencil.order == 0) {
+        if (xwgt[1] > xwgt[0]) i++;
+        if (ywgt[1] > ywgt[0]) j++;
+        if (zwgt[1] > zwgt[0]) k++;
+    }
 
-    return (AccessIJK(i, j, k));
+    stencil.indices = {i, j, k};
+    return (true);
 }
 
-float StretchedGrid::GetValueLinear(const DblArr3 &coords) const
+float StretchedGrid::InterpolateStencilHelper(const InterpolationStencil &stencil) const
 {
-    // Clamp coordinates on periodic boundaries to grid extents
-    //
-    DblArr3 cCoords;
-    ClampCoord(coords, cCoords);
+    size_t i = stencil.indices[0];
+    size_t j = stencil.indices[1];
+    size_t k = stencil.indices[2];
 
-    // handlese case where grid is 2D. I.e. if 2d then zwgt[0] == 1 &&
-    // zwgt[1] = 0.0
-    //
-    double xwgt[2], ywgt[2], zwgt[2];
-    size_t i, j, k;
-    double x = cCoords[0];
-    double y = cCoords[1];
-    double z = GetGeometryDim() == 3 ? cCoords[2] : 0.0;
-    bool   inside = _insideGrid(x, y, z, i, j, k, xwgt, ywgt, zwgt);
+    if (stencil.order == 0) return (AccessIJK(i, j, k));
 
-    if (!inside) return (GetMissingValue());
+    const double *xwgt = stencil.wgts;
+    const double *ywgt = stencil.wgts + 2;
+    const double *zwgt = stencil.wgts + 4;
 
     vector<size_t> dims = GetDimensions();
     VAssert(i < dims[0] - 1);
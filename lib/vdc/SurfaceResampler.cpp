@@ -0,0 +1,415 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <vapor/TaskScheduler.h>
+#include <vapor/StructuredGrid.h>
+#include <vapor/SurfaceResampler.h>
+
+using namespace VAPoR;
+using namespace Wasp;
+
+namespace {
+
+const uint32_t outside = std::numeric_limits<uint32_t>::max();
+
+// Tolerance on parametric cell coordinates when deciding whether a point
+// is inside a cell
+//
+const double eps = 1e-6;
+
+const int maxNewton = 12;
+const int maxWalk = 32;
+
+// Fetch the user coordinates of the corner nodes of a cell. Corner
+// n = a + 2*b + 4*c corresponds to node (i+a, j+b, k+c).
+//
+void cellCorners(const StructuredGrid *sg, size_t ndim, const long cell[3], double corners[8][3])
+{
+    int ncorners = ndim == 3 ? 8 : 4;
+    for (int n = 0; n < ncorners; n++) {
+        size_t i = cell[0] + (n & 1);
+        size_t j = cell[1] + ((n >> 1) & 1);
+        if (ndim == 3) {
+            sg->GetUserCoordinates(i, j, (size_t)cell[2] + ((n >> 2) & 1), corners[n][0], corners[n][1], corners[n][2]);
+        } else {
+            sg->GetUserCoordinates(i, j, corners[n][0], corners[n][1], corners[n][2]);
+        }
+    }
+}
+
+// Invert the bilinear (2D) or trilinear (3D) map of a cell with
+// Newton's method, returning the parametric coordinates of point p in w.
+// Returns false if the iteration does not converge.
+//
+bool invertCell(size_t ndim, const double c[8][3], const double p[3], double w[3])
+{
+    double s = 0.5, t = 0.5, u = 0.5;
+    int    ncorners = ndim == 3 ? 8 : 4;
+
+    for (int iter = 0; iter < maxNewton; iter++) {
+        double X[3] = {0.0, 0.0, 0.0};
+        double Ds[3] = {0.0, 0.0, 0.0};
+        double Dt[3] = {0.0, 0.0, 0.0};
+        double Du[3] = {0.0, 0.0, 0.0};
+
+        for (int n = 0; n < ncorners; n++) {
+            int    a = n & 1, b = (n >> 1) & 1, d = (n >> 2) & 1;
+            double wa = a ? s : 1.0 - s;
+            double wb = b ? t : 1.0 - t;
+            double wd = ndim == 3 ? (d ? u : 1.0 - u) : 1.0;
+            double da = a ? 1.0 : -1.0;
+            double db = b ? 1.0 : -1.0;
+            double dd = d ? 1.0 : -1.0;
+            for (int m = 0; m < 3; m++) {
+                X[m] += wa * wb * wd * c[n][m];
+                Ds[m] += da * wb * wd * c[n][m];
+                Dt[m] += wa * db * wd * c[n][m];
+                Du[m] += wa * wb * dd * c[n][m];
+            }
+        }
+
+        double r[3] = {X[0] - p[0], X[1] - p[1], X[2] - p[2]};
+        double ds, dt, du = 0.0;
+
+        if (ndim == 3) {
+            double det = Ds[0] * (Dt[1] * Du[2] - Du[1] * Dt[2]) - Dt[0] * (Ds[1] * Du[2] - Du[1] * Ds[2]) + Du[0] * (Ds[1] * Dt[2] - Dt[1] * Ds[2]);
+            double scale = std::sqrt((Ds[0] * Ds[0] + Ds[1] * Ds[1] + Ds[2] * Ds[2]) * (Dt[0] * Dt[0] + Dt[1] * Dt[1] + Dt[2] * Dt[2]) * (Du[0] * Du[0] + Du[1] * Du[1] + Du[2] * Du[2]));
+            if (!(std::abs(det) > 1e-12 * scale)) return (false);
+
+            ds = (r[0] * (Dt[1] * Du[2] - Du[1] * Dt[2]) - Dt[0] * (r[1] * Du[2] - Du[1] * r[2]) + Du[0] * (r[1] * Dt[2] - Dt[1] * r[2])) / det;
+            dt = (Ds[0] * (r[1] * Du[2] - Du[1] * r[2]) - r[0] * (Ds[1] * Du[2] - Du[1] * Ds[2]) + Du[0] * (Ds[1] * r[2] - r[1] * Ds[2])) / det;
+            du = (Ds[0] * (Dt[1] * r[2] - r[1] * Dt[2]) - Dt[0] * (Ds[1] * r[2] - r[1] * Ds[2]) + r[0] * (Ds[1] * Dt[2] - Dt[1] * Ds[2])) / det;
+        } else {
+            double det = Ds[0] * Dt[1] - Dt[0] * Ds[1];
+            double scale = std::sqrt((Ds[0] * Ds[0] + Ds[1] * Ds[1]) * (Dt[0] * Dt[0] + Dt[1] * Dt[1]));
+            if (!(std::abs(det) > 1e-12 * scale)) return (false);
+
+            ds = (r[0] * Dt[1] - Dt[0] * r[1]) / det;
+            dt = (Ds[0] * r[1] - r[0] * Ds[1]) / det;
+        }
+
+        s -= ds;
+        t -= dt;
+        u -= du;
+
+        // Far outside of the cell the map is meaningless; the caller only
+        // needs to know which direction to step.
+        //
+        if (std::abs(s) > 1e3 || std::abs(t) > 1e3 || std::abs(u) > 1e3) break;
+
+        if (std::abs(ds) + std::abs(dt) + std::abs(du) < 1e-10) break;
+    }
+
+    if (!std::isfinite(s) || !std::isfinite(t) || !std::isfinite(u)) return (false);
+
+    w[0] = s;
+    w[1] = t;
+    w[2] = ndim == 3 ? u : 0.0;
+    return (true);
+}
+
+bool insideCell(size_t ndim, const double w[3])
+{
+    for (int a = 0; a < ndim; a++) {
+        if (w[a] < -eps || w[a] > 1.0 + eps) return (false);
+    }
+    return (true);
+}
+
+// Walk from cell toward the cell containing point p, stepping in the
+// direction indicated by the parametric coordinates of p. Returns false
+// if the walk leaves the grid or does not terminate.
+//
+bool walk(const StructuredGrid *sg, size_t ndim, const long ncells[3], const double p[3], long cell[3], double w[3])
+{
+    double corners[8][3];
+    for (int step = 0; step < maxWalk; step++) {
+        cellCorners(sg, ndim, cell, corners);
+        if (!invertCell(ndim, corners, p, w)) return (false);
+
+        if (insideCell(ndim, w)) return (true);
+
+        bool moved = false;
+        for (int a = 0; a < ndim; a++) {
+            if (w[a] >= -eps && w[a] <= 1.0 + eps) continue;
+
+            long next = cell[a] + (long)std::floor(w[a]);
+            next = std::max(0L, std::min(next, ncells[a] - 1));
+            if (next != cell[a]) {
+                cell[a] = next;
+                moved = true;
+            }
+        }
+        if (!moved) return (false);
+    }
+    return (false);
+}
+
+// Find the cell containing p and its parametric coordinates. If haveGuess
+// is true cell contains the starting point of a walk. Otherwise, or if
+// the walk fails, the grid's own cell search is used.
+//
+bool locate(const StructuredGrid *sg, size_t ndim, const long ncells[3], const double p[3], bool haveGuess, long cell[3], double w[3])
+{
+    if (haveGuess && walk(sg, ndim, ncells, p, cell, w)) return (true);
+
+    DblArr3    coords = {p[0], p[1], p[2]};
+    Size_tArr3 indices = {0, 0, 0};
+    if (!sg->GetIndicesCell(coords, indices)) return (false);
+
+    for (int a = 0; a < 3; a++) { cell[a] = a < ndim ? std::min((long)indices[a], ncells[a] - 1) : 0; }
+
+    double corners[8][3];
+    cellCorners(sg, ndim, cell, corners);
+    if (!invertCell(ndim, corners, p, w)) w[0] = w[1] = w[2] = 0.5;
+
+    for (int a = 0; a < 3; a++) { w[a] = a < ndim ? std::max(0.0, std::min(w[a], 1.0)) : 0.0; }
+    return (true);
+}
+
+};    // namespace
+
+SurfaceResampler::SurfaceResampler(int nthreads)
+{
+    if (nthreads < 1) nthreads = TaskScheduler::Instance().GetNumThreads();
+    _nthreads = nthreads;
+    _nu = 0;
+    _nv = 0;
+}
+
+void SurfaceResampler::SetPlane(const std::vector<double> &origin, const std::vector<double> &du, const std::vector<double> &dv, size_t nu, size_t nv)
+{
+    VAssert(origin.size() == 3 && du.size() == 3 && dv.size() == 3);
+
+    std::vector<double> points(3 * nu * nv);
+    for (size_t j = 0; j < nv; j++) {
+        for (size_t i = 0; i < nu; i++) {
+            for (int a = 0; a < 3; a++) { points[3 * (j * nu + i) + a] = origin[a] + i * du[a] + j * dv[a]; }
+        }
+    }
+
+    SetSurface(points, nu, nv);
+}
+
+void SurfaceResampler::SetSurface(const std::vector<double> &points, size_t nu, size_t nv)
+{
+    VAssert(points.size() == 3 * nu * nv);
+
+    if (nu == _nu && nv == _nv && points == _points) return;
+
+    _nu = nu;
+    _nv = nv;
+    _points = points;
+    Invalidate();
+}
+
+void SurfaceResampler::Invalidate()
+{
+    _cells.clear();
+    _weights.clear();
+    _signature.clear();
+    _gridType.clear();
+}
+
+void SurfaceResampler::_gridSignature(const Grid *grid, std::vector<double> &sig) const
+{
+    sig.clear();
+
+    const std::vector<size_t> &dims = grid->GetNodeDimensions();
+    sig.push_back(grid->GetTopologyDim());
+    sig.insert(sig.end(), dims.begin(), dims.end());
+
+    std::vector<size_t> minAbs = grid->GetMinAbs();
+    sig.insert(sig.end(), minAbs.begin(), minAbs.end());
+
+    DblArr3 minu, maxu;
+    grid->GetUserExtents(minu, maxu);
+    sig.insert(sig.end(), minu.begin(), minu.end());
+    sig.insert(sig.end(), maxu.begin(), maxu.end());
+
+    // Extents alone do not detect coordinates that vary in the interior
+    // (e.g. terrain following vertical coordinates), so include the
+    // coordinates of the first, middle, and last node along each axis.
+    //
+    size_t ndim = dims.size();
+    size_t n[3] = {1, 1, 1};
+    for (int a = 0; a < ndim && a < 3; a++) n[a] = dims[a] > 1 ? 3 : 1;
+
+    for (size_t k = 0; k < n[2]; k++) {
+        for (size_t j = 0; j < n[1]; j++) {
+            for (size_t i = 0; i < n[0]; i++) {
+                Size_tArr3 indices = {0, 0, 0};
+                size_t     ijk[3] = {i, j, k};
+                for (int a = 0; a < ndim && a < 3; a++) indices[a] = ijk[a] * (dims[a] - 1) / 2;
+
+                DblArr3 coords = {0.0, 0.0, 0.0};
+                grid->GetUserCoordinates(indices, coords);
+                sig.insert(sig.end(), coords.begin(), coords.end());
+            }
+        }
+    }
+}
+
+int SurfaceResampler::_locate(const StructuredGrid *sg)
+{
+    size_t                     ndim = sg->GetTopologyDim();
+    const std::vector<size_t> &dims = sg->GetNodeDimensions();
+
+    _cells.resize(3 * _nu * _nv);
+    _weights.resize(3 * _nu * _nv);
+
+    long ncells[3];
+    for (int a = 0; a < 3; a++) ncells[a] = a < ndim ? (long)dims[a] - 1 : 1;
+
+    DblArr3 minu, maxu;
+    sg->GetUserExtents(minu, maxu);
+
+    const double *points = _points.data();
+    uint32_t *    cells = _cells.data();
+    float *       weights = _weights.data();
+    size_t        nu = _nu;
+
+    ParallelForParts(0, _nv, std::min((size_t)_nthreads, _nv), [&](size_t, size_t v0, size_t v1) {
+        long   cell[3] = {0, 0, 0};
+        double w[3];
+        bool   haveGuess = false;
+
+        for (size_t v = v0; v < v1; v++) {
+            // Start each row from the first sample of the previous row
+            //
+            if (v > v0 && cells[3 * (v - 1) * nu] != outside) {
+                for (int a = 0; a < 3; a++) cell[a] = cells[3 * (v - 1) * nu + a];
+                haveGuess = true;
+            }
+
+            for (size_t u = 0; u < nu; u++) {
+                size_t        idx = v * nu + u;
+                const double *p = points + 3 * idx;
+
+                // Cheap rejection of samples outside of the grid's bounding box
+                //
+                bool inBox = true;
+                for (int a = 0; a < ndim; a++) {
+                    if (p[a] < minu[a] || p[a] > maxu[a]) inBox = false;
+                }
+
+                if (inBox && locate(sg, ndim, ncells, p, haveGuess, cell, w)) {
+                    for (int a = 0; a < 3; a++) {
+                        cells[3 * idx + a] = (uint32_t)cell[a];
+                        weights[3 * idx + a] = (float)w[a];
+                    }
+                    haveGuess = true;
+                } else {
+                    cells[3 * idx] = outside;
+                }
+            }
+        }
+    });
+    return (0);
+}
+
+int SurfaceResampler::_gather(const StructuredGrid *sg, float *values) const
+{
+    size_t          ndim = sg->GetTopologyDim();
+    int             ncorners = ndim == 3 ? 8 : 4;
+    const uint32_t *cells = _cells.data();
+    const float *   weights = _weights.data();
+    size_t          nu = _nu;
+    float           mv = sg->GetMissingValue();
+    bool            hasMissing = sg->HasMissingData();
+    bool            nearest = sg->GetInterpolationOrder() == 0;
+
+    ParallelForParts(0, _nv, std::min((size_t)_nthreads, _nv), [&](size_t, size_t v0, size_t v1) {
+        for (size_t idx = v0 * nu; idx < v1 * nu; idx++) {
+            const uint32_t *cell = cells + 3 * idx;
+            const float *   w = weights + 3 * idx;
+
+            if (cell[0] == outside) {
+                values[idx] = mv;
+                continue;
+            }
+
+            if (nearest) {
+                values[idx] = sg->AccessIJK(cell[0] + (w[0] >= 0.5f), cell[1] + (w[1] >= 0.5f), cell[2] + (ndim == 3 && w[2] >= 0.5f));
+                continue;
+            }
+
+            float sum = 0.0;
+            bool  missing = false;
+            for (int n = 0; n < ncorners && !missing; n++) {
+                int   a = n & 1, b = (n >> 1) & 1, d = (n >> 2) & 1;
+                float weight = (a ? w[0] : 1.0f - w[0]) * (b ? w[1] : 1.0f - w[1]);
+                if (ndim == 3) weight *= d ? w[2] : 1.0f - w[2];
+                if (weight == 0.0f) continue;
+
+                float v = sg->AccessIJK(cell[0] + a, cell[1] + b, cell[2] + d);
+                if (hasMissing && v == mv) missing = true;
+                sum += weight * v;
+            }
+            values[idx] = missing ? mv : sum;
+        }
+    });
+    return (0);
+}
+
+int SurfaceResampler::_sample(const Grid *grid, float *values) const
+{
+    const double *points = _points.data();
+    size_t        nu = _nu;
+
+    ParallelForParts(0, _nv, std::min((size_t)_nthreads, _nv), [&](size_t, size_t v0, size_t v1) {
+        for (size_t idx = v0 * nu; idx < v1 * nu; idx++) {
+            const double *p = points + 3 * idx;
+            DblArr3       coords = {p[0], p[1], p[2]};
+            values[idx] = grid->GetValue(coords);
+        }
+    });
+    return (0);
+}
+
+int SurfaceResampler::Resample(const Grid *grid, float *values)
+{
+    VAssert(grid);
+
+    if (!_nu || !_nv) {
+        SetErrMsg("No sample points defined");
+        return (-1);
+    }
+
+    // Cell walking and cached weights are only used for structured grids
+    // whose cells may be addressed by (i,j,k). Periodic grids are left to
+    // Grid::GetValue(), which remaps coordinates into the grid.
+    //
+    const StructuredGrid *     sg = dynamic_cast<const StructuredGrid *>(grid);
+    const std::vector<size_t> &dims = grid->GetNodeDimensions();
+    const std::vector<bool> &  periodic = grid->GetPeriodic();
+
+    bool cacheable = sg && (grid->GetTopologyDim() == 2 || grid->GetTopologyDim() == 3) && dims.size() == grid->GetTopologyDim();
+    for (int a = 0; a < dims.size() && cacheable; a++) {
+        if (dims[a] < 2 || dims[a] >= outside) cacheable = false;
+    }
+    for (int a = 0; a < periodic.size() && cacheable; a++) {
+        if (periodic[a]) cacheable = false;
+    }
+
+    // Computing the signature also fills the grid's cached user
+    // extents before the grid is accessed from multiple threads.
+    //
+    std::vector<double> sig;
+    _gridSignature(grid, sig);
+
+    if (!cacheable) return (_sample(grid, values));
+
+    if (_cells.empty() || sig != _signature || grid->GetType() != _gridType) {
+        Invalidate();
+        int rc = _locate(sg);
+        if (rc < 0) {
+            Invalidate();
+            return (rc);
+        }
+        _signature = sig;
+        _gridType = grid->GetType();
+    }
+
+    return (_gather(sg, values));
+}
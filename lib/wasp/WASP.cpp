@@ -2,11 +2,14 @@
 #include <sstream>
 #include <sstream>
 #include <iterator>
+#include <atomic>
+#include <mutex>
 #include <sys/stat.h>
 #include "vapor/utils.h"
 #include "vapor/MatWaveBase.h"
 #include "vapor/Compressor.h"
 #include "vapor/WASP.h"
+#include "vapor/Trace.h"
 
 using namespace VAPoR;
 using namespace Wasp;
@@ -195,8 +198,8 @@ bool vectorinc::next(vector<size_t> &start, size_t &offset)
 class thread_state {
 public:
     int                  _id;
-    EasyThreads *        _et;    // one per thread
-    int                  _nthreads;
+    std::atomic<int> *   _next;       // next block to process, shared
+    std::mutex *         _ncmutex;    // serializes NetCDF calls, shared
     string               _varname;
     vector<NetCDFCpp *>  _ncdfcptrs;    // one for each file
     vector<size_t>       _start;
@@ -218,10 +221,10 @@ public:
     bool                 _unblock_flag;    // unblock the data after reconstruction?
     static int           _status;          // error indicator
 
-    thread_state(int id, EasyThreads *et, int nthreads, string &varname, const vector<NetCDFCpp *> &ncdfcptrs, const vector<size_t> &start, const vector<size_t> &count, const vector<size_t> &bs,
+    thread_state(int id, std::atomic<int> *next, std::mutex *ncmutex, string &varname, const vector<NetCDFCpp *> &ncdfcptrs, const vector<size_t> &start, const vector<size_t> &count, const vector<size_t> &bs,
                  const vector<size_t> &udims, const vector<size_t> &ncoeffs, const vector<size_t> &encoded_dims, const vector<Compressor *> &compressors, void *data, int data_type,
                  unsigned char *mask, void *block, void *coeffs, int block_type, int xtype, unsigned char *maps, int level, bool unblock_flag)
-    : _id(id), _et(et), _nthreads(nthreads), _varname(varname), _ncdfcptrs(ncdfcptrs), _start(start), _count(count), _bs(bs), _udims(udims), _ncoeffs(ncoeffs), _encoded_dims(encoded_dims),
+    : _id(id), _next(next), _ncmutex(ncmutex), _varname(varname), _ncdfcptrs(ncdfcptrs), _start(start), _count(count), _bs(bs), _udims(udims), _ncoeffs(ncoeffs), _encoded_dims(encoded_dims),
       _compressors(compressors), _data(data), _data_type(data_type), _mask(mask), _block(block), _coeffs(coeffs), _block_type(block_type), _xtype(xtype), _maps(maps), _level(level),
       _unblock_flag(unblock_flag)
     {
@@ -972,13 +975,12 @@ template<class T> void *RunWriteThreadTemplate(thread_state &s, T dummy)
 {
     vectorinc vec(s._start, s._count, s._udims, s._bs);
 
-    s._status = 0;
-
     //
-    // Process blocks of data assigned to this thread
+    // Claim blocks one at a time so that threads given cheap blocks
+    // take on more of them
     //
     int n = vec.num();
-    for (int i = s._id; i < n; i += s._nthreads) {
+    for (int i = (*s._next)++; i < n; i = (*s._next)++) {
         // Get starting coordinates of i'th block
         //
         size_t         offset;
@@ -1007,10 +1009,10 @@ template<class T> void *RunWriteThreadTemplate(thread_state &s, T dummy)
         // NetCDF library is not thread safe
         //
         //
-        s._et->MutexLock();
+        s._ncmutex->lock();
         int rc = StoreBlock(s._varname, s._ncdfcptrs[0], bcoords, s._encoded_dims[0], (T *)s._block);
         if (rc < 0) { s._status = -1; }
-        s._et->MutexUnlock();
+        s._ncmutex->unlock();
         if (s._status < 0) break;
     }
     return (0);
@@ -1048,13 +1050,12 @@ template<class T, class U> void *RunWriteThreadCompressedTemplate(thread_state &
 {
     vectorinc vec(s._start, s._count, s._udims, s._bs);
 
-    s._status = 0;
-
     //
-    // Process blocks of data assigned to this thread
+    // Claim blocks one at a time so that threads given cheap blocks
+    // take on more of them
     //
     int n = vec.num();
-    for (int i = s._id; i < n; i += s._nthreads) {
+    for (int i = (*s._next)++; i < n; i = (*s._next)++) {
         // Get starting coordinates of i'th block
         //
         size_t         offset;
@@ -1092,10 +1093,10 @@ template<class T, class U> void *RunWriteThreadCompressedTemplate(thread_state &
         // NetCDF library is not thread safe
         //
         //
-        s._et->MutexLock();
+        s._ncmutex->lock();
         rc = StoreBlockCompressed(s._varname, s._ncdfcptrs, bcoords, s._ncoeffs, s._encoded_dims, (U *)s._coeffs, datarange, s._maps, s._xtype);
         if (rc < 0) { s._status = -1; }
-        s._et->MutexUnlock();
+        s._ncmutex->unlock();
         if (s._status < 0) break;
     }
     return (0);
@@ -1187,10 +1188,8 @@ template<class T> void *RunReadThreadTemplate(thread_state &s, T dummy)
 
     vectorinc vec(aligned_start, aligned_count, s._udims, s._bs);
 
-    s._status = 0;
-
     int n = vec.num();
-    for (int i = s._id; i < n; i += s._nthreads) {
+    for (int i = (*s._next)++; i < n; i = (*s._next)++) {
         size_t         offset;
         vector<size_t> start;
 
@@ -1211,10 +1210,10 @@ template<class T> void *RunReadThreadTemplate(thread_state &s, T dummy)
         // Read wavelet coefficients from disk. Need a mutex because
         // NetCDF API is not thread safe
         //
-        s._et->MutexLock();
+        s._ncmutex->lock();
         int rc = FetchBlock(s._varname, s._ncdfcptrs[0], bcoords, s._encoded_dims[0], blockptr);
         if (rc < 0) s._status = -1;
-        s._et->MutexUnlock();
+        s._ncmutex->unlock();
         if (s._status < 0) break;
 
         if (unblock_flag) {
@@ -1272,10 +1271,8 @@ template<class T, class U> void *RunReadThreadCompressedTemplate(thread_state &s
 
     vectorinc vec(aligned_start, aligned_count, s._udims, s._bs);
 
-    s._status = 0;
-
     int n = vec.num();
-    for (int i = s._id; i < n; i += s._nthreads) {
+    for (int i = (*s._next)++; i < n; i = (*s._next)++) {
         size_t         offset;
         vector<size_t> start;
 
@@ -1290,10 +1287,10 @@ template<class T, class U> void *RunReadThreadCompressedTemplate(thread_state &s
         // NetCDF API is not thread safe
         //
         U datarange[2];
-        s._et->MutexLock();
+        s._ncmutex->lock();
         int rc = FetchBlockCompressed(s._varname, s._ncdfcptrs, bcoords, s._ncoeffs, s._encoded_dims, (U *)s._coeffs, datarange, s._maps, s._xtype);
         if (rc < 0) s._status = -1;
-        s._et->MutexUnlock();
+        s._ncmutex->unlock();
         if (s._status < 0) break;
 
         // Transform coordinates from global to the region-of-interest
@@ -1391,6 +1388,25 @@ void *RunReadThreadCompressed(void *arg)
     }
 }
 
+// Run each thread state as a task on the shared scheduler. A task keeps
+// its state, and so its private buffers and Compressor, while it claims
+// blocks from the shared counter
+//
+void RunThreadStates(void *(*start)(void *), const vector<void *> &argvec)
+{
+    if (argvec.size() == 1) {
+        start(argvec[0]);
+        return;
+    }
+
+    TaskGroup group;
+    for (int i = 0; i < argvec.size(); i++) {
+        void *arg = argvec[i];
+        group.Run([start, arg]() { start(arg); });
+    }
+    group.Wait();
+}
+
 };    // namespace
 
 WASP::WASP(int nthreads)
@@ -1414,16 +1430,13 @@ WASP::WASP(int nthreads)
     _open_write = false;
     _open_varname.clear();
 
-    _et = NULL;
-
-    // Set up execution threads for parallel execution
+    // Blocks are processed by _nthreads tasks run on the shared
+    // TaskScheduler
     //
-    if (nthreads < 1) nthreads = EasyThreads::NProc();
+    if (nthreads < 1) nthreads = TaskScheduler::Instance().GetNumThreads();
     if (nthreads < 1) nthreads = 1;
 
-    _et = new EasyThreads(nthreads);
-
-    _nthreads = _et->GetNumThreads() > 0 ? _et->GetNumThreads() : 1;
+    _nthreads = nthreads;
 
     // One Compressor instance for each thread
     //
@@ -1435,7 +1448,6 @@ WASP::~WASP()
     for (int i = 0; i < _open_compressors.size(); i++) {
         if (_open_compressors[i]) delete _open_compressors[i];
     }
-    if (_et) delete _et;
 }
 
 int WASP::Create(string path, int cmode, size_t initialsz, size_t &bufrsizehintp, int numfiles)
@@ -2319,31 +2331,19 @@ template<class T, class U> int WASP::_PutVara(vector<size_t> start, vector<size_
     //
     // Set up thread state for parallel (threaded) execution
     //
-    vector<void *> argvec;
+    std::atomic<int> next(0);
+    std::mutex       ncmutex;
+    vector<void *>   argvec;
     for (int i = 0; i < _nthreads; i++) {
-        argvec.push_back((void *)new thread_state(i, _et, _nthreads, _open_varname, _ncdfcptrs, start, count, _open_bs, _open_udims, ncoeffs, encoded_dims, _open_compressors, (void *)data, data_type,
+        argvec.push_back((void *)new thread_state(i, &next, &ncmutex, _open_varname, _ncdfcptrs, start, count, _open_bs, _open_udims, ncoeffs, encoded_dims, _open_compressors, (void *)data, data_type,
                                                   (unsigned char *)mask, block + i * block_size, coeffs + i * coeffs_size, block_type, _open_varxtype,
                                                   maps + i * maps_size * NetCDFCpp::SizeOf(_open_varxtype), 0, true));
     }
 
-    if (_nthreads == 1) {
-        if (_open_wname.empty()) {
-            RunWriteThread(argvec[0]);
-        } else {
-            RunWriteThreadCompressed(argvec[0]);
-        }
+    if (_open_wname.empty()) {
+        RunThreadStates(RunWriteThread, argvec);
     } else {
-        int rc;
-        if (_open_wname.empty()) {
-            rc = _et->ParRun(RunWriteThread, argvec);
-        } else {
-            rc = _et->ParRun(RunWriteThreadCompressed, argvec);
-        }
-
-        if (rc < 0) {
-            SetErrMsg("Error spawning threads");
-            return (-1);
-        }
+        RunThreadStates(RunWriteThreadCompressed, argvec);
     }
     for (int i = 0; i < argvec.size(); i++) delete (thread_state *)argvec[i];
 
@@ -2362,6 +2362,8 @@ template<class T> int WASP::_PutVara(vector<size_t> start, vector<size_t> count,
         return (-1);
     }
 
+    TraceSpan span("WASP::PutVara", "io", _open_varname);
+
     if (!_open_waspvar) { return (NetCDFCpp::PutVara(_open_varname, start, count, data)); }
 
     VAssert(_open_compressors.size() != 0);
@@ -2538,32 +2540,21 @@ template<class T, class U> int WASP::_GetVara(vector<size_t> start, vector<size_
     //
     // Set up thread state for parallel (threaded) execution
     //
-    vector<void *> argvec;
+    std::atomic<int> next(0);
+    std::mutex       ncmutex;
+    vector<void *>   argvec;
     for (int i = 0; i < _nthreads; i++) {
         U *blkptr = block + i * block_size;
 
-        argvec.push_back((void *)new thread_state(i, _et, _nthreads, _open_varname, _ncdfcptrs, start, count, bs_at_level, dims_at_level, ncoeffs, encoded_dims, _open_compressors, data, data_type,
+        argvec.push_back((void *)new thread_state(i, &next, &ncmutex, _open_varname, _ncdfcptrs, start, count, bs_at_level, dims_at_level, ncoeffs, encoded_dims, _open_compressors, data, data_type,
                                                   NULL, blkptr, coeffs + i * coeffs_size, block_type, _open_varxtype, maps + i * maps_size * NetCDFCpp::SizeOf(_open_varxtype), _open_level,
                                                   unblock_flag));
     }
 
-    if (_nthreads == 1) {
-        if (_open_wname.empty()) {
-            RunReadThread(argvec[0]);
-        } else {
-            RunReadThreadCompressed(argvec[0]);
-        }
+    if (_open_wname.empty()) {
+        RunThreadStates(RunReadThread, argvec);
     } else {
-        int rc;
-        if (_open_wname.empty()) {
-            rc = _et->ParRun(RunReadThread, argvec);
-        } else {
-            rc = _et->ParRun(RunReadThreadCompressed, argvec);
-        }
-        if (rc < 0) {
-            SetErrMsg("Error spawning threads");
-            return (-1);
-        }
+        RunThreadStates(RunReadThreadCompressed, argvec);
     }
 
     for (int i = 0; i < argvec.size(); i++) delete (thread_state *)argvec[i];
@@ -2583,6 +2574,8 @@ template<class T> int WASP::_GetVara(vector<size_t> start, vector<size_t> count,
         return (-1);
     }
 
+    TraceSpan span("WASP::GetVara", "io", _open_varname);
+
     if (!_open_waspvar) { return (NetCDFCpp::GetVara(_open_varname, start, count, data)); }
 
     VAssert(_open_compressors.size() != 0);
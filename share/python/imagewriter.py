@@ -1,7 +1,8 @@
 # outfile   : string
 # width     : image width
 # height    : image height
-# rgbbuffer : buffer of R, G, B values
+# rgbbuffer : buffer of R, G, B values, either a bytes-like object or
+#             a sequence of integers
 
 def drawpng( outfile, width, height, rgbbuffer ):
     import matplotlib
@@ -9,7 +10,10 @@ def drawpng( outfile, width, height, rgbbuffer ):
     import matplotlib.image as mpimg
     import numpy as np
 
-    buf = np.array( rgbbuffer, dtype=np.uint8 )
+    if isinstance( rgbbuffer, (bytes, bytearray, memoryview) ):
+        buf = np.frombuffer( rgbbuffer, dtype=np.uint8 )
+    else:
+        buf = np.array( rgbbuffer, dtype=np.uint8 )
     buf = buf.reshape( height, width, 3 )
     mpimg.imsave( outfile, buf, format='png' )
 
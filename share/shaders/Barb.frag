@@ -0,0 +1,32 @@
+#version 330 core
+
+uniform bool lightingEnabled;
+uniform vec3 lightDir;
+uniform bool useColormap;
+uniform vec4 constantColor;
+uniform sampler1D colormap;
+uniform float minLUTValue;
+uniform float maxLUTValue;
+
+in vec3 fNormal;
+in float fValue;
+out vec4 fragment;
+
+void main() {
+    vec4 color = constantColor;
+    if (useColormap) {
+        float s = clamp((fValue - minLUTValue) / (maxLUTValue - minLUTValue), 0.0, 1.0);
+        color = texture(colormap, s);
+    }
+    if (lightingEnabled) {
+        vec3 normal;
+        if (gl_FrontFacing)
+            normal = fNormal;
+        else
+            normal = -fNormal;
+
+        float diffuse = max(dot(normal, -lightDir), 0.0);
+        color.rgb *= max(diffuse, 0.2f);
+    }
+    fragment = color;
+}
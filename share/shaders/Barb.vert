@@ -0,0 +1,46 @@
+#version 330 core
+
+// Shared barb mesh. The barb frame has z along the barb direction.
+// vOffset.xy is the offset from the barb axis in units of the barb radius,
+// vOffset.z the position along the axis in units of the barb length, and
+// vOffset.w an additional position along the axis in units of the radius.
+//
+layout (location = 0) in vec4 vOffset;
+layout (location = 1) in vec3 vNormal;
+
+// Per barb instance
+//
+layout (location = 2) in vec3 iPosition;
+layout (location = 3) in vec3 iDirection;
+layout (location = 4) in float iMagnitude;
+layout (location = 5) in float iValue;
+
+uniform mat4 P;
+uniform mat4 MV;
+uniform vec3 scales;
+uniform float lengthScale;
+uniform float radius;
+
+out vec3 fNormal;
+out float fValue;
+
+void main() {
+    // Barbs are built in scaled space so they are not distorted by the
+    // scene transform
+    //
+    vec3 v = scales * iDirection * iMagnitude * lengthScale;
+    float len = length(v);
+    vec3 dir = v / len;
+
+    vec3 u = cross(dir, vec3(1.0, 0.0, 0.0));
+    if (dot(u, u) == 0.0)
+        u = cross(dir, vec3(0.0, 1.0, 0.0));
+    u = normalize(u);
+    vec3 b = cross(u, dir);
+
+    vec3 p = dir * (vOffset.z * len + vOffset.w * radius) + (u * vOffset.x + b * vOffset.y) * radius;
+
+    gl_Position = P * MV * vec4(iPosition + p / scales, 1.0);
+    fNormal = normalize(u * vNormal.x + b * vNormal.y + dir * vNormal.z);
+    fValue = iValue;
+}
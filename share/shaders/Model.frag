@@ -0,0 +1,21 @@
+#version 330 core
+
+uniform bool lightingEnabled;
+uniform vec3 lightDir;
+
+in  vec4 fColor;
+in  vec3 fNormal;
+out vec4 fragment;
+
+void main() {
+    vec4 color = fColor;
+    if (lightingEnabled) {
+        vec3 normal = normalize(fNormal);
+        if (!gl_FrontFacing)
+            normal = -normal;
+
+        float diffuse = max(dot(normal, -lightDir), 0.0);
+        color.rgb *= max(diffuse, 0.2f);
+    }
+    fragment = color;
+}
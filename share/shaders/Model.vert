@@ -0,0 +1,20 @@
+#version 330 core
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec4 vColor;
+layout (location = 3) in mat4 vInstance;
+layout (location = 7) in mat3 vNormalMatrix;    // inverse transpose of mat3(vInstance)
+
+out vec3 fNormal;
+out vec4 fColor;
+
+uniform mat4 P;
+uniform mat4 MV;
+
+
+void main() {
+    gl_Position = P * MV * vInstance * vec4(vPos, 1.0f);
+    fNormal = vNormalMatrix * vNormal;
+    fColor = vColor;
+}
@@ -1,12 +1,12 @@
 #version 330 core
 in vec2 TexCoords;
+in vec4 Color;
 out vec4 fragment;
 
-uniform vec4 color;
 uniform sampler2D text;
 
 void main()
 {
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    fragment = color * sampled;
+    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords / vec2(textureSize(text, 0))).r);
+    fragment = Color * sampled;
 }
@@ -1,11 +1,13 @@
 #version 330 core
-layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location = 0) in vec4 vertex;    // clip space position
+layout (location = 1) in vec2 texCoord;  // atlas pixels
+layout (location = 2) in vec4 vertexColor;
 out vec2 TexCoords;
-
-uniform mat4 MVP;
+out vec4 Color;
 
 void main()
 {
-    gl_Position = MVP * vec4(vertex.xy, 0.0, 1.0);
-    TexCoords = vertex.zw;
+    gl_Position = vertex;
+    TexCoords = texCoord;
+    Color = vertexColor;
 }
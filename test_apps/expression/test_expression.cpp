@@ -0,0 +1,342 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cmath>
+#include <limits>
+#include <cstdio>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/NetCDFCpp.h>
+#include <vapor/DataMgr.h>
+#include <vapor/FileUtils.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Compare variables computed by DataMgr::AddExpressionVar() against
+// values computed directly from a small CF data set written by the test.
+// Both inputs have missing values, which must propagate through every
+// operator.
+//
+
+struct {
+    int                     memsize;
+    int                     nthreads;
+    string                  file;
+    OptionParser::Boolean_T keep;
+    OptionParser::Boolean_T help;
+    OptionParser::Boolean_T debug;
+} opt;
+
+OptionParser::OptDescRec_T set_opts[] = {{"memsize", 1, "100", "Cache size in MBs"},
+                                         {"nthreads", 1, "0",
+                                          "Specify number of execution threads "
+                                          "0 => use number of cores"},
+                                         {"file", 1, "test_expression.nc", "Path of the data set written by the test"},
+                                         {"keep", 0, "", "Do not remove the data set on exit"},
+                                         {"help", 0, "", "Print this message and exit"},
+                                         {"debug", 0, "", "Debug mode"},
+                                         {NULL}};
+
+OptionParser::Option_T get_options[] = {{"memsize", Wasp::CvtToInt, &opt.memsize, sizeof(opt.memsize)},
+                                        {"nthreads", Wasp::CvtToInt, &opt.nthreads, sizeof(opt.nthreads)},
+                                        {"file", Wasp::CvtToCPPStr, &opt.file, sizeof(opt.file)},
+                                        {"keep", Wasp::CvtToBoolean, &opt.keep, sizeof(opt.keep)},
+                                        {"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+                                        {"debug", Wasp::CvtToBoolean, &opt.debug, sizeof(opt.debug)},
+                                        {NULL}};
+
+const char *ProgName;
+
+const size_t NX = 9;
+const size_t NY = 6;
+const size_t NZ = 5;
+const float  FillValue = 1e30;
+const float  NaN = std::numeric_limits<float>::quiet_NaN();
+
+// The data set, with missing values stored as NaN
+//
+class dataset_c {
+public:
+    std::vector<float> x, y, z;
+    std::vector<float> U, V, T2;
+
+    size_t offset(size_t i, size_t j, size_t k = 0) const { return (i + NX * (j + NY * k)); }
+};
+
+void make_dataset(dataset_c &d)
+{
+    for (size_t i = 0; i < NX; i++) d.x.push_back(0.25 * i * i + i);    // stretched
+    for (size_t j = 0; j < NY; j++) d.y.push_back(2.0 * j);
+    for (size_t k = 0; k < NZ; k++) d.z.push_back(10.0 * k);
+
+    for (size_t idx = 0; idx < NX * NY * NZ; idx++) {
+        d.U.push_back(idx % 11 == 3 ? NaN : 10.0 * sin(0.3 * idx));
+        d.V.push_back(idx % 13 == 5 ? NaN : 5.0 * cos(0.2 * idx));
+    }
+
+    // A column of U that is entirely missing
+    //
+    for (size_t k = 0; k < NZ; k++) d.U[d.offset(1, 1, k)] = NaN;
+
+    for (size_t j = 0; j < NY; j++) {
+        for (size_t i = 0; i < NX; i++) d.T2.push_back(i + 0.5 * j);
+    }
+}
+
+int write_dataset(string path, const dataset_c &d)
+{
+    std::vector<float> U = d.U;
+    std::vector<float> V = d.V;
+    for (size_t i = 0; i < U.size(); i++) {
+        if (std::isnan(U[i])) U[i] = FillValue;
+        if (std::isnan(V[i])) V[i] = FillValue;
+    }
+
+    NetCDFCpp nc;
+    size_t    chsz = NC_SIZEHINT_DEFAULT;
+    int       rc = nc.Create(path, NC_CLOBBER, 0, chsz);
+    if (rc < 0) return (-1);
+
+    if (nc.DefDim("x", NX) < 0 || nc.DefDim("y", NY) < 0 || nc.DefDim("z", NZ) < 0) return (-1);
+
+    const char *axes[] = {"X", "Y", "Z"};
+    const char *names[] = {"x", "y", "z"};
+    for (int i = 0; i < 3; i++) {
+        if (nc.DefVar(names[i], NC_FLOAT, {names[i]}) < 0) return (-1);
+        if (nc.PutAtt(names[i], "axis", string(axes[i])) < 0) return (-1);
+        if (nc.PutAtt(names[i], "units", string("m")) < 0) return (-1);
+    }
+    if (nc.PutAtt("z", "positive", string("up")) < 0) return (-1);
+
+    if (nc.DefVar("U", NC_FLOAT, {"z", "y", "x"}) < 0) return (-1);
+    if (nc.DefVar("V", NC_FLOAT, {"z", "y", "x"}) < 0) return (-1);
+    if (nc.DefVar("T2", NC_FLOAT, {"y", "x"}) < 0) return (-1);
+    if (nc.PutAtt("U", "_FillValue", FillValue) < 0) return (-1);
+    if (nc.PutAtt("V", "_FillValue", FillValue) < 0) return (-1);
+
+    if (nc.EndDef() < 0) return (-1);
+
+    if (nc.PutVar("x", d.x.data()) < 0) return (-1);
+    if (nc.PutVar("y", d.y.data()) < 0) return (-1);
+    if (nc.PutVar("z", d.z.data()) < 0) return (-1);
+    if (nc.PutVar("U", U.data()) < 0) return (-1);
+    if (nc.PutVar("V", V.data()) < 0) return (-1);
+    if (nc.PutVar("T2", d.T2.data()) < 0) return (-1);
+
+    return (nc.Close());
+}
+
+// Reference value of a derived variable at grid index (i,j,k), or NaN
+// where the result must be missing
+//
+typedef std::function<float(const dataset_c &d, size_t i, size_t j, size_t k)> reference_t;
+
+reference_t pointwise(std::function<float(float u, float v)> f)
+{
+    return ([f](const dataset_c &d, size_t i, size_t j, size_t k) {
+        size_t idx = d.offset(i, j, k);
+        return (f(d.U[idx], d.V[idx]));
+    });
+}
+
+bool either_nan(float u, float v) { return (std::isnan(u) || std::isnan(v)); }
+
+bool same(float expected, float value, float mv)
+{
+    if (std::isnan(expected) || !std::isfinite(expected)) return (value == mv);
+    if (value == mv) return (false);
+
+    return (std::fabs(value - expected) <= 1e-5 * std::max(1.0f, std::fabs(expected)));
+}
+
+// Compare the variable over the box [min, max] of its grid
+//
+int compare(DataMgr &datamgr, string name, const dataset_c &d, const reference_t &ref, std::vector<size_t> min, std::vector<size_t> max)
+{
+    Grid *g = datamgr.GetVariable(0, name, -1, -1, min, max, false);
+    if (!g) {
+        cerr << ProgName << " : " << name << " : read failed" << endl;
+        return (-1);
+    }
+
+    std::vector<size_t> dims = g->GetDimensions();
+    std::vector<size_t> minAbs = g->GetMinAbs();
+    dims.resize(3, 1);
+    minAbs.resize(3, 0);
+    float mv = g->GetMissingValue();
+
+    int nerrors = 0;
+    for (size_t k = 0; k < dims[2]; k++) {
+        for (size_t j = 0; j < dims[1]; j++) {
+            for (size_t i = 0; i < dims[0]; i++) {
+                float expected = ref(d, i + minAbs[0], j + minAbs[1], k + minAbs[2]);
+                float value = g->AccessIJK(i, j, k);
+                if (same(expected, value, mv)) continue;
+
+                if (nerrors++ < 5) { cerr << ProgName << " : " << name << "(" << i + minAbs[0] << "," << j + minAbs[1] << "," << k + minAbs[2] << ") = " << value << ", expected " << expected << endl; }
+            }
+        }
+    }
+    delete g;
+
+    return (nerrors ? -1 : 0);
+}
+
+int main(int argc, char **argv)
+{
+    OptionParser op;
+
+    ProgName = FileUtils::LegacyBasename(argv[0]);
+
+    MyBase::SetErrMsgFilePtr(stderr);
+
+    if (op.AppendOptions(set_opts) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (op.ParseOptions(&argc, argv, get_options) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (opt.help) {
+        cerr << "Usage: " << ProgName << " [options]" << endl;
+        op.PrintOptionHelp(stderr);
+        exit(0);
+    }
+
+    if (opt.debug) { MyBase::SetDiagMsgFilePtr(stderr); }
+
+    dataset_c d;
+    make_dataset(d);
+    if (write_dataset(opt.file, d) < 0) exit(1);
+
+    DataMgr datamgr("cf", opt.memsize, opt.nthreads);
+    int     rc = datamgr.Initialize({opt.file}, {});
+    if (rc < 0) exit(1);
+
+    DC::DataVar t2info;
+    datamgr.GetDataVarInfo("T2", t2info);
+    string mesh2D = t2info.GetMeshName();
+
+    class test_c {
+    public:
+        string      expression;
+        string      mesh;
+        reference_t ref;
+    };
+
+    std::vector<test_c> tests = {
+        {"U + V", "", pointwise([](float u, float v) { return (u + v); })},
+        {"sqrt(U*U + V*V)", "", pointwise([](float u, float v) { return (std::sqrt(u * u + v * v)); })},
+        {"U / V", "", pointwise([](float u, float v) { return (u / v); })},
+        {"U > V", "", pointwise([](float u, float v) { return (either_nan(u, v) ? NaN : (u > v ? 1.0f : 0.0f)); })},
+        {"U != V", "", pointwise([](float u, float v) { return (either_nan(u, v) ? NaN : (u != v ? 1.0f : 0.0f)); })},
+        {"!U", "", pointwise([](float u, float) { return (std::isnan(u) ? NaN : (u == 0.0f ? 1.0f : 0.0f)); })},
+        {"U && V", "", pointwise([](float u, float v) { return (either_nan(u, v) ? NaN : (u != 0.0f && v != 0.0f ? 1.0f : 0.0f)); })},
+        {"U || 1", "", pointwise([](float u, float) { return (std::isnan(u) ? NaN : 1.0f); })},
+        {"min(U, V)", "", pointwise([](float u, float v) { return (either_nan(u, v) ? NaN : std::min(u, v)); })},
+        {"max(U, V)", "", pointwise([](float u, float v) { return (either_nan(u, v) ? NaN : std::max(u, v)); })},
+        {"where(U > 0, U, V)", "", pointwise([](float u, float v) { return (std::isnan(u) ? NaN : (u > 0 ? u : v)); })},
+        {"where(V > 0, 1, 2)", "", pointwise([](float, float v) { return (std::isnan(v) ? NaN : (v > 0 ? 1.0f : 2.0f)); })},
+        {"ddx(U)", "",
+         [](const dataset_c &d, size_t i, size_t j, size_t k) {
+             size_t im = i > 0 ? i - 1 : i;
+             size_t ip = i < NX - 1 ? i + 1 : i;
+             return ((d.U[d.offset(ip, j, k)] - d.U[d.offset(im, j, k)]) / (d.x[ip] - d.x[im]));
+         }},
+        {"ddz(V)", "",
+         [](const dataset_c &d, size_t i, size_t j, size_t k) {
+             size_t km = k > 0 ? k - 1 : k;
+             size_t kp = k < NZ - 1 ? k + 1 : k;
+             return ((d.V[d.offset(i, j, kp)] - d.V[d.offset(i, j, km)]) / (d.z[kp] - d.z[km]));
+         }},
+        {"T2 + vmean(U)", "",
+         [](const dataset_c &d, size_t i, size_t j, size_t) {
+             float  sum = 0.0;
+             size_t n = 0;
+             for (size_t k = 0; k < NZ; k++) {
+                 float u = d.U[d.offset(i, j, k)];
+                 if (std::isnan(u)) continue;
+                 sum += u;
+                 n++;
+             }
+             return (n ? d.T2[d.offset(i, j)] + sum / n : NaN);
+         }},
+        {"vmax(V)", mesh2D,
+         [](const dataset_c &d, size_t i, size_t j, size_t) {
+             float m = NaN;
+             for (size_t k = 0; k < NZ; k++) {
+                 float v = d.V[d.offset(i, j, k)];
+                 if (!std::isnan(v)) m = std::isnan(m) ? v : std::max(m, v);
+             }
+             return (m);
+         }},
+    };
+
+    int nfailed = 0;
+    for (int t = 0; t < tests.size(); t++) {
+        const test_c &test = tests[t];
+        string        name = "expr" + std::to_string(t);
+
+        if (datamgr.AddExpressionVar(name, test.expression, test.mesh) < 0) {
+            cerr << ProgName << " : \"" << test.expression << "\" : AddExpressionVar failed" << endl;
+            nfailed++;
+            continue;
+        }
+
+        // The whole domain, and a box whose stencil halo lies inside it
+        //
+        size_t              rank = datamgr.GetNumDimensions(name);
+        std::vector<size_t> min = {0, 0, 0}, max = {NX - 1, NY - 1, NZ - 1};
+        std::vector<size_t> boxMin = {2, 1, 1}, boxMax = {6, 4, 3};
+        min.resize(rank);
+        max.resize(rank);
+        boxMin.resize(rank);
+        boxMax.resize(rank);
+
+        if (compare(datamgr, name, d, test.ref, min, max) < 0 || compare(datamgr, name, d, test.ref, boxMin, boxMax) < 0) {
+            cerr << ProgName << " : \"" << test.expression << "\" : FAILED" << endl;
+            nfailed++;
+        }
+
+        datamgr.RemoveDerivedVar(name);
+    }
+
+    // Invalid expressions must be rejected
+    //
+    std::vector<std::pair<string, string>> invalid = {
+        {"ddz(T2)", ""}, {"ddy(T2) + ddz(T2)", ""}, {"U +", ""}, {"W * 2", ""}, {"U + T2", ""}, {"vmean(U)", ""},
+    };
+    MyBase::SetErrMsgFilePtr(NULL);
+    for (const auto &e : invalid) {
+        if (datamgr.AddExpressionVar("invalid", e.first, e.second) == 0) {
+            cerr << ProgName << " : \"" << e.first << "\" : invalid expression was accepted" << endl;
+            datamgr.RemoveDerivedVar("invalid");
+            nfailed++;
+        }
+    }
+    MyBase::SetErrMsgFilePtr(stderr);
+
+    // Names may not be reused
+    //
+    if (datamgr.AddExpressionVar("U", "V * 2") == 0) {
+        cerr << ProgName << " : an expression variable replaced U" << endl;
+        nfailed++;
+    }
+
+    if (!opt.keep) remove(opt.file.c_str());
+
+    if (nfailed) {
+        cout << nfailed << " of " << tests.size() + invalid.size() + 1 << " tests FAILED" << endl;
+        exit(1);
+    }
+
+    cout << "PASSED" << endl;
+    exit(0);
+}
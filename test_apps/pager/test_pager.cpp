@@ -0,0 +1,283 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/RegularGrid.h>
+#include <vapor/BlockPager.h>
+#include <vapor/FileUtils.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Compare a RegularGrid whose blocks are paged in by a BlockPager against
+// an in-memory copy of the same grid. Every access method must return
+// identical values, and the pager must stay within its resident limit.
+//
+
+struct {
+    std::vector<size_t>     dims;
+    std::vector<size_t>     bs;
+    int                     maxresident;
+    int                     nthreads;
+    OptionParser::Boolean_T help;
+    OptionParser::Boolean_T debug;
+} opt;
+
+OptionParser::OptDescRec_T set_opts[] = {{"dims", 1, "70:50:40",
+                                          "Colon delimited 3-element vector "
+                                          "specifying grid dimensions"},
+                                         {"bs", 1, "16:16:16",
+                                          "Colon delimited 3-element vector "
+                                          "specifying block size"},
+                                         {"maxresident", 1, "4", "Maximum number of resident blocks"},
+                                         {"nthreads", 1, "0",
+                                          "Specify number of execution threads "
+                                          "0 => use number of cores"},
+                                         {"help", 0, "", "Print this message and exit"},
+                                         {"debug", 0, "", "Debug mode"},
+                                         {NULL}};
+
+OptionParser::Option_T get_options[] = {{"dims", Wasp::CvtToSize_tVec, &opt.dims, sizeof(opt.dims)},
+                                        {"bs", Wasp::CvtToSize_tVec, &opt.bs, sizeof(opt.bs)},
+                                        {"maxresident", Wasp::CvtToInt, &opt.maxresident, sizeof(opt.maxresident)},
+                                        {"nthreads", Wasp::CvtToInt, &opt.nthreads, sizeof(opt.nthreads)},
+                                        {"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+                                        {"debug", Wasp::CvtToBoolean, &opt.debug, sizeof(opt.debug)},
+                                        {NULL}};
+
+const char *ProgName;
+
+const float MissingValue = -999.0;
+
+float value(size_t i, size_t j, size_t k)
+{
+    if ((i + 3 * j + 7 * k) % 19 == 0) return (MissingValue);
+    return ((float)(i + 100 * j) + 0.01 * k);
+}
+
+// The in-memory grid, and the storage the pager loads blocks from
+//
+class source_c {
+public:
+    size_t               nblocks;
+    size_t               blockSize;
+    std::vector<float>   storage;
+    std::vector<float *> blks;
+    RegularGrid *        grid;
+};
+
+void make_source(source_c &s)
+{
+    s.nblocks = 1;
+    s.blockSize = 1;
+    for (int i = 0; i < 3; i++) {
+        s.nblocks *= (opt.dims[i] - 1) / opt.bs[i] + 1;
+        s.blockSize *= opt.bs[i];
+    }
+
+    s.storage.assign(s.nblocks * s.blockSize, 0.0);
+    for (size_t b = 0; b < s.nblocks; b++) s.blks.push_back(s.storage.data() + b * s.blockSize);
+
+    s.grid = new RegularGrid(opt.dims, opt.bs, s.blks, {0.0, 0.0, 0.0}, {1.0, 1.0, 1.0});
+    s.grid->SetMissingValue(MissingValue);
+    s.grid->SetHasMissingValues(true);
+
+    for (size_t k = 0; k < opt.dims[2]; k++) {
+        for (size_t j = 0; j < opt.dims[1]; j++) {
+            for (size_t i = 0; i < opt.dims[0]; i++) { s.grid->SetValueIJK(i, j, k, value(i, j, k)); }
+        }
+    }
+}
+
+// Return a paged grid, with a pager of its own, reading blocks from s
+//
+RegularGrid *make_paged(const source_c &s, std::shared_ptr<BlockPager> &pager)
+{
+    auto loader = [&s](size_t index, float *data) {
+        std::copy(s.blks[index], s.blks[index] + s.blockSize, data);
+        return (0);
+    };
+
+    pager = std::make_shared<BlockPager>(s.nblocks, s.blockSize, opt.maxresident, loader, MissingValue);
+
+    RegularGrid *g = new RegularGrid(opt.dims, opt.bs, std::vector<float *>(), {0.0, 0.0, 0.0}, {1.0, 1.0, 1.0});
+    g->SetMissingValue(MissingValue);
+    g->SetHasMissingValues(true);
+    g->SetBlockPager(pager);
+    return (g);
+}
+
+int check(bool ok, const string &what)
+{
+    if (!ok) cerr << ProgName << " : " << what << " : FAILED" << endl;
+    return (ok ? 0 : 1);
+}
+
+// The resident set may only exceed its limit if more than that many
+// blocks, nacquired, are acquired at once
+//
+int check_residency(const BlockPager &pager, const string &what, size_t nacquired)
+{
+    size_t limit = std::max((size_t)opt.maxresident, nacquired);
+    if (opt.debug) cerr << what << " : peak resident " << pager.GetPeakResident() << ", loads " << pager.GetNumLoads() << endl;
+    return (check(pager.GetPeakResident() <= limit, what + " peak residency"));
+}
+
+int test_get_value(const source_c &s)
+{
+    std::shared_ptr<BlockPager> pager;
+    RegularGrid *               g = make_paged(s, pager);
+
+    size_t nerrors = 0;
+    for (size_t k = 0; k < opt.dims[2]; k++) {
+        for (size_t j = 0; j < opt.dims[1]; j++) {
+            for (size_t i = 0; i < opt.dims[0]; i++) {
+                Size_tArr3 index = {i, j, k};
+                if (g->GetValueAtIndex(index) != s.grid->GetValueAtIndex(index)) nerrors++;
+                if (g->AccessIJK(i, j, k) != value(i, j, k)) nerrors++;
+            }
+        }
+    }
+
+    int nfailed = check(nerrors == 0, "GetValueAtIndex");
+    nfailed += check_residency(*pager, "GetValueAtIndex", 1);
+    delete g;
+    return (nfailed);
+}
+
+// Return the number of values at which two iterators differ, or -1 if
+// they visit different numbers of values
+//
+long compare_iterators(const Grid *g0, const Grid *g1, const std::vector<double> &minu, const std::vector<double> &maxu)
+{
+    long nerrors = 0;
+    auto a = minu.empty() ? g0->cbegin() : g0->cbegin(minu, maxu);
+    auto b = minu.empty() ? g1->cbegin() : g1->cbegin(minu, maxu);
+    auto aEnd = g0->cend();
+    auto bEnd = g1->cend();
+    for (; a != aEnd && b != bEnd; ++a, ++b) {
+        if (*a != *b) nerrors++;
+    }
+    return (a == aEnd && b == bEnd ? nerrors : -1);
+}
+
+int test_iterators(const source_c &s)
+{
+    std::shared_ptr<BlockPager> pager;
+    RegularGrid *               g = make_paged(s, pager);
+
+    int nfailed = check(compare_iterators(g, s.grid, {}, {}) == 0, "ConstIterator");
+
+    // A box in user coordinates
+    //
+    nfailed += check(compare_iterators(g, s.grid, {0.2, 0.1, 0.3}, {0.7, 0.9, 0.6}) == 0, "ConstIterator box");
+
+    nfailed += check_residency(*pager, "ConstIterator", 1);
+    delete g;
+    return (nfailed);
+}
+
+int test_get_range(const source_c &s)
+{
+    std::shared_ptr<BlockPager> pager;
+    RegularGrid *               g = make_paged(s, pager);
+
+    float r0[2], r1[2];
+    g->GetRange(r0);
+    s.grid->GetRange(r1);
+    int nfailed = check(r0[0] == r1[0] && r0[1] == r1[1], "GetRange");
+
+    Size_tArr3 min = {3, 5, 7};
+    Size_tArr3 max = {opt.dims[0] - 4, opt.dims[1] - 2, opt.dims[2] - 3};
+    g->GetRange(min, max, r0);
+    s.grid->GetRange(min, max, r1);
+    nfailed += check(r0[0] == r1[0] && r0[1] == r1[1], "GetRange box");
+
+    nfailed += check_residency(*pager, "GetRange", Grid::GetNumThreads(opt.nthreads));
+    delete g;
+    return (nfailed);
+}
+
+int test_parallel_for_each(const source_c &s)
+{
+    std::shared_ptr<BlockPager> pager;
+    RegularGrid *               g = make_paged(s, pager);
+
+    std::atomic<size_t> count(0);
+    std::atomic<size_t> nerrors(0);
+    g->ParallelForEach(
+        [&](int, const Grid::Span &span) {
+            for (size_t i = 0; i < span.n; i++) {
+                if (span.data[i] != value(span.index[0] + i, span.index[1], span.index[2])) nerrors++;
+            }
+            count += span.n;
+        },
+        opt.nthreads);
+
+    int nfailed = check(nerrors == 0 && count == opt.dims[0] * opt.dims[1] * opt.dims[2], "ParallelForEach");
+
+    // Each block is acquired once
+    //
+    nfailed += check(pager->GetNumLoads() == s.nblocks, "ParallelForEach loads");
+    nfailed += check_residency(*pager, "ParallelForEach", Grid::GetNumThreads(opt.nthreads));
+    delete g;
+    return (nfailed);
+}
+
+int main(int argc, char **argv)
+{
+    OptionParser op;
+
+    ProgName = FileUtils::LegacyBasename(argv[0]);
+
+    MyBase::SetErrMsgFilePtr(stderr);
+
+    if (op.AppendOptions(set_opts) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (op.ParseOptions(&argc, argv, get_options) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (opt.help) {
+        cerr << "Usage: " << ProgName << " [options]" << endl;
+        op.PrintOptionHelp(stderr);
+        exit(0);
+    }
+
+    if (opt.dims.size() != 3 || opt.bs.size() != 3) {
+        cerr << ProgName << " : dims and bs must have 3 elements" << endl;
+        exit(1);
+    }
+
+    if (opt.debug) { MyBase::SetDiagMsgFilePtr(stderr); }
+
+    source_c s;
+    make_source(s);
+
+    int nfailed = 0;
+    nfailed += test_get_value(s);
+    nfailed += test_iterators(s);
+    nfailed += test_get_range(s);
+    nfailed += test_parallel_for_each(s);
+
+    delete s.grid;
+
+    if (nfailed) {
+        cerr << ProgName << " : " << nfailed << " checks failed" << endl;
+        exit(1);
+    }
+
+    cout << ProgName << " : all checks passed" << endl;
+    return (0);
+}
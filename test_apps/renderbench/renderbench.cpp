@@ -0,0 +1,473 @@
+#include <vapor/glutil.h>    // Must be included first!!!
+#include <EGL/egl.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/FileUtils.h>
+#include <vapor/Version.h>
+#include <vapor/XmlNode.h>
+#include <vapor/ControlExecutive.h>
+#include <vapor/DataStatus.h>
+#include <vapor/ViewpointParams.h>
+#include <vapor/GLManager.h>
+#include <vapor/Renderer.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Headless rendering benchmark. A session file is loaded, the data sets
+// it references are opened, and a fixed sequence of frames is rendered
+// into an offscreen EGL surface while the camera orbits the rotation
+// center and the time step advances. Per frame and summary timings for
+// every renderer, the portion of that time spent fetching data, and the
+// process memory use are written as JSON.
+//
+// No GPU is required. With Mesa, setting EGL_PLATFORM=surfaceless and
+// LIBGL_ALWAYS_SOFTWARE=1 selects the llvmpipe software rasterizer.
+//
+
+struct opt_t {
+    int                     nframes;
+    int                     warmup;
+    int                     ts0;
+    int                     nts;
+    double                  orbit;
+    int                     width;
+    int                     height;
+    string                  out;
+    OptionParser::Boolean_T nosync;
+    OptionParser::Boolean_T help;
+} opt;
+
+OptionParser::OptDescRec_T set_opts[] = {{"nframes", 1, "32", "Number of frames to time"},
+                                         {"warmup", 1, "2", "Number of untimed frames rendered first"},
+                                         {"ts0", 1, "0", "First time step to render"},
+                                         {"nts", 1, "1", "Number of time steps to cycle through. -1 => all"},
+                                         {"orbit", 1, "0", "Degrees the camera orbits about the rotation center over all timed frames"},
+                                         {"width", 1, "1024", "Image width in pixels"},
+                                         {"height", 1, "768", "Image height in pixels"},
+                                         {"out", 1, "", "Write the JSON report to this file instead of the standard output"},
+                                         {"nosync", 0, "", "Do not wait for the GPU to finish before stopping renderer timers"},
+                                         {"help", 0, "", "Print this message and exit"},
+                                         {NULL}};
+
+OptionParser::Option_T get_options[] = {{"nframes", Wasp::CvtToInt, &opt.nframes, sizeof(opt.nframes)},
+                                        {"warmup", Wasp::CvtToInt, &opt.warmup, sizeof(opt.warmup)},
+                                        {"ts0", Wasp::CvtToInt, &opt.ts0, sizeof(opt.ts0)},
+                                        {"nts", Wasp::CvtToInt, &opt.nts, sizeof(opt.nts)},
+                                        {"orbit", Wasp::CvtToDouble, &opt.orbit, sizeof(opt.orbit)},
+                                        {"width", Wasp::CvtToInt, &opt.width, sizeof(opt.width)},
+                                        {"height", Wasp::CvtToInt, &opt.height, sizeof(opt.height)},
+                                        {"out", Wasp::CvtToCPPStr, &opt.out, sizeof(opt.out)},
+                                        {"nosync", Wasp::CvtToBoolean, &opt.nosync, sizeof(opt.nosync)},
+                                        {"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+                                        {NULL}};
+
+const char *ProgName;
+
+// Offscreen OpenGL 3.3 core profile context
+//
+struct egl_context_t {
+    EGLDisplay display;
+    EGLSurface surface;
+    EGLContext context;
+};
+
+int create_context(int width, int height, egl_context_t &ctx)
+{
+    ctx.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (ctx.display == EGL_NO_DISPLAY || !eglInitialize(ctx.display, NULL, NULL)) {
+        MyBase::SetErrMsg("Failed to initialize EGL display");
+        return (-1);
+    }
+
+    const EGLint configAttribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_DEPTH_SIZE, 24, EGL_NONE};
+
+    EGLConfig config;
+    EGLint    nconfigs = 0;
+    if (!eglChooseConfig(ctx.display, configAttribs, &config, 1, &nconfigs) || nconfigs < 1) {
+        MyBase::SetErrMsg("No EGL configuration supports offscreen OpenGL rendering");
+        return (-1);
+    }
+
+    const EGLint surfaceAttribs[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+
+    ctx.surface = eglCreatePbufferSurface(ctx.display, config, surfaceAttribs);
+    if (ctx.surface == EGL_NO_SURFACE) {
+        MyBase::SetErrMsg("Failed to create %dx%d EGL pbuffer", width, height);
+        return (-1);
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+
+    const EGLint contextAttribs[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3, EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE};
+
+    ctx.context = eglCreateContext(ctx.display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (ctx.context == EGL_NO_CONTEXT) {
+        MyBase::SetErrMsg("Failed to create OpenGL 3.3 core profile context");
+        return (-1);
+    }
+
+    if (!eglMakeCurrent(ctx.display, ctx.surface, ctx.surface, ctx.context)) {
+        MyBase::SetErrMsg("Failed to make OpenGL context current");
+        return (-1);
+    }
+    return (0);
+}
+
+void destroy_context(egl_context_t &ctx)
+{
+    eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(ctx.display, ctx.context);
+    eglDestroySurface(ctx.display, ctx.surface);
+    eglTerminate(ctx.display);
+}
+
+// The GUI records the data sets open in a session in its own params
+// class, which is not available here, so read them directly from the
+// session file. Each data set is stored under a separator node named for
+// the data set.
+//
+const XmlNode *find_node(const XmlNode *node, const string &tag)
+{
+    if (node->GetTag() == tag) return (node);
+
+    for (int i = 0; i < node->GetNumChildren(); i++) {
+        const XmlNode *found = find_node(node->GetChild(i), tag);
+        if (found) return (found);
+    }
+    return (NULL);
+}
+
+int open_datasets(ControlExec &ce, string sessionFile)
+{
+    XmlParser parser;
+    XmlNode   root;
+    if (parser.LoadFromFile(&root, sessionFile) < 0) return (-1);
+
+    const XmlNode *openNode = find_node(&root, "OpenDataSetsTag");
+    if (!openNode || !openNode->GetNumChildren()) {
+        MyBase::SetErrMsg("Session file \"%s\" does not reference any data sets", sessionFile.c_str());
+        return (-1);
+    }
+
+    for (int i = 0; i < openNode->GetNumChildren(); i++) {
+        const XmlNode *sepNode = openNode->GetChild(i);
+        const XmlNode *dsNode = sepNode->GetChild("DataSetParam");
+        if (!dsNode) continue;
+
+        string         dataSetName = sepNode->GetTag();
+        vector<string> paths;
+        if (dsNode->HasElementString("DataSetPathsTag")) dsNode->GetElementStringVec("DataSetPathsTag", paths);
+        string format = dsNode->HasElementString("DataSetFormatTag") ? dsNode->GetElementString("DataSetFormatTag") : "vdc";
+
+        if (ce.OpenData(paths, vector<string>(), dataSetName, format) < 0) return (-1);
+    }
+    return (0);
+}
+
+// Column major 4x4 matrix product, c = a * b
+//
+void mat_mult(const double a[16], const double b[16], double c[16])
+{
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            double sum = 0.0;
+            for (int k = 0; k < 4; k++) sum += a[k * 4 + row] * b[col * 4 + k];
+            c[col * 4 + row] = sum;
+        }
+    }
+}
+
+// Rotate the model view matrix \p m0 by \p degrees about the camera's up
+// axis through \p center, producing \p m
+//
+void orbit_camera(const double m0[16], const vector<double> &center, double degrees, double m[16])
+{
+    // The second row of the rotation part of the model view matrix is
+    // the up direction in world coordinates
+    //
+    double ax = m0[1], ay = m0[5], az = m0[9];
+    double len = std::sqrt(ax * ax + ay * ay + az * az);
+    if (len == 0.0) {
+        std::copy(m0, m0 + 16, m);
+        return;
+    }
+    ax /= len;
+    ay /= len;
+    az /= len;
+
+    double rad = degrees * M_PI / 180.0;
+    double c = std::cos(rad), s = std::sin(rad), t = 1.0 - c;
+
+    double r[16] = {t * ax * ax + c,      t * ax * ay + s * az, t * ax * az - s * ay, 0.0, t * ax * ay - s * az, t * ay * ay + c,
+                    t * ay * az + s * ax, 0.0,                  t * ax * az + s * ay, t * ay * az - s * ax, t * az * az + c, 0.0,
+                    0.0,                  0.0,                  0.0,                  1.0};
+
+    double toCenter[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, center[0], center[1], center[2], 1};
+    double fromCenter[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, -center[0], -center[1], -center[2], 1};
+
+    double tmp1[16], tmp2[16];
+    mat_mult(m0, toCenter, tmp1);
+    mat_mult(tmp1, r, tmp2);
+    mat_mult(tmp2, fromCenter, m);
+}
+
+// Current and peak resident set size in MBs
+//
+void memory_usage(double &rss, double &peak)
+{
+    rss = 0.0;
+    peak = 0.0;
+
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        long size, resident;
+        if (fscanf(fp, "%ld %ld", &size, &resident) == 2) rss = (double)resident * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+        fclose(fp);
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) peak = usage.ru_maxrss / 1024.0;
+}
+
+string json_string(const string &s)
+{
+    string r = "\"";
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') {
+            r += '\\';
+            r += ch;
+        } else if ((unsigned char)ch < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            r += buf;
+        } else {
+            r += ch;
+        }
+    }
+    return (r + "\"");
+}
+
+struct stats_t {
+    double mean, median, min, max;
+};
+
+stats_t compute_stats(vector<double> v)
+{
+    stats_t s = {0.0, 0.0, 0.0, 0.0};
+    if (v.empty()) return (s);
+
+    std::sort(v.begin(), v.end());
+    for (auto x : v) s.mean += x;
+    s.mean /= v.size();
+    s.median = v.size() % 2 ? v[v.size() / 2] : 0.5 * (v[v.size() / 2 - 1] + v[v.size() / 2]);
+    s.min = v.front();
+    s.max = v.back();
+    return (s);
+}
+
+void print_stats(FILE *fp, const char *name, const vector<double> &v)
+{
+    stats_t s = compute_stats(v);
+    fprintf(fp, "%s: {\"mean\": %.6f, \"median\": %.6f, \"min\": %.6f, \"max\": %.6f}", json_string(name).c_str(), s.mean, s.median, s.min, s.max);
+}
+
+// Timings of one renderer across all timed frames
+//
+struct renderer_times_t {
+    string         window;
+    string         type;
+    string         name;
+    vector<double> paint;
+    vector<double> fetch;
+};
+
+int main(int argc, char **argv)
+{
+    OptionParser op;
+
+    ProgName = FileUtils::LegacyBasename(argv[0]);
+    MyBase::SetErrMsgFilePtr(stderr);
+
+    if (op.AppendOptions(set_opts) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (op.ParseOptions(&argc, argv, get_options) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (opt.help || argc != 2) {
+        cerr << "Usage: " << ProgName << " [options] session.vs3" << endl;
+        op.PrintOptionHelp(stderr);
+        exit(opt.help ? 0 : 1);
+    }
+    string sessionFile = argv[1];
+
+    FILE *fp = stdout;
+    if (!opt.out.empty()) {
+        fp = fopen(opt.out.c_str(), "w");
+        if (!fp) {
+            MyBase::SetErrMsg("fopen(%s) : %M", opt.out.c_str());
+            exit(1);
+        }
+    }
+
+    egl_context_t ctx;
+    if (create_context(opt.width, opt.height, ctx) < 0) exit(1);
+
+    Renderer::SetSynchronousTiming(!opt.nosync);
+
+    vector<GLManager *>      glManagers;
+    vector<renderer_times_t> rtimes;
+    vector<double>           frameTimes;
+    vector<string>           winNames;
+    string                   glRenderer = (const char *)glGetString(GL_RENDERER);
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "\"session\": %s,\n", json_string(sessionFile).c_str());
+    fprintf(fp, "\"version\": %s,\n", json_string(Version::GetFullVersionString()).c_str());
+    fprintf(fp, "\"gl_renderer\": %s,\n", json_string(glRenderer).c_str());
+    fprintf(fp, "\"width\": %d, \"height\": %d, \"synchronous\": %s,\n", opt.width, opt.height, opt.nosync ? "false" : "true");
+    fprintf(fp, "\"frames\": [\n");
+
+    {
+        ControlExec ce;
+
+        if (ce.LoadState(sessionFile) < 0) exit(1);
+        if (open_datasets(ce, sessionFile) < 0) exit(1);
+
+        DataStatus *ds = ce.GetDataStatus();
+        ParamsMgr * pm = ce.GetParamsMgr();
+
+        winNames = ce.GetVisualizerNames();
+        if (winNames.empty()) {
+            MyBase::SetErrMsg("Session file \"%s\" does not contain a visualizer", sessionFile.c_str());
+            exit(1);
+        }
+
+        // Visualizers render into their own framebuffer before copying
+        // to the default one, so they may all share the pbuffer
+        //
+        std::map<string, vector<double>> initialMV;
+        for (auto winName : winNames) {
+            GLManager *glManager = new GLManager;
+            glManagers.push_back(glManager);
+
+            // Non-fatal warnings, such as a software renderer being
+            // detected, are also reported through the error message
+            // mechanism, so only the return code is checked
+            //
+            if (ce.InitializeViz(winName, glManager) < 0) exit(1);
+            if (ce.ResizeViz(winName, opt.width, opt.height) < 0) exit(1);
+
+            initialMV[winName] = pm->GetViewpointParams(winName)->GetModelViewMatrix();
+        }
+
+        size_t numTS = ds->GetTimeCoordinates().size();
+        if (numTS < 1) numTS = 1;
+        size_t ts0 = std::min((size_t)std::max(opt.ts0, 0), numTS - 1);
+        size_t nts = opt.nts < 1 ? numTS - ts0 : std::min((size_t)opt.nts, numTS - ts0);
+
+        // Disable undo while driving the params
+        //
+        pm->SetSaveStateEnabled(false);
+
+        std::map<string, size_t> rindex;
+        for (int frame = -opt.warmup; frame < opt.nframes; frame++) {
+            int    timed = std::max(frame, 0);
+            size_t ts = ts0 + timed % nts;
+            double degrees = opt.nframes > 1 ? opt.orbit * timed / (opt.nframes - 1) : 0.0;
+
+            for (auto winName : winNames) {
+                for (auto dataSetName : ds->GetDataMgrNames()) {
+                    vector<RenderParams *> rParams;
+                    pm->GetRenderParams(winName, dataSetName, rParams);
+                    for (auto rp : rParams) rp->SetCurrentTimestep(ds->MapGlobalToLocalTimeStep(dataSetName, ts));
+                }
+            }
+
+            double t0 = GetTime();
+            for (auto winName : winNames) {
+                ViewpointParams *vp = pm->GetViewpointParams(winName);
+                double           m[16];
+                orbit_camera(initialMV[winName].data(), vp->GetRotationCenter(), degrees, m);
+                vp->SetModelViewMatrix(m);
+
+                if (ce.Paint(winName, false) < 0) exit(1);
+            }
+            glFinish();
+            double frameTime = GetTime() - t0;
+
+            if (frame < 0) continue;
+
+            double rss, peak;
+            memory_usage(rss, peak);
+
+            frameTimes.push_back(frameTime);
+            fprintf(fp, "%s  {\"frame\": %d, \"ts\": %zu, \"orbit\": %.3f, \"time\": %.6f, \"rss_mb\": %.1f, \"renderers\": [", frame ? ",\n" : "", frame, ts, degrees, frameTime, rss);
+
+            int n = 0;
+            for (auto winName : winNames) {
+                vector<string> types, names;
+                vector<double> paint, fetch;
+                if (ce.GetRenderTimes(winName, types, names, paint, fetch) < 0) exit(1);
+
+                for (int i = 0; i < types.size(); i++) {
+                    string key = winName + "/" + types[i] + "/" + names[i];
+                    if (!rindex.count(key)) {
+                        rindex[key] = rtimes.size();
+                        rtimes.push_back({winName, types[i], names[i], {}, {}});
+                    }
+                    rtimes[rindex[key]].paint.push_back(paint[i]);
+                    rtimes[rindex[key]].fetch.push_back(fetch[i]);
+
+                    fprintf(fp, "%s{\"window\": %s, \"type\": %s, \"name\": %s, \"paint\": %.6f, \"fetch\": %.6f}", n++ ? ", " : "", json_string(winName).c_str(), json_string(types[i]).c_str(),
+                            json_string(names[i]).c_str(), paint[i], fetch[i]);
+                }
+            }
+            fprintf(fp, "]}");
+        }
+
+        for (auto winName : winNames) ce.RemoveVisualizer(winName, true);
+    }
+
+    for (auto glManager : glManagers) delete glManager;
+    destroy_context(ctx);
+
+    double rss, peak;
+    memory_usage(rss, peak);
+
+    fprintf(fp, "\n],\n");
+    fprintf(fp, "\"summary\": {\n");
+    fprintf(fp, "  \"frames\": %d,\n  ", (int)frameTimes.size());
+    print_stats(fp, "frame_time", frameTimes);
+    fprintf(fp, ",\n  \"peak_rss_mb\": %.1f,\n", peak);
+    fprintf(fp, "  \"renderers\": [");
+    for (int i = 0; i < rtimes.size(); i++) {
+        fprintf(fp, "%s\n    {\"window\": %s, \"type\": %s, \"name\": %s, ", i ? "," : "", json_string(rtimes[i].window).c_str(), json_string(rtimes[i].type).c_str(),
+                json_string(rtimes[i].name).c_str());
+        print_stats(fp, "paint", rtimes[i].paint);
+        fprintf(fp, ", ");
+        print_stats(fp, "fetch", rtimes[i].fetch);
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "\n  ]\n}\n}\n");
+
+    if (fp != stdout) fclose(fp);
+    return (0);
+}
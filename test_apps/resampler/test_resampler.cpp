@@ -0,0 +1,293 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/FileUtils.h>
+#include <vapor/RegularGrid.h>
+#include <vapor/CurvilinearGrid.h>
+#include <vapor/SurfaceResampler.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Resample an analytic field onto an oblique plane through a regular and
+// a curvilinear grid with SurfaceResampler, and compare every sample
+// against Grid::GetValue() at the same point. The field is linear, so
+// both interpolate it exactly. A second grid with the same dimensions but
+// different coordinates must invalidate the resampler's cached weights.
+//
+
+struct {
+    std::vector<size_t>     dims;
+    std::vector<size_t>     samples;
+    int                     nthreads;
+    OptionParser::Boolean_T help;
+    OptionParser::Boolean_T debug;
+} opt;
+
+OptionParser::OptDescRec_T set_opts[] = {{"dims", 1, "33:29:17",
+                                          "Colon delimited 3-element vector "
+                                          "specifying grid dimensions"},
+                                         {"samples", 1, "64:48",
+                                          "Colon delimited 2-element vector "
+                                          "specifying the sample lattice dimensions"},
+                                         {"nthreads", 1, "0",
+                                          "Specify number of execution threads "
+                                          "0 => use number of cores"},
+                                         {"help", 0, "", "Print this message and exit"},
+                                         {"debug", 0, "", "Debug mode"},
+                                         {NULL}};
+
+OptionParser::Option_T get_options[] = {{"dims", Wasp::CvtToSize_tVec, &opt.dims, sizeof(opt.dims)},
+                                        {"samples", Wasp::CvtToSize_tVec, &opt.samples, sizeof(opt.samples)},
+                                        {"nthreads", Wasp::CvtToInt, &opt.nthreads, sizeof(opt.nthreads)},
+                                        {"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+                                        {"debug", Wasp::CvtToBoolean, &opt.debug, sizeof(opt.debug)},
+                                        {NULL}};
+
+const char *ProgName;
+
+float field(double x, double y, double z) { return ((float)(2.0 * x - 3.0 * y + 5.0 * z + 1.0)); }
+
+// An affine map from index space to user coordinates. The horizontal part
+// is sheared for curvilinear grids, and the origin is moved by offset.
+//
+class mapping_c {
+public:
+    double scale[3];
+    double shear[2];
+    double offset[3];
+
+    void Map(double i, double j, double k, double p[3]) const
+    {
+        p[0] = scale[0] * i + shear[0] * j + offset[0];
+        p[1] = scale[1] * j + shear[1] * i + offset[1];
+        p[2] = scale[2] * k + offset[2];
+    }
+};
+
+// Grids and the storage for their data and coordinates
+//
+class grid_c {
+public:
+    std::vector<float> data;
+    std::vector<float> xcoords;
+    std::vector<float> ycoords;
+    StructuredGrid *   grid;
+
+    grid_c() : grid(NULL) {}
+    ~grid_c()
+    {
+        if (grid) delete grid;
+    }
+};
+
+void fill_data(grid_c &g, const mapping_c &m)
+{
+    g.grid->SetInterpolationOrder(1);
+
+    for (size_t k = 0; k < opt.dims[2]; k++) {
+        for (size_t j = 0; j < opt.dims[1]; j++) {
+            for (size_t i = 0; i < opt.dims[0]; i++) {
+                double p[3];
+                m.Map(i, j, k, p);
+                g.grid->SetValueIJK(i, j, k, field(p[0], p[1], p[2]));
+            }
+        }
+    }
+}
+
+void make_regular(grid_c &g, const mapping_c &m)
+{
+    g.data.assign(opt.dims[0] * opt.dims[1] * opt.dims[2], 0.0);
+
+    std::vector<double> minu(3), maxu(3);
+    m.Map(0, 0, 0, minu.data());
+    m.Map(opt.dims[0] - 1, opt.dims[1] - 1, opt.dims[2] - 1, maxu.data());
+
+    g.grid = new RegularGrid(opt.dims, opt.dims, {g.data.data()}, minu, maxu);
+    fill_data(g, m);
+}
+
+void make_curvilinear(grid_c &g, const mapping_c &m)
+{
+    std::vector<size_t> dims2d = {opt.dims[0], opt.dims[1]};
+
+    g.xcoords.assign(dims2d[0] * dims2d[1], 0.0);
+    g.ycoords.assign(dims2d[0] * dims2d[1], 0.0);
+    RegularGrid xrg(dims2d, dims2d, {g.xcoords.data()}, {0.0, 0.0}, {1.0, 1.0});
+    RegularGrid yrg(dims2d, dims2d, {g.ycoords.data()}, {0.0, 0.0}, {1.0, 1.0});
+    for (size_t j = 0; j < dims2d[1]; j++) {
+        for (size_t i = 0; i < dims2d[0]; i++) {
+            double p[3];
+            m.Map(i, j, 0, p);
+            xrg.SetValueIJK(i, j, 0, p[0]);
+            yrg.SetValueIJK(i, j, 0, p[1]);
+        }
+    }
+
+    std::vector<double> zcoords;
+    for (size_t k = 0; k < opt.dims[2]; k++) {
+        double p[3];
+        m.Map(0, 0, k, p);
+        zcoords.push_back(p[2]);
+    }
+
+    g.data.assign(opt.dims[0] * opt.dims[1] * opt.dims[2], 0.0);
+    g.grid = new CurvilinearGrid(opt.dims, opt.dims, {g.data.data()}, xrg, yrg, zcoords, NULL);
+    fill_data(g, m);
+}
+
+// An oblique plane whose samples lie strictly inside the grid defined by
+// a mapping. The far corner of the lattice is at (0.7, 0.8, 0.6) in
+// normalized index space.
+//
+class plane_c {
+public:
+    std::vector<double> origin;
+    std::vector<double> du;
+    std::vector<double> dv;
+    size_t              nu;
+    size_t              nv;
+
+    plane_c(const mapping_c &m) : origin(3), du(3), dv(3), nu(opt.samples[0]), nv(opt.samples[1])
+    {
+        double n[3] = {(double)opt.dims[0] - 1, (double)opt.dims[1] - 1, (double)opt.dims[2] - 1};
+
+        double pu[3], pv[3];
+        m.Map(0.1 * n[0], 0.1 * n[1], 0.1 * n[2], origin.data());
+        m.Map(0.6 * n[0], 0.3 * n[1], 0.3 * n[2], pu);
+        m.Map(0.2 * n[0], 0.6 * n[1], 0.4 * n[2], pv);
+        for (int a = 0; a < 3; a++) {
+            du[a] = (pu[a] - origin[a]) / (nu - 1);
+            dv[a] = (pv[a] - origin[a]) / (nv - 1);
+        }
+    }
+
+    DblArr3 Point(size_t u, size_t v) const
+    {
+        DblArr3 p;
+        for (int a = 0; a < 3; a++) p[a] = origin[a] + u * du[a] + v * dv[a];
+        return (p);
+    }
+};
+
+int check(bool ok, const string &what)
+{
+    if (!ok) cerr << ProgName << " : " << what << " : FAILED" << endl;
+    return (ok ? 0 : 1);
+}
+
+// Resample g and compare each sample with Grid::GetValue() and with the
+// analytic field
+//
+int compare(SurfaceResampler &r, const plane_c &plane, const grid_c &g, const string &what)
+{
+    size_t             nu = plane.nu;
+    size_t             nv = plane.nv;
+    std::vector<float> values(nu * nv);
+    if (r.Resample(g.grid, values.data()) < 0) return (check(false, what + " Resample"));
+
+    // Tolerance relative to the range of the field over the grid
+    //
+    float range[2];
+    g.grid->GetRange(range);
+    double tol = 1e-4 * (range[1] - range[0]);
+
+    size_t nerrors = 0;
+    double maxerr = 0.0;
+    for (size_t v = 0; v < nv; v++) {
+        for (size_t u = 0; u < nu; u++) {
+            DblArr3 p = plane.Point(u, v);
+            float   expected = g.grid->GetValue(p);
+            double  err = std::fabs(values[v * nu + u] - expected);
+            double  analytic = std::fabs(values[v * nu + u] - field(p[0], p[1], p[2]));
+            maxerr = std::max(maxerr, std::max(err, analytic));
+            if (expected == g.grid->GetMissingValue() || !(err <= tol) || !(analytic <= tol)) nerrors++;
+        }
+    }
+
+    if (opt.debug) cerr << what << " : max error " << maxerr << ", tolerance " << tol << endl;
+    return (check(nerrors == 0, what));
+}
+
+int test_grid(void (*make)(grid_c &, const mapping_c &), const mapping_c &m, const string &what)
+{
+    plane_c          plane(m);
+    SurfaceResampler r(opt.nthreads);
+    r.SetPlane(plane.origin, plane.du, plane.dv, plane.nu, plane.nv);
+
+    grid_c g0;
+    make(g0, m);
+    int nfailed = compare(r, plane, g0, what);
+
+    // Same geometry again, from the cached weights
+    //
+    nfailed += compare(r, plane, g0, what + " cached");
+
+    // Same dimensions, moved and stretched. The cache must be rebuilt, or
+    // the samples would be gathered from the old cells.
+    //
+    mapping_c m1 = m;
+    for (int a = 0; a < 3; a++) {
+        m1.offset[a] += 0.25 * m.scale[a];
+        m1.scale[a] *= 1.1;
+    }
+    grid_c g1;
+    make(g1, m1);
+    nfailed += compare(r, plane, g1, what + " moved");
+
+    return (nfailed);
+}
+
+int main(int argc, char **argv)
+{
+    OptionParser op;
+
+    ProgName = FileUtils::LegacyBasename(argv[0]);
+
+    MyBase::SetErrMsgFilePtr(stderr);
+
+    if (op.AppendOptions(set_opts) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (op.ParseOptions(&argc, argv, get_options) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (opt.help) {
+        cerr << "Usage: " << ProgName << " [options]" << endl;
+        op.PrintOptionHelp(stderr);
+        exit(0);
+    }
+
+    if (opt.dims.size() != 3 || opt.samples.size() != 2 || opt.samples[0] < 2 || opt.samples[1] < 2) {
+        cerr << ProgName << " : dims must have 3 elements, samples 2 elements of at least 2" << endl;
+        exit(1);
+    }
+
+    if (opt.debug) { MyBase::SetDiagMsgFilePtr(stderr); }
+
+    mapping_c regular = {{1.0 / 32, 2.0 / 28, 0.5 / 16}, {0.0, 0.0}, {0.0, 0.0, 0.0}};
+    mapping_c curvilinear = {{1.0 / 32, 2.0 / 28, 0.5 / 16}, {0.01, -0.015}, {-0.3, 0.2, 0.1}};
+
+    int nfailed = 0;
+    nfailed += test_grid(make_regular, regular, "regular");
+    nfailed += test_grid(make_curvilinear, curvilinear, "curvilinear");
+
+    if (nfailed) {
+        cerr << ProgName << " : " << nfailed << " checks failed" << endl;
+        exit(1);
+    }
+
+    cout << ProgName << " : all checks passed" << endl;
+    return (0);
+}
@@ -0,0 +1,199 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdio>
+
+#include <vapor/CFuncs.h>
+#include <vapor/OptionParser.h>
+#include <vapor/FileUtils.h>
+#include <vapor/VDCNetCDF.h>
+#include <vapor/DataMgr.h>
+
+using namespace Wasp;
+using namespace VAPoR;
+
+//
+// Write a small compressed VDC, then read a variable from it both with
+// DataMgr::GetVariable() and with DataMgr::GetVariableStreamed(). The
+// streamed grid is traversed with ParallelForEach(), so blocks are paged
+// in from scheduler tasks while the VDC decodes them in parallel, and
+// every value must match the cached grid.
+//
+
+struct {
+    std::string             file;
+    std::vector<size_t>     dims;
+    std::vector<size_t>     bs;
+    std::vector<size_t>     cratios;
+    int                     maxresidentmb;
+    int                     nthreads;
+    OptionParser::Boolean_T help;
+    OptionParser::Boolean_T debug;
+} opt;
+
+OptionParser::OptDescRec_T set_opts[] = {{"file", 1, "test_streamed.nc", "Path of the VDC master file to write"},
+                                         {"dims", 1, "128:96:64",
+                                          "Colon delimited 3-element vector "
+                                          "specifying grid dimensions"},
+                                         {"bs", 1, "16:16:16",
+                                          "Colon delimited 3-element vector "
+                                          "specifying block size"},
+                                         {"cratios", 1, "1:8:64", "Colon delimited list of compression ratios"},
+                                         {"maxresidentmb", 1, "1", "Limit, in megabytes, on resident blocks"},
+                                         {"nthreads", 1, "0",
+                                          "Specify number of execution threads "
+                                          "0 => use number of cores"},
+                                         {"help", 0, "", "Print this message and exit"},
+                                         {"debug", 0, "", "Debug mode"},
+                                         {NULL}};
+
+OptionParser::Option_T get_options[] = {{"file", Wasp::CvtToCPPStr, &opt.file, sizeof(opt.file)},
+                                        {"dims", Wasp::CvtToSize_tVec, &opt.dims, sizeof(opt.dims)},
+                                        {"bs", Wasp::CvtToSize_tVec, &opt.bs, sizeof(opt.bs)},
+                                        {"cratios", Wasp::CvtToSize_tVec, &opt.cratios, sizeof(opt.cratios)},
+                                        {"maxresidentmb", Wasp::CvtToInt, &opt.maxresidentmb, sizeof(opt.maxresidentmb)},
+                                        {"nthreads", Wasp::CvtToInt, &opt.nthreads, sizeof(opt.nthreads)},
+                                        {"help", Wasp::CvtToBoolean, &opt.help, sizeof(opt.help)},
+                                        {"debug", Wasp::CvtToBoolean, &opt.debug, sizeof(opt.debug)},
+                                        {NULL}};
+
+const char *ProgName;
+
+float value(size_t i, size_t j, size_t k) { return ((float)(i + 2 * j) + 0.5 * k); }
+
+int set_coord(VDCNetCDF &vdc, string dimname, size_t dimlen)
+{
+    std::vector<float> buf;
+    for (size_t i = 0; i < dimlen; i++) buf.push_back((float)i);
+
+    return (vdc.PutVar(0, dimname, -1, buf.data()));
+}
+
+int write_vdc()
+{
+    VDCNetCDF vdc(opt.nthreads);
+
+    int rc = vdc.Initialize(opt.file, vector<string>(), VDC::W, opt.bs);
+    if (rc < 0) return (-1);
+
+    vector<string> dimnames = {"Nx", "Ny", "Nz"};
+    for (int i = 0; i < 3; i++) {
+        rc = vdc.DefineDimension(dimnames[i], opt.dims[i], i);
+        if (rc < 0) return (-1);
+
+        rc = vdc.DefineCoordVar(dimnames[i], vector<string>{dimnames[i]}, "", "", i, DC::XType::FLOAT, false);
+        if (rc < 0) return (-1);
+    }
+
+    rc = vdc.SetCompressionBlock("bior4.4", opt.cratios);
+    if (rc < 0) return (-1);
+
+    rc = vdc.DefineDataVar("T", dimnames, dimnames, "", DC::XType::FLOAT, true);
+    if (rc < 0) return (-1);
+
+    rc = vdc.EndDefine();
+    if (rc < 0) return (-1);
+
+    for (int i = 0; i < 3; i++) {
+        rc = set_coord(vdc, dimnames[i], opt.dims[i]);
+        if (rc < 0) return (-1);
+    }
+
+    std::vector<float> data;
+    for (size_t k = 0; k < opt.dims[2]; k++) {
+        for (size_t j = 0; j < opt.dims[1]; j++) {
+            for (size_t i = 0; i < opt.dims[0]; i++) { data.push_back(value(i, j, k)); }
+        }
+    }
+
+    return (vdc.PutVar(0, "T", -1, data.data()));
+}
+
+int check(bool ok, const string &what)
+{
+    if (!ok) cerr << ProgName << " : " << what << " : FAILED" << endl;
+    return (ok ? 0 : 1);
+}
+
+// Compare the streamed grid against the cached one at level of detail lod
+//
+int test_streamed(DataMgr &datamgr, int lod)
+{
+    Grid *cached = datamgr.GetVariable(0, "T", -1, lod);
+    Grid *streamed = datamgr.GetVariableStreamed(0, "T", -1, lod, opt.maxresidentmb);
+    if (!cached || !streamed) return (check(false, "GetVariableStreamed"));
+
+    std::atomic<size_t> count(0);
+    std::atomic<size_t> nerrors(0);
+    streamed->ParallelForEach(
+        [&](int, const Grid::Span &span) {
+            for (size_t i = 0; i < span.n; i++) {
+                Size_tArr3 index = {span.index[0] + i, span.index[1], span.index[2]};
+                if (span.data[i] != cached->GetValueAtIndex(index)) nerrors++;
+            }
+            count += span.n;
+        },
+        opt.nthreads);
+
+    if (opt.debug) cerr << "lod " << lod << " : " << count << " values, " << nerrors << " mismatches" << endl;
+
+    int nfailed = check(nerrors == 0 && count == opt.dims[0] * opt.dims[1] * opt.dims[2], "ParallelForEach lod " + std::to_string(lod));
+
+    delete streamed;
+    delete cached;
+    return (nfailed);
+}
+
+int main(int argc, char **argv)
+{
+    OptionParser op;
+
+    ProgName = FileUtils::LegacyBasename(argv[0]);
+
+    MyBase::SetErrMsgFilePtr(stderr);
+
+    if (op.AppendOptions(set_opts) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (op.ParseOptions(&argc, argv, get_options) < 0) {
+        cerr << ProgName << " : " << op.GetErrMsg();
+        exit(1);
+    }
+
+    if (opt.help) {
+        cerr << "Usage: " << ProgName << " [options]" << endl;
+        op.PrintOptionHelp(stderr);
+        exit(0);
+    }
+
+    if (opt.dims.size() != 3 || opt.bs.size() != 3 || opt.cratios.empty()) {
+        cerr << ProgName << " : dims and bs must have 3 elements, cratios at least one" << endl;
+        exit(1);
+    }
+
+    if (opt.debug) { MyBase::SetDiagMsgFilePtr(stderr); }
+
+    if (write_vdc() < 0) exit(1);
+
+    // Large enough to cache the whole variable
+    //
+    size_t  memsize = 2 * opt.dims[0] * opt.dims[1] * opt.dims[2] * sizeof(float) / (1024 * 1024) + 16;
+    DataMgr datamgr("vdc", memsize, opt.nthreads);
+    int     rc = datamgr.Initialize({opt.file}, {});
+    if (rc < 0) exit(1);
+
+    int nfailed = 0;
+    nfailed += test_streamed(datamgr, 0);
+    nfailed += test_streamed(datamgr, -1);
+
+    if (nfailed) {
+        cerr << ProgName << " : " << nfailed << " checks failed" << endl;
+        exit(1);
+    }
+
+    cout << ProgName << " : all checks passed" << endl;
+    return (0);
+}